@@ -0,0 +1,148 @@
+// Throughput and CPU cost of batched frame reads (io_uring / pread thread pool) against the synchronous
+// ImageSequenceSource::getFrame() path.
+//
+// Usage: batch_read_bench [directory] [--frames N] [--batch B] [--direct]
+// Without a directory, N synthetic 2304x2304 16-bit uncompressed TIFFs are written to a temporary directory
+// first. --direct opens files with O_DIRECT, which is the only way to measure the device rather than the page
+// cache on repeated runs; without it, drop caches before each run for cold numbers. CPU time is process time
+// (all threads, user + system) divided by frames, so kernel work done on behalf of io_uring is included.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "BatchFrameReader.h"
+#include "ImageSequenceSource.h"
+#include "TiffFormat.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t touch(const cv::Mat& image) {
+    std::uint64_t sum = 0;
+    for (int y = 0; y < image.rows; ++y) {
+        const auto* row = image.ptr<std::uint8_t>(y);
+        const std::size_t bytes = static_cast<std::size_t>(image.cols) * image.elemSize();
+        for (std::size_t x = 0; x < bytes; x += 64) {
+            sum += row[x];
+        }
+    }
+    return sum;
+}
+
+void report(const std::string& name, std::size_t frames, std::size_t frame_bytes, double wall_seconds,
+            double cpu_seconds) {
+    const double frames_per_second = static_cast<double>(frames) / wall_seconds;
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << frames_per_second << " frames/s" << std::setw(9)
+              << frames_per_second * static_cast<double>(frame_bytes) / 1.0e6 << " MB/s" << std::setprecision(3)
+              << std::setw(9) << cpu_seconds * 1000.0 / static_cast<double>(frames) << " ms CPU/frame\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::size_t frames = 64;
+    std::size_t batch = 32;
+    bool direct = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--direct") {
+            direct = true;
+        } else {
+            directory = arg;
+        }
+    }
+
+    std::filesystem::path synthetic;
+    if (directory.empty()) {
+        synthetic = std::filesystem::temp_directory_path() / "droplet_batch_read_bench";
+        std::filesystem::create_directories(synthetic);
+        cv::Mat image(2304, 2304, CV_16UC1);
+        for (std::size_t f = 0; f < frames; ++f) {
+            for (int y = 0; y < image.rows; ++y) {
+                auto* row = image.ptr<std::uint16_t>(y);
+                for (int x = 0; x < image.cols; ++x) {
+                    row[x] = static_cast<std::uint16_t>(x * 5 + y + f * 13);
+                }
+            }
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05zu.tif", f);
+            std::string error;
+            if (!TiffFormat::writeGrayscale(synthetic / name, image, error)) {
+                std::cerr << error << '\n';
+                return 1;
+            }
+        }
+        directory = synthetic.string();
+    }
+
+    ImageSequenceSource source(directory, 1.0);
+    std::string error;
+    if (!source.load(error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    const std::size_t total = source.getTotalFrames();
+    const std::size_t frame_bytes = static_cast<std::size_t>(source.frameSize().area()) * CV_ELEM_SIZE(source.frameType());
+    std::cout << total << " frames of " << frame_bytes / 1024 << " KB, batches of " << batch
+              << (direct ? ", O_DIRECT" : "") << '\n';
+
+    std::uint64_t checksum = 0;
+    std::vector<std::size_t> indices(total);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    auto wall = Clock::now();
+    std::clock_t cpu = std::clock();
+    for (std::size_t i = 0; i < total; ++i) {
+        checksum += touch(source.getFrame(i));
+    }
+    report("getFrame (mmap)", total, frame_bytes, std::chrono::duration<double>(Clock::now() - wall).count(),
+           static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC);
+
+    for (const bool io_uring : {false, true}) {
+        BatchReadParams params;
+        params.use_io_uring = io_uring;
+        params.direct_io = direct;
+        params.queue_depth = batch;
+        BatchFrameReader reader(params);
+        if (io_uring && reader.backend() != BatchReadBackend::IoUring) {
+            std::cout << "io_uring unavailable: " << reader.fallbackReason() << '\n';
+            continue;
+        }
+        wall = Clock::now();
+        cpu = std::clock();
+        for (std::size_t begin = 0; begin < total; begin += batch) {
+            const std::size_t count = std::min(batch, total - begin);
+            for (const cv::Mat& frame : source.readFrames(std::span(indices).subspan(begin, count), reader)) {
+                checksum += touch(frame);
+            }
+        }
+        report(io_uring ? "batched io_uring" : "batched pread", total, frame_bytes,
+               std::chrono::duration<double>(Clock::now() - wall).count(),
+               static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC);
+        std::cout << "  " << reader.stats().system_calls << " system calls, " << reader.stats().short_reads
+                  << " short reads, " << reader.stats().direct_io_fallbacks << " O_DIRECT fallbacks\n";
+    }
+
+    if (!synthetic.empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(synthetic, ec);
+    }
+    std::cout << "checksum " << checksum << '\n';
+    return 0;
+}
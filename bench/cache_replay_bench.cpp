@@ -0,0 +1,142 @@
+// Hit rate of each FrameCache replacement policy on recorded frame request traces.
+//
+// Usage: cache_replay_bench [trace ...] [--capacity FRAMES] [--pin FILE]
+// Traces are FrameCacheTrace files (one frame id per line), e.g. recorded with FrameCache::setTraceRecording()
+// during a GUI session. --pin replays with the ids listed in FILE pinned (auto-tune samples, background frames).
+// Without traces, three synthetic sessions over a 3000-frame sequence are replayed. The default capacity is the
+// spec's 512 MB budget for 2304x2304 16-bit frames (48 frames).
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FrameCache.h"
+
+namespace {
+
+constexpr std::size_t kSequenceFrames = 3000;
+
+// Sequential playback while the user keeps flipping back to a handful of frames of interest.
+std::vector<std::size_t> playbackWithRevisits() {
+    std::vector<std::size_t> trace;
+    std::vector<std::size_t> marked;
+    for (std::size_t i = 0; i < 16; ++i) {
+        marked.push_back(150 + i * 180);
+    }
+    for (std::size_t i = 0; i < kSequenceFrames; ++i) {
+        trace.push_back(i);
+        if (i % 3 == 0) {
+            trace.push_back(marked[(i / 3) % marked.size()]);
+        }
+    }
+    return trace;
+}
+
+std::vector<std::size_t> autoTuneSamples() {
+    std::vector<std::size_t> samples;
+    for (std::size_t i = 0; i < kSequenceFrames; i += 100) {
+        samples.push_back(i);
+    }
+    return samples;
+}
+
+// Auto-tune: the sample frames scored once per parameter set, with stretches of playback in between, then one
+// full analysis pass.
+std::vector<std::size_t> autoTuneThenAnalysis() {
+    std::vector<std::size_t> trace;
+    for (std::size_t pass = 0; pass < 6; ++pass) {
+        for (const std::size_t sample : autoTuneSamples()) {
+            trace.push_back(sample);
+        }
+        for (std::size_t i = pass * 500; i < pass * 500 + 500; ++i) {
+            trace.push_back(i);
+        }
+    }
+    for (std::size_t i = 0; i < kSequenceFrames; ++i) {
+        trace.push_back(i);
+    }
+    return trace;
+}
+
+// Scrubbing: a random walk with short jumps around a few regions.
+std::vector<std::size_t> scrubbing() {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> step(-6, 6);
+    std::uniform_int_distribution<std::size_t> region(0, 4);
+    std::vector<std::size_t> trace;
+    long position = 0;
+    for (int i = 0; i < 6000; ++i) {
+        if (i % 500 == 0) {
+            position = static_cast<long>(region(random) * 600);
+        }
+        position = std::clamp<long>(position + step(random), 0, static_cast<long>(kSequenceFrames) - 1);
+        trace.push_back(static_cast<std::size_t>(position));
+    }
+    return trace;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t capacity = 48;
+    std::vector<std::size_t> pinned;
+    struct Session {
+        std::string name;
+        std::vector<std::size_t> trace;
+        std::vector<std::size_t> pinned;
+    };
+    std::vector<Session> sessions;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        std::string error;
+        if (arg == "--capacity" && i + 1 < argc) {
+            capacity = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--pin" && i + 1 < argc) {
+            if (!FrameCacheTrace::load(argv[++i], pinned, error)) {
+                std::cerr << error << '\n';
+                return 1;
+            }
+        } else {
+            std::vector<std::size_t> trace;
+            if (!FrameCacheTrace::load(arg, trace, error)) {
+                std::cerr << error << '\n';
+                return 1;
+            }
+            sessions.push_back({arg, std::move(trace), {}});
+        }
+    }
+    if (sessions.empty()) {
+        sessions.push_back({"playback + revisits", playbackWithRevisits(), {}});
+        sessions.push_back({"auto-tune + analysis", autoTuneThenAnalysis(), {}});
+        sessions.push_back({"auto-tune + analysis", autoTuneThenAnalysis(), autoTuneSamples()});
+        sessions.push_back({"scrubbing", scrubbing(), {}});
+    }
+    if (!pinned.empty()) {
+        for (Session& session : sessions) {
+            session.pinned = pinned;
+        }
+    }
+
+    std::cout << "capacity " << capacity << " frames\n";
+    for (const auto& [name, trace, pins] : sessions) {
+        std::cout << name << " (" << trace.size() << " requests";
+        if (!pins.empty()) {
+            std::cout << ", " << pins.size() << " frames pinned";
+        }
+        std::cout << ")\n";
+        for (const CachePolicyKind kind : {CachePolicyKind::Lru, CachePolicyKind::TwoQueue, CachePolicyKind::TinyLfu}) {
+            auto policy = makeCachePolicy(kind);
+            const std::string policy_name = policy->name();
+            const FrameCacheStats stats = FrameCacheTrace::replay(trace, capacity, std::move(policy), pins);
+            std::cout << "  " << std::left << std::setw(8) << policy_name << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(6) << stats.hitRate() * 100.0 << "% hits" << std::setw(8)
+                      << stats.evictions << " evictions" << std::setw(8) << stats.rejected << " rejected\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Compression ratio and encode / decode cost of FrameCodec, and how many frames the compressed cache tier adds.
+//
+// Usage: frame_codec_bench [directory] [--frames N] [--noise SIGMA] [--budget MB]
+// Without a directory, N synthetic 2304x2304 16-bit frames are generated: a smooth illumination gradient,
+// Gaussian sensor noise of SIGMA counts and a grid of bright droplets. With a directory, its first N frames are
+// read through ImageSequenceSource. The effective frame count is projected for splits of the cache budget
+// (default 512 MB) between the raw tier and the compressed tier, from the mean compressed size measured here.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "ImageSequenceSource.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+cv::Mat syntheticFrame(int size, double noise_sigma, unsigned seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<double> noise(0.0, noise_sigma);
+    cv::Mat frame(size, size, CV_16UC1);
+    for (int y = 0; y < size; ++y) {
+        auto* row = frame.ptr<std::uint16_t>(y);
+        for (int x = 0; x < size; ++x) {
+            double value = 1800.0 + 0.15 * x + 0.1 * y + noise(random);
+            const double dx = (x + seed * 3) % 160 - 80.0;
+            const double dy = y % 160 - 80.0;
+            const double r2 = dx * dx + dy * dy;
+            if (r2 < 45.0 * 45.0) {
+                value += 6000.0 * (1.0 - r2 / (45.0 * 45.0));
+            }
+            row[x] = static_cast<std::uint16_t>(std::clamp(value, 0.0, 65535.0));
+        }
+    }
+    return frame;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::size_t frames = 8;
+    double noise_sigma = 12.0;
+    double budget_mb = 512.0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--noise" && i + 1 < argc) {
+            noise_sigma = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget_mb = std::strtod(argv[++i], nullptr);
+        } else {
+            directory = arg;
+        }
+    }
+
+    std::vector<cv::Mat> images;
+    if (directory.empty()) {
+        for (std::size_t f = 0; f < frames; ++f) {
+            images.push_back(syntheticFrame(2304, noise_sigma, static_cast<unsigned>(f)));
+        }
+    } else {
+        ImageSequenceSource source(directory, 1.0);
+        std::string error;
+        if (!source.load(error)) {
+            std::cerr << error << '\n';
+            return 1;
+        }
+        for (std::size_t f = 0; f < std::min(frames, source.getTotalFrames()); ++f) {
+            images.push_back(source.getFrame(f).clone());
+        }
+    }
+
+    double encode_ms = 0.0;
+    double decode_ms = 0.0;
+    double scalar_ms = 0.0;
+    std::size_t raw_bytes = 0;
+    std::size_t encoded_bytes = 0;
+    for (const cv::Mat& image : images) {
+        EncodedFrame encoded;
+        auto begin = Clock::now();
+        if (!FrameCodec::encode(image, encoded)) {
+            std::cerr << "unsupported frame type\n";
+            return 1;
+        }
+        encode_ms += millisecondsSince(begin);
+        cv::Mat decoded;
+        begin = Clock::now();
+        FrameCodec::decode(encoded, decoded);
+        decode_ms += millisecondsSince(begin);
+        begin = Clock::now();
+        FrameCodec::decodeScalar(encoded, decoded);
+        scalar_ms += millisecondsSince(begin);
+        raw_bytes += encoded.rawBytes();
+        encoded_bytes += encoded.bytes.size();
+    }
+
+    const double count = static_cast<double>(images.size());
+    const double raw_mb = static_cast<double>(raw_bytes) / count / (1024.0 * 1024.0);
+    const double encoded_mb = static_cast<double>(encoded_bytes) / count / (1024.0 * 1024.0);
+    std::cout << std::fixed << std::setprecision(2) << images.size() << " frames of " << raw_mb << " MB, compressed to "
+              << encoded_mb << " MB (ratio " << raw_mb / encoded_mb << ")\n";
+    std::cout << "encode          " << encode_ms / count << " ms/frame\n";
+    std::cout << "decode ("
+              << (FrameCodec::simdDecode() ? "SSE2)  " : "scalar)") << " " << decode_ms / count << " ms/frame, "
+              << raw_mb * 1000.0 / (decode_ms / count) << " MB/s\n";
+    std::cout << "decode (scalar) " << scalar_ms / count << " ms/frame\n";
+
+    std::cout << "effective frames in " << budget_mb << " MB:\n";
+    for (const double compressed_share : {0.0, 0.25, 0.5, 0.75}) {
+        const double raw_frames = std::floor(budget_mb * (1.0 - compressed_share) / raw_mb);
+        const double compressed_frames = std::floor(budget_mb * compressed_share / encoded_mb);
+        std::cout << "  " << std::setw(3) << static_cast<int>(compressed_share * 100.0) << "% compressed: "
+                  << std::setw(5) << static_cast<int>(raw_frames + compressed_frames) << " ("
+                  << static_cast<int>(raw_frames) << " raw + " << static_cast<int>(compressed_frames)
+                  << " compressed)\n";
+    }
+    return 0;
+}
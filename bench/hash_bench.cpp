@@ -0,0 +1,108 @@
+// SHA-256 throughput of each kernel HashUtils supports on this CPU.
+//
+// Usage: hash_bench <scratch directory> [--mb N] [--files F]
+// Hashes an N MB buffer in memory (default 256), then F files of N/F MB each (default 8) written to the scratch
+// directory, one at a time and through sha256HexFiles(). File rates include the page cache; drop it between runs
+// to measure the disk instead.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HashUtils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+std::vector<std::byte> patternBytes(std::size_t size, unsigned int seed) {
+    std::vector<std::byte> bytes(size);
+    unsigned int value = seed;
+    for (auto& byte : bytes) {
+        value = value * 1103515245U + 12345U;
+        byte = static_cast<std::byte>(value >> 24U);
+    }
+    return bytes;
+}
+
+void report(const char* what, double megabytes, double seconds, const std::string& digest) {
+    std::cout << "  " << std::left << std::setw(18) << what << std::right << std::fixed << std::setprecision(0)
+              << std::setw(7) << megabytes / seconds << " MB/s   [" << digest.substr(0, 16) << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: hash_bench <scratch directory> [--mb N] [--files F]\n";
+        return 1;
+    }
+    const std::filesystem::path directory = argv[1];
+    std::size_t megabytes = 256;
+    std::size_t file_count = 8;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--mb" && i + 1 < argc) {
+            megabytes = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--files" && i + 1 < argc) {
+            file_count = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Unknown argument: " << arg << '\n';
+            return 1;
+        }
+    }
+
+    const std::vector<std::byte> buffer = patternBytes(megabytes << 20U, 1);
+    std::vector<std::filesystem::path> paths;
+    const std::size_t file_bytes = buffer.size() / file_count;
+    for (std::size_t i = 0; i < file_count; ++i) {
+        paths.push_back(directory / ("hash_bench_" + std::to_string(i) + ".bin"));
+        std::ofstream(paths.back(), std::ios::binary)
+            .write(reinterpret_cast<const char*>(buffer.data() + i * file_bytes), static_cast<std::streamsize>(file_bytes));
+    }
+    const double files_mb = static_cast<double>(file_bytes * file_count) / (1024.0 * 1024.0);
+
+    const HashUtils::Sha256Kernel kernels[] = {HashUtils::Sha256Kernel::Portable, HashUtils::Sha256Kernel::ShaNi,
+                                               HashUtils::Sha256Kernel::Avx2MultiBuffer};
+    const HashUtils::Sha256Kernel default_kernel = HashUtils::sha256Kernel();
+    std::cout << megabytes << " MB, " << file_count << " files; default kernel "
+              << HashUtils::sha256KernelName(default_kernel) << '\n';
+    for (const auto kernel : kernels) {
+        if (!HashUtils::setSha256Kernel(kernel)) {
+            std::cout << HashUtils::sha256KernelName(kernel) << ": not supported\n";
+            continue;
+        }
+        std::cout << HashUtils::sha256KernelName(kernel) << '\n';
+        auto begin = Clock::now();
+        const std::string digest = HashUtils::sha256Hex(buffer);
+        report("memory", static_cast<double>(megabytes), secondsSince(begin), digest);
+
+        begin = Clock::now();
+        std::string last;
+        for (const auto& path : paths) {
+            last = HashUtils::sha256HexFile(path);
+        }
+        report("files, one by one", files_mb, secondsSince(begin), last);
+
+        begin = Clock::now();
+        const auto digests = HashUtils::sha256HexFiles(paths);
+        report("sha256HexFiles", files_mb, secondsSince(begin), digests.back());
+    }
+    HashUtils::setSha256Kernel(default_kernel);
+
+    for (const auto& path : paths) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Read latency of ImageSequenceSource (memory-mapped, zero-copy where possible) against plain libtiff reads.
+//
+// Usage: image_sequence_read_bench [directory] [--frames N] [--passes P] [--scan-threads T]
+// Without a directory, N synthetic 2304x2304 16-bit uncompressed TIFFs (10.6 MB each) are written to a
+// temporary directory first. The page cache state is not controlled: run once after dropping caches for
+// cold numbers, or repeat for warm ones. Every frame is fully summed so lazily mapped pages are faulted in.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef DROPLET_WITH_TIFF
+#include <tiffio.h>
+#endif
+
+#include "ImageSequenceSource.h"
+#include "TiffFormat.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+std::uint64_t touch(const cv::Mat& image) {
+    std::uint64_t sum = 0;
+    for (int y = 0; y < image.rows; ++y) {
+        if (image.depth() == CV_16U) {
+            const auto* row = image.ptr<std::uint16_t>(y);
+            for (int x = 0; x < image.cols; ++x) {
+                sum += row[x];
+            }
+        } else {
+            const auto* row = image.ptr<std::uint8_t>(y);
+            for (int x = 0; x < image.cols; ++x) {
+                sum += row[x];
+            }
+        }
+    }
+    return sum;
+}
+
+void report(const std::string& name, double first_ms, std::vector<double> steady_ms) {
+    std::sort(steady_ms.begin(), steady_ms.end());
+    const auto at = [&steady_ms](double q) {
+        return steady_ms.empty() ? 0.0 : steady_ms[static_cast<std::size_t>(q * static_cast<double>(steady_ms.size() - 1))];
+    };
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(3)
+              << " first " << std::setw(9) << first_ms << " ms"
+              << "   steady median " << std::setw(9) << at(0.5) << " ms"
+              << "   p95 " << std::setw(9) << at(0.95) << " ms" << '\n';
+}
+
+#ifdef DROPLET_WITH_TIFF
+cv::Mat readWithLibtiff(const std::string& path) {
+    TIFF* tif = TIFFOpen(path.c_str(), "r");
+    if (tif == nullptr) {
+        return {};
+    }
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint16_t bits = 8;
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bits);
+    cv::Mat image(static_cast<int>(height), static_cast<int>(width), bits == 16 ? CV_16UC1 : CV_8UC1);
+    for (std::uint32_t row = 0; row < height; ++row) {
+        if (TIFFReadScanline(tif, image.ptr(static_cast<int>(row)), row) < 0) {
+            image.release();
+            break;
+        }
+    }
+    TIFFClose(tif);
+    return image;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::size_t frames = 24;
+    std::size_t passes = 3;
+    std::size_t scan_threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--passes" && i + 1 < argc) {
+            passes = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--scan-threads" && i + 1 < argc) {
+            scan_threads = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            directory = arg;
+        }
+    }
+
+    std::filesystem::path synthetic;
+    if (directory.empty()) {
+        synthetic = std::filesystem::temp_directory_path() / "droplet_image_sequence_bench";
+        std::filesystem::create_directories(synthetic);
+        cv::Mat image(2304, 2304, CV_16UC1);
+        for (std::size_t f = 0; f < frames; ++f) {
+            for (int y = 0; y < image.rows; ++y) {
+                auto* row = image.ptr<std::uint16_t>(y);
+                for (int x = 0; x < image.cols; ++x) {
+                    row[x] = static_cast<std::uint16_t>(x * 7 + y * 3 + f * 11);
+                }
+            }
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05zu.tif", f);
+            std::string error;
+            if (!TiffFormat::writeGrayscale(synthetic / name, image, error)) {
+                std::cerr << error << '\n';
+                return 1;
+            }
+        }
+        directory = synthetic.string();
+    }
+
+    ImageSequenceSource source(directory, 1.0, scan_threads);
+    std::string error;
+    auto begin = Clock::now();
+    if (!source.load(error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    const double load_ms = millisecondsSince(begin);
+    const std::size_t total = source.getTotalFrames();
+    std::cout << total << " frames, " << source.frameSize().width << "x" << source.frameSize().height
+              << ", load " << std::fixed << std::setprecision(3) << load_ms << " ms\n";
+    const SequenceValidationReport& validation = source.validationReport();
+    std::cout << "time to ready " << validation.time_to_ready_seconds * 1000.0 << " ms (enumerate "
+              << validation.enumerate_seconds * 1000.0 << " ms, validate " << validation.sampled_files << " headers on "
+              << validation.threads << " threads " << validation.validate_seconds * 1000.0 << " ms, "
+              << validation.header_bytes_read << " header bytes read, " << validation.reused_headers
+              << " headers from the index)\n";
+
+    std::uint64_t checksum = 0;
+    std::vector<double> steady;
+
+    begin = Clock::now();
+    checksum += touch(source.getFrame(0));
+    const double mapped_first = millisecondsSince(begin);
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+        for (std::size_t i = 0; i < total; ++i) {
+            begin = Clock::now();
+            checksum += touch(source.getFrame(i));
+            steady.push_back(millisecondsSince(begin));
+        }
+    }
+    report("mmap", mapped_first, steady);
+    const auto stats = source.readStats();
+    std::cout << "  zero-copy " << stats.zero_copy_frames << ", decoded " << stats.decoded_frames << ", libtiff "
+              << stats.libtiff_frames << '\n';
+    // Headers parsed during the passes go into the index, so the next run on this directory starts from it.
+    source.updateIndex();
+
+#ifdef DROPLET_WITH_TIFF
+    steady.clear();
+    begin = Clock::now();
+    checksum += touch(readWithLibtiff(source.framePath(0)));
+    const double libtiff_first = millisecondsSince(begin);
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+        for (std::size_t i = 0; i < total; ++i) {
+            begin = Clock::now();
+            checksum += touch(readWithLibtiff(source.framePath(i)));
+            steady.push_back(millisecondsSince(begin));
+        }
+    }
+    report("libtiff", libtiff_first, steady);
+#else
+    std::cout << "libtiff comparison skipped (built without DROPLET_WITH_TIFF)\n";
+#endif
+
+    std::cout << "checksum " << checksum << '\n';
+    if (!synthetic.empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(synthetic, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Per-frame cost of LineScanAnalyzer::push() against the 2304x4, 8938 FPS line mode (spec 3.5 AC-R4).
+//
+// Usage: line_scan_bench [--frames N] [--16bit]
+// N (default 200000) synthetic strips are pushed: a noisy background with a dark droplet crossing the probe region
+// every 50 frames, cycled from a small set so generating them is not measured. Reports microseconds per frame and the
+// headroom over the camera's frame rate; the exit status is 1 when push() cannot keep up with the camera.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "LineScanAnalysis.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double kCameraFps = 8938.0;
+constexpr int kWidth = 2304;
+constexpr int kRows = 4;
+constexpr std::size_t kPeriod = 50;
+constexpr std::size_t kDuration = 12;
+
+cv::Mat syntheticStrip(std::size_t index, bool sixteen_bit, std::mt19937& random) {
+    std::uniform_real_distribution<double> noise(-4.0, 4.0);
+    const double scale = sixteen_bit ? 200.0 : 1.0;
+    const bool droplet = index % kPeriod < kDuration;
+    cv::Mat strip(kRows, kWidth, sixteen_bit ? CV_16UC1 : CV_8UC1);
+    for (int y = 0; y < kRows; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            const double value = ((droplet && x >= 900 && x < 1400) ? 70.0 : 200.0) + noise(random);
+            if (sixteen_bit) {
+                strip.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(value * scale);
+            } else {
+                strip.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(value);
+            }
+        }
+    }
+    return strip;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t frames = 200000;
+    bool sixteen_bit = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frames = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--16bit") {
+            sixteen_bit = true;
+        }
+    }
+
+    std::mt19937 random(1);
+    std::vector<cv::Mat> strips;
+    for (std::size_t i = 0; i < 2 * kPeriod; ++i) {
+        strips.push_back(syntheticStrip(i, sixteen_bit, random));
+    }
+
+    LineScanParams params;
+    params.probe_begin = 1000;
+    params.probe_end = 1200;
+    LineScanAnalyzer analyzer(params);
+    const auto begin = Clock::now();
+    for (std::size_t i = 0; i < frames; ++i) {
+        analyzer.push(strips[i % strips.size()], static_cast<double>(i) / kCameraFps);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    const LineScanSummary summary = analyzer.summary();
+    const double fps = static_cast<double>(frames) / seconds;
+    std::cout << std::fixed << std::setprecision(2) << frames << " strips of " << kWidth << "x" << kRows << ", "
+              << (sixteen_bit ? 16 : 8) << "-bit: " << seconds * 1.0e6 / static_cast<double>(frames) << " us/frame, "
+              << std::setprecision(0) << fps << " frames/s (" << std::setprecision(1) << fps / kCameraFps
+              << "x the camera's " << std::setprecision(0) << kCameraFps << " FPS), " << summary.passages
+              << " passages\n";
+    return fps >= kCameraFps ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// Per-frame allocation cost of the Tier A detection pipeline with OpenCV's standard allocator against
+// PooledMatAllocator (with and without huge pages).
+//
+// Usage: mat_pool_bench [--frames N] [--passes P]
+// N synthetic 2304x2304 16-bit frames (Tier A) are cropped to the 1800x1800 ROI, run through the running background
+// subtractor and droplet detection, P times per allocator. Every intermediate image (float accumulator, converted,
+// blurred and binary images) is allocated and freed per frame, which is what the pool recycles. Reported: mean and
+// p95 ms per frame, and page faults per frame (getrusage; POSIX only).
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "BackgroundSubtraction.h"
+#include "DropletDetection.h"
+#include "PooledMatAllocator.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+long pageFaults() {
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+#endif
+}
+
+cv::Mat syntheticFrame(int size, unsigned seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<double> noise(0.0, 12.0);
+    cv::Mat frame(size, size, CV_16UC1);
+    for (int y = 0; y < size; ++y) {
+        auto* row = frame.ptr<std::uint16_t>(y);
+        for (int x = 0; x < size; ++x) {
+            double value = 1800.0 + noise(random);
+            const double dx = (x + seed * 7) % 120 - 60.0;
+            const double dy = y % 120 - 60.0;
+            const double r2 = dx * dx + dy * dy;
+            if (r2 < 30.0 * 30.0) {
+                value += 9000.0;
+            }
+            row[x] = static_cast<std::uint16_t>(std::clamp(value, 0.0, 65535.0));
+        }
+    }
+    return frame;
+}
+
+struct RunResult {
+    std::vector<double> frame_ms;
+    long faults = 0;
+    std::size_t detections = 0;
+};
+
+RunResult runPipeline(const std::vector<cv::Mat>& frames, std::size_t passes) {
+    const int roi = 1800;
+    const cv::Rect roi_rect((frames.front().cols - roi) / 2, (frames.front().rows - roi) / 2, roi, roi);
+    DropletDetectionParams params;
+    params.min_area_px2 = 100.0;
+
+    RunResult result;
+    const long faults_before = pageFaults();
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+        RunningExponentialBackgroundSubtractor background;
+        for (const cv::Mat& frame : frames) {
+            const auto begin = Clock::now();
+            const cv::Mat foreground = background.apply(frame(roi_rect));
+            result.detections += detectDroplets(foreground, params).size();
+            result.frame_ms.push_back(millisecondsSince(begin));
+        }
+    }
+    result.faults = pageFaults() - faults_before;
+    return result;
+}
+
+void report(const std::string& name, RunResult result) {
+    std::sort(result.frame_ms.begin(), result.frame_ms.end());
+    double total = 0.0;
+    for (const double ms : result.frame_ms) {
+        total += ms;
+    }
+    const double count = static_cast<double>(result.frame_ms.size());
+    const double p95 = result.frame_ms[static_cast<std::size_t>(0.95 * (count - 1))];
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(2)
+              << " mean " << std::setw(8) << total / count << " ms/frame"
+              << "   p95 " << std::setw(8) << p95 << " ms"
+              << "   page faults " << std::setw(9) << static_cast<double>(result.faults) / count << " /frame"
+              << "   (" << result.detections << " detections)\n";
+}
+
+void reportPool(const PooledMatAllocator& pool) {
+    const PooledMatAllocatorStats stats = pool.stats();
+    std::cout << std::setw(16) << "" << "pool: " << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.unpooled << " unpooled, " << stats.released << " released, "
+              << std::setprecision(1) << static_cast<double>(stats.bytes_retained) / (1024.0 * 1024.0)
+              << " MB retained\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t frame_count = 24;
+    std::size_t passes = 2;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frame_count = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--passes" && i + 1 < argc) {
+            passes = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Unknown argument: " << arg << '\n';
+            return 1;
+        }
+    }
+
+    std::vector<cv::Mat> frames;
+    for (std::size_t f = 0; f < frame_count; ++f) {
+        frames.push_back(syntheticFrame(2304, static_cast<unsigned>(f)));
+    }
+    std::cout << frame_count << " frames x " << passes << " passes, 2304x2304 16-bit, ROI 1800x1800\n";
+
+    report("std allocator", runPipeline(frames, passes));
+
+    {
+        const auto pool = PooledMatAllocator::create();
+        const ScopedMatAllocator guard(pool);
+        report("pooled", runPipeline(frames, passes));
+        reportPool(*pool);
+    }
+
+    {
+        PooledMatAllocatorParams params;
+        params.huge_pages = true;
+        const auto pool = PooledMatAllocator::create(params);
+        const ScopedMatAllocator guard(pool);
+        report("pooled + THP", runPipeline(frames, passes));
+        reportPool(*pool);
+    }
+    return 0;
+}
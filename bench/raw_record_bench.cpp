@@ -0,0 +1,122 @@
+// Sustained write rate of RawRecorder, and read-back rate of RawRecordingSource.
+//
+// Usage: raw_record_bench <output directory> [--frames N] [--fps F]
+// N synthetic 2304x2304 16-bit frames (Tier A) are handed to the recorder at F frames per second (0 = as fast as
+// possible), with and without direct I/O. Reported: MB/s accepted, frames dropped, longest record() call, and the
+// rate at which the recording is read back and summed through the mapping.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "RawRecording.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void runOnce(const std::filesystem::path& path, bool direct_io, std::size_t frame_count, double fps) {
+    StreamFrame frame;
+    frame.image = cv::Mat(2304, 2304, CV_16UC1);
+    for (int y = 0; y < frame.image.rows; ++y) {
+        auto* row = frame.image.ptr<std::uint16_t>(y);
+        for (int x = 0; x < frame.image.cols; ++x) {
+            row[x] = static_cast<std::uint16_t>(1800 + (x * 7 + y * 13) % 97);
+        }
+    }
+    const double frame_mb = static_cast<double>(frame.image.total() * frame.image.elemSize()) / (1024.0 * 1024.0);
+
+    RawRecorderParams params;
+    params.direct_io = direct_io;
+    RawRecorder recorder(params);
+    std::string error;
+    if (!recorder.open(path.string(), frame.image.size(), frame.image.type(), fps, error)) {
+        std::cerr << error << '\n';
+        return;
+    }
+    double slowest_ms = 0.0;
+    const auto begin = Clock::now();
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        if (fps > 0.0) {
+            std::this_thread::sleep_until(begin + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(static_cast<double>(i) / fps)));
+        }
+        frame.frame_index = i;
+        frame.timestamp = fps > 0.0 ? static_cast<double>(i) / fps : 0.0;
+        const auto call = Clock::now();
+        recorder.record(frame);
+        slowest_ms = std::max(slowest_ms, secondsSince(call) * 1000.0);
+    }
+    const double record_seconds = secondsSince(begin);
+    if (!recorder.finish(error)) {
+        std::cerr << error << '\n';
+        return;
+    }
+    const double total_seconds = secondsSince(begin);
+    const RawRecorderStats stats = recorder.stats();
+
+    std::cout << std::left << std::setw(10) << (stats.direct_io ? "direct" : "buffered") << std::right << std::fixed
+              << std::setprecision(1) << " accepted " << std::setw(7)
+              << static_cast<double>(stats.frames_recorded) * frame_mb / record_seconds << " MB/s"
+              << "   on disk " << std::setw(7) << static_cast<double>(stats.bytes_written) / (1024.0 * 1024.0) / total_seconds
+              << " MB/s   dropped " << stats.frames_dropped << "/" << frame_count << "   slowest record() "
+              << std::setprecision(2) << slowest_ms << " ms\n";
+
+    RawRecordingSource source(path.string());
+    if (!source.load(error)) {
+        std::cerr << error << '\n';
+        return;
+    }
+    const auto read_begin = Clock::now();
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < source.getTotalFrames(); ++i) {
+        const cv::Mat image = source.getFrame(i);
+        for (int y = 0; y < image.rows; y += 64) {
+            sum += image.ptr<std::uint16_t>(y)[0];
+        }
+    }
+    std::cout << std::setw(10) << "" << " read back " << std::setprecision(0)
+              << static_cast<double>(source.getTotalFrames()) / secondsSince(read_begin) << " frames/s (zero-copy)"
+              << "   [checksum " << sum << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: raw_record_bench <output directory> [--frames N] [--fps F]\n";
+        return 1;
+    }
+    const std::filesystem::path directory = argv[1];
+    std::size_t frame_count = 200;
+    double fps = 0.0;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frame_count = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::strtod(argv[++i], nullptr);
+        } else {
+            std::cerr << "Unknown argument: " << arg << '\n';
+            return 1;
+        }
+    }
+
+    std::cout << frame_count << " frames, 2304x2304 16-bit, " << (fps > 0.0 ? std::to_string(fps) + " FPS" : "unpaced")
+              << '\n';
+    const std::filesystem::path path = directory / "raw_record_bench.draw";
+    runOnce(path, true, frame_count, fps);
+    runOnce(path, false, frame_count, fps);
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return 0;
+}
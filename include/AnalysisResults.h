@@ -1,32 +1,171 @@
 #pragma once
 
-#include <any>
+#include "DataModels.h"
+#include "MemoryGovernor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (IAnalysisModule::run output, exportResults input)
+
+template <std::size_t N>
+struct ResultKeyName {
+    constexpr ResultKeyName(const char (&text)[N]) { std::copy_n(text, N, value); }
+    char value[N]{};
+};
+
+// Compile-time result key. The value type and name are part of the key type, so lookups resolve to a
+// fixed slot index instead of hashing a string and any_cast'ing.
+template <typename T, ResultKeyName Name>
+struct ResultKey {
+    using value_type = T;
+    static constexpr std::string_view name() { return {Name.value, sizeof(Name.value) - 1}; }
+};
+
+using FrameDetectionsKey = ResultKey<std::vector<FrameDetections>, "frame_detections">;
+using TracksKey = ResultKey<std::vector<Track>, "tracks">;
+
+namespace AnalysisResultsDetail {
+
+inline std::size_t nextSlotIndex() {
+    static std::atomic<std::size_t> next_index{0};
+    return next_index.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename Key>
+std::size_t slotIndex() {
+    static const std::size_t index = nextSlotIndex();
+    return index;
+}
 
+template <typename T>
+std::size_t valueBytes(const T& value) {
+    if constexpr (requires { approximateMemoryBytes(value); }) {
+        return approximateMemoryBytes(value);
+    } else {
+        return sizeof(T);
+    }
+}
+
+// Keeps a stored value charged to the memory governor until the last view of it is gone.
+template <typename T>
+struct ChargedValue {
+    std::shared_ptr<const T> value;
+    MemoryCharge charge;
+};
+
+} // namespace AnalysisResultsDetail
+
+// Values are immutable once stored and held through shared_ptr<const T>: copying an AnalysisResults or
+// handing a result to an exporter via share<Key>() never copies the payload. Each stored value is charged to
+// MemoryGovernor::global() under MemoryCategory::Results (by its approximate size) for as long as any copy of the
+// results or any shared view still refers to it.
 class AnalysisResults final {
 public:
+    struct EntryReport {
+        std::string_view name;
+        std::size_t bytes = 0;
+    };
+
     AnalysisResults() = default;
 
-    template <typename T>
-    void set(std::string key, T value) {
-        values_.insert_or_assign(std::move(key), std::any(std::move(value)));
+    // Move-only insertion; pass std::move(value) so multi-GB results are never copied.
+    template <typename Key>
+    void set(typename Key::value_type&& value) {
+        using T = typename Key::value_type;
+        setShared<Key>(std::make_shared<const T>(std::move(value)));
+    }
+
+    template <typename Key>
+    void setShared(std::shared_ptr<const typename Key::value_type> value) {
+        if (!value) {
+            throw std::invalid_argument("AnalysisResults value must not be null: " + std::string(Key::name()));
+        }
+        using T = typename Key::value_type;
+        const std::size_t bytes = AnalysisResultsDetail::valueBytes(*value);
+        const T* payload = value.get();
+        auto charged = std::make_shared<const AnalysisResultsDetail::ChargedValue<T>>(
+            AnalysisResultsDetail::ChargedValue<T>{std::move(value), MemoryCharge(MemoryCategory::Results, bytes)});
+        auto& slot = slotFor(AnalysisResultsDetail::slotIndex<Key>());
+        slot.name = Key::name();
+        slot.bytes = bytes;
+        // Views share the charge's lifetime but point straight at the payload.
+        slot.value = std::shared_ptr<const void>(std::move(charged), payload);
+    }
+
+    template <typename Key>
+    bool has() const {
+        const auto index = AnalysisResultsDetail::slotIndex<Key>();
+        return index < slots_.size() && slots_[index].value != nullptr;
+    }
+
+    bool has(std::string_view name) const {
+        return std::any_of(slots_.begin(), slots_.end(),
+                           [name](const Slot& slot) { return slot.value != nullptr && slot.name == name; });
+    }
+
+    template <typename Key>
+    const typename Key::value_type& get() const {
+        return *share<Key>();
     }
 
-    bool has(const std::string& key) const { return values_.contains(key); }
+    // Shared immutable view that stays valid after the entry is replaced or the results object is gone.
+    template <typename Key>
+    std::shared_ptr<const typename Key::value_type> share() const {
+        using T = typename Key::value_type;
+        const auto index = AnalysisResultsDetail::slotIndex<Key>();
+        if (index >= slots_.size() || slots_[index].value == nullptr) {
+            throw std::out_of_range("AnalysisResults missing key: " + std::string(Key::name()));
+        }
+        return std::static_pointer_cast<const T>(slots_[index].value);
+    }
 
-    template <typename T>
-    const T& get(const std::string& key) const {
-        const auto it = values_.find(key);
-        if (it == values_.end()) {
-            throw std::out_of_range("AnalysisResults missing key: " + key);
+    template <typename Key>
+    void erase() {
+        const auto index = AnalysisResultsDetail::slotIndex<Key>();
+        if (index < slots_.size()) {
+            slots_[index] = Slot{};
         }
-        return std::any_cast<const T&>(it->second);
+    }
+
+    std::vector<EntryReport> memoryReport() const {
+        std::vector<EntryReport> report;
+        for (const auto& slot : slots_) {
+            if (slot.value != nullptr) {
+                report.push_back(EntryReport{slot.name, slot.bytes});
+            }
+        }
+        return report;
+    }
+
+    std::size_t totalBytes() const {
+        std::size_t total = 0;
+        for (const auto& slot : slots_) {
+            total += slot.value != nullptr ? slot.bytes : 0;
+        }
+        return total;
     }
 
 private:
-    std::unordered_map<std::string, std::any> values_;
-};
+    struct Slot {
+        std::shared_ptr<const void> value;
+        std::string_view name;
+        std::size_t bytes = 0;
+    };
 
+    Slot& slotFor(std::size_t index) {
+        if (index >= slots_.size()) {
+            slots_.resize(index + 1);
+        }
+        return slots_[index];
+    }
+
+    std::vector<Slot> slots_;
+};
@@ -5,6 +5,8 @@
 
 #include <opencv2/core.hpp>
 
+#include "MemoryGovernor.h"
+
 enum class BackgroundSubtractionMethod {
     None,
     StaticMedian,
@@ -30,6 +32,8 @@ public:
 private:
     RunningExponentialBackgroundParams params_;
     cv::Mat background_accum_;
+    // The float accumulator, charged to the global memory governor.
+    MemoryCharge accum_charge_{MemoryCategory::Background};
     int expected_type_ = -1;
     cv::Size expected_size_;
 };
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Storage: NVMe SSD, read >3 GB/s)
+
+class ThreadPool;
+
+// One byte range of a file, read into caller-owned memory.
+struct BatchReadRequest {
+    std::string path;
+    std::uint64_t offset = 0;
+    std::size_t length = 0;
+    // Fewer bytes are accepted once this many have arrived (0 = length). Direct I/O ranges are rounded up to
+    // whole blocks and may run past the end of the file.
+    std::size_t required = 0;
+    std::uint8_t* destination = nullptr;
+};
+
+enum class BatchReadBackend { IoUring, ThreadPool };
+
+struct BatchReadParams {
+    // false forces the pread thread-pool backend.
+    bool use_io_uring = true;
+    // Reads in flight at once (io_uring ring size / pread worker threads).
+    std::size_t queue_depth = 32;
+    // Open files with O_DIRECT (Linux) to bypass the page cache. Requests must then start at, and have lengths
+    // and destinations aligned to, kDirectIoAlignment; prepareFrame() takes care of that. Files on filesystems
+    // without direct I/O support (tmpfs) are read through the page cache instead.
+    bool direct_io = false;
+};
+
+struct BatchReadStats {
+    std::size_t batches = 0;
+    std::size_t requests = 0;
+    std::size_t bytes = 0;
+    // io_uring_enter / pread system calls.
+    std::size_t system_calls = 0;
+    // Reads the kernel completed only partially and that were resubmitted for the remainder.
+    std::size_t short_reads = 0;
+    // Files that had to be opened without O_DIRECT although it was requested.
+    std::size_t direct_io_fallbacks = 0;
+};
+
+// A frame read straight into a freshly allocated, page-aligned buffer: `frame` views the pixels inside it (and
+// keeps it alive); `request` fills it.
+struct PreparedFrameRead {
+    BatchReadRequest request;
+    cv::Mat frame;
+};
+
+// Reads many byte ranges concurrently so fast NVMe devices see a deep queue instead of one blocking read per
+// frame. On Linux the requests are submitted through an io_uring instance owned by the reader (raw system calls,
+// no liburing); elsewhere, or when the kernel does not allow io_uring, the same batches are served by a pool of
+// threads issuing pread(). read() blocks until the whole batch is done. Not thread-safe: use one reader per thread.
+class BatchFrameReader {
+public:
+    static constexpr std::size_t kDirectIoAlignment = 4096;
+
+    explicit BatchFrameReader(const BatchReadParams& params = {});
+    ~BatchFrameReader();
+
+    BatchFrameReader(const BatchFrameReader&) = delete;
+    BatchFrameReader& operator=(const BatchFrameReader&) = delete;
+
+    BatchReadBackend backend() const;
+    // Why io_uring is not in use (empty when it is, or when it was not requested).
+    const std::string& fallbackReason() const { return fallback_reason_; }
+    const BatchReadParams& params() const { return params_; }
+
+    // Fails on the first request that cannot be opened or read in full; destinations of other requests are then
+    // unspecified.
+    bool read(std::span<const BatchReadRequest> requests, std::string& error_message);
+
+    // Aligned destination for rows x cols pixels stored contiguously (rows `step` bytes apart) at pixel_offset.
+    PreparedFrameRead prepareFrame(const std::string& path, std::uint64_t pixel_offset, int rows, int cols, int type,
+                                   std::size_t step) const;
+
+    const BatchReadStats& stats() const { return stats_; }
+
+private:
+    struct Ring;
+
+    bool readWithThreads(std::span<const BatchReadRequest> requests, std::string& error_message);
+
+    BatchReadParams params_;
+    BatchReadStats stats_;
+    std::string fallback_reason_;
+    std::unique_ptr<Ring> ring_;
+    std::unique_ptr<ThreadPool> pool_;  // pread backend, created on first use
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Frame Cache (Memory-Budget Based))
+
+// Replacement policy of a FrameCache: decides which resident frame goes next and whether a newly loaded frame is
+// worth displacing it. The cache calls it under one lock, only for frames that are resident and not pinned (plus
+// accessed() for every request, pinned()/unpinned() when a resident frame changes sides and erased() when clear()
+// drops one), so implementations need no locking of their own. Calls for ids the policy does not track must be ignored: an eviction can race with
+// a hit on the same frame.
+class CachePolicy {
+public:
+    virtual ~CachePolicy() = default;
+
+    virtual const char* name() const = 0;
+    // Frames the budget holds (budget / frame size); called before the first insert and whenever it changes.
+    virtual void setCapacity(std::size_t /*frames*/) {}
+    // Every get(), before inserted() for a miss. resident = the frame was cached.
+    virtual void accessed(std::size_t id, bool resident) = 0;
+    virtual void inserted(std::size_t id) = 0;
+    virtual void erased(std::size_t id) = 0;
+    // A resident frame was pinned (it must not be offered as a victim until unpinned) or released again. Unlike
+    // erased(), pinning is not an eviction; by default the frame is forgotten and re-enters as if newly inserted.
+    virtual void pinned(std::size_t id) { erased(id); }
+    virtual void unpinned(std::size_t id) { inserted(id); }
+    virtual std::optional<std::size_t> victim() const = 0;
+    // Whether a new frame should displace `victim`; false leaves the cache unchanged and returns the new frame
+    // uncached.
+    virtual bool admit(std::size_t /*candidate*/, std::size_t /*victim*/) const { return true; }
+};
+
+enum class CachePolicyKind { Lru, TwoQueue, TinyLfu };
+
+std::unique_ptr<CachePolicy> makeCachePolicy(CachePolicyKind kind);
+// "lru", "2q" or "tinylfu".
+std::optional<CachePolicyKind> parseCachePolicyKind(const std::string& name);
+
+// Least recently used first. Not scan-resistant: one sequential pass longer than the cache flushes it.
+class LruPolicy final : public CachePolicy {
+public:
+    const char* name() const override { return "lru"; }
+    void accessed(std::size_t id, bool resident) override;
+    void inserted(std::size_t id) override;
+    void erased(std::size_t id) override;
+    std::optional<std::size_t> victim() const override;
+
+private:
+    std::list<std::size_t> order_;  // most recent first
+    std::unordered_map<std::size_t, std::list<std::size_t>::iterator> positions_;
+};
+
+// Full 2Q (Johnson & Shasha): new frames enter a FIFO probation queue of about a quarter of the cache, and only
+// frames requested again after leaving it (remembered in a ghost list of ids) enter the main LRU queue. A
+// sequential pass churns through probation and leaves the frames that are revisited alone. A pinned frame leaves
+// its queue without a ghost entry and returns to the same queue when released, so pinning cannot promote it.
+class TwoQueuePolicy final : public CachePolicy {
+public:
+    const char* name() const override { return "2q"; }
+    void setCapacity(std::size_t frames) override;
+    void accessed(std::size_t id, bool resident) override;
+    void inserted(std::size_t id) override;
+    void erased(std::size_t id) override;
+    void pinned(std::size_t id) override;
+    void unpinned(std::size_t id) override;
+    std::optional<std::size_t> victim() const override;
+
+private:
+    enum class Queue { Probation, Main, Ghost };
+    struct Position {
+        Queue queue;
+        std::list<std::size_t>::iterator it;
+    };
+
+    std::list<std::size_t>& listOf(Queue queue);
+    void remove(std::size_t id);
+
+    std::size_t probation_limit_ = 1;
+    std::size_t ghost_limit_ = 1;
+    std::list<std::size_t> probation_;  // newest first
+    std::list<std::size_t> main_;       // most recent first
+    std::list<std::size_t> ghost_;      // most recently demoted first
+    std::unordered_map<std::size_t, Position> positions_;
+    std::unordered_map<std::size_t, Queue> pinned_;  // the queue each pinned frame left
+};
+
+// LRU eviction with TinyLFU admission (Einziger, Friedman & Manes): request frequencies are estimated by a small
+// count-min sketch of 4-bit counters, halved every 10 x capacity requests so old popularity fades, and a new frame
+// only replaces the LRU victim when it has been requested more often. Frames seen once by a scan lose to frames
+// the user keeps coming back to.
+class TinyLfuPolicy final : public CachePolicy {
+public:
+    const char* name() const override { return "tinylfu"; }
+    void setCapacity(std::size_t frames) override;
+    void accessed(std::size_t id, bool resident) override;
+    void inserted(std::size_t id) override { lru_.inserted(id); }
+    void erased(std::size_t id) override { lru_.erased(id); }
+    std::optional<std::size_t> victim() const override { return lru_.victim(); }
+    bool admit(std::size_t candidate, std::size_t victim) const override;
+
+    // Estimated requests for id since the last halving (at most 15).
+    std::uint32_t frequency(std::size_t id) const;
+
+private:
+    static constexpr std::size_t kRows = 4;
+
+    std::size_t slot(std::size_t id, std::size_t row) const;
+
+    LruPolicy lru_;
+    std::vector<std::uint8_t> counters_ = std::vector<std::uint8_t>(kRows * 64);
+    std::size_t width_ = 64;
+    std::size_t samples_ = 0;
+    std::size_t sample_limit_ = 640;
+};
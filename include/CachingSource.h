@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+#include "FrameCache.h"
+#include "InputSource.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+// Puts a FrameCache in front of another source: getFrame() returns a Mat header over the cached pixels, so a hit
+// costs no I/O and no copy. Several threads may read through one CachingSource (or several sources may share a
+// cache, as long as they use different key offsets) provided the wrapped source allows concurrent getFrame() calls,
+// as both TIFF sources and PrefetchingSource do. Frames returned here are shared: treat them as read-only.
+class CachingSource final : public InputSource {
+public:
+    // A null cache creates a private one with the default 512 MB budget. key_offset is added to the frame index to
+    // form the cache key.
+    explicit CachingSource(std::shared_ptr<InputSource> source, std::shared_ptr<FrameCache> cache = nullptr,
+                           std::size_t key_offset = 0);
+
+    Type getType() const override { return source_->getType(); }
+    std::size_t getTotalFrames() const override { return source_->getTotalFrames(); }
+    cv::Mat getFrame(std::size_t logical_index) override;
+    double getTimestamp(std::size_t logical_index) const override { return source_->getTimestamp(logical_index); }
+
+    // Same as getFrame(), keeping the handle (and therefore the frame) for the caller.
+    FrameHandle getFrameHandle(std::size_t logical_index);
+
+    FrameCache& cache() const { return *cache_; }
+    const InputSource& source() const { return *source_; }
+
+private:
+    std::shared_ptr<InputSource> source_;
+    std::shared_ptr<FrameCache> cache_;
+    std::size_t key_offset_;
+};
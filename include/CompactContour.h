@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Detection::contour, kept for fluorescence masking)
+//
+// Contours from findContours(..., CHAIN_APPROX_SIMPLE) only change direction at stored vertices and every
+// edge is horizontal, vertical or diagonal. ChainRuns stores each edge as a Freeman direction plus a run
+// length (usually one byte per vertex instead of 8). Arbitrary polygons fall back to zigzag varint deltas.
+
+enum class CompactContourEncoding : std::uint8_t {
+    ChainRuns,
+    DeltaVarint,
+};
+
+// Reference into a CompactContourStore. The first vertex is kept inline; the remaining edges live in the
+// store's shared byte buffer at [offset, offset + byte_length).
+struct CompactContourRef {
+    std::uint64_t offset = 0;
+    std::uint32_t byte_length = 0;
+    std::uint32_t vertex_count = 0;
+    cv::Point start;
+    CompactContourEncoding encoding = CompactContourEncoding::ChainRuns;
+
+    bool empty() const { return vertex_count == 0; }
+};
+
+// Append-only buffer shared by many contours (typically one store per frame or per worker thread).
+// Not thread-safe for concurrent encode(); concurrent decoding of a store that is no longer growing is safe.
+class CompactContourStore {
+public:
+    CompactContourRef encode(const std::vector<cv::Point>& contour);
+
+    std::vector<cv::Point> decode(const CompactContourRef& ref) const;
+    void decode(const CompactContourRef& ref, std::vector<cv::Point>& out) const;
+
+    // Streams the vertices of `ref` in order without materialising them: visit(const cv::Point&).
+    template <typename Visitor>
+    void forEachVertex(const CompactContourRef& ref, Visitor&& visit) const;
+
+    cv::Rect boundingRect(const CompactContourRef& ref) const;
+
+    void clear() { bytes_.clear(); }
+    void reserve(std::size_t bytes) { bytes_.reserve(bytes); }
+    void shrinkToFit() { bytes_.shrink_to_fit(); }
+
+    std::size_t sizeBytes() const { return bytes_.size(); }
+    std::size_t capacityBytes() const { return bytes_.capacity(); }
+
+private:
+    std::vector<std::uint8_t> bytes_;
+};
+
+// Fills the contour (interior plus boundary pixels, matching cv::drawContours(..., cv::FILLED)) into a CV_8U
+// mask straight from the encoded form. Pixels outside the mask are clipped; other pixels are left untouched.
+void rasterizeCompactContour(const CompactContourStore& store,
+                             const CompactContourRef& ref,
+                             cv::Mat& mask,
+                             std::uint8_t value = 255);
+
+// Heap bytes held by a plain vertex vector (the "before" side of memory reports).
+inline std::size_t contourHeapBytes(const std::vector<cv::Point>& contour) {
+    return contour.capacity() * sizeof(cv::Point);
+}
+
+namespace CompactContourDetail {
+
+// Freeman chain directions, image coordinates (y grows downwards).
+inline constexpr int kDirectionDx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+inline constexpr int kDirectionDy[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+
+inline std::uint64_t readVarint(const std::uint8_t*& cursor) {
+    std::uint64_t value = 0;
+    int shift = 0;
+    while (true) {
+        const std::uint8_t byte = *cursor++;
+        value |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+inline int zigzagDecode(std::uint64_t value) {
+    return static_cast<int>(static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U));
+}
+
+} // namespace CompactContourDetail
+
+template <typename Visitor>
+void CompactContourStore::forEachVertex(const CompactContourRef& ref, Visitor&& visit) const {
+    if (ref.empty()) {
+        return;
+    }
+
+    cv::Point point = ref.start;
+    visit(static_cast<const cv::Point&>(point));
+
+    const std::uint8_t* cursor = bytes_.data() + ref.offset;
+    for (std::uint32_t vertex = 1; vertex < ref.vertex_count; ++vertex) {
+        if (ref.encoding == CompactContourEncoding::ChainRuns) {
+            const std::uint8_t head = *cursor++;
+            std::uint64_t run_minus_one = (head >> 3U) & 0x0FU;
+            if ((head & 0x80U) != 0) {
+                run_minus_one |= CompactContourDetail::readVarint(cursor) << 4U;
+            }
+            const int run = static_cast<int>(run_minus_one) + 1;
+            const int direction = head & 0x07;
+            point.x += CompactContourDetail::kDirectionDx[direction] * run;
+            point.y += CompactContourDetail::kDirectionDy[direction] * run;
+        } else {
+            point.x += CompactContourDetail::zigzagDecode(CompactContourDetail::readVarint(cursor));
+            point.y += CompactContourDetail::zigzagDecode(CompactContourDetail::readVarint(cursor));
+        }
+        visit(static_cast<const cv::Point&>(point));
+    }
+}
@@ -2,9 +2,12 @@
 
 #include <opencv2/core.hpp>
 
+#include "CompactContour.h"
+
 #include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 struct FluorescenceMetrics {
@@ -32,6 +35,7 @@ struct Detection {
     float aspect_ratio = 0.0F;
     cv::Rect bounding_box;
     std::vector<cv::Point> contour;
+    CompactContourRef compact_contour;  // Set instead of `contour` when detecting into a CompactContourStore
     std::unordered_map<std::string, FluorescenceMetrics> fluorescence;
 };
 
@@ -52,3 +56,45 @@ struct Track {
     std::size_t line_crossing_frame = 0;
 };
 
+// Approximate bytes held by each model (inline members plus owned heap), used for memory reporting.
+// Contours encoded into a CompactContourStore are owned by the store and counted there.
+inline std::size_t approximateMemoryBytes(const Detection& detection) {
+    std::size_t bytes = sizeof(Detection) + contourHeapBytes(detection.contour);
+    bytes += detection.fluorescence.bucket_count() * sizeof(void*);
+    for (const auto& [channel, metrics] : detection.fluorescence) {
+        bytes += sizeof(std::pair<const std::string, FluorescenceMetrics>) + 2 * sizeof(void*);
+        bytes += channel.capacity() > 15 ? channel.capacity() : 0;
+        bytes += metrics.bg_method.capacity() > 15 ? metrics.bg_method.capacity() : 0;
+    }
+    return bytes;
+}
+
+inline std::size_t approximateMemoryBytes(const FrameDetections& frame) {
+    std::size_t bytes = sizeof(FrameDetections) + (frame.detections.capacity() - frame.detections.size()) * sizeof(Detection);
+    for (const auto& detection : frame.detections) {
+        bytes += approximateMemoryBytes(detection);
+    }
+    return bytes;
+}
+
+inline std::size_t approximateMemoryBytes(const Track& track) {
+    return sizeof(Track)
+        + track.droplet_ids.capacity() * sizeof(std::size_t)
+        + track.frame_indices.capacity() * sizeof(std::size_t)
+        + track.centroids.capacity() * sizeof(cv::Point2f)
+        + track.timestamps.capacity() * sizeof(double)
+        + track.velocities.capacity() * sizeof(float);
+}
+
+template <typename T>
+std::size_t approximateMemoryBytes(const std::vector<T>& values) {
+    std::size_t bytes = sizeof(values) + (values.capacity() - values.size()) * sizeof(T);
+    for (const auto& value : values) {
+        if constexpr (requires { approximateMemoryBytes(value); }) {
+            bytes += approximateMemoryBytes(value);
+        } else {
+            bytes += sizeof(T);
+        }
+    }
+    return bytes;
+}
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include <opencv2/core.hpp>
 
+#include "CompactContour.h"
 #include "DataModels.h"
 
 struct DropletDetectionParams {
@@ -20,3 +22,28 @@ struct DropletDetectionParams {
 
 // Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (core droplet detection pipeline)
 std::vector<Detection> detectDroplets(const cv::Mat& frame, const DropletDetectionParams& params);
+
+// Same pipeline, but each contour is encoded into `contour_store` (Detection::compact_contour) and
+// Detection::contour is left empty. Use one store per frame or per worker thread.
+std::vector<Detection> detectDroplets(const cv::Mat& frame,
+                                      const DropletDetectionParams& params,
+                                      CompactContourStore& contour_store);
+
+// Pixels of neighbourhood the pipeline reads around each output pixel (blur, adaptive threshold window and
+// morphology). Detecting on a sub-image padded by this much gives the same binary mask inside the unpadded
+// region as detecting on the full frame.
+int detectionContextRadius(const DropletDetectionParams& params);
+
+// Detects the droplets whose centroid lies in `core`, reading only `core` padded by detectionContextRadius()
+// (clipped to the frame); results are appended in frame coordinates and match full-frame detection.
+// Returns false, appending nothing, if such a droplet extends outside `core`: the caller has to widen
+// the region or fall back to full-frame detection. `pixels_read` receives the padded area.
+bool detectDropletsInRegion(const cv::Mat& frame,
+                            const cv::Rect& core,
+                            const DropletDetectionParams& params,
+                            std::vector<Detection>& detections,
+                            std::size_t* pixels_read = nullptr);
+
+// Unions intersecting rectangles until the set is pairwise disjoint, so regions processed with
+// detectDropletsInRegion() never report the same droplet twice.
+void mergeOverlappingRegions(std::vector<cv::Rect>& regions);
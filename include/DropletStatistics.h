@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DataModels.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/06_data_formats.md (6.3 Summary Statistics JSON: frequency_hz, diameter_um)
+// Spec reference: Docs/TECHSPEC_SPLIT/10_testing_validation.md (frequency = line crossings / duration)
+
+struct MeasurementLine {
+    bool enabled = false;
+    cv::Point2f start;
+    cv::Point2f end;
+};
+
+// True when the step from `from` to `to` touches or crosses the measurement segment. A step that ends on
+// the line counts; the following step that leaves it does not, so a droplet is never counted twice.
+bool segmentCrossesLine(const cv::Point2f& from, const cv::Point2f& to, const MeasurementLine& line);
+// True when `from` lies on the measurement segment and `to` is off its line: the crossing of a droplet first
+// seen on the line. Only meaningful for a track that has not crossed yet (then every earlier step stayed on
+// the line, since arriving on it would have counted as the crossing).
+bool segmentLeavesLine(const cv::Point2f& from, const cv::Point2f& to, const MeasurementLine& line);
+
+// Welford running mean/variance. Every query is O(1); NaN/inf samples are ignored.
+class OnlineStatistics {
+public:
+    void add(double value);
+    // Chan et al. parallel combination, so per-thread accumulators can be folded together.
+    void merge(const OnlineStatistics& other);
+    void reset() { *this = OnlineStatistics{}; }
+
+    std::size_t count() const { return count_; }
+    double mean() const { return count_ > 0 ? mean_ : std::numeric_limits<double>::quiet_NaN(); }
+    // Sample variance (n - 1); NaN below two samples.
+    double variance() const;
+    double stddev() const;
+    // Coefficient of variation in percent (std / mean * 100).
+    double cvPercent() const;
+    double min() const { return count_ > 0 ? min_ : std::numeric_limits<double>::quiet_NaN(); }
+    double max() const { return count_ > 0 ? max_ : std::numeric_limits<double>::quiet_NaN(); }
+
+private:
+    std::size_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = 0.0;
+    double max_ = 0.0;
+};
+
+// Equal-width histogram over [lower, upper). Values outside the range land in the underflow/overflow
+// counters, so quantiles stay meaningful for in-range data without unbounded memory.
+class FixedHistogram {
+public:
+    FixedHistogram() = default;
+    FixedHistogram(double lower, double upper, std::size_t bin_count);
+
+    void add(double value);
+    void merge(const FixedHistogram& other);
+    void reset();
+
+    double lower() const { return lower_; }
+    double upper() const { return upper_; }
+    double binWidth() const { return bin_width_; }
+    const std::vector<std::uint64_t>& counts() const { return counts_; }
+    std::uint64_t underflow() const { return underflow_; }
+    std::uint64_t overflow() const { return overflow_; }
+    std::uint64_t total() const { return total_; }
+
+    // Linearly interpolated within the bin, so the error is at most one bin width for in-range data.
+    // Cost is bounded by the (fixed) bin count, independent of the number of samples.
+    double quantile(double q) const;
+
+private:
+    double lower_ = 0.0;
+    double upper_ = 0.0;
+    double bin_width_ = 0.0;
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t underflow_ = 0;
+    std::uint64_t overflow_ = 0;
+    std::uint64_t total_ = 0;
+};
+
+// Crossing events over the most recent `window_s` seconds of stream time. Events are grouped per
+// timestamp, so memory is bounded by the number of frames inside the window.
+class SlidingWindowRate {
+public:
+    explicit SlidingWindowRate(double window_s = 1.0);
+
+    void add(double timestamp_s, std::size_t events = 1);
+    // Moves the window end forward without adding events (frames with no crossings).
+    void advance(double now_s);
+
+    std::size_t eventsInWindow() const { return events_in_window_; }
+    // Events per second over the window, or over the observed span while the stream is shorter than
+    // the window. NaN until time has advanced.
+    double rateHz() const;
+
+private:
+    void evict();
+
+    struct Bucket {
+        double timestamp_s = 0.0;
+        std::size_t events = 0;
+    };
+
+    double window_s_ = 1.0;
+    double first_s_ = std::numeric_limits<double>::quiet_NaN();
+    double now_s_ = std::numeric_limits<double>::quiet_NaN();
+    std::size_t events_in_window_ = 0;
+    std::deque<Bucket> buckets_;
+};
+
+struct DropletStatisticsParams {
+    // Calibration applied to diameters and speeds (see um_per_px in 06_data_formats.md).
+    double um_per_px = 1.0;
+    double rate_window_s = 1.0;
+    double diameter_histogram_max_um = 200.0;
+    std::size_t diameter_histogram_bins = 400;
+    double velocity_histogram_max_um_per_s = 1.0e5;
+    std::size_t velocity_histogram_bins = 500;
+};
+
+struct DropletStatisticsSnapshot {
+    std::size_t total_frames = 0;
+    std::size_t total_detected = 0;
+    std::size_t total_tracked = 0;
+    std::size_t total_crossings = 0;
+    double duration_s = 0.0;
+    double crossing_rate_hz = std::numeric_limits<double>::quiet_NaN();
+    // Per-interval droplet frequency: crossings in a frame / time since the previous frame with crossings.
+    // Includes the interval ending at the newest frame with crossings, so nothing is lost at end of stream.
+    OnlineStatistics frequency_hz;
+    // One sample per track (its mean equivalent diameter), however many frames it was detected in.
+    OnlineStatistics diameter_um;
+    double diameter_median_um = std::numeric_limits<double>::quiet_NaN();
+    OnlineStatistics velocity_um_per_s;
+};
+
+// Accumulates summary statistics while frames are tracked, so the live view and the exported summary
+// read the same numbers and no post-pass over tracks is needed. Feed it from StreamingTracker
+// (setStatisticsEngine) or call the on* hooks directly. Not thread-safe; snapshot() is O(active tracks) plus
+// the bounded histogram median.
+class DropletStatisticsEngine {
+public:
+    explicit DropletStatisticsEngine(const DropletStatisticsParams& params = {});
+
+    // Called once per frame before its links: counts detections, advances the rate window.
+    void onFrame(const FrameDetections& frame);
+    // `diameter_px` is the equivalent diameter of the detection that starts / extends the track.
+    void onTrackStarted(const Track& track, float diameter_px);
+    // Called after a centroid has been appended to `track`; `speed_px_per_s` is the new velocity entry.
+    void onLink(const Track& track, float diameter_px, float speed_px_per_s, bool crossed_line);
+    // The track is complete: its mean diameter joins the diameter statistics for good.
+    void onTrackRetired(const Track& track);
+
+    DropletStatisticsSnapshot snapshot() const;
+
+    // Retired tracks only (snapshot() also counts the active ones).
+    const FixedHistogram& diameterHistogram() const { return diameter_histogram_; }
+    const FixedHistogram& velocityHistogram() const { return velocity_histogram_; }
+
+private:
+    // Frequency sample of the pending crossing group; NaN when there is none (or no previous group).
+    double crossingGroupFrequency() const;
+    void flushCrossingGroup();
+    double trackDiameterUm(const OnlineStatistics& diameter_px) const;
+
+    DropletStatisticsParams params_;
+
+    std::size_t total_frames_ = 0;
+    std::size_t total_detected_ = 0;
+    std::size_t total_tracked_ = 0;
+    std::size_t total_crossings_ = 0;
+    double first_timestamp_s_ = std::numeric_limits<double>::quiet_NaN();
+    double last_timestamp_s_ = std::numeric_limits<double>::quiet_NaN();
+
+    // Crossings seen in the current frame; committed as a frequency sample when a later timestamp arrives
+    // (snapshot() counts them before that).
+    std::size_t group_crossings_ = 0;
+    double group_timestamp_s_ = 0.0;
+    double previous_group_timestamp_s_ = std::numeric_limits<double>::quiet_NaN();
+
+    OnlineStatistics frequency_hz_;
+    // Retired tracks; active ones are kept per track id until they retire (snapshot() adds them).
+    OnlineStatistics diameter_um_;
+    std::unordered_map<std::size_t, OnlineStatistics> active_diameter_px_;
+    OnlineStatistics velocity_um_per_s_;
+    FixedHistogram diameter_histogram_;
+    FixedHistogram velocity_histogram_;
+    SlidingWindowRate crossing_rate_;
+};
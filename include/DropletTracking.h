@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DataModels.h"
+#include "DropletStatistics.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.4 Offline Processing, Step 2: tracking)
+
+enum class TrackingAssignment {
+    // Links the closest gated pairs first. Cheapest, but can swap IDs in tightly packed droplet trains.
+    GreedyNearest,
+    // Minimum total squared distance per connected component of gated candidate links (sparse
+    // Jonker-Volgenant style solver). Components are small on typical data, so cost stays close to greedy.
+    Optimal,
+};
+
+struct TrackingParams {
+    // Search radius around the predicted position. 0 derives it per track from the droplet size:
+    // search_radius_bbox_scale * max(bounding_box.width, bounding_box.height).
+    double search_radius_px = 0.0;
+    double search_radius_bbox_scale = 1.5;
+    // The window grows by this fraction of the predicted displacement to absorb velocity changes.
+    double velocity_uncertainty = 0.5;
+    // Relative change gates, |new - old| / max(new, old). Non-positive disables the gate.
+    double max_area_change = 0.5;
+    double max_diameter_change = 0.3;
+    // Frames a track may go unmatched (coasting on its velocity) before it is closed.
+    std::size_t max_missed_frames = 0;
+    TrackingAssignment assignment = TrackingAssignment::GreedyNearest;
+};
+
+// Where an active track expects its droplet in a future frame, with the gate the tracker will apply.
+struct TrackPrediction {
+    std::size_t track_id = 0;
+    cv::Point2f position;
+    float search_radius = 0.0F;
+    // Largest bounding-box side of the last matched detection.
+    float extent_px = 0.0F;
+};
+
+using TrackSink = std::function<void(Track&& finished_track)>;
+
+// Incremental form of performTracking(): frames are pushed as soon as their detections are ready and
+// only active tracks are held. A track is retired to the sink once it has gone unmatched for more than
+// max_missed_frames frames, so memory stays bounded on unbounded streams. The tracks produced (IDs,
+// links, velocities, line crossings) are identical to performTracking() over the same frames.
+// Frames must be pushed in increasing frame_index_logical order; gaps (dropped frames) are allowed.
+class StreamingTracker {
+public:
+    StreamingTracker(const TrackingParams& params, const MeasurementLine& measurement_line, TrackSink sink);
+    ~StreamingTracker();
+
+    StreamingTracker(const StreamingTracker&) = delete;
+    StreamingTracker& operator=(const StreamingTracker&) = delete;
+    StreamingTracker(StreamingTracker&&) noexcept;
+    StreamingTracker& operator=(StreamingTracker&&) noexcept;
+
+    // Optional; not owned and must outlive the tracker. Receives every frame, new track, link and retired track as it
+    // happens, so summary statistics are current after each push().
+    void setStatisticsEngine(DropletStatisticsEngine* engine);
+
+    void push(const FrameDetections& frame);
+    // Retires every active track to the sink. The tracker can keep accepting later frames afterwards.
+    void finalize();
+
+    // Predicted positions of all active tracks at `frame_index` (normally the next frame to be pushed).
+    std::vector<TrackPrediction> predictions(std::size_t frame_index) const;
+
+    std::size_t activeTrackCount() const;
+    std::size_t retiredTrackCount() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Links detections frame to frame by matching against velocity-predicted positions (see
+// TrackingAssignment). Detections are bucketed in a uniform grid per frame, so the work per frame is linear in
+// the droplet count. Every detection ends up in exactly one track; tracks are ordered by track_id.
+// Track::velocities holds one entry per link (px/s, or px/frame when timestamps do not advance).
+std::vector<Track> performTracking(const std::vector<FrameDetections>& all_detections,
+                                   const TrackingParams& tracking_params,
+                                   const MeasurementLine& measurement_line);
@@ -4,6 +4,7 @@
 
 #include <vector>
 
+#include "CompactContour.h"
 #include "DataModels.h"
 
 namespace FluorescenceQuantification {
@@ -21,4 +22,14 @@ namespace FluorescenceQuantification {
         const cv::Mat& all_droplets_mask,
         const cv::Mat& global_background_mask = cv::Mat(),
         const BackgroundOptions& options = {});
+
+    // Same metrics for a contour held in a CompactContourStore; the droplet mask is rasterized straight
+    // from the encoded form.
+    FluorescenceMetrics computeFluorescenceMetrics(
+        const cv::Mat& fluor_image,
+        const CompactContourStore& contour_store,
+        const CompactContourRef& droplet_contour,
+        const cv::Mat& all_droplets_mask,
+        const cv::Mat& global_background_mask = cv::Mat(),
+        const BackgroundOptions& options = {});
 }
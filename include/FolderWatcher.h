@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "SidecarIndex.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (FR-IS2: File Collection Rule)
+
+struct FolderWatchParams {
+    // Linux: learn about new files from inotify. Without it (other platforms, network shares that send no events,
+    // or when inotify is unavailable) completion is judged by polling alone.
+    bool use_inotify = true;
+    // How often the directory is listed, for files no event announced.
+    std::chrono::milliseconds poll_interval{200};
+    // A file nobody announced is complete once its size (non-zero) and modification time have stayed the same for
+    // this long.
+    std::chrono::milliseconds stable_for{1000};
+    // An empty file is complete once it has stayed empty this long (or stable_for, if longer): it is most likely a
+    // placeholder its writer abandoned, and leaving it pending would hold back every file that sorts after it.
+    std::chrono::milliseconds empty_timeout{10000};
+};
+
+// Reports TIFF files in the top level of a directory once their writer is done with them. Files announced by
+// inotify (created or modified) are complete when they are closed after writing (IN_CLOSE_WRITE) or renamed into
+// the directory (IN_MOVED_TO); files found only by listing the directory (already there at start(), written over
+// a network share, or after the event queue overflowed) are complete once their size and modification time have
+// been stable for stable_for (empty files for empty_timeout). Each file is reported once. Not thread-safe.
+class FolderWatcher {
+public:
+    explicit FolderWatcher(std::string directory, const FolderWatchParams& params = {});
+    ~FolderWatcher();
+
+    FolderWatcher(const FolderWatcher&) = delete;
+    FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+    // False when the directory cannot be listed. Files already present become candidates like any new file.
+    bool start(std::string& error_message);
+    // True when inotify events are being used; otherwise inotifyError() says why not (empty if not requested).
+    bool usingInotify() const { return inotify_fd_ >= 0; }
+    const std::string& inotifyError() const { return inotify_error_; }
+
+    // Waits up to `timeout` for at least one file to complete; returns the paths of all newly completed files in
+    // alphabetical order (possibly none).
+    std::vector<std::string> waitForCompleted(std::chrono::milliseconds timeout);
+
+    // Names of files seen but not complete yet, in alphabetical order.
+    std::vector<std::string> pending() const;
+
+private:
+    struct Candidate {
+        FileStamp stamp;
+        std::chrono::steady_clock::time_point stable_since;
+        // Announced by inotify: wait for its close or rename event instead of judging by stability.
+        bool awaiting_event = false;
+    };
+
+    void readEvents();
+    void scan();
+    void complete(const std::string& name);
+
+    std::string directory_;
+    FolderWatchParams params_;
+    int inotify_fd_ = -1;
+    std::string inotify_error_;
+    std::chrono::steady_clock::time_point next_scan_;
+    std::map<std::string, Candidate> pending_;
+    std::set<std::string> completed_;  // not yet returned
+    std::set<std::string> reported_;   // completed at some point; never reported again
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "FolderWatcher.h"
+#include "ImageSequenceSource.h"
+#include "InputSource.h"
+#include "StreamFrame.h"
+#include "TiffFormat.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 1: Image Sequence Source)
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (FR-IS2: File Collection Rule)
+
+struct SequenceFollowParams {
+    FolderWatchParams watch;
+    // grabNextFrame() reports Stopped once no new file has completed for this long; 0 = follow until stop().
+    std::chrono::milliseconds end_after_idle{0};
+};
+
+// Image sequence that grows while it is analyzed: single-page TIFFs are appended as the acquisition software
+// finishes writing them into the directory (see FolderWatcher), so analysis can start with the first frame instead
+// of after the run. Frames keep the alphabetical filename order of ImageSequenceSource: a completed file is held
+// back while a file that sorts before it is still being written, and a file that completes after a later name was
+// already appended is skipped and listed in skipped(). Every appended file's header is checked against spec 3.2 and
+// the first file's format when it is appended; rejected files are skipped and listed as well, as are files that stay
+// empty for FolderWatchParams::empty_timeout.
+// grabNextFrame() hands each appended frame out once, in order, with the interface of a live camera, so the same
+// consumers (LiveAnalysisScheduler, detection loops) can follow a folder. grabNextFrame() must be called from a
+// single thread; getFrame() and the accessors may be called from any thread.
+class FollowingSequenceSource final : public InputSource {
+public:
+    FollowingSequenceSource(const std::string& directory, double fps_manual, const SequenceFollowParams& params = {});
+
+    // False when the directory cannot be watched. Files already in the directory are streamed first.
+    bool start(std::string& error_message);
+    // Makes grabNextFrame() return Stopped once the frames appended so far have been handed out. Any thread.
+    void stop();
+
+    // Waits up to `timeout` for the next frame. frame_index is the position in the sequence, timestamp the
+    // inferred file-order time and arrival when the file was appended. Never throws: an appended file that can no
+    // longer be read (deleted, replaced, truncated) is skipped and listed in skipped(), and the next frame handed
+    // out is reported as LostFrame.
+    GrabStatus grabNextFrame(StreamFrame& frame, std::chrono::microseconds timeout);
+
+    Type getType() const override { return Type::ImageSequence; }
+    // Frames appended so far; grows while following.
+    std::size_t getTotalFrames() const override { return frame_count_.load(std::memory_order_acquire); }
+    // Always a decoded copy the caller owns, never a view of the file, which its writer may still truncate or replace.
+    // Throws std::out_of_range for a frame not appended (yet) and std::runtime_error when the file cannot be read.
+    cv::Mat getFrame(std::size_t logical_index) override;
+    double getTimestamp(std::size_t logical_index) const override;
+
+    std::string framePath(std::size_t logical_index) const;
+    // Empty / -1 until the first frame has been appended.
+    cv::Size frameSize() const;
+    int frameType() const;
+    // Completed files that were not appended, or could not be read any more when handed out, in the order they were
+    // rejected.
+    std::vector<SequenceValidationIssue> skipped() const;
+    bool usingInotify() const { return watcher_.usingInotify(); }
+    const std::string& inotifyError() const { return watcher_.inotifyError(); }
+
+private:
+    struct FrameFile {
+        std::string path;
+        TiffPageLayout page;
+        bool little_endian = true;
+    };
+
+    void append(const std::vector<std::string>& completed);
+    void appendFile(const std::string& path);
+    void reject(const std::string& path, const std::string& message);
+
+    std::string directory_;
+    double fps_manual_;
+    SequenceFollowParams params_;
+    FolderWatcher watcher_;  // grabbing thread only
+
+    // Grabbing thread only.
+    std::set<std::string> held_;  // completed, waiting for an earlier name to complete
+    std::string last_appended_;   // file name
+    std::size_t next_delivery_ = 0;
+    bool frames_lost_ = false;  // a frame was skipped since the last one handed out
+    std::chrono::steady_clock::time_point last_growth_;
+
+    mutable std::mutex mutex_;  // guards everything below
+    std::deque<FrameFile> frames_;
+    std::deque<std::chrono::steady_clock::time_point> appended_at_;
+    cv::Size frame_size_;
+    int frame_type_ = -1;
+    std::vector<SequenceValidationIssue> skipped_;
+
+    std::atomic<std::size_t> frame_count_{0};
+    std::atomic<bool> stop_requested_{false};
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "CachePolicy.h"
+#include "FrameCodec.h"
+#include "MemoryGovernor.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Frame Cache (Memory-Budget Based))
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Cache Budget)
+
+// Shared, read-only reference to a cached frame. Copying a handle (or taking a cv::Mat header from it) never
+// copies pixels, and the frame stays alive for as long as any handle to it exists, even after the cache has
+// evicted it. Callers must not write into the pixels.
+class FrameHandle {
+public:
+    FrameHandle() = default;
+
+    explicit operator bool() const { return frame_ != nullptr; }
+    // Empty Mat for a default-constructed handle.
+    const cv::Mat& mat() const;
+    const cv::Mat& operator*() const { return mat(); }
+    const cv::Mat* operator->() const { return &mat(); }
+    std::size_t bytes() const;
+
+private:
+    friend class FrameCache;
+    explicit FrameHandle(std::shared_ptr<const cv::Mat> frame) : frame_(std::move(frame)) {}
+
+    std::shared_ptr<const cv::Mat> frame_;
+};
+
+struct FrameCacheStats {
+    std::size_t hits = 0;
+    // get() calls that ran the loader.
+    std::size_t misses = 0;
+    // get() calls served by decoding a frame from the compressed tier.
+    std::size_t compressed_hits = 0;
+    // get() calls that found the frame being loaded by another thread and waited for that load instead.
+    std::size_t shared_loads = 0;
+    std::size_t evictions = 0;
+    // Loaded frames the policy declined to cache (they were returned, not kept).
+    std::size_t rejected = 0;
+    std::size_t frames = 0;
+    std::size_t pinned_frames = 0;
+    std::size_t bytes = 0;
+    std::size_t peak_bytes = 0;
+    // Compressed tier: frames held, their encoded size and what they take decoded.
+    std::size_t compressed_frames = 0;
+    std::size_t compressed_bytes = 0;
+    std::size_t compressed_raw_bytes = 0;
+    double encode_seconds = 0.0;
+    double decode_seconds = 0.0;
+
+    // Share of get() calls that did not run the loader.
+    double hitRate() const;
+    // Frames available without touching the disk, across both tiers.
+    std::size_t effectiveFrames() const { return frames + compressed_frames; }
+};
+
+// Memory-budget cache of decoded frames, safe to share between threads (frame-parallel detection, the GUI and a
+// prefetcher at the same time). Frames live in independently locked shards keyed by frame id; which frame to evict
+// and whether a new frame is worth caching is left to a CachePolicy (LRU by default, or the scan-resistant 2Q and
+// TinyLFU policies), which sees every request in order: a hit only locks its own shard and records the access
+// there, and the recorded accesses are handed to the policy under its lock before it next inserts, evicts or
+// admits a frame (or once a shard has collected enough of them). Named sets of frames (auto-tune
+// samples, background frames) can be pinned: they are never evicted, count against the budget and are admitted
+// whatever the policy thinks. A miss runs the loader outside any lock, and concurrent get() calls for the same id
+// wait for that one load rather than starting their own; when the loader throws, every waiter sees the exception
+// and nothing is cached. An optional second tier keeps evicted 8/16-bit frames losslessly compressed (FrameCodec)
+// in a budget of its own; a miss checks it and decodes the frame before falling back to the loader. Both tiers are
+// accounted with a MemoryGovernor, which can take frames back (compressed ones first, then the policy's victims)
+// when the process as a whole goes over its budget.
+class FrameCache {
+public:
+    static constexpr std::size_t kDefaultBudgetBytes = 512U * 1024U * 1024U;
+    static constexpr std::size_t kDefaultShards = 8;
+
+    // A null policy means LRU; a null governor leaves the cache out of the process-wide accounting.
+    explicit FrameCache(std::size_t memory_budget_bytes = kDefaultBudgetBytes, std::size_t shards = kDefaultShards,
+                        std::unique_ptr<CachePolicy> policy = nullptr,
+                        MemoryGovernor* governor = &MemoryGovernor::global());
+    ~FrameCache();
+
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    // Cached frame, or the loader's result (cached if it fits the budget and the policy admits it). Rethrows the
+    // loader's exception.
+    FrameHandle get(std::size_t frame_id, const std::function<cv::Mat()>& loader);
+
+    // Pins the frames of a named set; those already cached stay, the others are kept once loaded. Pinning a name
+    // again replaces its set. A frame in several sets stays pinned until the last of them is unpinned.
+    void pin(const std::string& set_name, std::span<const std::size_t> frame_ids);
+    void unpin(const std::string& set_name);
+
+    // Drops every cached frame, pinned or not (pin sets stay); loads in flight still complete and are cached.
+    void clear();
+    void setMemoryBudget(std::size_t bytes);
+    std::size_t getMemoryBudgetBytes() const { return budget_.load(); }
+    // Budget divided by the size of the first frame loaded (0 before that), as in the spec's N_cache.
+    std::size_t getMaxFrames() const;
+    std::size_t getMemoryUsageBytes() const { return bytes_.load(); }
+    const char* policyName() const;
+
+    // Budget of the compressed tier in encoded bytes; 0 (the default) disables the tier and drops its frames.
+    // Frames move between the tiers: evicted ones are encoded into it, decoded ones leave it.
+    void setCompressedBudget(std::size_t bytes);
+    std::size_t getCompressedBudgetBytes() const;
+
+    // While enabled, every requested frame id is appended to a trace (see FrameCacheTrace).
+    void setTraceRecording(bool enabled);
+    std::vector<std::size_t> takeTrace();
+
+    FrameCacheStats stats() const;
+
+private:
+    struct Entry {
+        // Set once the frame is loaded; until then `pending` delivers it to waiting callers.
+        std::shared_ptr<const cv::Mat> frame;
+        std::shared_future<std::shared_ptr<const cv::Mat>> pending;
+        std::size_t bytes = 0;
+        // Loaded and pinned: counted in pinned_frames_ and hidden from the policy.
+        bool pinned = false;
+    };
+
+    // A request not yet shown to the policy; `sequence` restores the order across shards.
+    struct Access {
+        std::uint64_t sequence = 0;
+        std::size_t frame_id = 0;
+        bool resident = false;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::size_t, Entry> entries;
+        // Taken last, after the shard or the policy mutex, and never with another one inside it.
+        std::mutex access_mutex;
+        std::vector<Access> accesses;
+    };
+
+    struct CompressedEntry {
+        EncodedFrame encoded;
+        std::list<std::size_t>::iterator position;
+    };
+
+    // LRU of encoded frames. Its mutex is never held together with any other.
+    struct CompressedTier {
+        mutable std::mutex mutex;
+        std::size_t budget = 0;
+        std::size_t bytes = 0;
+        std::size_t raw_bytes = 0;
+        std::list<std::size_t> recency;  // most recent first
+        std::unordered_map<std::size_t, CompressedEntry> frames;
+
+        // Bytes freed.
+        std::size_t trim(std::size_t limit);
+    };
+
+    Shard& shardOf(std::size_t frame_id) { return shards_[frame_id % shards_.size()]; }
+    // Records a request in its shard (whose mutex the caller holds); applies the recorded ones when enough piled up.
+    void accessed(Shard& shard, std::size_t frame_id, bool resident);
+    // Hands every recorded request to the policy, oldest first. Requires policy_mutex_.
+    void drainAccesses();
+    bool isPinned(std::size_t frame_id) const { return pin_counts_.count(frame_id) != 0; }
+    void updateCapacity();
+    // Evicts until `bytes` more fit, then reserves them; false (nothing reserved) when the policy rejects the
+    // frame or only pinned frames are left.
+    bool makeRoom(std::size_t frame_id, std::size_t bytes);
+    void evictToBudget();
+    // The evicted frame, or null when it was no longer cached (or pinned meanwhile).
+    std::shared_ptr<const cv::Mat> evict(std::size_t frame_id);
+    void demote(std::size_t frame_id, const cv::Mat& frame);
+    bool promote(std::size_t frame_id, cv::Mat& frame);
+    // Moves a cached frame between the policy and the pinned frames after its pin count changed.
+    void refreshPin(std::size_t frame_id);
+    // Governor shrinker: drops compressed frames, then evicts (without demoting) until `bytes` are freed.
+    std::size_t shrink(std::size_t bytes);
+    void charged(MemoryCategory category, std::size_t bytes);
+    void released(MemoryCategory category, std::size_t bytes);
+
+    std::vector<Shard> shards_;
+    std::atomic<std::size_t> budget_;
+    std::atomic<std::size_t> bytes_{0};
+    std::atomic<std::size_t> first_frame_bytes_{0};
+    std::mutex evict_mutex_;  // one evictor at a time; never taken while a shard or the policy mutex is held
+
+    // Taken after a shard mutex, never before one (a shard's access_mutex comes after both).
+    mutable std::mutex policy_mutex_;
+    std::unique_ptr<CachePolicy> policy_;
+    std::map<std::string, std::vector<std::size_t>> pin_sets_;
+    std::unordered_map<std::size_t, std::size_t> pin_counts_;
+    bool tracing_ = false;
+    std::vector<std::size_t> trace_;
+    std::atomic<std::uint64_t> access_sequence_{0};
+    std::vector<Access> drained_;  // scratch for drainAccesses()
+
+    CompressedTier compressed_;
+
+    MemoryGovernor* governor_;
+    MemoryGovernor::ShrinkerId shrinker_id_ = 0;
+
+    std::atomic<std::size_t> hits_{0};
+    std::atomic<std::size_t> misses_{0};
+    std::atomic<std::size_t> compressed_hits_{0};
+    std::atomic<std::uint64_t> encode_nanoseconds_{0};
+    std::atomic<std::uint64_t> decode_nanoseconds_{0};
+    std::atomic<std::size_t> shared_loads_{0};
+    std::atomic<std::size_t> evictions_{0};
+    std::atomic<std::size_t> rejected_{0};
+    std::atomic<std::size_t> frames_{0};
+    std::atomic<std::size_t> pinned_frames_{0};
+    std::atomic<std::size_t> peak_bytes_{0};
+};
+
+// Recorded request traces: one frame id per line, '#' starts a comment. Replaying a trace through each policy is
+// how the policies are compared on real GUI / auto-tune / playback sessions (see bench/cache_replay_bench.cpp).
+namespace FrameCacheTrace {
+    bool load(const std::filesystem::path& path, std::vector<std::size_t>& trace, std::string& error_message);
+    bool save(const std::filesystem::path& path, std::span<const std::size_t> trace, std::string& error_message);
+
+    // Runs the trace single-threaded through a cache of capacity_frames equally sized frames with the given
+    // policy, after pinning `pinned`.
+    FrameCacheStats replay(std::span<const std::size_t> trace, std::size_t capacity_frames,
+                           std::unique_ptr<CachePolicy> policy, std::span<const std::size_t> pinned = {});
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Cache Budget)
+
+// A frame compressed by FrameCodec::encode().
+struct EncodedFrame {
+    int rows = 0;
+    int cols = 0;
+    int type = -1;
+    std::vector<std::uint8_t> bytes;
+
+    std::size_t rawBytes() const { return static_cast<std::size_t>(rows) * cols * CV_ELEM_SIZE(type); }
+};
+
+// Lossless codec for CV_8UC1 / CV_16UC1 frames, fast enough to sit between the frame cache and the disk. Each
+// sample is predicted by its left neighbour (the first of a row by the sample above), the residuals are zigzag
+// mapped and bit-packed in blocks of 128 at the smallest width that holds the block. Smooth backgrounds need a few
+// bits per pixel instead of 16. Blocks are packed in 8 interleaved 16-bit lanes so decoding (unpack, unzigzag and
+// running sum) runs eight samples per SSE2 instruction; targets without SSE2 use a scalar decoder that produces
+// the same pixels.
+namespace FrameCodec {
+    constexpr std::size_t kBlockSamples = 128;
+
+    bool supports(const cv::Mat& frame);
+
+    // False (and nothing written) for unsupported frames.
+    bool encode(const cv::Mat& frame, EncodedFrame& encoded);
+    // Into a new Mat of the original size and type. False for corrupt or truncated data.
+    bool decode(const EncodedFrame& encoded, cv::Mat& frame);
+    // Same, always through the scalar decoder.
+    bool decodeScalar(const EncodedFrame& encoded, cv::Mat& frame);
+
+    // Whether decode() uses SSE2 on this build.
+    bool simdDecode();
+}
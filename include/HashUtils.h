@@ -5,12 +5,29 @@
 #include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace HashUtils {
     // Spec reference: Docs/TECHSPEC_SPLIT/06_data_formats.md (session JSON provenance: *_hash_sha256)
 
+    // SHA-256 compression kernels. Portable runs everywhere; ShaNi uses the x86 SHA extensions for one stream;
+    // Avx2MultiBuffer hashes up to eight independent streams at once in the lanes of AVX2 registers, which only
+    // sha256HexFiles() can use (a single stream is hashed with Portable under that kernel).
+    enum class Sha256Kernel { Portable, ShaNi, Avx2MultiBuffer };
+
+    const char* sha256KernelName(Sha256Kernel kernel);
+    bool sha256KernelSupported(Sha256Kernel kernel);
+    // Kernel in use; defaults to the fastest one the CPU supports (ShaNi, then Avx2MultiBuffer, then Portable).
+    Sha256Kernel sha256Kernel();
+    // For tests and benchmarks. Returns false, and changes nothing, when the CPU does not support the kernel.
+    bool setSha256Kernel(Sha256Kernel kernel);
+
     std::string sha256Hex(std::span<const std::byte> data);
     std::string sha256Hex(std::string_view text);
+    // Streams the file through large sequential reads. Throws std::runtime_error when it cannot be read.
     std::string sha256HexFile(const std::filesystem::path& file_path);
+    // One digest per file, in the same order. Under Avx2MultiBuffer eight files are hashed side by side;
+    // otherwise this is sha256HexFile() in a loop. Same exceptions as sha256HexFile().
+    std::vector<std::string> sha256HexFiles(std::span<const std::filesystem::path> file_paths);
 }
 
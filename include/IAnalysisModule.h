@@ -33,7 +33,7 @@ public:
 };
 #endif
 
-struct AnalysisResults;
+class AnalysisResults;
 
 using ProgressCallback =
     std::function<void(std::size_t current, std::size_t total, const std::string& status)>;
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "BatchFrameReader.h"
+#include "InputSource.h"
+#include "MappedFile.h"
+#include "SidecarIndex.h"
+#include "TiffFormat.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 1: Image Sequence Source)
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+struct SequenceValidationIssue {
+    std::string file;  // file name, without the directory
+    std::string message;
+};
+
+// Outcome of the load() scan. time_to_ready_seconds (enumeration + validation) is how long a user waits before
+// the first frame can be requested; no pixel data is read to get there.
+struct SequenceValidationReport {
+    std::size_t total_files = 0;
+    std::size_t sampled_files = 0;
+    // Sampled files whose unchanged size and mtime let their header come from the sidecar index.
+    std::size_t reused_headers = 0;
+    // Header blocks read across all sampled files.
+    std::size_t header_bytes_read = 0;
+    std::size_t threads = 0;
+    double enumerate_seconds = 0.0;
+    double validate_seconds = 0.0;
+    double time_to_ready_seconds = 0.0;
+    // Format of the first file, which every sampled file is compared against.
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint16_t bits_per_sample = 0;
+    // One entry per rejected sampled file, in filename order.
+    std::vector<SequenceValidationIssue> issues;
+
+    bool ok() const { return issues.empty(); }
+};
+
+// Directory of single-page TIFFs, one frame per file in alphabetical filename order (no index parsing). load() lists
+// and sorts the top level of the directory once, then parses the headers of every 10th file on a thread pool (reading
+// only the blocks that hold the directory, never pixels) and validates them against spec 3.2 and the first file's
+// format; every rejected file is listed in validationReport(). The sorted file list and every parsed header (size,
+// mtime and strip offsets per file: the load() samples, plus those parsed on first access, which updateIndex() adds)
+// are kept in a sidecar index inside the directory, so a reopen only re-reads the headers of files whose size or mtime
+// changed (checked at load() for samples, on first access for the rest). getFrame() maps the file and, when the
+// uncompressed pixel data is stored as gap-free rows in native byte order, returns a cv::Mat that points straight into
+// the mapping; the Mat keeps the mapping alive on its own and writes to it stay private to the process. Other layouts
+// are decoded into a fresh Mat. Each file's directory is parsed once and its strip offsets reused; its mapping is
+// reused for as long as a frame from it or one of the last kRecentMappings reads still holds it, so zero-copy frames
+// of one file share their pixels (treat them as read-only, like frames from a FrameCache). After load(),
+// getFrame(), readFrames() and updateIndex() may be called from several threads at once.
+class ImageSequenceSource final : public InputSource {
+public:
+    static constexpr std::size_t kMaxFiles = 100000;
+    static constexpr std::size_t kValidationStride = 10;
+    static constexpr std::size_t kRecentMappings = 8;
+
+    // scan_threads = 0 picks max(4, hardware threads): header reads are latency-bound, not CPU-bound.
+    ImageSequenceSource(const std::string& directory, double fps_manual, std::size_t scan_threads = 0);
+
+    // On failure error_message is the first issue of the validation report.
+    bool load(std::string& error_message);
+
+    static std::filesystem::path indexPath(const std::string& directory);
+
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return frames_.size(); }
+    // Throws std::out_of_range for an invalid index and std::runtime_error when the file cannot be read.
+    cv::Mat getFrame(std::size_t logical_index) override;
+    double getTimestamp(std::size_t logical_index) const override;
+
+    // Reads several frames with one batch of I/O (see BatchFrameReader): uncompressed native-order frames land in
+    // page-aligned Mats of their own, anything else goes through getFrame(). Same exceptions as getFrame().
+    std::vector<cv::Mat> readFrames(std::span<const std::size_t> logical_indices, BatchFrameReader& reader);
+
+    const std::string& framePath(std::size_t logical_index) const;
+    cv::Size frameSize() const { return frame_size_; }
+    int frameType() const { return frame_type_; }
+    TiffReadStats readStats() const;
+    // Headers parsed by getFrame() / readFrames() because neither the load() sample nor the index had them.
+    std::size_t headersParsedOnAccess() const { return headers_parsed_on_access_.load(std::memory_order_relaxed); }
+    const SequenceValidationReport& validationReport() const { return report_; }
+    // Rewrites the sidecar index when headers were parsed since load() (or the previous call), so the next open
+    // does not parse them again; a no-op otherwise. Call it once reading is done, not per frame.
+    void updateIndex();
+    // Why the sidecar index could not be written (e.g. read-only media); empty when it was written or was current.
+    const std::string& indexWriteError() const { return index_write_error_; }
+
+private:
+    struct FrameFile {
+        std::string path;
+        // Parsed on first access (or during validation sampling).
+        std::optional<TiffPageLayout> page;
+        bool little_endian = true;
+        // Size and mtime the page was parsed at; written to the sidecar index with the page.
+        std::optional<FileStamp> stamp;
+        // The page came from the index and the file has not been compared with `stamp` yet.
+        bool stamp_unchecked = false;
+        // Shared with the zero-copy frames and recent reads that still use it.
+        std::weak_ptr<MappedFile> mapping;
+    };
+
+    FrameFile layoutOf(FrameFile& frame);
+    void checkFormat(const FrameFile& frame) const;
+    bool reuseIndex(std::vector<FrameFile>& frames);
+    void validateSample(std::vector<FrameFile>& frames);
+    void writeIndex(const std::vector<FrameFile>& frames);
+    std::shared_ptr<MappedFile> mappingOf(FrameFile& frame, const FrameFile& parsed);
+    cv::Mat readFrame(FrameFile& frame);
+
+    std::string directory_;
+    double fps_manual_;
+    std::size_t scan_threads_;
+    std::vector<FrameFile> frames_;
+    cv::Size frame_size_;
+    int frame_type_ = -1;
+    std::mutex pages_mutex_;  // guards frames_' entries after load() and the three members below
+    std::size_t unindexed_headers_ = 0;
+    std::vector<std::shared_ptr<MappedFile>> recent_mappings_;
+    std::size_t next_recent_mapping_ = 0;
+    std::atomic<std::size_t> zero_copy_frames_{0};
+    std::atomic<std::size_t> decoded_frames_{0};
+    std::atomic<std::size_t> libtiff_frames_{0};
+    std::atomic<std::size_t> batched_frames_{0};
+    std::atomic<std::size_t> headers_parsed_on_access_{0};
+    SequenceValidationReport report_;
+    std::string index_write_error_;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "StreamFrame.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.4 Real-Time Camera Control)
+
+// Log-scale latency histogram: four buckets per power of two from 1 us to about 70 s, so percentiles are within
+// 19% of the true value. Not thread-safe; the scheduler records under its own locks and hands out copies.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBucketCount = 105;
+
+    void record(std::chrono::nanoseconds latency);
+
+    std::uint64_t count() const { return count_; }
+    double meanMs() const;
+    double maxMs() const { return max_us_ / 1000.0; }
+    // Upper edge of the bucket holding the `percentile`-th (0-100) sample, capped at the maximum; 0 when empty.
+    double percentileMs(double percentile) const;
+
+    // Samples in bucket `bucket`, and its upper edge (the last bucket is unbounded).
+    std::uint64_t bucketCount(std::size_t bucket) const { return buckets_[bucket]; }
+    static double bucketUpperMs(std::size_t bucket);
+
+    // "n=... mean=... p50=... p95=... p99=... max=... ms".
+    std::string summary() const;
+
+private:
+    std::array<std::uint64_t, kBucketCount> buckets_{};
+    std::uint64_t count_ = 0;
+    double sum_us_ = 0.0;
+    double max_us_ = 0.0;
+};
+
+enum class LiveAnalysisPolicy {
+    // Analyze the newest frame when the analyzer is free; any frame that was waiting is skipped.
+    LatestWins,
+    // Queue up to max_queued_frames; on overflow the oldest queued frame is skipped (spec 3.5 queue overflow).
+    BoundedLag,
+};
+
+struct LiveSchedulerParams {
+    LiveAnalysisPolicy policy = LiveAnalysisPolicy::LatestWins;
+    // BoundedLag only.
+    std::size_t max_queued_frames = 4;
+    // BoundedLag only: a queued frame that has waited longer than this since it arrived is skipped, unless it is
+    // the newest one. 0 = no age limit.
+    std::chrono::milliseconds max_lag{0};
+    // How long one grab call may wait; bounds how quickly stop() takes effect.
+    std::chrono::milliseconds grab_timeout{100};
+};
+
+struct LiveSchedulerStats {
+    std::uint64_t frames_grabbed = 0;
+    // Frames the camera reported lost (frame index gaps): acquisition itself fell behind.
+    std::uint64_t frames_lost = 0;
+    std::uint64_t grab_timeouts = 0;
+    std::uint64_t frames_displayed = 0;
+    // Newest frames replaced by a newer one before the display took them.
+    std::uint64_t display_superseded = 0;
+    std::uint64_t frames_analyzed = 0;
+    // Grabbed frames the analysis policy skipped (or stop() discarded).
+    std::uint64_t analysis_skipped = 0;
+    // Frames the analyzer threw on; analyzed + skipped + errors + still queued = grabbed.
+    std::uint64_t analysis_errors = 0;
+    std::string last_error;
+    // Arrival in the host buffer to takeDisplayFrame(), and to the analysis callback returning.
+    LatencyHistogram display_latency;
+    LatencyHistogram analysis_latency;
+};
+
+// Decouples acquisition, display and analysis of a live stream. A grab thread pulls frames from the camera as
+// fast as it delivers them and never waits for anything else, so a slow analysis cannot make the camera lose
+// frames. Each grabbed frame is shared (not copied) with the display, which always takes the newest one, and with
+// one analysis thread, which sees frames in acquisition order under the configured policy and counts every frame
+// it skips. End-to-end latencies from the camera's arrival time are kept as histograms.
+class LiveAnalysisScheduler {
+public:
+    // Called on the grab thread; e.g. wraps SimulatedCameraSource::grabNextFrame().
+    using Grabber = std::function<GrabStatus(StreamFrame& frame, std::chrono::microseconds timeout)>;
+    // Called on the analysis thread, one frame at a time. Exceptions are counted and the stream goes on.
+    using Analyzer = std::function<void(const StreamFrame& frame)>;
+
+    explicit LiveAnalysisScheduler(const LiveSchedulerParams& params = {});
+    ~LiveAnalysisScheduler();
+
+    LiveAnalysisScheduler(const LiveAnalysisScheduler&) = delete;
+    LiveAnalysisScheduler& operator=(const LiveAnalysisScheduler&) = delete;
+
+    // Starts the grab and analysis threads. `analyzer` may be empty (display only). False while running (until
+    // stop() or join() has returned) or without a grabber. A scheduler can be started again after stop() or join();
+    // the new run starts with no pending frames and fresh stats().
+    bool start(Grabber grabber, Analyzer analyzer, std::string& error_message);
+    // Stops grabbing now; frames still queued for analysis are skipped. Also called by the destructor.
+    void stop();
+    // Waits until the camera reports GrabStatus::Stopped and every queued frame has been analyzed (or skipped).
+    void join();
+
+    // For the UI's repaint timer: the newest frame, if it has not been taken yet.
+    bool takeDisplayFrame(StreamFrame& frame);
+
+    LiveSchedulerStats stats() const;
+
+private:
+    void grabLoop();
+    void analysisLoop();
+
+    LiveSchedulerParams params_;
+    Grabber grabber_;
+    Analyzer analyzer_;
+
+    mutable std::mutex display_mutex_;
+    StreamFrame display_frame_;
+    bool display_pending_ = false;
+
+    mutable std::mutex analysis_mutex_;
+    std::condition_variable analysis_ready_;
+    std::deque<StreamFrame> queue_;
+    bool grabbing_done_ = false;
+    bool stop_requested_ = false;
+
+    // Guarded by display_mutex_ / analysis_mutex_ as for the frames they describe; grab counters by analysis_mutex_.
+    LiveSchedulerStats stats_;
+
+    std::thread grab_thread_;
+    std::thread analysis_thread_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+// Whole-file private mapping. Pages are mapped copy-on-write (POSIX MAP_PRIVATE, Windows FILE_MAP_COPY), so
+// nothing is ever written back: callers that modify a cv::Mat pointing into the mapping only touch their own
+// copies of the affected pages. Shared ownership lets zero-copy frames keep the mapping alive after the
+// source that produced them has moved on.
+class MappedFile : public std::enable_shared_from_this<MappedFile> {
+public:
+    // Returns nullptr and sets error_message when the file cannot be opened or mapped (empty files included).
+    static std::shared_ptr<MappedFile> open(const std::filesystem::path& path, std::string& error_message);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::span<const std::uint8_t> bytes() const { return {data_, size_}; }
+
+    // cv::Mat header over [offset, offset + rows * step) of the mapping, without copying. The Mat (and every
+    // copy or ROI of it) holds a reference to this mapping. The range must lie inside the file.
+    cv::Mat matView(std::size_t offset, int rows, int cols, int type, std::size_t step) const;
+
+private:
+    MappedFile(std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+    std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.5 Memory Usage)
+
+enum class MemoryCategory {
+    FrameCache,
+    CompressedFrames,
+    Background,
+    DetectorScratch,
+    Results,
+    // Free buffers a PooledMatAllocator keeps for reuse.
+    PooledBuffers,
+    Other,
+};
+
+inline constexpr std::size_t kMemoryCategoryCount = 7;
+
+const char* memoryCategoryName(MemoryCategory category);
+
+struct MemoryUsage {
+    struct Category {
+        const char* name = "";
+        std::size_t bytes = 0;
+        std::size_t peak_bytes = 0;
+    };
+
+    std::array<Category, kMemoryCategoryCount> categories{};
+    std::size_t bytes = 0;
+    std::size_t peak_bytes = 0;
+    // 0 = unlimited.
+    std::size_t budget_bytes = 0;
+    // Times the governor went over budget and asked the shrinkers for memory, and what they gave back.
+    std::size_t shrink_requests = 0;
+    std::size_t shrunk_bytes = 0;
+    // Shrink requests that left usage over budget (everything left was pinned or not shrinkable).
+    std::size_t overruns = 0;
+
+    const Category& operator[](MemoryCategory category) const { return categories[static_cast<std::size_t>(category)]; }
+    // One line for the log, e.g. "612.0 MB (peak 1.9 GB) of 2.5 GB: frame_cache 512.0 MB, results 100.0 MB".
+    std::string summary() const;
+};
+
+// Process-wide account of the large allocations (cached frames, background models, detector working images,
+// accumulated results) against the peak-memory budget of spec 4.5. Components add and release the bytes they
+// hold under a category; caches also register a shrinker, a callback that frees up to the requested number of
+// bytes and returns how many it freed. Whenever usage grows past the budget, enforce() asks the shrinkers in
+// registration order for the excess, so caches give up frames to make room for everything else rather than the
+// process swapping. add() and release() are lock-free and never shrink, so they are safe under a component's own
+// locks; enforce() (and a growing MemoryCharge) must be called without holding a lock any shrinker takes.
+class MemoryGovernor {
+public:
+    // Spec 4.5 peak-memory targets.
+    static constexpr std::size_t kOfflineBudgetBytes = 2560U * 1024U * 1024U;
+    static constexpr std::size_t kRealtimeBudgetBytes = 800U * 1024U * 1024U;
+
+    using Shrinker = std::function<std::size_t(std::size_t bytes)>;
+    using ShrinkerId = std::uint64_t;
+
+    // The instance components register with by default; its budget starts at kOfflineBudgetBytes.
+    static MemoryGovernor& global();
+
+    // 0 = unlimited (usage is still tracked).
+    explicit MemoryGovernor(std::size_t budget_bytes = 0);
+
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    // Lowering the budget shrinks right away.
+    void setBudget(std::size_t bytes);
+    std::size_t getBudgetBytes() const { return budget_.load(); }
+
+    void add(MemoryCategory category, std::size_t bytes);
+    void release(MemoryCategory category, std::size_t bytes);
+
+    // Asks the shrinkers for the bytes over budget; returns what they freed. One thread shrinks at a time (the
+    // others wait and usually find usage back under budget); calls from inside a shrinker do nothing.
+    std::size_t enforce();
+
+    ShrinkerId addShrinker(Shrinker shrinker);
+    // Waits for a shrink in progress, so the callback is never running once this returns.
+    void removeShrinker(ShrinkerId id);
+
+    std::size_t currentBytes() const { return bytes_.load(); }
+    std::size_t currentBytes(MemoryCategory category) const;
+    std::size_t peakBytes() const { return peak_bytes_.load(); }
+    MemoryUsage usage() const;
+    // Starts peak tracking over from the current usage (per benchmark run, per analysis).
+    void resetPeak();
+
+private:
+    struct Account {
+        std::atomic<std::size_t> bytes{0};
+        std::atomic<std::size_t> peak_bytes{0};
+    };
+
+    struct Registration {
+        ShrinkerId id = 0;
+        Shrinker shrinker;
+    };
+
+    std::atomic<std::size_t> budget_;
+    std::array<Account, kMemoryCategoryCount> accounts_;
+    std::atomic<std::size_t> bytes_{0};
+    std::atomic<std::size_t> peak_bytes_{0};
+    std::atomic<std::size_t> shrink_requests_{0};
+    std::atomic<std::size_t> shrunk_bytes_{0};
+    std::atomic<std::size_t> overruns_{0};
+
+    // Held while shrinking and while the registrations change.
+    std::mutex shrink_mutex_;
+    std::vector<Registration> shrinkers_;
+    ShrinkerId next_id_ = 1;
+};
+
+// Bytes held under a category for as long as the charge lives. Growing it enforces the budget, so do that
+// outside locks a shrinker may need. A copy charges the same bytes again; a moved-from charge holds nothing.
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemoryCategory category, std::size_t bytes = 0,
+                          MemoryGovernor& governor = MemoryGovernor::global());
+    ~MemoryCharge();
+
+    MemoryCharge(const MemoryCharge& other);
+    MemoryCharge& operator=(const MemoryCharge& other);
+    MemoryCharge(MemoryCharge&& other) noexcept;
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+
+    void resize(std::size_t bytes);
+    void reset() { resize(0); }
+    std::size_t bytes() const { return bytes_; }
+    MemoryCategory category() const { return category_; }
+
+private:
+    MemoryGovernor* governor_;
+    MemoryCategory category_;
+    std::size_t bytes_ = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "BatchFrameReader.h"
+#include "InputSource.h"
+#include "MappedFile.h"
+#include "SidecarIndex.h"
+#include "TiffFormat.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 2: Multi-Page TIFF Source)
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+// Multi-page TIFF (classic or BigTIFF) read through one memory mapping of the whole file. load() walks the IFD
+// chain once, validates every page against spec 3.2 and page 0, and keeps each page's strip layout, so
+// getFrame() is O(1) in the page index: a zero-copy Mat over the mapping for contiguous native-order pages, a
+// decoded copy otherwise (libtiff, seeking directly to the page's directory, for compressed pages).
+// The page table is cached in a sidecar "<file>.idx" keyed by the file's size and modification time; reopening
+// an unchanged stack skips the scan. Writing the sidecar is best-effort (read-only media just rescans).
+// getFrame() may be called concurrently from several threads once load() has returned.
+class MultiPageTIFFSource final : public InputSource {
+public:
+    // Spec 3.2 limit for fluorescence stacks; pass 0 for unlimited (time-lapse stacks).
+    static constexpr std::size_t kFluorescenceMaxPages = 10;
+
+    explicit MultiPageTIFFSource(const std::string& tiff_path, std::size_t max_pages = kFluorescenceMaxPages);
+
+    bool load(std::string& error_message);
+
+    Type getType() const override { return Type::MultiPageTIFF; }
+    std::size_t getTotalFrames() const override { return pages_.size(); }
+    // Throws std::out_of_range for an invalid index and std::runtime_error when the page cannot be decoded.
+    cv::Mat getFrame(std::size_t page_index) override;
+    // Multi-page TIFF has no inherent timestamps: the page index is returned.
+    double getTimestamp(std::size_t page_index) const override { return static_cast<double>(page_index); }
+
+    // Reads several pages with one batch of I/O (see BatchFrameReader) into page-aligned Mats of their own instead
+    // of views of the mapping; pages that need decoding go through getFrame(). Same exceptions as getFrame().
+    std::vector<cv::Mat> readFrames(std::span<const std::size_t> page_indices, BatchFrameReader& reader);
+
+    cv::Size frameSize() const { return frame_size_; }
+    int frameType() const { return frame_type_; }
+    bool isBigTiff() const { return big_tiff_; }
+    // True when the page table came from the sidecar index rather than a scan of the file.
+    bool loadedFromIndex() const { return loaded_from_index_; }
+    // Why the sidecar could not be written during the last load() (empty on success).
+    const std::string& indexWriteError() const { return index_write_error_; }
+    TiffReadStats readStats() const;
+
+    static std::filesystem::path indexPath(const std::string& tiff_path);
+
+private:
+    bool readIndex(const FileStamp& stamp);
+    void writeIndex(const FileStamp& stamp);
+    bool scan(std::string& error_message);
+
+    std::string path_;
+    std::size_t max_pages_;
+    std::shared_ptr<MappedFile> file_;
+    bool little_endian_ = true;
+    bool big_tiff_ = false;
+    std::vector<TiffPageLayout> pages_;
+    cv::Size frame_size_;
+    int frame_type_ = -1;
+    bool loaded_from_index_ = false;
+    std::string index_write_error_;
+
+    std::atomic<std::size_t> zero_copy_frames_{0};
+    std::atomic<std::size_t> decoded_frames_{0};
+    std::atomic<std::size_t> libtiff_frames_{0};
+    std::atomic<std::size_t> batched_frames_{0};
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+// cv::Mat header over rows x cols pixels at `data` (rows `step` bytes apart) inside memory that `owner` keeps
+// alive, e.g. a file mapping or an aligned read buffer. The Mat and every copy or ROI of it share a reference to
+// the owner, so the memory is released with the last of them, not when the producer goes away.
+cv::Mat wrapOwnedMemory(std::shared_ptr<const void> owner, std::uint8_t* data, int rows, int cols, int type,
+                        std::size_t step);
+
+// Uninitialised buffer of `bytes` bytes whose start is aligned to `alignment` (a power of two).
+std::shared_ptr<std::uint8_t> allocateAligned(std::size_t bytes, std::size_t alignment);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "MemoryGovernor.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.3 Performance Targets, 4.5 Memory Usage)
+
+struct PooledMatAllocatorParams {
+    // Free buffers kept for reuse, over all size classes; buffers returned beyond this are unmapped.
+    std::size_t max_retained_bytes = 256U * 1024U * 1024U;
+    // Smaller requests go to OpenCV's standard allocator: malloc serves them from its heap without syscalls.
+    std::size_t min_pooled_bytes = 256U * 1024U;
+    // Back buffers of 2 MB and more with transparent huge pages (Linux; ignored elsewhere).
+    bool huge_pages = false;
+};
+
+struct PooledMatAllocatorStats {
+    // Pooled allocations served from a free list / by mapping a new buffer.
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    // Allocations passed to the standard allocator (too small, or over user data).
+    std::size_t unpooled = 0;
+    // Returned buffers unmapped because the retention limit was reached (or by trim()).
+    std::size_t released = 0;
+    std::size_t buffers_retained = 0;
+    std::size_t bytes_retained = 0;
+    std::size_t bytes_in_use = 0;
+};
+
+// cv::MatAllocator that recycles the many-megabyte buffers OpenCV allocates and frees for every frame (colour
+// conversions, blurs, thresholds, float accumulators). Requests are rounded up to a size class (whole pages, eight
+// classes per power of two, so at most 12.5% goes unused) and served from that class's free list; only a miss maps
+// new, page-aligned memory, so a steady pipeline stops paying for mmap/munmap and first-touch page faults. Free
+// buffers count against the memory governor, which can ask the pool to unmap them.
+//
+// Install it for a pipeline or a thread with ScopedMatAllocator, or for a single Mat by setting Mat::allocator
+// before create(). Buffers may be freed from any thread, and a pool lives on (without retaining anything) until the
+// last Mat allocated from it is gone, so frames may outlive the pipeline that produced them.
+class PooledMatAllocator final : public cv::MatAllocator {
+public:
+    static constexpr std::size_t kHugePageBytes = 2U * 1024U * 1024U;
+
+    static std::shared_ptr<PooledMatAllocator> create(const PooledMatAllocatorParams& params = {},
+                                                      MemoryGovernor* governor = &MemoryGovernor::global());
+    // This thread's own pool (default parameters), created on first use.
+    static const std::shared_ptr<PooledMatAllocator>& forCurrentThread();
+
+    PooledMatAllocator(const PooledMatAllocator&) = delete;
+    PooledMatAllocator& operator=(const PooledMatAllocator&) = delete;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, std::size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage_flags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    // Bytes actually mapped for a pooled request of `bytes`.
+    std::size_t sizeClass(std::size_t bytes) const;
+    // Unmaps free buffers until at least `bytes` are released (all of them by default); returns the bytes released.
+    std::size_t trim(std::size_t bytes = static_cast<std::size_t>(-1)) const;
+    PooledMatAllocatorStats stats() const;
+
+private:
+    PooledMatAllocator(const PooledMatAllocatorParams& params, MemoryGovernor* governor);
+    ~PooledMatAllocator() override;
+
+    // Called when the owning shared_ptr goes; the pool is deleted once no buffer is out either.
+    void detach();
+    void unreference() const;
+
+    const PooledMatAllocatorParams params_;
+    MemoryGovernor* governor_;
+    MemoryGovernor::ShrinkerId shrinker_id_ = 0;
+
+    // The owner plus one per buffer handed out.
+    mutable std::atomic<std::size_t> references_{1};
+
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<std::size_t, std::vector<void*>> free_lists_;  // by size class
+    mutable bool detached_ = false;
+    mutable PooledMatAllocatorStats stats_;
+};
+
+// Routes cv::Mat allocations made on this thread through `pool` until destroyed; guards nest. Allocations on other
+// threads, and on this one outside a guard, use whatever default allocator was installed before.
+class ScopedMatAllocator {
+public:
+    explicit ScopedMatAllocator(std::shared_ptr<PooledMatAllocator> pool = PooledMatAllocator::forCurrentThread());
+    ~ScopedMatAllocator();
+
+    ScopedMatAllocator(const ScopedMatAllocator&) = delete;
+    ScopedMatAllocator& operator=(const ScopedMatAllocator&) = delete;
+
+private:
+    std::shared_ptr<PooledMatAllocator> pool_;
+    const PooledMatAllocator* previous_;
+};
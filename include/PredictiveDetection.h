@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DataModels.h"
+#include "DropletDetection.h"
+#include "DropletTracking.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (high-speed acquisition modes, core detection pipeline)
+
+struct PredictiveDetectionParams {
+    DropletDetectionParams detection;
+    // Inlet region where new droplets appear; always processed. Empty disables it, in which case new
+    // droplets are only picked up at resyncs.
+    cv::Rect entry_zone;
+    // Extra pixels around each predicted droplet box (search radius + half the droplet extent).
+    int window_margin_px = 4;
+    // Full-frame detection every N frames (0 disables periodic resyncs).
+    std::size_t resync_interval_frames = 100;
+    // Run full-frame detection instead when the windows would cover more than this fraction of the frame.
+    double max_window_fraction = 0.5;
+};
+
+struct PredictiveDetectionStats {
+    bool full_frame = false;
+    // Why the frame fell back to full-frame detection.
+    bool resync_scheduled = false;
+    bool gating_failed = false;
+    std::size_t windows = 0;
+    // Pixels fed through the detection pipeline (including context padding and any fallback pass)
+    // divided by the frame area. Can exceed 1 on a frame where gating failed.
+    double processed_pixel_fraction = 0.0;
+};
+
+// Runs detectDroplets() only inside windows around tracker predictions plus the entry zone. Each window
+// is padded by detectionContextRadius(), so detections inside it match full-frame detection exactly.
+// Falls back to full-frame detection on the first frame, every resync_interval_frames, and whenever
+// gating fails: a predicted droplet inside the frame has no detection within its gate, or a detection
+// is clipped by a window edge. Not thread-safe; use one detector per stream.
+class PredictiveDropletDetector {
+public:
+    explicit PredictiveDropletDetector(const PredictiveDetectionParams& params);
+
+    // `predictions` are normally StreamingTracker::predictions(frame_index) for this frame.
+    std::vector<Detection> detect(const cv::Mat& frame, const std::vector<TrackPrediction>& predictions);
+
+    // Forces full-frame detection on the next call (e.g. after a seek or a parameter change).
+    void requestResync() { resync_requested_ = true; }
+
+    const PredictiveDetectionStats& lastStats() const { return last_stats_; }
+    // Processed-pixel fraction averaged over every frame seen so far.
+    double averageProcessedFraction() const;
+    std::size_t framesProcessed() const { return frames_; }
+    std::size_t fullFrameCount() const { return full_frames_; }
+
+private:
+    std::vector<Detection> detectFullFrame(const cv::Mat& frame);
+    void buildWindows(const cv::Size& frame_size, const std::vector<TrackPrediction>& predictions);
+    bool detectInWindows(const cv::Mat& frame,
+                         const std::vector<TrackPrediction>& predictions,
+                         std::vector<Detection>& detections,
+                         double& processed_pixels);
+
+    PredictiveDetectionParams params_;
+    int context_radius_ = 0;
+    cv::Size frame_size_;
+    bool resync_requested_ = true;
+    std::size_t frames_since_resync_ = 0;
+
+    std::size_t frames_ = 0;
+    std::size_t full_frames_ = 0;
+    double processed_fraction_sum_ = 0.0;
+    PredictiveDetectionStats last_stats_;
+
+    std::vector<cv::Rect> windows_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <opencv2/core.hpp>
+
+#include "InputSource.h"
+#include "ThreadPool.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+struct PrefetchParams {
+    // Dedicated I/O threads; reads never run on the consumer's thread unless the frame was not prefetched.
+    std::size_t io_threads = 2;
+    // Bytes of frames read ahead but not yet consumed (in flight or ready), including reads that were cancelled
+    // while in flight and have not returned yet.
+    std::size_t byte_budget = 256U * 1024U * 1024U;
+    // Upper bound on frames ahead of the consumer, whatever the budget allows.
+    std::size_t max_depth = 8;
+    // Requests with the same stride in a row before read-ahead starts (1 = after the second request).
+    std::size_t confirmations = 2;
+};
+
+struct PrefetchStats {
+    // getFrame() calls served from a finished prefetch / from one still in flight (the consumer waited).
+    std::size_t hits = 0;
+    std::size_t late_hits = 0;
+    // getFrame() calls that read synchronously.
+    std::size_t misses = 0;
+    std::size_t issued = 0;
+    // Prefetches dropped because the access pattern moved on (queued, in flight or already read).
+    std::size_t cancelled = 0;
+    std::size_t pattern_changes = 0;
+    std::size_t peak_bytes = 0;
+};
+
+// Read-ahead decorator for file-backed sources. It watches the indices passed to getFrame(); once the same
+// stride (sequential playback, or every Nth frame during auto-tune sampling, forwards or backwards) has been seen
+// `confirmations` times it reads the next frames along that stride on its own I/O pool, up to max_depth frames and
+// byte_budget bytes, and hands them out when they are requested. Any other request (a GUI scrub, a seek) counts
+// as a pattern change: everything read ahead is dropped, queued reads are skipped and reads already in flight are
+// discarded when they finish (their buffers count against byte_budget until then). Prefetched frames are consumed once; repeated requests for the same frame go to
+// the wrapped source. The wrapped source must allow concurrent getFrame() calls (both TIFF sources do).
+class PrefetchingSource final : public InputSource {
+public:
+    explicit PrefetchingSource(std::shared_ptr<InputSource> source, const PrefetchParams& params = {});
+    ~PrefetchingSource() override;
+
+    PrefetchingSource(const PrefetchingSource&) = delete;
+    PrefetchingSource& operator=(const PrefetchingSource&) = delete;
+
+    Type getType() const override { return source_->getType(); }
+    std::size_t getTotalFrames() const override { return source_->getTotalFrames(); }
+    cv::Mat getFrame(std::size_t logical_index) override;
+    double getTimestamp(std::size_t logical_index) const override { return source_->getTimestamp(logical_index); }
+
+    PrefetchStats stats() const;
+    const InputSource& source() const { return *source_; }
+
+private:
+    struct Slot {
+        std::uint64_t generation = 0;
+        bool ready = false;
+        // A pool thread is reading the frame (set when the read starts, not when it is queued).
+        bool in_flight = false;
+        cv::Mat frame;
+        // Estimate while in flight, actual size once ready.
+        std::size_t bytes = 0;
+    };
+
+    bool takeSlot(std::size_t index, cv::Mat& frame, std::unique_lock<std::mutex>& lock);
+    void observe(std::size_t index);
+    void schedule(std::size_t index);
+    void read(std::size_t index, std::uint64_t generation);
+    std::size_t bytesInUse() const;
+
+    std::shared_ptr<InputSource> source_;
+    PrefetchParams params_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slot_ready_;
+    std::map<std::size_t, Slot> slots_;
+    // Bytes of reads cancelled while in flight, by generation, until those reads return.
+    std::map<std::uint64_t, std::size_t> abandoned_;
+    std::uint64_t generation_ = 0;
+    bool has_last_ = false;
+    std::size_t last_index_ = 0;
+    std::ptrdiff_t stride_ = 0;
+    std::size_t repeats_ = 0;
+    std::size_t frame_bytes_ = 0;
+    PrefetchStats stats_;
+
+    // Last member: destroyed (and drained) first, while everything its tasks touch is still alive.
+    ThreadPool pool_;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "InputSource.h"
+#include "MappedFile.h"
+#include "StreamFrame.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Storage: NVMe SSD)
+
+// Raw recording container (little-endian):
+//   [0, 4096)      header: magic "DRAWREC1", version, frame geometry, chunk layout, fps, frame count, index offset
+//   [4096, ...)    chunks of chunk_frames frames, packed (frame_bytes each), each chunk padded to a multiple of 4096
+//   index_offset   one entry per recorded frame: camera frame index (u64), timestamp (f64)
+// Recording frame i lives in chunk i / chunk_frames. The frame count and index offset are only written by
+// RawRecorder::finish(), so an interrupted recording is rejected rather than half-read.
+namespace RawRecordingFormat {
+constexpr char kMagic[8] = {'D', 'R', 'A', 'W', 'R', 'E', 'C', '1'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderBytes = 4096;
+constexpr std::size_t kAlignment = 4096;
+constexpr std::size_t kIndexEntryBytes = 16;
+
+struct IndexEntry {
+    std::uint64_t frame_index = 0;
+    double timestamp = 0.0;
+};
+} // namespace RawRecordingFormat
+
+struct RawRecorderParams {
+    // Target size of one write; a chunk holds as many whole frames as fit (at least one).
+    std::size_t chunk_bytes = 32U * 1024U * 1024U;
+    // Chunk buffers: one being filled while the others are written (2 = plain double buffering).
+    std::size_t buffers = 4;
+    // Write around the page cache (O_DIRECT on Linux, FILE_FLAG_NO_BUFFERING on Windows); falls back to buffered
+    // writes where the filesystem does not support it (tmpfs).
+    bool direct_io = true;
+    // Disk space is reserved this far ahead of the data written so far (Linux posix_fallocate; 0 = never).
+    std::size_t preallocate_bytes = 1024U * 1024U * 1024U;
+};
+
+struct RawRecorderStats {
+    std::uint64_t frames_recorded = 0;
+    // Frames refused because every chunk buffer was still waiting for the disk, the frame did not match the
+    // recording's size or type, or an earlier write had failed.
+    std::uint64_t frames_dropped = 0;
+    std::uint64_t chunks_written = 0;
+    std::uint64_t bytes_written = 0;
+    // Most chunks ever waiting for the writer at once.
+    std::size_t peak_queued_chunks = 0;
+    bool direct_io = false;
+};
+
+// Recording sink for the acquisition thread. record() only copies the frame into the chunk buffer being filled;
+// full chunks go to a writer thread that issues one large aligned write each. record() never waits for the disk:
+// when every buffer is still queued it drops the frame and counts it, and the camera frame index stored with each
+// recorded frame shows the gap. Not thread-safe: record() and finish() belong to one thread.
+class RawRecorder {
+public:
+    explicit RawRecorder(const RawRecorderParams& params = {});
+    ~RawRecorder();
+
+    RawRecorder(const RawRecorder&) = delete;
+    RawRecorder& operator=(const RawRecorder&) = delete;
+
+    // Creates (or truncates) `path` for frames of `frame_size` and `type` and starts the writer thread.
+    bool open(const std::string& path, cv::Size frame_size, int type, double fps, std::string& error_message);
+    bool isOpen() const { return writer_.joinable(); }
+
+    // False when the frame was dropped.
+    bool record(const StreamFrame& frame);
+
+    // Writes the last partial chunk, waits for the writer, then appends the index and completes the header.
+    // False when any write failed; the file is then not a valid recording. Also called by the destructor.
+    bool finish(std::string& error_message);
+
+    RawRecorderStats stats() const;
+
+private:
+    struct Chunk {
+        std::shared_ptr<std::uint8_t> data;
+        std::size_t frames = 0;
+        std::uint64_t number = 0;
+    };
+
+    static constexpr std::size_t kNoChunk = static_cast<std::size_t>(-1);
+
+    void submitFilling();
+    void writeLoop();
+
+    RawRecorderParams params_;
+    std::string path_;
+    cv::Size frame_size_;
+    int type_ = -1;
+    double fps_ = 0.0;
+    std::size_t frame_bytes_ = 0;
+    std::size_t chunk_frames_ = 0;
+    std::size_t chunk_bytes_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;  // HANDLE
+#else
+    int fd_ = -1;
+#endif
+    std::uint64_t allocated_bytes_ = 0;  // writer thread
+
+    // Acquisition side.
+    std::vector<RawRecordingFormat::IndexEntry> index_;
+    std::size_t filling_ = kNoChunk;
+    std::uint64_t next_chunk_ = 0;
+
+    std::vector<Chunk> chunks_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::size_t> free_;
+    std::deque<std::size_t> queued_;
+    bool closing_ = false;
+    std::string write_error_;
+    std::atomic<bool> failed_{false};
+    RawRecorderStats stats_;
+
+    std::thread writer_;
+};
+
+// Reads a finished RawRecorder container through one memory mapping: getFrame() is a zero-copy view of the
+// frame's bytes, so recorded runs are re-analyzed without any decoding. getFrame() may be called concurrently
+// once load() has returned.
+class RawRecordingSource final : public InputSource {
+public:
+    explicit RawRecordingSource(std::string path);
+
+    bool load(std::string& error_message);
+
+    // A recording is a finite, timestamped frame sequence.
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return index_.size(); }
+    // Throws std::out_of_range for an invalid index.
+    cv::Mat getFrame(std::size_t logical_index) override;
+    // Camera timestamp recorded with the frame (seconds since acquisition start).
+    double getTimestamp(std::size_t logical_index) const override { return index_.at(logical_index).timestamp; }
+
+    // The camera's frame counter for recording frame `logical_index`; gaps are frames the camera or the recorder
+    // lost.
+    std::uint64_t cameraFrameIndex(std::size_t logical_index) const { return index_.at(logical_index).frame_index; }
+    cv::Size frameSize() const { return frame_size_; }
+    int frameType() const { return type_; }
+    double fps() const { return fps_; }
+
+private:
+    std::string path_;
+    std::shared_ptr<MappedFile> file_;
+    cv::Size frame_size_;
+    int type_ = -1;
+    double fps_ = 0.0;
+    std::size_t frame_bytes_ = 0;
+    std::size_t chunk_frames_ = 0;
+    std::size_t chunk_bytes_ = 0;
+    std::vector<RawRecordingFormat::IndexEntry> index_;
+};
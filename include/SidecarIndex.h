@@ -0,0 +1,73 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+// Size and modification time of a file, recorded in an index so a stale index is detected on reopen.
+struct FileStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime_ticks = 0;
+
+    static std::optional<FileStamp> of(const std::filesystem::path& path);
+    bool operator==(const FileStamp&) const = default;
+};
+
+// Versioned binary index stored next to input data, so expensive scans (IFD chains, directory listings) can be
+// skipped when the data is reopened. Integers are stored little-endian; the file ends in an FNV-1a 64 checksum
+// of everything before it and is replaced atomically (temporary file + rename). Indexes are a pure cache:
+// callers treat every read or write failure as "no index" and fall back to scanning.
+class SidecarWriter {
+public:
+    SidecarWriter(std::string_view magic, std::uint32_t version);
+
+    template <std::integral T>
+    void put(T value) {
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bytes_.push_back(static_cast<std::uint8_t>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xFFU));
+        }
+    }
+    void putString(std::string_view text);
+
+    bool commit(const std::filesystem::path& path, std::string& error_message) const;
+
+private:
+    std::vector<std::uint8_t> bytes_;
+};
+
+class SidecarReader {
+public:
+    // Empty when the file is missing, truncated, corrupt, or has a different magic or version.
+    static std::optional<SidecarReader> open(const std::filesystem::path& path, std::string_view magic,
+                                             std::uint32_t version);
+
+    template <std::integral T>
+    bool get(T& value) {
+        if (sizeof(T) > end_ - position_) {
+            return false;
+        }
+        std::uint64_t raw = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            raw |= static_cast<std::uint64_t>(bytes_[position_ + i]) << (8 * i);
+        }
+        value = static_cast<T>(raw);
+        position_ += sizeof(T);
+        return true;
+    }
+    bool getString(std::string& text);
+
+    // Remaining payload bytes (the checksum is not part of the payload).
+    std::size_t remaining() const { return end_ - position_; }
+
+private:
+    std::vector<std::uint8_t> bytes_;
+    std::size_t position_ = 0;
+    std::size_t end_ = 0;
+};
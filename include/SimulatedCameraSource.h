@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "InputSource.h"
+#include "StreamFrame.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+// Spec reference: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.4 Real-Time Camera Control, 4.5 Memory Usage)
+
+struct SimulatedCameraParams {
+    int width = 2304;
+    int height = 2304;
+    // CV_8UC1 or CV_16UC1.
+    int type = CV_16UC1;
+    double fps = 23.3;
+    // Host frame buffers the camera writes into, as with dcambuf_alloc(); frames not read before the camera comes
+    // round again are lost.
+    std::size_t ring_frames = 10;
+    // Frames to acquire before stopping; 0 = until stop().
+    std::uint64_t frame_limit = 0;
+
+    // Generated frames: bright droplets on a noisy background, flowing along x by one grid step every
+    // `pattern_frames` frames (so the pattern repeats seamlessly). Generated once when acquisition starts.
+    std::size_t pattern_frames = 16;
+    int droplet_radius_px = 30;
+    int droplet_spacing_px = 120;
+
+    // When set, its first `replay_frames` frames (0 = all) are loaded at start and replayed in a loop instead;
+    // their size and type replace width, height and type.
+    std::shared_ptr<InputSource> replay;
+    std::size_t replay_frames = 32;
+
+    // Spec 3.5 AC-R3: 2304x2304, 16-bit, 23.3 FPS.
+    static SimulatedCameraParams fullFrame();
+    // Spec 3.5 AC-R4: 2304x4, 8-bit, 8938 FPS.
+    static SimulatedCameraParams highSpeedLine();
+};
+
+struct SimulatedCameraStats {
+    std::uint64_t frames_acquired = 0;
+    std::uint64_t frames_delivered = 0;
+    // Frames overwritten in the ring before they were read, and the grabs that reported such a gap.
+    std::uint64_t frames_lost = 0;
+    std::uint64_t lost_frame_events = 0;
+    // Frames the simulated camera produced later than one frame interval after their exposure time (the host
+    // could not keep up with generating them; a real camera would not be late).
+    std::uint64_t late_frames = 0;
+};
+
+// Hardware-free CameraStream source for load-testing the live path: a producer thread acquires frames at the
+// configured rate into a ring of host buffers, the way DCAM does, and grabNextFrame() hands them to one consumer.
+// The ring is lock-free and single-producer/single-consumer, and nothing is copied on the way out: buffers are
+// swapped between the ring and the caller's StreamFrame, and the buffer the caller held before goes back to the
+// camera. The camera never waits. When the consumer falls a whole ring behind, the oldest frames are overwritten,
+// the next grab returns GrabStatus::LostFrame with the oldest frame still available, and the gap also shows in
+// StreamFrame::frame_index, matching DCAMERR_LOSTFRAME. Only one thread may grab at a time.
+class SimulatedCameraSource final : public InputSource {
+public:
+    explicit SimulatedCameraSource(SimulatedCameraParams params = {});
+    ~SimulatedCameraSource() override;
+
+    SimulatedCameraSource(const SimulatedCameraSource&) = delete;
+    SimulatedCameraSource& operator=(const SimulatedCameraSource&) = delete;
+
+    // Generates (or loads) the frames and starts acquisition. False for invalid parameters, an unreadable replay
+    // source, or when started and not stopped since. After stop() the camera can be started again: acquisition
+    // restarts at frame index 0 with an empty ring and fresh stats().
+    bool start(std::string& error_message);
+    // Ends acquisition; frames already in the ring can still be grabbed until the next start(). Also called by the
+    // destructor.
+    void stop();
+    bool isAcquiring() const { return acquiring_.load(); }
+
+    // Waits up to `timeout` for the next frame. On Ok and LostFrame, `frame` receives it and its previous image
+    // buffer is recycled (a buffer still shared with other Mats is left to them).
+    GrabStatus grabNextFrame(StreamFrame& frame, std::chrono::microseconds timeout);
+
+    Type getType() const override { return Type::CameraStream; }
+    std::size_t getTotalFrames() const override { return 0; }
+    // Streams have no random access: the next frame in acquisition order, whatever the index (an empty Mat once
+    // stopped, or after waiting one second for a frame).
+    cv::Mat getFrame(std::size_t logical_index) override;
+    // Camera time of frame `logical_index` (frame index / fps).
+    double getTimestamp(std::size_t logical_index) const override;
+
+    const SimulatedCameraParams& params() const { return params_; }
+    cv::Size frameSize() const { return cv::Size(params_.width, params_.height); }
+    SimulatedCameraStats stats() const;
+
+private:
+    struct Buffer {
+        StreamFrame frame;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<Buffer*> buffer{nullptr};
+    };
+
+    bool prepareFrames(std::string& error_message);
+    void acquire();
+    Buffer* spareBuffer();
+
+    SimulatedCameraParams params_;
+    std::vector<cv::Mat> frames_;  // generated or replayed, cycled through
+
+    std::vector<Slot> slots_;
+    // Every buffer ever allocated, owned here; the ring, the return queue and the camera pass raw pointers.
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    // Buffers the consumer hands back to the camera: single-producer (consumer) / single-consumer (camera).
+    std::vector<std::atomic<Buffer*>> returned_;
+    alignas(64) std::atomic<std::size_t> returned_head_{0};  // next to pop (camera)
+    alignas(64) std::atomic<std::size_t> returned_tail_{0};  // next to push (consumer)
+    std::vector<Buffer*> recycled_;  // camera-side: buffers it overwrote
+
+    // Frames published into the ring so far; frame k lives in slot k % ring_frames.
+    alignas(64) std::atomic<std::uint64_t> acquired_{0};
+    alignas(64) std::uint64_t next_index_ = 0;  // consumer-side
+
+    std::thread camera_;
+    std::atomic<bool> acquiring_{false};
+    std::atomic<bool> stop_requested_{false};
+
+    std::atomic<std::uint64_t> delivered_{0};
+    std::atomic<std::uint64_t> lost_{0};
+    std::atomic<std::uint64_t> lost_events_{0};
+    std::atomic<std::uint64_t> late_{0};
+};
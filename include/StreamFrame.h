@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <opencv2/core.hpp>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+
+// One frame from a live (CameraStream) source.
+struct StreamFrame {
+    cv::Mat image;
+    // The camera's running frame counter (DCAM iFrame): it counts every exposed frame, so a gap between two
+    // delivered frames is the number of frames lost in between.
+    std::uint64_t frame_index = 0;
+    // Camera time of the exposure, in seconds since acquisition start.
+    double timestamp = 0.0;
+    // When the frame reached the host buffer; grab-to-analysis latency is measured from here.
+    std::chrono::steady_clock::time_point arrival;
+};
+
+enum class GrabStatus {
+    Ok,
+    // The frame is valid, but frames before it were overwritten before they were read (DCAMERR_LOSTFRAME).
+    LostFrame,
+    // No frame arrived within the timeout.
+    Timeout,
+    // Acquisition has ended and every buffered frame has been delivered.
+    Stopped,
+};
+
+inline const char* grabStatusName(GrabStatus status) {
+    switch (status) {
+        case GrabStatus::Ok:
+            return "ok";
+        case GrabStatus::LostFrame:
+            return "lost_frame";
+        case GrabStatus::Timeout:
+            return "timeout";
+        case GrabStatus::Stopped:
+            break;
+    }
+    return "stopped";
+}
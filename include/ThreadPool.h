@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Spec reference: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+// Fixed-size worker pool for I/O-bound background work (header scans, prefetch reads). Tasks run in submission
+// order; exceptions are delivered through the returned future. The destructor finishes every queued task before
+// joining, so futures obtained from submit() always become ready.
+class ThreadPool {
+public:
+    // 0 = std::thread::hardware_concurrency() (at least 1).
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F task) {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    std::size_t threadCount() const { return workers_.size(); }
+
+private:
+    void enqueue(std::function<void()> task);
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "MappedFile.h"
+#include "SidecarIndex.h"
+
+// Spec reference: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+// Directory entries of one TIFF page that the readers need. Strip offsets and byte counts are absolute file
+// positions, so an uncompressed page can be read straight out of a memory mapping.
+struct TiffPageLayout {
+    // File offset of this page's image file directory (lets libtiff jump straight to it).
+    std::uint64_t ifd_offset = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint16_t bits_per_sample = 0;
+    std::uint16_t samples_per_pixel = 1;
+    std::uint16_t compression = 1;  // 1 = uncompressed
+    std::uint16_t photometric = 1;  // 1 = min-is-black
+    std::uint16_t planar_configuration = 1;
+    std::uint16_t sample_format = 1;  // 1 = unsigned integer
+    bool tiled = false;
+    std::uint32_t rows_per_strip = 0;
+    std::vector<std::uint64_t> strip_offsets;
+    std::vector<std::uint64_t> strip_byte_counts;
+};
+
+struct TiffFileLayout {
+    bool little_endian = true;
+    bool big_tiff = false;
+    std::vector<TiffPageLayout> pages;
+};
+
+enum class TiffReadPath { ZeroCopy, Decoded, Libtiff };
+
+struct TiffReadStats {
+    // Frames returned as headers over the file mapping (no pixel copy).
+    std::size_t zero_copy_frames = 0;
+    // Uncompressed frames copied out of the mapping (strip gaps, misalignment or foreign byte order).
+    std::size_t decoded_frames = 0;
+    // Compressed frames decoded through libtiff (only when built with DROPLET_WITH_TIFF).
+    std::size_t libtiff_frames = 0;
+    // Frames read into aligned buffers by a batched readFrames() call.
+    std::size_t batched_frames = 0;
+};
+
+struct TiffWriteOptions {
+    // 0 writes the whole image as one strip.
+    std::uint32_t rows_per_strip = 0;
+    // Motorola byte order ("MM"); readers then have to byte-swap 16-bit samples.
+    bool big_endian = false;
+    // 64-bit offsets (BigTIFF), required once the file exceeds 4 GB.
+    bool big_tiff = false;
+};
+
+namespace TiffFormat {
+    constexpr std::uint32_t kMaxDimension = 8192;
+
+    // Parses the header and up to max_pages image file directories (0 = the whole chain) of classic or
+    // BigTIFF data. Only the tags listed in TiffPageLayout are decoded; everything is bounds-checked.
+    bool parse(std::span<const std::uint8_t> file, TiffFileLayout& layout, std::string& error_message,
+               std::size_t max_pages = 1);
+
+    // Same, reading only the 4 KB blocks of the file that hold the header, directories and strip tables
+    // (no mapping, no pixel data). bytes_read reports how much was actually read.
+    bool parseFile(const std::filesystem::path& path, TiffFileLayout& layout, std::string& error_message,
+                   std::size_t max_pages = 1, std::size_t* bytes_read = nullptr);
+
+    // Spec 3.2 page rules (8/16-bit unsigned grayscale, strip-based, at most 8192x8192, BigTIFF only when allowed).
+    // Compression is not checked here: readers decide whether they can decode it (see canDecode()).
+    bool validatePage(const TiffFileLayout& layout, const TiffPageLayout& page, std::string& error_message,
+                      bool allow_big_tiff = false);
+
+    // False for compressed pages when the library is built without libtiff.
+    bool canDecode(const TiffPageLayout& page, std::string& error_message);
+
+    int matType(const TiffPageLayout& page);
+    std::size_t rowBytes(const TiffPageLayout& page);
+
+    // File offset of the first pixel when an uncompressed page is stored as consecutive rows in file order
+    // (any strip split, as long as there are no gaps) and lies entirely inside a file of file_size bytes.
+    std::optional<std::uint64_t> contiguousPixelOffset(const TiffPageLayout& page, std::uint64_t file_size);
+
+    // contiguousPixelOffset() for pages whose samples are also in host byte order, i.e. pages whose pixels can be
+    // used exactly as stored in the file.
+    std::optional<std::uint64_t> nativePixelOffset(const TiffPageLayout& page, bool little_endian,
+                                                   std::uint64_t file_size);
+
+    // Copies the strips of an uncompressed page into a new Mat, byte-swapping 16-bit big-endian samples.
+    bool decodeUncompressed(std::span<const std::uint8_t> file, bool little_endian, const TiffPageLayout& page,
+                            cv::Mat& image, std::string& error_message);
+
+    // Reads a validated page of a mapped file: a zero-copy matView() when the page is contiguous, aligned and in
+    // native byte order, otherwise a decoded copy (libtiff, opened on `path`, for compressed pages).
+    // Safe to call concurrently on the same mapping.
+    bool readPage(const MappedFile& file, const std::string& path, bool little_endian, const TiffPageLayout& page,
+                  cv::Mat& image, TiffReadPath& read_path, std::string& error_message);
+    // Same page, always decoded with ordinary reads into a Mat of its own: nothing is mapped, so the file may be
+    // truncated or rewritten afterwards (e.g. by the software still writing the directory) without affecting it.
+    bool readPageCopy(const std::string& path, bool little_endian, const TiffPageLayout& page, cv::Mat& image,
+                      std::string& error_message);
+
+    // Stores / restores the directory fields of a page in a sidecar index. getPage() rejects truncated records.
+    void putPage(SidecarWriter& writer, const TiffPageLayout& page);
+    bool getPage(SidecarReader& reader, TiffPageLayout& page);
+
+    // Writes a CV_8UC1/CV_16UC1 image as an uncompressed grayscale TIFF (pixel rows 16-byte aligned).
+    bool writeGrayscale(const std::filesystem::path& path, const cv::Mat& image, std::string& error_message,
+                        const TiffWriteOptions& options = {});
+    // Same, one page per image (pages may differ in size and depth).
+    bool writeGrayscalePages(const std::filesystem::path& path, std::span<const cv::Mat> pages,
+                             std::string& error_message, const TiffWriteOptions& options = {});
+}
@@ -45,6 +45,7 @@ cv::Mat RunningExponentialBackgroundSubtractor::apply(const cv::Mat& frame) {
         expected_type_ = frame.type();
         expected_size_ = frame.size();
         frame.convertTo(background_accum_, CV_32F);
+        accum_charge_.resize(background_accum_.total() * background_accum_.elemSize());
         return cv::Mat::zeros(frame.size(), frame.type());
     }
 
@@ -76,6 +77,7 @@ cv::Mat RunningExponentialBackgroundSubtractor::backgroundImage() const {
 
 void RunningExponentialBackgroundSubtractor::reset() {
     background_accum_.release();
+    accum_charge_.reset();
     expected_type_ = -1;
     expected_size_ = {};
 }
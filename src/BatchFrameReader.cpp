@@ -0,0 +1,445 @@
+#include "BatchFrameReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <map>
+#include <vector>
+
+#include "OwnedMat.h"
+#include "ThreadPool.h"
+
+#if defined(__linux__) && defined(DROPLET_WITH_IO_URING)
+#include <atomic>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define DROPLET_IO_URING_BACKEND 1
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+// Spec: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Storage: NVMe SSD, read >3 GB/s)
+
+namespace {
+
+// Largest single read handed to the kernel; longer requests continue where the previous read stopped.
+constexpr std::size_t kMaxReadChunk = std::size_t{1} << 30;
+
+std::size_t requiredBytes(const BatchReadRequest& request) {
+    return request.required == 0 ? request.length : std::min(request.required, request.length);
+}
+
+std::string shortReadError(const BatchReadRequest& request, std::uint64_t done) {
+    return "Unexpected end of file: " + request.path + " (read " + std::to_string(done) + " of " +
+        std::to_string(requiredBytes(request)) + " bytes at offset " + std::to_string(request.offset) + ")";
+}
+
+#ifndef _WIN32
+// Descriptors of one batch, one per distinct path, closed with the batch.
+class FileSet {
+public:
+    FileSet(bool direct_io, BatchReadStats& stats) : direct_io_(direct_io), stats_(stats) {}
+    ~FileSet() {
+        for (const auto& [path, fd] : fds_) {
+            ::close(fd);
+        }
+    }
+    FileSet(const FileSet&) = delete;
+    FileSet& operator=(const FileSet&) = delete;
+
+    // -1 with error_message set when the file cannot be opened.
+    int open(const std::string& path, std::string& error_message) {
+        const auto known = fds_.find(path);
+        if (known != fds_.end()) {
+            return known->second;
+        }
+        int fd = -1;
+#ifdef O_DIRECT
+        if (direct_io_) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+            if (fd < 0 && errno == EINVAL) {
+                ++stats_.direct_io_fallbacks;
+            }
+        }
+#endif
+        if (fd < 0) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (fd < 0) {
+            error_message = "Cannot open file: " + path + " (" + std::strerror(errno) + ")";
+            return -1;
+        }
+        fds_.emplace(path, fd);
+        return fd;
+    }
+
+private:
+    bool direct_io_;
+    BatchReadStats& stats_;
+    std::map<std::string, int> fds_;
+};
+#endif
+
+struct ThreadReadResult {
+    std::string error;
+    std::size_t system_calls = 0;
+    std::size_t short_reads = 0;
+};
+
+} // namespace
+
+#ifdef DROPLET_IO_URING_BACKEND
+
+// Minimal io_uring instance: submission and completion rings mapped from the kernel, driven with plain
+// io_uring_setup / io_uring_enter / io_uring_register system calls.
+struct BatchFrameReader::Ring {
+    int fd = -1;
+    unsigned entries = 0;
+    void* sq_ring = MAP_FAILED;
+    std::size_t sq_ring_bytes = 0;
+    void* cq_ring = MAP_FAILED;
+    std::size_t cq_ring_bytes = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqes_bytes = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqes_bytes);
+        }
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+            ::munmap(cq_ring, cq_ring_bytes);
+        }
+        if (sq_ring != MAP_FAILED) {
+            ::munmap(sq_ring, sq_ring_bytes);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    static std::unique_ptr<Ring> create(unsigned depth, std::string& error_message) {
+        io_uring_params params{};
+        auto ring = std::make_unique<Ring>();
+        ring->fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+        if (ring->fd < 0) {
+            error_message = std::string("io_uring_setup failed (") + std::strerror(errno) + ")";
+            return nullptr;
+        }
+        ring->entries = params.sq_entries;
+
+        ring->sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            ring->sq_ring_bytes = ring->cq_ring_bytes = std::max(ring->sq_ring_bytes, ring->cq_ring_bytes);
+        }
+        ring->sq_ring = ::mmap(nullptr, ring->sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               ring->fd, IORING_OFF_SQ_RING);
+        if (ring->sq_ring == MAP_FAILED) {
+            error_message = std::string("Cannot map the io_uring submission ring (") + std::strerror(errno) + ")";
+            return nullptr;
+        }
+        ring->cq_ring = single_mmap ? ring->sq_ring
+                                    : ::mmap(nullptr, ring->cq_ring_bytes, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            error_message = std::string("Cannot map the io_uring completion ring (") + std::strerror(errno) + ")";
+            return nullptr;
+        }
+        ring->sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, ring->sqes_bytes, PROT_READ | PROT_WRITE,
+                                                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) {
+            error_message = std::string("Cannot map the io_uring submission entries (") + std::strerror(errno) + ")";
+            return nullptr;
+        }
+
+        auto* sq = static_cast<std::uint8_t*>(ring->sq_ring);
+        auto* cq = static_cast<std::uint8_t*>(ring->cq_ring);
+        ring->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // IORING_OP_READ needs Linux 5.6; older kernels take the thread-pool path.
+        std::vector<std::uint8_t> probe_storage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(probe_storage.data());
+        if (::syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+            probe->last_op < IORING_OP_READ || (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) == 0) {
+            error_message = "io_uring does not support IORING_OP_READ (Linux 5.6 or newer required)";
+            return nullptr;
+        }
+        return ring;
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete) {
+        return static_cast<int>(
+            ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+    }
+};
+
+#else
+
+struct BatchFrameReader::Ring {};
+
+#endif
+
+BatchFrameReader::BatchFrameReader(const BatchReadParams& params) : params_(params) {
+    params_.queue_depth = std::clamp<std::size_t>(params_.queue_depth, 1, 4096);
+    if (!params_.use_io_uring) {
+        return;
+    }
+#ifdef DROPLET_IO_URING_BACKEND
+    ring_ = Ring::create(static_cast<unsigned>(params_.queue_depth), fallback_reason_);
+#else
+    fallback_reason_ = "io_uring support is not compiled in";
+#endif
+}
+
+BatchFrameReader::~BatchFrameReader() = default;
+
+BatchReadBackend BatchFrameReader::backend() const {
+    return ring_ ? BatchReadBackend::IoUring : BatchReadBackend::ThreadPool;
+}
+
+PreparedFrameRead BatchFrameReader::prepareFrame(const std::string& path, std::uint64_t pixel_offset, int rows,
+                                                 int cols, int type, std::size_t step) const {
+    const std::size_t pixel_bytes =
+        rows > 0 ? static_cast<std::size_t>(rows - 1) * step + static_cast<std::size_t>(cols) * CV_ELEM_SIZE(type) : 0;
+    std::uint64_t start = pixel_offset;
+    std::size_t length = pixel_bytes;
+    if (params_.direct_io) {
+        start = pixel_offset & ~static_cast<std::uint64_t>(kDirectIoAlignment - 1);
+        length = static_cast<std::size_t>(pixel_offset - start) + pixel_bytes;
+        length = (length + kDirectIoAlignment - 1) & ~(kDirectIoAlignment - 1);
+    }
+    const auto lead = static_cast<std::size_t>(pixel_offset - start);
+
+    auto buffer = allocateAligned(std::max<std::size_t>(length, 1), kDirectIoAlignment);
+    PreparedFrameRead prepared;
+    prepared.request.path = path;
+    prepared.request.offset = start;
+    prepared.request.length = length;
+    prepared.request.required = lead + pixel_bytes;
+    prepared.request.destination = buffer.get();
+    prepared.frame = wrapOwnedMemory(buffer, buffer.get() + lead, rows, cols, type, step);
+    return prepared;
+}
+
+bool BatchFrameReader::read(std::span<const BatchReadRequest> requests, std::string& error_message) {
+    ++stats_.batches;
+    stats_.requests += requests.size();
+    if (requests.empty()) {
+        return true;
+    }
+    if (!ring_) {
+        return readWithThreads(requests, error_message);
+    }
+
+#ifdef DROPLET_IO_URING_BACKEND
+    Ring& ring = *ring_;
+    FileSet files(params_.direct_io, stats_);
+    std::vector<int> fds(requests.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        fds[i] = files.open(requests[i].path, error_message);
+        if (fds[i] < 0) {
+            return false;
+        }
+    }
+
+    std::vector<std::uint64_t> done(requests.size(), 0);
+    std::deque<std::size_t> queued;
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        queued.push_back(i);
+    }
+    std::size_t in_flight = 0;
+    bool failed = false;
+
+    while (true) {
+        // Only this thread produces submissions, so the tail can be read without synchronisation.
+        unsigned tail = *ring.sq_tail;
+        while (!failed && !queued.empty() && in_flight < ring.entries) {
+            const std::size_t index = queued.front();
+            queued.pop_front();
+            const BatchReadRequest& request = requests[index];
+            const unsigned slot = tail & ring.sq_mask;
+            io_uring_sqe& sqe = ring.sqes[slot];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fds[index];
+            sqe.off = request.offset + done[index];
+            sqe.addr = reinterpret_cast<std::uint64_t>(request.destination + done[index]);
+            sqe.len = static_cast<std::uint32_t>(std::min<std::uint64_t>(request.length - done[index], kMaxReadChunk));
+            sqe.user_data = index;
+            ring.sq_array[slot] = slot;
+            ++tail;
+            ++in_flight;
+        }
+        std::atomic_ref<unsigned>(*ring.sq_tail).store(tail, std::memory_order_release);
+        if (in_flight == 0) {
+            break;
+        }
+
+        const unsigned to_submit = tail - std::atomic_ref<unsigned>(*ring.sq_head).load(std::memory_order_acquire);
+        ++stats_.system_calls;
+        if (ring.enter(to_submit, 1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            if (!failed) {
+                error_message = std::string("io_uring_enter failed (") + std::strerror(errno) + ")";
+            }
+            failed = true;
+            // Nothing can be reaped reliably any more; the ring is unusable for this batch.
+            break;
+        }
+
+        unsigned head = *ring.cq_head;
+        const unsigned ready = std::atomic_ref<unsigned>(*ring.cq_tail).load(std::memory_order_acquire);
+        for (; head != ready; ++head) {
+            const io_uring_cqe& cqe = ring.cqes[head & ring.cq_mask];
+            const auto index = static_cast<std::size_t>(cqe.user_data);
+            const BatchReadRequest& request = requests[index];
+            --in_flight;
+            if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+                queued.push_back(index);
+            } else if (cqe.res < 0) {
+                if (!failed) {
+                    error_message = "Failed to read " + request.path + " (" + std::strerror(-cqe.res) + ")";
+                }
+                failed = true;
+            } else if (cqe.res == 0) {
+                if (done[index] < requiredBytes(request) && !failed) {
+                    error_message = shortReadError(request, done[index]);
+                    failed = true;
+                }
+            } else {
+                done[index] += static_cast<std::uint64_t>(cqe.res);
+                if (done[index] < request.length) {
+                    ++stats_.short_reads;
+                    queued.push_back(index);
+                }
+            }
+        }
+        std::atomic_ref<unsigned>(*ring.cq_head).store(head, std::memory_order_release);
+    }
+
+    if (failed) {
+        if (in_flight > 0) {
+            // The kernel may still write into the destinations; this ring cannot be trusted again.
+            ring_.reset();
+            fallback_reason_ = "io_uring disabled after a failed batch";
+        }
+        return false;
+    }
+    for (const auto& request : requests) {
+        stats_.bytes += request.length;
+    }
+    return true;
+#else
+    return readWithThreads(requests, error_message);
+#endif
+}
+
+bool BatchFrameReader::readWithThreads(std::span<const BatchReadRequest> requests, std::string& error_message) {
+    if (!pool_) {
+        pool_ = std::make_unique<ThreadPool>(params_.queue_depth);
+    }
+    ThreadPool& pool = *pool_;
+    std::vector<std::future<ThreadReadResult>> pending;
+    pending.reserve(requests.size());
+
+#ifdef _WIN32
+    for (const auto& request : requests) {
+        pending.push_back(pool.submit([&request]() {
+            ThreadReadResult result;
+            std::ifstream in(request.path, std::ios::binary);
+            if (!in) {
+                result.error = "Cannot open file: " + request.path;
+                return result;
+            }
+            in.seekg(static_cast<std::streamoff>(request.offset));
+            in.read(reinterpret_cast<char*>(request.destination), static_cast<std::streamsize>(request.length));
+            ++result.system_calls;
+            if (static_cast<std::size_t>(in.gcount()) < requiredBytes(request)) {
+                result.error = shortReadError(request, static_cast<std::uint64_t>(in.gcount()));
+            }
+            return result;
+        }));
+    }
+#else
+    FileSet files(params_.direct_io, stats_);
+    std::vector<int> fds(requests.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        fds[i] = files.open(requests[i].path, error_message);
+        if (fds[i] < 0) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        pending.push_back(pool.submit([&request = requests[i], fd = fds[i]]() {
+            ThreadReadResult result;
+            std::uint64_t done = 0;
+            while (done < request.length) {
+                const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(request.length - done, kMaxReadChunk));
+                const ssize_t count = ::pread(fd, request.destination + done, chunk,
+                                              static_cast<off_t>(request.offset + done));
+                ++result.system_calls;
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    result.error = "Failed to read " + request.path + " (" + std::strerror(errno) + ")";
+                    return result;
+                }
+                if (count == 0) {
+                    break;
+                }
+                done += static_cast<std::uint64_t>(count);
+                if (done < request.length) {
+                    ++result.short_reads;
+                }
+            }
+            if (done < requiredBytes(request)) {
+                result.error = shortReadError(request, done);
+            }
+            return result;
+        }));
+    }
+#endif
+
+    bool ok = true;
+    for (auto& task : pending) {
+        const ThreadReadResult result = task.get();
+        stats_.system_calls += result.system_calls;
+        stats_.short_reads += result.short_reads;
+        if (!result.error.empty() && ok) {
+            error_message = result.error;
+            ok = false;
+        }
+    }
+    if (ok) {
+        for (const auto& request : requests) {
+            stats_.bytes += request.length;
+        }
+    }
+    return ok;
+}
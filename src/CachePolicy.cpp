@@ -0,0 +1,220 @@
+#include "CachePolicy.h"
+
+#include <algorithm>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Frame Cache (Memory-Budget Based))
+
+namespace {
+
+constexpr std::uint8_t kMaxCount = 15;
+
+std::uint64_t mix(std::uint64_t value) {
+    // splitmix64 finaliser
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
+std::unique_ptr<CachePolicy> makeCachePolicy(CachePolicyKind kind) {
+    switch (kind) {
+        case CachePolicyKind::TwoQueue:
+            return std::make_unique<TwoQueuePolicy>();
+        case CachePolicyKind::TinyLfu:
+            return std::make_unique<TinyLfuPolicy>();
+        case CachePolicyKind::Lru:
+            break;
+    }
+    return std::make_unique<LruPolicy>();
+}
+
+std::optional<CachePolicyKind> parseCachePolicyKind(const std::string& name) {
+    if (name == "lru") {
+        return CachePolicyKind::Lru;
+    }
+    if (name == "2q") {
+        return CachePolicyKind::TwoQueue;
+    }
+    if (name == "tinylfu") {
+        return CachePolicyKind::TinyLfu;
+    }
+    return std::nullopt;
+}
+
+void LruPolicy::accessed(std::size_t id, bool resident) {
+    const auto found = positions_.find(id);
+    if (resident && found != positions_.end()) {
+        order_.splice(order_.begin(), order_, found->second);
+    }
+}
+
+void LruPolicy::inserted(std::size_t id) {
+    const auto found = positions_.find(id);
+    if (found != positions_.end()) {
+        order_.splice(order_.begin(), order_, found->second);
+        return;
+    }
+    order_.push_front(id);
+    positions_.emplace(id, order_.begin());
+}
+
+void LruPolicy::erased(std::size_t id) {
+    const auto found = positions_.find(id);
+    if (found != positions_.end()) {
+        order_.erase(found->second);
+        positions_.erase(found);
+    }
+}
+
+std::optional<std::size_t> LruPolicy::victim() const {
+    if (order_.empty()) {
+        return std::nullopt;
+    }
+    return order_.back();
+}
+
+void TwoQueuePolicy::setCapacity(std::size_t frames) {
+    // Kin = 25% of the cache as the paper recommends. Its Kout of 50% assumes small pages; ghosts here are bare
+    // ids next to megabyte frames, so remembering twice the cache lets revisits that are further apart count.
+    probation_limit_ = std::max<std::size_t>(1, frames / 4);
+    ghost_limit_ = std::max<std::size_t>(1, frames * 2);
+}
+
+void TwoQueuePolicy::accessed(std::size_t id, bool resident) {
+    const auto found = positions_.find(id);
+    // Hits in probation do not promote: a burst of requests for a new frame is still one use.
+    if (resident && found != positions_.end() && found->second.queue == Queue::Main) {
+        main_.splice(main_.begin(), main_, found->second.it);
+    }
+}
+
+void TwoQueuePolicy::inserted(std::size_t id) {
+    Queue queue = Queue::Probation;
+    const auto found = positions_.find(id);
+    if (found != positions_.end()) {
+        if (found->second.queue != Queue::Ghost) {
+            return;
+        }
+        queue = Queue::Main;
+        remove(id);
+    }
+    std::list<std::size_t>& list = listOf(queue);
+    list.push_front(id);
+    positions_[id] = Position{queue, list.begin()};
+}
+
+void TwoQueuePolicy::erased(std::size_t id) {
+    if (pinned_.erase(id) != 0) {
+        return;
+    }
+    const auto found = positions_.find(id);
+    if (found == positions_.end() || found->second.queue == Queue::Ghost) {
+        return;
+    }
+    const bool demote = found->second.queue == Queue::Probation;
+    remove(id);
+    if (demote) {
+        ghost_.push_front(id);
+        positions_[id] = Position{Queue::Ghost, ghost_.begin()};
+        if (ghost_.size() > ghost_limit_) {
+            positions_.erase(ghost_.back());
+            ghost_.pop_back();
+        }
+    }
+}
+
+void TwoQueuePolicy::pinned(std::size_t id) {
+    const auto found = positions_.find(id);
+    if (found == positions_.end() || found->second.queue == Queue::Ghost) {
+        return;
+    }
+    pinned_[id] = found->second.queue;
+    remove(id);
+}
+
+void TwoQueuePolicy::unpinned(std::size_t id) {
+    const auto found = pinned_.find(id);
+    if (found == pinned_.end()) {
+        inserted(id);  // pinned before it was loaded: a new frame
+        return;
+    }
+    std::list<std::size_t>& list = listOf(found->second);
+    list.push_front(id);
+    positions_[id] = Position{found->second, list.begin()};
+    pinned_.erase(found);
+}
+
+std::optional<std::size_t> TwoQueuePolicy::victim() const {
+    if (!probation_.empty() && (probation_.size() > probation_limit_ || main_.empty())) {
+        return probation_.back();
+    }
+    if (!main_.empty()) {
+        return main_.back();
+    }
+    return std::nullopt;
+}
+
+std::list<std::size_t>& TwoQueuePolicy::listOf(Queue queue) {
+    switch (queue) {
+        case Queue::Probation:
+            return probation_;
+        case Queue::Main:
+            return main_;
+        case Queue::Ghost:
+            break;
+    }
+    return ghost_;
+}
+
+void TwoQueuePolicy::remove(std::size_t id) {
+    const auto found = positions_.find(id);
+    listOf(found->second.queue).erase(found->second.it);
+    positions_.erase(found);
+}
+
+void TinyLfuPolicy::setCapacity(std::size_t frames) {
+    // About 16 counters per cached frame keeps collisions rare for the few thousand frames of a sequence.
+    std::size_t width = 64;
+    while (width < frames * 16) {
+        width *= 2;
+    }
+    if (width != width_) {
+        width_ = width;
+        counters_.assign(kRows * width_, 0);
+        samples_ = 0;
+    }
+    sample_limit_ = std::max<std::size_t>(10, frames * 10);
+}
+
+void TinyLfuPolicy::accessed(std::size_t id, bool resident) {
+    lru_.accessed(id, resident);
+    for (std::size_t row = 0; row < kRows; ++row) {
+        std::uint8_t& counter = counters_[slot(id, row)];
+        counter = static_cast<std::uint8_t>(std::min<int>(kMaxCount, counter + 1));
+    }
+    if (++samples_ >= sample_limit_) {
+        for (std::uint8_t& counter : counters_) {
+            counter = static_cast<std::uint8_t>(counter / 2);
+        }
+        samples_ /= 2;
+    }
+}
+
+bool TinyLfuPolicy::admit(std::size_t candidate, std::size_t victim) const {
+    return frequency(candidate) > frequency(victim);
+}
+
+std::uint32_t TinyLfuPolicy::frequency(std::size_t id) const {
+    std::uint32_t estimate = kMaxCount;
+    for (std::size_t row = 0; row < kRows; ++row) {
+        estimate = std::min<std::uint32_t>(estimate, counters_[slot(id, row)]);
+    }
+    return estimate;
+}
+
+std::size_t TinyLfuPolicy::slot(std::size_t id, std::size_t row) const {
+    const std::uint64_t hash = mix(static_cast<std::uint64_t>(id) ^ (static_cast<std::uint64_t>(row) << 56));
+    return row * width_ + static_cast<std::size_t>(hash & (width_ - 1));
+}
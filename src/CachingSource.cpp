@@ -0,0 +1,28 @@
+#include "CachingSource.h"
+
+#include <stdexcept>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+CachingSource::CachingSource(std::shared_ptr<InputSource> source, std::shared_ptr<FrameCache> cache,
+                             std::size_t key_offset)
+    : source_(std::move(source)), cache_(std::move(cache)), key_offset_(key_offset) {
+    if (!source_) {
+        throw std::invalid_argument("CachingSource requires a source");
+    }
+    if (!cache_) {
+        cache_ = std::make_shared<FrameCache>();
+    }
+}
+
+cv::Mat CachingSource::getFrame(std::size_t logical_index) {
+    return getFrameHandle(logical_index).mat();
+}
+
+FrameHandle CachingSource::getFrameHandle(std::size_t logical_index) {
+    if (logical_index >= source_->getTotalFrames()) {
+        throw std::out_of_range("Frame index out of range");
+    }
+    return cache_->get(key_offset_ + logical_index, [this, logical_index]() { return source_->getFrame(logical_index); });
+}
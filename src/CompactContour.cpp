@@ -0,0 +1,221 @@
+#include "CompactContour.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Detection::contour for fluorescence masking and overlays).
+
+namespace {
+
+int chainDirection(int dx, int dy, int& run) {
+    const int adx = std::abs(dx);
+    const int ady = std::abs(dy);
+    if ((adx == 0 && ady == 0) || (adx != 0 && ady != 0 && adx != ady)) {
+        return -1;
+    }
+
+    run = std::max(adx, ady);
+    const int sx = (dx > 0) - (dx < 0);
+    const int sy = (dy > 0) - (dy < 0);
+    for (int direction = 0; direction < 8; ++direction) {
+        if (CompactContourDetail::kDirectionDx[direction] == sx && CompactContourDetail::kDirectionDy[direction] == sy) {
+            return direction;
+        }
+    }
+    return -1;
+}
+
+bool isChainCodable(const std::vector<cv::Point>& contour) {
+    for (std::size_t index = 1; index < contour.size(); ++index) {
+        int run = 0;
+        if (chainDirection(contour[index].x - contour[index - 1].x, contour[index].y - contour[index - 1].y, run) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void appendVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value) {
+    while (value >= 0x80U) {
+        bytes.push_back(static_cast<std::uint8_t>((value & 0x7FU) | 0x80U));
+        value >>= 7U;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t zigzagEncode(int value) {
+    const auto wide = static_cast<std::int64_t>(value);
+    return static_cast<std::uint64_t>((wide << 1) ^ (wide >> 63));
+}
+
+// Sets every pixel on the segment a-b. Chain-coded edges only visit lattice points, which is exactly what
+// the 8-connected cv::line used by drawContours produces for them.
+void drawEdgePixels(cv::Mat& mask, const cv::Point& a, const cv::Point& b, std::uint8_t value) {
+    const int dx = b.x - a.x;
+    const int dy = b.y - a.y;
+    const int steps = std::max(std::abs(dx), std::abs(dy));
+    for (int step = 0; step <= steps; ++step) {
+        int x = a.x;
+        int y = a.y;
+        if (steps > 0) {
+            x += static_cast<int>(std::lround(static_cast<double>(dx) * step / steps));
+            y += static_cast<int>(std::lround(static_cast<double>(dy) * step / steps));
+        }
+        if (x >= 0 && y >= 0 && x < mask.cols && y < mask.rows) {
+            mask.ptr<std::uint8_t>(y)[x] = value;
+        }
+    }
+}
+
+} // namespace
+
+CompactContourRef CompactContourStore::encode(const std::vector<cv::Point>& contour) {
+    if (contour.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("contour has too many vertices for CompactContourRef");
+    }
+
+    CompactContourRef ref;
+    ref.offset = bytes_.size();
+    ref.vertex_count = static_cast<std::uint32_t>(contour.size());
+    if (contour.empty()) {
+        return ref;
+    }
+
+    ref.start = contour.front();
+    ref.encoding = isChainCodable(contour) ? CompactContourEncoding::ChainRuns : CompactContourEncoding::DeltaVarint;
+
+    for (std::size_t index = 1; index < contour.size(); ++index) {
+        const int dx = contour[index].x - contour[index - 1].x;
+        const int dy = contour[index].y - contour[index - 1].y;
+        if (ref.encoding == CompactContourEncoding::ChainRuns) {
+            int run = 0;
+            const int direction = chainDirection(dx, dy, run);
+            const auto run_minus_one = static_cast<std::uint64_t>(run - 1);
+            std::uint8_t head = static_cast<std::uint8_t>(direction | ((run_minus_one & 0x0FU) << 3U));
+            if (run_minus_one >= 0x10U) {
+                head |= 0x80U;
+                bytes_.push_back(head);
+                appendVarint(bytes_, run_minus_one >> 4U);
+            } else {
+                bytes_.push_back(head);
+            }
+        } else {
+            appendVarint(bytes_, zigzagEncode(dx));
+            appendVarint(bytes_, zigzagEncode(dy));
+        }
+    }
+
+    const std::size_t length = bytes_.size() - ref.offset;
+    if (length > std::numeric_limits<std::uint32_t>::max()) {
+        bytes_.resize(ref.offset);
+        throw std::invalid_argument("encoded contour exceeds CompactContourRef byte range");
+    }
+    ref.byte_length = static_cast<std::uint32_t>(length);
+    return ref;
+}
+
+std::vector<cv::Point> CompactContourStore::decode(const CompactContourRef& ref) const {
+    std::vector<cv::Point> contour;
+    decode(ref, contour);
+    return contour;
+}
+
+void CompactContourStore::decode(const CompactContourRef& ref, std::vector<cv::Point>& out) const {
+    out.clear();
+    out.reserve(ref.vertex_count);
+    forEachVertex(ref, [&out](const cv::Point& point) { out.push_back(point); });
+}
+
+cv::Rect CompactContourStore::boundingRect(const CompactContourRef& ref) const {
+    if (ref.empty()) {
+        return {};
+    }
+
+    int min_x = ref.start.x;
+    int min_y = ref.start.y;
+    int max_x = ref.start.x;
+    int max_y = ref.start.y;
+    forEachVertex(ref, [&](const cv::Point& point) {
+        min_x = std::min(min_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_x = std::max(max_x, point.x);
+        max_y = std::max(max_y, point.y);
+    });
+    return {min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+}
+
+void rasterizeCompactContour(const CompactContourStore& store,
+                             const CompactContourRef& ref,
+                             cv::Mat& mask,
+                             std::uint8_t value) {
+    if (mask.empty() || mask.type() != CV_8UC1) {
+        throw std::invalid_argument("mask must be a non-empty CV_8UC1 image");
+    }
+    if (ref.empty()) {
+        return;
+    }
+
+    const cv::Rect bounds = store.boundingRect(ref);
+    const cv::Rect clipped = bounds & cv::Rect(0, 0, mask.cols, mask.rows);
+
+    // Interior: edge-flag fill. Each non-horizontal edge toggles the first pixel right of its crossing on
+    // every scanline it spans (half-open in y), then a running XOR along each row yields even-odd parity.
+    if (!clipped.empty()) {
+        const int width = bounds.width + 1;
+        thread_local std::vector<std::uint8_t> parity;
+        parity.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(bounds.height), 0);
+
+        auto toggleEdge = [&](const cv::Point& a, const cv::Point& b) {
+            if (a.y == b.y) {
+                return;
+            }
+            const int y_begin = std::min(a.y, b.y);
+            const int y_end = std::max(a.y, b.y);
+            const double inverse_slope = static_cast<double>(b.x - a.x) / static_cast<double>(b.y - a.y);
+            for (int y = y_begin; y < y_end; ++y) {
+                const double x_cross = a.x + (y - a.y) * inverse_slope;
+                int column = static_cast<int>(std::floor(x_cross)) + 1 - bounds.x;
+                column = std::clamp(column, 0, width - 1);
+                parity[static_cast<std::size_t>(y - bounds.y) * width + column] ^= 1U;
+            }
+        };
+
+        cv::Point previous = ref.start;
+        bool first = true;
+        store.forEachVertex(ref, [&](const cv::Point& point) {
+            if (!first) {
+                toggleEdge(previous, point);
+            }
+            first = false;
+            previous = point;
+        });
+        toggleEdge(previous, ref.start);
+
+        for (int y = clipped.y; y < clipped.y + clipped.height; ++y) {
+            const std::uint8_t* flags = parity.data() + static_cast<std::size_t>(y - bounds.y) * width;
+            std::uint8_t* out = mask.ptr<std::uint8_t>(y);
+            std::uint8_t inside = 0;
+            for (int x = bounds.x; x < clipped.x + clipped.width; ++x) {
+                inside ^= flags[x - bounds.x];
+                if (inside != 0 && x >= clipped.x) {
+                    out[x] = value;
+                }
+            }
+        }
+    }
+
+    // Boundary pixels are part of the filled region, exactly as drawContours draws the outline.
+    cv::Point previous = ref.start;
+    bool first = true;
+    store.forEachVertex(ref, [&](const cv::Point& point) {
+        if (!first) {
+            drawEdgePixels(mask, previous, point, value);
+        }
+        first = false;
+        previous = point;
+    });
+    drawEdgePixels(mask, previous, ref.start, value);
+}
@@ -1,10 +1,12 @@
 #include "DropletDetection.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include <opencv2/imgproc.hpp>
 
 #include "MathUtils.h"
+#include "MemoryGovernor.h"
 
 namespace {
 int ensureOddKernel(int value, int fallback) {
@@ -51,9 +53,24 @@ cv::RotatedRect fitEllipseSafe(const std::vector<cv::Point>& contour, const cv::
                                               static_cast<float>(bounds.height)),
                            0.0F);
 }
-} // namespace
 
-std::vector<Detection> detectDroplets(const cv::Mat& frame, const DropletDetectionParams& params) {
+void offsetDetection(Detection& detection, const cv::Point& offset) {
+    const cv::Point2f offset_f(static_cast<float>(offset.x), static_cast<float>(offset.y));
+    detection.centroid += offset_f;
+    detection.bounding_box += offset;
+    for (auto& point : detection.contour) {
+        point += offset;
+    }
+}
+
+bool insideRect(const cv::Point2f& point, const cv::Rect& rect) {
+    return point.x >= static_cast<float>(rect.x) && point.y >= static_cast<float>(rect.y) &&
+        point.x < static_cast<float>(rect.x + rect.width) && point.y < static_cast<float>(rect.y + rect.height);
+}
+
+std::vector<Detection> detectDropletsImpl(const cv::Mat& frame,
+                                          const DropletDetectionParams& params,
+                                          CompactContourStore* contour_store) {
     std::vector<Detection> detections;
     if (frame.empty()) {
         return detections;
@@ -69,6 +86,8 @@ std::vector<Detection> detectDroplets(const cv::Mat& frame, const DropletDetecti
     const int open_kernel = params.morph_open_kernel > 1 ? ensureOddKernel(params.morph_open_kernel, 3) : 0;
     const int close_kernel = params.morph_close_kernel > 1 ? ensureOddKernel(params.morph_close_kernel, 3) : 0;
 
+    // The 8-bit grayscale, blurred and binary working images, live until the contours are traced.
+    const MemoryCharge scratch(MemoryCategory::DetectorScratch, 3 * frame.total());
     cv::Mat gray = toGrayscale8(frame);
     cv::Mat blurred = gray;
     if (params.gaussian_sigma > 0.0 || gaussian_kernel > 1) {
@@ -125,10 +144,95 @@ std::vector<Detection> detectDroplets(const cv::Mat& frame, const DropletDetecti
         detection.circularity = static_cast<float>(MathUtils::calculateCircularity(area, perimeter));
         detection.aspect_ratio = static_cast<float>(MathUtils::aspectRatio(major_axis, minor_axis));
         detection.bounding_box = bounds;
-        detection.contour = contour;
+        if (contour_store != nullptr) {
+            detection.compact_contour = contour_store->encode(contour);
+        } else {
+            detection.contour = contour;
+        }
 
         detections.push_back(std::move(detection));
     }
 
     return detections;
 }
+} // namespace
+
+int detectionContextRadius(const DropletDetectionParams& params) {
+    int gaussian_kernel = params.gaussian_kernel_size > 1 ? ensureOddKernel(params.gaussian_kernel_size, 5) : 1;
+    if (gaussian_kernel <= 1 && params.gaussian_sigma > 0.0) {
+        // cv::GaussianBlur derives the 8-bit kernel size from sigma when none is given.
+        gaussian_kernel = static_cast<int>(std::lround(params.gaussian_sigma * 3.0 * 2.0 + 1.0)) | 1;
+    }
+    const int adaptive_block = ensureOddKernel(params.adaptive_block_size, 21);
+    const int open_kernel = params.morph_open_kernel > 1 ? ensureOddKernel(params.morph_open_kernel, 3) : 0;
+    const int close_kernel = params.morph_close_kernel > 1 ? ensureOddKernel(params.morph_close_kernel, 3) : 0;
+
+    // Blur, threshold window, then erode+dilate for each morphology pass, plus one pixel for contour tracing.
+    return gaussian_kernel / 2 + adaptive_block / 2 + 2 * (open_kernel / 2) + 2 * (close_kernel / 2) + 1;
+}
+
+std::vector<Detection> detectDroplets(const cv::Mat& frame, const DropletDetectionParams& params) {
+    return detectDropletsImpl(frame, params, nullptr);
+}
+
+std::vector<Detection> detectDroplets(const cv::Mat& frame,
+                                      const DropletDetectionParams& params,
+                                      CompactContourStore& contour_store) {
+    return detectDropletsImpl(frame, params, &contour_store);
+}
+
+bool detectDropletsInRegion(const cv::Mat& frame,
+                            const cv::Rect& core,
+                            const DropletDetectionParams& params,
+                            std::vector<Detection>& detections,
+                            std::size_t* pixels_read) {
+    const int context = detectionContextRadius(params);
+    const cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+    const cv::Rect clipped_core = core & frame_rect;
+    const cv::Rect padded =
+        cv::Rect(clipped_core.x - context, clipped_core.y - context, clipped_core.width + 2 * context,
+                 clipped_core.height + 2 * context) &
+        frame_rect;
+    if (pixels_read != nullptr) {
+        *pixels_read = static_cast<std::size_t>(padded.area());
+    }
+    if (clipped_core.area() <= 0) {
+        return true;
+    }
+
+    // ROI views share the frame buffer; only the padded window is read.
+    auto local = detectDropletsImpl(frame(padded), params, nullptr);
+    const std::size_t first_new = detections.size();
+    for (auto& detection : local) {
+        offsetDetection(detection, padded.tl());
+        if (!insideRect(detection.centroid, clipped_core)) {
+            continue;
+        }
+        // Outside the core the padding no longer covers the full filter footprint, so a droplet that
+        // spills over may differ from a full-frame pass.
+        if ((detection.bounding_box & clipped_core) != detection.bounding_box) {
+            detections.resize(first_new);
+            return false;
+        }
+        detections.push_back(std::move(detection));
+    }
+    return true;
+}
+
+void mergeOverlappingRegions(std::vector<cv::Rect>& regions) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        std::sort(regions.begin(), regions.end(), [](const cv::Rect& left, const cv::Rect& right) { return left.x < right.x; });
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            for (std::size_t j = i + 1; j < regions.size() && regions[j].x < regions[i].x + regions[i].width; ++j) {
+                if ((regions[i] & regions[j]).area() > 0) {
+                    regions[i] |= regions[j];
+                    regions.erase(regions.begin() + static_cast<std::ptrdiff_t>(j));
+                    merged = true;
+                    j = i;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,309 @@
+#include "DropletStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Spec: Docs/TECHSPEC_SPLIT/06_data_formats.md (6.3 Summary Statistics JSON)
+
+namespace {
+
+double cross(const cv::Point2f& a, const cv::Point2f& b, const cv::Point2f& c) {
+    return static_cast<double>(b.x - a.x) * (c.y - a.y) - static_cast<double>(b.y - a.y) * (c.x - a.x);
+}
+
+} // namespace
+
+bool segmentCrossesLine(const cv::Point2f& from, const cv::Point2f& to, const MeasurementLine& line) {
+    const double d1 = cross(line.start, line.end, from);
+    const double d2 = cross(line.start, line.end, to);
+    const double d3 = cross(from, to, line.start);
+    const double d4 = cross(from, to, line.end);
+    return ((d1 > 0.0 && d2 <= 0.0) || (d1 < 0.0 && d2 >= 0.0)) && ((d3 > 0.0) != (d4 > 0.0) || d3 == 0.0 || d4 == 0.0);
+}
+
+bool segmentLeavesLine(const cv::Point2f& from, const cv::Point2f& to, const MeasurementLine& line) {
+    if (cross(line.start, line.end, from) != 0.0 || cross(line.start, line.end, to) == 0.0) {
+        return false;
+    }
+    // On the line; within the segment when its projection falls between the end points.
+    const cv::Point2f direction = line.end - line.start;
+    const cv::Point2f offset = from - line.start;
+    const double along = static_cast<double>(direction.x) * offset.x + static_cast<double>(direction.y) * offset.y;
+    const double length_sq = static_cast<double>(direction.x) * direction.x + static_cast<double>(direction.y) * direction.y;
+    return along >= 0.0 && along <= length_sq;
+}
+
+void OnlineStatistics::add(double value) {
+    if (!std::isfinite(value)) {
+        return;
+    }
+    if (count_ == 0) {
+        min_ = value;
+        max_ = value;
+    } else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    ++count_;
+    const double delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+}
+
+void OnlineStatistics::merge(const OnlineStatistics& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    const auto n_a = static_cast<double>(count_);
+    const auto n_b = static_cast<double>(other.count_);
+    const double total = n_a + n_b;
+    const double delta = other.mean_ - mean_;
+    mean_ += delta * n_b / total;
+    m2_ += other.m2_ + delta * delta * n_a * n_b / total;
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+double OnlineStatistics::variance() const {
+    if (count_ < 2) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m2_ / static_cast<double>(count_ - 1);
+}
+
+double OnlineStatistics::stddev() const {
+    return std::sqrt(variance());
+}
+
+double OnlineStatistics::cvPercent() const {
+    const double average = mean();
+    if (!(std::abs(average) > 0.0)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return stddev() / average * 100.0;
+}
+
+FixedHistogram::FixedHistogram(double lower, double upper, std::size_t bin_count)
+    : lower_(lower), upper_(upper), counts_(bin_count, 0) {
+    if (bin_count == 0 || !(upper > lower)) {
+        throw std::invalid_argument("FixedHistogram requires upper > lower and at least one bin");
+    }
+    bin_width_ = (upper - lower) / static_cast<double>(bin_count);
+}
+
+void FixedHistogram::add(double value) {
+    if (std::isnan(value) || counts_.empty()) {
+        return;
+    }
+    ++total_;
+    if (value < lower_) {
+        ++underflow_;
+        return;
+    }
+    if (value >= upper_) {
+        ++overflow_;
+        return;
+    }
+    const auto bin = std::min(static_cast<std::size_t>((value - lower_) / bin_width_), counts_.size() - 1);
+    ++counts_[bin];
+}
+
+void FixedHistogram::merge(const FixedHistogram& other) {
+    if (other.counts_.size() != counts_.size() || other.lower_ != lower_ || other.upper_ != upper_) {
+        throw std::invalid_argument("FixedHistogram::merge requires identical binning");
+    }
+    for (std::size_t bin = 0; bin < counts_.size(); ++bin) {
+        counts_[bin] += other.counts_[bin];
+    }
+    underflow_ += other.underflow_;
+    overflow_ += other.overflow_;
+    total_ += other.total_;
+}
+
+void FixedHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    underflow_ = 0;
+    overflow_ = 0;
+    total_ = 0;
+}
+
+double FixedHistogram::quantile(double q) const {
+    if (total_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const double target = std::clamp(q, 0.0, 1.0) * static_cast<double>(total_);
+    double seen = static_cast<double>(underflow_);
+    if (target <= seen) {
+        return lower_;
+    }
+    for (std::size_t bin = 0; bin < counts_.size(); ++bin) {
+        const auto count = static_cast<double>(counts_[bin]);
+        if (count > 0.0 && target <= seen + count) {
+            return lower_ + bin_width_ * (static_cast<double>(bin) + (target - seen) / count);
+        }
+        seen += count;
+    }
+    return upper_;
+}
+
+SlidingWindowRate::SlidingWindowRate(double window_s) : window_s_(window_s) {
+    if (!(window_s > 0.0)) {
+        throw std::invalid_argument("SlidingWindowRate window must be positive");
+    }
+}
+
+void SlidingWindowRate::add(double timestamp_s, std::size_t events) {
+    advance(timestamp_s);
+    if (events == 0) {
+        return;
+    }
+    if (!buckets_.empty() && buckets_.back().timestamp_s == timestamp_s) {
+        buckets_.back().events += events;
+    } else {
+        buckets_.push_back(Bucket{timestamp_s, events});
+    }
+    events_in_window_ += events;
+}
+
+void SlidingWindowRate::advance(double now_s) {
+    if (std::isnan(first_s_)) {
+        first_s_ = now_s;
+    }
+    if (std::isnan(now_s_) || now_s > now_s_) {
+        now_s_ = now_s;
+    }
+    evict();
+}
+
+double SlidingWindowRate::rateHz() const {
+    if (std::isnan(now_s_)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const double span = std::min(window_s_, now_s_ - first_s_);
+    if (!(span > 0.0)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return static_cast<double>(events_in_window_) / span;
+}
+
+void SlidingWindowRate::evict() {
+    // Window is (now - window_s, now]; an event exactly window_s old has left it.
+    while (!buckets_.empty() && buckets_.front().timestamp_s <= now_s_ - window_s_) {
+        events_in_window_ -= buckets_.front().events;
+        buckets_.pop_front();
+    }
+}
+
+DropletStatisticsEngine::DropletStatisticsEngine(const DropletStatisticsParams& params)
+    : params_(params),
+      diameter_histogram_(0.0, params.diameter_histogram_max_um, params.diameter_histogram_bins),
+      velocity_histogram_(0.0, params.velocity_histogram_max_um_per_s, params.velocity_histogram_bins),
+      crossing_rate_(params.rate_window_s) {
+    if (!(params.um_per_px > 0.0)) {
+        throw std::invalid_argument("DropletStatisticsParams::um_per_px must be positive");
+    }
+}
+
+void DropletStatisticsEngine::onFrame(const FrameDetections& frame) {
+    const double timestamp = frame.timestamp_inferred_s;
+    if (group_crossings_ > 0 && timestamp > group_timestamp_s_) {
+        flushCrossingGroup();
+    }
+
+    ++total_frames_;
+    if (std::isnan(first_timestamp_s_)) {
+        first_timestamp_s_ = timestamp;
+    }
+    last_timestamp_s_ = timestamp;
+    crossing_rate_.advance(timestamp);
+
+    total_detected_ += frame.detections.size();
+}
+
+void DropletStatisticsEngine::onTrackStarted(const Track& track, float diameter_px) {
+    ++total_tracked_;
+    OnlineStatistics& diameter = active_diameter_px_[track.track_id];
+    diameter.reset();
+    diameter.add(diameter_px);
+}
+
+void DropletStatisticsEngine::onTrackRetired(const Track& track) {
+    const auto found = active_diameter_px_.find(track.track_id);
+    if (found == active_diameter_px_.end()) {
+        return;
+    }
+    const double diameter_um = trackDiameterUm(found->second);
+    diameter_um_.add(diameter_um);
+    diameter_histogram_.add(diameter_um);
+    active_diameter_px_.erase(found);
+}
+
+void DropletStatisticsEngine::onLink(const Track& track, float diameter_px, float speed_px_per_s, bool crossed_line) {
+    active_diameter_px_[track.track_id].add(diameter_px);
+
+    const double speed_um = static_cast<double>(speed_px_per_s) * params_.um_per_px;
+    velocity_um_per_s_.add(speed_um);
+    velocity_histogram_.add(speed_um);
+
+    if (!crossed_line || track.timestamps.empty()) {
+        return;
+    }
+    const double timestamp = track.timestamps.back();
+    if (group_crossings_ > 0 && timestamp > group_timestamp_s_) {
+        flushCrossingGroup();
+    }
+    group_timestamp_s_ = timestamp;
+    ++group_crossings_;
+    ++total_crossings_;
+    crossing_rate_.add(timestamp);
+}
+
+double DropletStatisticsEngine::crossingGroupFrequency() const {
+    const double gap = group_timestamp_s_ - previous_group_timestamp_s_;
+    return group_crossings_ > 0 && gap > 0.0 ? static_cast<double>(group_crossings_) / gap
+                                             : std::numeric_limits<double>::quiet_NaN();
+}
+
+double DropletStatisticsEngine::trackDiameterUm(const OnlineStatistics& diameter_px) const {
+    return diameter_px.mean() * params_.um_per_px;
+}
+
+void DropletStatisticsEngine::flushCrossingGroup() {
+    frequency_hz_.add(crossingGroupFrequency());
+    previous_group_timestamp_s_ = group_timestamp_s_;
+    group_crossings_ = 0;
+}
+
+DropletStatisticsSnapshot DropletStatisticsEngine::snapshot() const {
+    DropletStatisticsSnapshot snapshot;
+    snapshot.total_frames = total_frames_;
+    snapshot.total_detected = total_detected_;
+    snapshot.total_tracked = total_tracked_;
+    snapshot.total_crossings = total_crossings_;
+    snapshot.duration_s = total_frames_ > 0 ? last_timestamp_s_ - first_timestamp_s_ : 0.0;
+    snapshot.crossing_rate_hz = crossing_rate_.rateHz();
+    // The newest group's interval is complete once its frame has been linked, so it counts here too; it is
+    // only committed when a later timestamp arrives, in case more crossings share its timestamp.
+    snapshot.frequency_hz = frequency_hz_;
+    snapshot.frequency_hz.add(crossingGroupFrequency());
+    // Tracks still being followed count with their diameter so far, so the live view matches the summary.
+    snapshot.diameter_um = diameter_um_;
+    if (active_diameter_px_.empty()) {
+        snapshot.diameter_median_um = diameter_histogram_.quantile(0.5);
+    } else {
+        FixedHistogram diameters = diameter_histogram_;
+        for (const auto& [track_id, diameter_px] : active_diameter_px_) {
+            snapshot.diameter_um.add(trackDiameterUm(diameter_px));
+            diameters.add(trackDiameterUm(diameter_px));
+        }
+        snapshot.diameter_median_um = diameters.quantile(0.5);
+    }
+    snapshot.velocity_um_per_s = velocity_um_per_s_;
+    return snapshot;
+}
@@ -0,0 +1,696 @@
+#include "DropletTracking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.4 Step 2: performTracking) and
+// Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Detection + Tracking >= 80 FPS Tier A, >= 300 FPS Tier B).
+
+namespace {
+
+// Uniform grid over one frame's centroids, stored CSR style (cell_start_ + entries_) so building it is a
+// counting sort and the buffers are reused from frame to frame.
+class SpatialGrid {
+public:
+    void build(const std::vector<Detection>& detections, float cell_size) {
+        entries_.clear();
+        cell_start_.clear();
+        if (detections.empty()) {
+            cols_ = 0;
+            rows_ = 0;
+            return;
+        }
+
+        float min_x = std::numeric_limits<float>::max();
+        float min_y = std::numeric_limits<float>::max();
+        float max_x = std::numeric_limits<float>::lowest();
+        float max_y = std::numeric_limits<float>::lowest();
+        for (const auto& detection : detections) {
+            min_x = std::min(min_x, detection.centroid.x);
+            min_y = std::min(min_y, detection.centroid.y);
+            max_x = std::max(max_x, detection.centroid.x);
+            max_y = std::max(max_y, detection.centroid.y);
+        }
+
+        // Keep the cell count proportional to the detection count so sparse frames stay cheap.
+        const double max_cells = 4.0 * static_cast<double>(detections.size()) + 64.0;
+        cell_size_ = std::max(cell_size, 1.0F);
+        while ((std::floor((max_x - min_x) / cell_size_) + 1.0) * (std::floor((max_y - min_y) / cell_size_) + 1.0)
+               > max_cells) {
+            cell_size_ *= 2.0F;
+        }
+
+        origin_ = cv::Point2f(min_x, min_y);
+        cols_ = static_cast<int>(std::floor((max_x - min_x) / cell_size_)) + 1;
+        rows_ = static_cast<int>(std::floor((max_y - min_y) / cell_size_)) + 1;
+
+        cell_start_.assign(static_cast<std::size_t>(cols_) * static_cast<std::size_t>(rows_) + 1, 0);
+        cell_of_.resize(detections.size());
+        for (std::size_t index = 0; index < detections.size(); ++index) {
+            const auto cell = cellIndex(cellX(detections[index].centroid.x), cellY(detections[index].centroid.y));
+            cell_of_[index] = static_cast<std::uint32_t>(cell);
+            ++cell_start_[cell + 1];
+        }
+        for (std::size_t cell = 1; cell < cell_start_.size(); ++cell) {
+            cell_start_[cell] += cell_start_[cell - 1];
+        }
+
+        entries_.resize(detections.size());
+        fill_.assign(cell_start_.begin(), cell_start_.end() - 1);
+        for (std::size_t index = 0; index < detections.size(); ++index) {
+            entries_[fill_[cell_of_[index]]++] = static_cast<std::uint32_t>(index);
+        }
+    }
+
+    template <typename Fn>
+    void forEachCandidate(const cv::Point2f& center, float radius, Fn&& fn) const {
+        if (cols_ == 0) {
+            return;
+        }
+        const int x0 = std::max(cellX(center.x - radius), 0);
+        const int x1 = std::min(cellX(center.x + radius), cols_ - 1);
+        const int y0 = std::max(cellY(center.y - radius), 0);
+        const int y1 = std::min(cellY(center.y + radius), rows_ - 1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                const auto cell = cellIndex(x, y);
+                for (auto entry = cell_start_[cell]; entry < cell_start_[cell + 1]; ++entry) {
+                    fn(static_cast<std::size_t>(entries_[entry]));
+                }
+            }
+        }
+    }
+
+private:
+    int cellX(float x) const {
+        const double cell = std::floor((static_cast<double>(x) - origin_.x) / cell_size_);
+        return static_cast<int>(std::clamp(cell, -1.0, static_cast<double>(cols_)));
+    }
+    int cellY(float y) const {
+        const double cell = std::floor((static_cast<double>(y) - origin_.y) / cell_size_);
+        return static_cast<int>(std::clamp(cell, -1.0, static_cast<double>(rows_)));
+    }
+    std::size_t cellIndex(int x, int y) const {
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(cols_) + static_cast<std::size_t>(x);
+    }
+
+    float cell_size_ = 1.0F;
+    cv::Point2f origin_;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<std::uint32_t> cell_start_;
+    std::vector<std::uint32_t> entries_;
+    std::vector<std::uint32_t> cell_of_;
+    std::vector<std::uint32_t> fill_;
+};
+
+bool withinRelativeChange(float previous, float current, double max_change) {
+    if (max_change <= 0.0 || previous <= 0.0F || current <= 0.0F) {
+        return true;
+    }
+    return std::abs(current - previous) / std::max(current, previous) <= max_change;
+}
+
+struct ActiveTrack {
+    Track track;
+    cv::Point2f velocity_px_per_frame;
+    cv::Point2f predicted;
+    float search_radius = 0.0F;
+    float last_area = 0.0F;
+    float last_diameter = 0.0F;
+    float last_extent = 0.0F;
+    std::size_t last_frame = 0;
+    std::size_t missed_frames = 0;
+};
+
+struct Candidate {
+    float cost = 0.0F;
+    std::uint32_t track = 0;
+    std::uint32_t detection = 0;
+};
+
+class DisjointSets {
+public:
+    void reset(std::uint32_t count) {
+        parent_.resize(count);
+        for (std::uint32_t index = 0; index < count; ++index) {
+            parent_[index] = index;
+        }
+    }
+
+    std::uint32_t find(std::uint32_t index) {
+        while (parent_[index] != index) {
+            parent_[index] = parent_[parent_[index]];
+            index = parent_[index];
+        }
+        return index;
+    }
+
+    void unite(std::uint32_t a, std::uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent_[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+private:
+    std::vector<std::uint32_t> parent_;
+};
+
+// Rectangular linear assignment (every row assigned, rows <= columns) on a sparse cost graph, solved by
+// Jonker-Volgenant style shortest augmenting paths with row/column potentials. Each augmentation is a
+// Dijkstra search over reduced costs that stops at the first free column, so on the small, sparse
+// components produced by gating it touches only a handful of nodes.
+class SparseAssignmentSolver {
+public:
+    void reset(std::uint32_t rows, std::uint32_t columns) {
+        rows_ = rows;
+        columns_ = columns;
+        edges_.clear();
+    }
+
+    void addEdge(std::uint32_t row, std::uint32_t column, double cost) { edges_.push_back(Edge{row, column, cost}); }
+
+    const std::vector<std::uint32_t>& solve() {
+        buildAdjacency();
+
+        row_potential_.assign(rows_, 0.0);
+        column_potential_.assign(columns_, 0.0);
+        column_for_row_.assign(rows_, kNone);
+        row_for_column_.assign(columns_, kNone);
+        distance_.assign(columns_, kInfinity);
+        previous_row_.assign(columns_, kNone);
+        column_done_.assign(columns_, false);
+
+        for (std::uint32_t row = 0; row < rows_; ++row) {
+            augment(row);
+        }
+        return column_for_row_;
+    }
+
+private:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+    struct Edge {
+        std::uint32_t row = 0;
+        std::uint32_t column = 0;
+        double cost = 0.0;
+    };
+
+    struct HeapEntry {
+        double distance = 0.0;
+        std::uint32_t column = 0;
+        bool operator>(const HeapEntry& other) const {
+            return distance != other.distance ? distance > other.distance : column > other.column;
+        }
+    };
+
+    void buildAdjacency() {
+        row_start_.assign(static_cast<std::size_t>(rows_) + 1, 0);
+        for (const auto& edge : edges_) {
+            ++row_start_[edge.row + 1];
+        }
+        for (std::size_t row = 1; row < row_start_.size(); ++row) {
+            row_start_[row] += row_start_[row - 1];
+        }
+        adjacency_.resize(edges_.size());
+        std::vector<std::size_t> fill(row_start_.begin(), row_start_.end() - 1);
+        for (const auto& edge : edges_) {
+            adjacency_[fill[edge.row]++] = edge;
+        }
+    }
+
+    void augment(std::uint32_t start_row) {
+        touched_.clear();
+        visited_rows_.clear();
+        heap_.clear();
+
+        double min_value = 0.0;
+        std::uint32_t row = start_row;
+        std::uint32_t sink = kNone;
+        while (sink == kNone) {
+            visited_rows_.push_back(row);
+            for (auto index = row_start_[row]; index < row_start_[row + 1]; ++index) {
+                const auto& edge = adjacency_[index];
+                if (column_done_[edge.column]) {
+                    continue;
+                }
+                const double reduced = min_value + edge.cost - row_potential_[row] - column_potential_[edge.column];
+                if (reduced < distance_[edge.column]) {
+                    if (distance_[edge.column] == kInfinity) {
+                        touched_.push_back(edge.column);
+                    }
+                    distance_[edge.column] = reduced;
+                    previous_row_[edge.column] = row;
+                    heap_.push_back(HeapEntry{reduced, edge.column});
+                    std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+                }
+            }
+
+            std::uint32_t column = kNone;
+            while (!heap_.empty()) {
+                std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+                const HeapEntry entry = heap_.back();
+                heap_.pop_back();
+                if (!column_done_[entry.column] && entry.distance == distance_[entry.column]) {
+                    column = entry.column;
+                    break;
+                }
+            }
+            if (column == kNone) {
+                throw std::logic_error("SparseAssignmentSolver: row has no feasible column");
+            }
+
+            min_value = distance_[column];
+            column_done_[column] = true;
+            if (row_for_column_[column] == kNone) {
+                sink = column;
+            } else {
+                row = row_for_column_[column];
+            }
+        }
+
+        // Dual update keeps reduced costs non-negative for the next search.
+        row_potential_[start_row] += min_value;
+        for (const auto visited : visited_rows_) {
+            if (visited != start_row) {
+                row_potential_[visited] += min_value - distance_[column_for_row_[visited]];
+            }
+        }
+        for (const auto column : touched_) {
+            if (column_done_[column]) {
+                column_potential_[column] -= min_value - distance_[column];
+            }
+        }
+
+        std::uint32_t column = sink;
+        while (true) {
+            const auto owner = previous_row_[column];
+            row_for_column_[column] = owner;
+            std::swap(column_for_row_[owner], column);
+            if (owner == start_row) {
+                break;
+            }
+        }
+
+        for (const auto touched : touched_) {
+            distance_[touched] = kInfinity;
+            column_done_[touched] = false;
+        }
+    }
+
+    std::uint32_t rows_ = 0;
+    std::uint32_t columns_ = 0;
+    std::vector<Edge> edges_;
+    std::vector<Edge> adjacency_;
+    std::vector<std::size_t> row_start_;
+
+    std::vector<double> row_potential_;
+    std::vector<double> column_potential_;
+    std::vector<std::uint32_t> column_for_row_;
+    std::vector<std::uint32_t> row_for_column_;
+
+    std::vector<double> distance_;
+    std::vector<std::uint32_t> previous_row_;
+    std::vector<bool> column_done_;
+    std::vector<std::uint32_t> touched_;
+    std::vector<std::uint32_t> visited_rows_;
+    std::vector<HeapEntry> heap_;
+};
+
+} // namespace
+
+class StreamingTracker::Impl {
+public:
+    Impl(const TrackingParams& params, const MeasurementLine& line, TrackSink sink)
+        : params_(params), line_(line), sink_(std::move(sink)) {
+        if (!sink_) {
+            throw std::invalid_argument("StreamingTracker requires a track sink");
+        }
+    }
+
+    void push(const FrameDetections& frame) {
+        if (has_frames_ && frame.frame_index_logical <= last_frame_index_) {
+            throw std::invalid_argument("StreamingTracker frames must arrive in increasing frame_index_logical order");
+        }
+        has_frames_ = true;
+        last_frame_index_ = frame.frame_index_logical;
+        if (statistics_ != nullptr) {
+            statistics_->onFrame(frame);
+        }
+
+        const auto& detections = frame.detections;
+
+        float max_radius = 1.0F;
+        for (auto& active : active_) {
+            predict(active, frame.frame_index_logical);
+            max_radius = std::max(max_radius, active.search_radius);
+        }
+        grid_.build(detections, max_radius);
+
+        candidates_.clear();
+        for (std::size_t track_index = 0; track_index < active_.size(); ++track_index) {
+            const auto& active = active_[track_index];
+            const float radius_sq = active.search_radius * active.search_radius;
+            grid_.forEachCandidate(active.predicted, active.search_radius, [&](std::size_t detection_index) {
+                const auto& detection = detections[detection_index];
+                const cv::Point2f delta = detection.centroid - active.predicted;
+                const float distance_sq = delta.x * delta.x + delta.y * delta.y;
+                if (distance_sq > radius_sq
+                    || !withinRelativeChange(active.last_area, detection.area_px2, params_.max_area_change)
+                    || !withinRelativeChange(active.last_diameter, detection.diameter_eq_px, params_.max_diameter_change)) {
+                    return;
+                }
+                candidates_.push_back(Candidate{distance_sq, static_cast<std::uint32_t>(track_index),
+                                                static_cast<std::uint32_t>(detection_index)});
+            });
+        }
+
+        track_match_.assign(active_.size(), kUnmatched);
+        detection_matched_.assign(detections.size(), false);
+        if (params_.assignment == TrackingAssignment::Optimal) {
+            assignOptimal();
+        } else {
+            assignGreedy();
+        }
+
+        for (std::size_t track_index = 0; track_index < active_.size(); ++track_index) {
+            if (track_match_[track_index] != kUnmatched) {
+                append(active_[track_index], frame, detections[track_match_[track_index]]);
+            }
+        }
+
+        std::size_t kept = 0;
+        for (std::size_t track_index = 0; track_index < active_.size(); ++track_index) {
+            auto& active = active_[track_index];
+            if (track_match_[track_index] == kUnmatched && ++active.missed_frames > params_.max_missed_frames) {
+                retire(std::move(active.track));
+                continue;
+            }
+            if (kept != track_index) {
+                active_[kept] = std::move(active);
+            }
+            ++kept;
+        }
+        active_.resize(kept);
+
+        for (std::size_t detection_index = 0; detection_index < detections.size(); ++detection_index) {
+            if (!detection_matched_[detection_index]) {
+                start(frame, detections[detection_index]);
+            }
+        }
+    }
+
+    void finalize() {
+        for (auto& active : active_) {
+            retire(std::move(active.track));
+        }
+        active_.clear();
+    }
+
+    std::size_t activeTrackCount() const { return active_.size(); }
+    std::size_t retiredTrackCount() const { return retired_count_; }
+
+    void setStatisticsEngine(DropletStatisticsEngine* engine) { statistics_ = engine; }
+
+    std::vector<TrackPrediction> predictions(std::size_t frame_index) const {
+        std::vector<TrackPrediction> out;
+        out.reserve(active_.size());
+        for (const auto& active : active_) {
+            out.push_back(predictionFor(active, frame_index));
+        }
+        return out;
+    }
+
+private:
+    static constexpr std::uint32_t kUnmatched = std::numeric_limits<std::uint32_t>::max();
+
+    void assignGreedy() {
+        std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& left, const Candidate& right) {
+            if (left.cost != right.cost) {
+                return left.cost < right.cost;
+            }
+            if (left.track != right.track) {
+                return left.track < right.track;
+            }
+            return left.detection < right.detection;
+        });
+
+        for (const auto& candidate : candidates_) {
+            if (track_match_[candidate.track] != kUnmatched || detection_matched_[candidate.detection]) {
+                continue;
+            }
+            track_match_[candidate.track] = candidate.detection;
+            detection_matched_[candidate.detection] = true;
+        }
+    }
+
+    // Minimises the summed squared distance over each connected component of the gated candidate graph.
+    // Leaving a track unmatched costs its squared search radius, so a gated link is always worth taking
+    // unless it forces a costlier arrangement elsewhere in the component.
+    void assignOptimal() {
+        const auto track_count = static_cast<std::uint32_t>(active_.size());
+        components_.reset(track_count + static_cast<std::uint32_t>(detection_matched_.size()));
+        for (const auto& candidate : candidates_) {
+            components_.unite(candidate.track, track_count + candidate.detection);
+        }
+
+        // Group candidates by component root (counting sort keeps this linear).
+        component_start_.assign(static_cast<std::size_t>(track_count) + detection_matched_.size() + 1, 0);
+        for (const auto& candidate : candidates_) {
+            ++component_start_[components_.find(candidate.track) + 1];
+        }
+        for (std::size_t root = 1; root < component_start_.size(); ++root) {
+            component_start_[root] += component_start_[root - 1];
+        }
+        grouped_.resize(candidates_.size());
+        component_fill_.assign(component_start_.begin(), component_start_.end() - 1);
+        for (const auto& candidate : candidates_) {
+            grouped_[component_fill_[components_.find(candidate.track)]++] = candidate;
+        }
+
+        for (std::size_t root = 0; root + 1 < component_start_.size(); ++root) {
+            const auto begin = component_start_[root];
+            const auto end = component_start_[root + 1];
+            if (begin == end) {
+                continue;
+            }
+            if (end - begin == 1) {
+                const auto& only = grouped_[begin];
+                track_match_[only.track] = only.detection;
+                detection_matched_[only.detection] = true;
+                continue;
+            }
+            solveComponent(begin, end);
+        }
+    }
+
+    void solveComponent(std::size_t begin, std::size_t end) {
+        // Local row (track) and column (detection) numbering for this component. Each row also owns a
+        // private "unmatched" column, so every row can always be assigned.
+        local_rows_.clear();
+        local_columns_.clear();
+        for (std::size_t index = begin; index < end; ++index) {
+            const auto& candidate = grouped_[index];
+            if (row_of_track_.size() <= candidate.track) {
+                row_of_track_.resize(static_cast<std::size_t>(candidate.track) + 1, kUnmatched);
+            }
+            if (column_of_detection_.size() <= candidate.detection) {
+                column_of_detection_.resize(static_cast<std::size_t>(candidate.detection) + 1, kUnmatched);
+            }
+            if (row_of_track_[candidate.track] == kUnmatched) {
+                row_of_track_[candidate.track] = static_cast<std::uint32_t>(local_rows_.size());
+                local_rows_.push_back(candidate.track);
+            }
+            if (column_of_detection_[candidate.detection] == kUnmatched) {
+                column_of_detection_[candidate.detection] = static_cast<std::uint32_t>(local_columns_.size());
+                local_columns_.push_back(candidate.detection);
+            }
+        }
+
+        const auto row_count = static_cast<std::uint32_t>(local_rows_.size());
+        const auto detection_columns = static_cast<std::uint32_t>(local_columns_.size());
+        solver_.reset(row_count, detection_columns + row_count);
+        for (std::size_t index = begin; index < end; ++index) {
+            const auto& candidate = grouped_[index];
+            solver_.addEdge(row_of_track_[candidate.track], column_of_detection_[candidate.detection], candidate.cost);
+        }
+        for (std::uint32_t row = 0; row < row_count; ++row) {
+            const float radius = active_[local_rows_[row]].search_radius;
+            solver_.addEdge(row, detection_columns + row, static_cast<double>(radius) * radius);
+        }
+
+        const auto& column_for_row = solver_.solve();
+        for (std::uint32_t row = 0; row < row_count; ++row) {
+            const auto column = column_for_row[row];
+            if (column < detection_columns) {
+                track_match_[local_rows_[row]] = local_columns_[column];
+                detection_matched_[local_columns_[column]] = true;
+            }
+        }
+
+        for (const auto track : local_rows_) {
+            row_of_track_[track] = kUnmatched;
+        }
+        for (const auto detection : local_columns_) {
+            column_of_detection_[detection] = kUnmatched;
+        }
+    }
+
+    void retire(Track&& track) {
+        ++retired_count_;
+        if (statistics_ != nullptr) {
+            statistics_->onTrackRetired(track);
+        }
+        sink_(std::move(track));
+    }
+
+    void predict(ActiveTrack& active, std::size_t frame_index) const {
+        const auto prediction = predictionFor(active, frame_index);
+        active.predicted = prediction.position;
+        active.search_radius = prediction.search_radius;
+    }
+
+    TrackPrediction predictionFor(const ActiveTrack& active, std::size_t frame_index) const {
+        const auto frames_ahead = static_cast<float>(frame_index > active.last_frame ? frame_index - active.last_frame : 1);
+        const cv::Point2f displacement = active.velocity_px_per_frame * frames_ahead;
+
+        const double base_radius = params_.search_radius_px > 0.0
+            ? params_.search_radius_px
+            : params_.search_radius_bbox_scale * active.last_extent;
+        const double speed = std::hypot(displacement.x, displacement.y);
+
+        TrackPrediction prediction;
+        prediction.track_id = active.track.track_id;
+        prediction.position = active.track.centroids.back() + displacement;
+        prediction.search_radius = static_cast<float>(std::max(base_radius, 1.0) + params_.velocity_uncertainty * speed);
+        prediction.extent_px = active.last_extent;
+        return prediction;
+    }
+
+    void start(const FrameDetections& frame, const Detection& detection) {
+        ActiveTrack active;
+        active.track.track_id = next_track_id_++;
+        active.track.droplet_ids.push_back(detection.droplet_id);
+        active.track.frame_indices.push_back(frame.frame_index_logical);
+        active.track.centroids.push_back(detection.centroid);
+        active.track.timestamps.push_back(frame.timestamp_inferred_s);
+        remember(active, frame, detection);
+        if (statistics_ != nullptr) {
+            statistics_->onTrackStarted(active.track, detection.diameter_eq_px);
+        }
+        active_.push_back(std::move(active));
+    }
+
+    void append(ActiveTrack& active, const FrameDetections& frame, const Detection& detection) {
+        auto& track = active.track;
+        const cv::Point2f previous = track.centroids.back();
+        const double previous_timestamp = track.timestamps.back();
+        const auto frame_step = frame.frame_index_logical > active.last_frame
+            ? static_cast<float>(frame.frame_index_logical - active.last_frame)
+            : 1.0F;
+
+        const cv::Point2f step = detection.centroid - previous;
+        active.velocity_px_per_frame = cv::Point2f(step.x / frame_step, step.y / frame_step);
+
+        const double distance = std::hypot(step.x, step.y);
+        const double dt = frame.timestamp_inferred_s - previous_timestamp;
+        track.velocities.push_back(static_cast<float>(dt > 0.0 ? distance / dt : distance / frame_step));
+
+        track.droplet_ids.push_back(detection.droplet_id);
+        track.frame_indices.push_back(frame.frame_index_logical);
+        track.centroids.push_back(detection.centroid);
+        track.timestamps.push_back(frame.timestamp_inferred_s);
+
+        const bool crossed_now = line_.enabled && !track.crossed_line &&
+            (segmentCrossesLine(previous, detection.centroid, line_) ||
+             segmentLeavesLine(previous, detection.centroid, line_));
+        if (crossed_now) {
+            track.crossed_line = true;
+            track.line_crossing_frame = frame.frame_index_logical;
+        }
+        if (statistics_ != nullptr) {
+            statistics_->onLink(track, detection.diameter_eq_px, track.velocities.back(), crossed_now);
+        }
+
+        remember(active, frame, detection);
+    }
+
+    static void remember(ActiveTrack& active, const FrameDetections& frame, const Detection& detection) {
+        active.last_area = detection.area_px2;
+        active.last_diameter = detection.diameter_eq_px;
+        active.last_extent = static_cast<float>(std::max(detection.bounding_box.width, detection.bounding_box.height));
+        active.last_frame = frame.frame_index_logical;
+        active.missed_frames = 0;
+    }
+
+    TrackingParams params_;
+    MeasurementLine line_;
+    TrackSink sink_;
+    DropletStatisticsEngine* statistics_ = nullptr;
+    std::size_t next_track_id_ = 1;
+    std::size_t retired_count_ = 0;
+    std::size_t last_frame_index_ = 0;
+    bool has_frames_ = false;
+
+    std::vector<ActiveTrack> active_;
+
+    SpatialGrid grid_;
+    std::vector<Candidate> candidates_;
+    std::vector<std::uint32_t> track_match_;
+    std::vector<bool> detection_matched_;
+
+    DisjointSets components_;
+    std::vector<std::size_t> component_start_;
+    std::vector<std::size_t> component_fill_;
+    std::vector<Candidate> grouped_;
+    std::vector<std::uint32_t> local_rows_;
+    std::vector<std::uint32_t> local_columns_;
+    std::vector<std::uint32_t> row_of_track_;
+    std::vector<std::uint32_t> column_of_detection_;
+    SparseAssignmentSolver solver_;
+};
+
+StreamingTracker::StreamingTracker(const TrackingParams& params, const MeasurementLine& measurement_line, TrackSink sink)
+    : impl_(std::make_unique<Impl>(params, measurement_line, std::move(sink))) {}
+
+StreamingTracker::~StreamingTracker() = default;
+StreamingTracker::StreamingTracker(StreamingTracker&&) noexcept = default;
+StreamingTracker& StreamingTracker::operator=(StreamingTracker&&) noexcept = default;
+
+void StreamingTracker::setStatisticsEngine(DropletStatisticsEngine* engine) { impl_->setStatisticsEngine(engine); }
+
+void StreamingTracker::push(const FrameDetections& frame) { impl_->push(frame); }
+
+void StreamingTracker::finalize() { impl_->finalize(); }
+
+std::vector<TrackPrediction> StreamingTracker::predictions(std::size_t frame_index) const {
+    return impl_->predictions(frame_index);
+}
+
+std::size_t StreamingTracker::activeTrackCount() const { return impl_->activeTrackCount(); }
+
+std::size_t StreamingTracker::retiredTrackCount() const { return impl_->retiredTrackCount(); }
+
+std::vector<Track> performTracking(const std::vector<FrameDetections>& all_detections,
+                                   const TrackingParams& tracking_params,
+                                   const MeasurementLine& measurement_line) {
+    std::vector<Track> tracks;
+    StreamingTracker tracker(tracking_params, measurement_line,
+                             [&tracks](Track&& track) { tracks.push_back(std::move(track)); });
+    for (const auto& frame : all_detections) {
+        tracker.push(frame);
+    }
+    tracker.finalize();
+
+    std::sort(tracks.begin(), tracks.end(),
+              [](const Track& left, const Track& right) { return left.track_id < right.track_id; });
+    return tracks;
+}
@@ -49,6 +49,18 @@ cv::Mat buildDropletMask(const cv::Size& size, const std::vector<cv::Point>& con
     return droplet_mask;
 }
 
+cv::Mat buildDropletMask(const cv::Size& size, const CompactContourStore& store, const CompactContourRef& contour) {
+    if (contour.empty()) {
+        throw std::invalid_argument("droplet_contour must not be empty");
+    }
+    cv::Mat droplet_mask = cv::Mat::zeros(size, CV_8U);
+    rasterizeCompactContour(store, contour, droplet_mask, 255);
+    if (cv::countNonZero(droplet_mask) == 0) {
+        throw std::invalid_argument("droplet_contour produced an empty mask");
+    }
+    return droplet_mask;
+}
+
 cv::Mat computeAnnulusMask(const cv::Mat& droplet_mask, int annulus_width) {
     const int kernel_size = annulus_width * 2 + 1;
     const auto kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(kernel_size, kernel_size));
@@ -80,16 +92,10 @@ double sumFromMask(const cv::Mat& image, const cv::Mat& mask) {
     return cv::sum(masked)[0];
 }
 
-} // namespace
-
-namespace FluorescenceQuantification {
-
-FluorescenceMetrics computeFluorescenceMetrics(
-    const cv::Mat& fluor_image,
-    const std::vector<cv::Point>& droplet_contour,
-    const cv::Mat& all_droplets_mask,
-    const cv::Mat& global_background_mask,
-    const BackgroundOptions& options) {
+void validateInputs(const cv::Mat& fluor_image,
+                    const cv::Mat& all_droplets_mask,
+                    const cv::Mat& global_background_mask,
+                    const FluorescenceQuantification::BackgroundOptions& options) {
     validateSingleChannelMat(fluor_image, "fluor_image");
     validateMask(all_droplets_mask, "all_droplets_mask", fluor_image.size());
     validateMask(global_background_mask, "global_background_mask", fluor_image.size());
@@ -103,9 +109,14 @@ FluorescenceMetrics computeFluorescenceMetrics(
     if (options.saturated_fraction_threshold < 0.0F || options.saturated_fraction_threshold > 1.0F) {
         throw std::invalid_argument("BackgroundOptions.saturated_fraction_threshold must be in [0, 1]");
     }
+}
 
-    const cv::Mat droplet_mask = buildDropletMask(fluor_image.size(), droplet_contour);
-
+FluorescenceMetrics metricsFromDropletMask(
+    const cv::Mat& fluor_image,
+    const cv::Mat& droplet_mask,
+    const cv::Mat& all_droplets_mask,
+    const cv::Mat& global_background_mask,
+    const FluorescenceQuantification::BackgroundOptions& options) {
     FluorescenceMetrics metrics;
     metrics.mean = meanFromMask(fluor_image, droplet_mask);
     metrics.integrated = static_cast<float>(sumFromMask(fluor_image, droplet_mask));
@@ -167,4 +178,31 @@ FluorescenceMetrics computeFluorescenceMetrics(
     return metrics;
 }
 
+} // namespace
+
+namespace FluorescenceQuantification {
+
+FluorescenceMetrics computeFluorescenceMetrics(
+    const cv::Mat& fluor_image,
+    const std::vector<cv::Point>& droplet_contour,
+    const cv::Mat& all_droplets_mask,
+    const cv::Mat& global_background_mask,
+    const BackgroundOptions& options) {
+    validateInputs(fluor_image, all_droplets_mask, global_background_mask, options);
+    const cv::Mat droplet_mask = buildDropletMask(fluor_image.size(), droplet_contour);
+    return metricsFromDropletMask(fluor_image, droplet_mask, all_droplets_mask, global_background_mask, options);
+}
+
+FluorescenceMetrics computeFluorescenceMetrics(
+    const cv::Mat& fluor_image,
+    const CompactContourStore& contour_store,
+    const CompactContourRef& droplet_contour,
+    const cv::Mat& all_droplets_mask,
+    const cv::Mat& global_background_mask,
+    const BackgroundOptions& options) {
+    validateInputs(fluor_image, all_droplets_mask, global_background_mask, options);
+    const cv::Mat droplet_mask = buildDropletMask(fluor_image.size(), contour_store, droplet_contour);
+    return metricsFromDropletMask(fluor_image, droplet_mask, all_droplets_mask, global_background_mask, options);
+}
+
 } // namespace FluorescenceQuantification
@@ -0,0 +1,204 @@
+#include "FolderWatcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (FR-IS2: File Collection Rule)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool hasTiffExtension(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".tif" || extension == ".tiff";
+}
+
+} // namespace
+
+FolderWatcher::FolderWatcher(std::string directory, const FolderWatchParams& params)
+    : directory_(std::move(directory)), params_(params) {}
+
+FolderWatcher::~FolderWatcher() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+#endif
+}
+
+bool FolderWatcher::start(std::string& error_message) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(directory_, ec)) {
+        error_message = "Cannot open directory: " + directory_;
+        return false;
+    }
+#ifdef __linux__
+    // Watch before the first listing, so nothing written in between goes unnoticed.
+    if (params_.use_inotify && inotify_fd_ < 0) {
+        inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ < 0 ||
+            ::inotify_add_watch(inotify_fd_, directory_.c_str(),
+                                IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) <
+                0) {
+            inotify_error_ = std::string("inotify unavailable (") + std::strerror(errno) + "), polling instead";
+            if (inotify_fd_ >= 0) {
+                ::close(inotify_fd_);
+                inotify_fd_ = -1;
+            }
+        }
+    }
+#else
+    if (params_.use_inotify) {
+        inotify_error_ = "inotify is Linux-only, polling instead";
+    }
+#endif
+    scan();
+    next_scan_ = Clock::now() + params_.poll_interval;
+    return true;
+}
+
+std::vector<std::string> FolderWatcher::waitForCompleted(std::chrono::milliseconds timeout) {
+    const auto deadline = Clock::now() + timeout;
+    for (;;) {
+        readEvents();
+        auto now = Clock::now();
+        if (now >= next_scan_) {
+            scan();
+            next_scan_ = now + params_.poll_interval;
+        }
+        if (!completed_.empty() || now >= deadline) {
+            break;
+        }
+
+        const auto wait = std::min(deadline, next_scan_) - now;
+#ifdef __linux__
+        if (inotify_fd_ >= 0) {
+            pollfd events{inotify_fd_, POLLIN, 0};
+            const auto wait_ms = std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+            ::poll(&events, 1, static_cast<int>(wait_ms));
+            continue;
+        }
+#endif
+        std::this_thread::sleep_for(wait);
+    }
+
+    std::vector<std::string> paths;
+    paths.reserve(completed_.size());
+    for (const auto& name : completed_) {
+        paths.push_back((std::filesystem::path(directory_) / name).string());
+    }
+    completed_.clear();
+    return paths;
+}
+
+std::vector<std::string> FolderWatcher::pending() const {
+    std::vector<std::string> names;
+    names.reserve(pending_.size());
+    for (const auto& [name, candidate] : pending_) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+void FolderWatcher::readEvents() {
+#ifdef __linux__
+    if (inotify_fd_ < 0) {
+        return;
+    }
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;  // EAGAIN: drained
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                // Events were lost: judge everything still pending by stability from now on.
+                for (auto& [name, candidate] : pending_) {
+                    candidate.awaiting_event = false;
+                }
+                next_scan_ = Clock::now();
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR) != 0) {
+                continue;
+            }
+            const std::string name(event->name);
+            if (!hasTiffExtension(name) || reported_.count(name) != 0) {
+                continue;
+            }
+            if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+                complete(name);
+            } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                pending_.erase(name);
+            } else {
+                Candidate& candidate = pending_[name];
+                candidate.awaiting_event = true;
+            }
+        }
+    }
+#endif
+}
+
+void FolderWatcher::scan() {
+    const auto now = Clock::now();
+    std::set<std::string> present;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code type_error;
+        if (!it->is_regular_file(type_error) || !hasTiffExtension(it->path())) {
+            continue;
+        }
+        const std::string name = it->path().filename().string();
+        if (reported_.count(name) != 0) {
+            continue;
+        }
+        present.insert(name);
+        const auto stamp = FileStamp::of(it->path());
+        if (!stamp) {
+            continue;
+        }
+        const auto [entry, inserted] = pending_.try_emplace(name, Candidate{*stamp, now, false});
+        Candidate& candidate = entry->second;
+        if (inserted || candidate.awaiting_event) {
+            continue;
+        }
+        if (*stamp != candidate.stamp) {
+            candidate.stamp = *stamp;
+            candidate.stable_since = now;
+        } else if (now - candidate.stable_since >=
+                   (stamp->size > 0 ? params_.stable_for : std::max(params_.stable_for, params_.empty_timeout))) {
+            complete(name);
+        }
+    }
+    if (ec) {
+        return;  // a failed listing says nothing about which files are gone
+    }
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        it = present.count(it->first) == 0 && !it->second.awaiting_event ? pending_.erase(it) : std::next(it);
+    }
+}
+
+void FolderWatcher::complete(const std::string& name) {
+    pending_.erase(name);
+    reported_.insert(name);
+    completed_.insert(name);
+}
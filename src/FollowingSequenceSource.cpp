@@ -0,0 +1,187 @@
+#include "FollowingSequenceSource.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#include "TimeUtils.h"
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 1: Image Sequence Source)
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (FR-IS2: File Collection Rule)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string fileName(const std::string& path) {
+    return std::filesystem::path(path).filename().string();
+}
+
+bool acceptPage(const TiffFileLayout& layout, std::string& error_message) {
+    return TiffFormat::validatePage(layout, layout.pages.front(), error_message) &&
+        TiffFormat::canDecode(layout.pages.front(), error_message);
+}
+
+} // namespace
+
+FollowingSequenceSource::FollowingSequenceSource(const std::string& directory, double fps_manual,
+                                                 const SequenceFollowParams& params)
+    : directory_(directory), fps_manual_(fps_manual), params_(params), watcher_(directory, params.watch) {}
+
+bool FollowingSequenceSource::start(std::string& error_message) {
+    if (!watcher_.start(error_message)) {
+        return false;
+    }
+    last_growth_ = Clock::now();
+    return true;
+}
+
+void FollowingSequenceSource::stop() {
+    stop_requested_.store(true, std::memory_order_release);
+}
+
+GrabStatus FollowingSequenceSource::grabNextFrame(StreamFrame& frame, std::chrono::microseconds timeout) {
+    const auto deadline = Clock::now() + timeout;
+    for (;;) {
+        while (next_delivery_ >= frame_count_.load(std::memory_order_acquire)) {
+            if (stop_requested_.load(std::memory_order_acquire)) {
+                return GrabStatus::Stopped;
+            }
+            const auto now = Clock::now();
+            if (params_.end_after_idle.count() > 0 && now - last_growth_ >= params_.end_after_idle) {
+                return GrabStatus::Stopped;
+            }
+            if (now >= deadline) {
+                return GrabStatus::Timeout;
+            }
+            // Short waits keep stop() and the idle limit responsive.
+            auto wait = std::min<Clock::duration>(deadline - now, std::chrono::milliseconds(50));
+            if (params_.end_after_idle.count() > 0) {
+                wait = std::min<Clock::duration>(wait, last_growth_ + params_.end_after_idle - now);
+            }
+            append(watcher_.waitForCompleted(std::chrono::ceil<std::chrono::milliseconds>(wait)));
+        }
+
+        const std::size_t index = next_delivery_++;
+        try {
+            frame.image = getFrame(index);
+        } catch (const std::exception& e) {
+            // The file changed or vanished after it was appended; like a camera, move on to the next frame.
+            reject(framePath(index), e.what());
+            frames_lost_ = true;
+            continue;
+        }
+        frame.frame_index = index;
+        frame.timestamp = getTimestamp(index);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frame.arrival = appended_at_[index];
+        }
+        const bool lost = std::exchange(frames_lost_, false);
+        return lost ? GrabStatus::LostFrame : GrabStatus::Ok;
+    }
+}
+
+cv::Mat FollowingSequenceSource::getFrame(std::size_t logical_index) {
+    FrameFile file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (logical_index >= frames_.size()) {
+            throw std::out_of_range("FollowingSequenceSource::getFrame index " + std::to_string(logical_index) +
+                                    " out of range");
+        }
+        file = frames_[logical_index];
+    }
+    // Never a view of a mapping: the acquisition software may still truncate or replace a file it has written, which
+    // would fault (SIGBUS) a consumer reading through mapped pages.
+    std::string error;
+    cv::Mat image;
+    if (!TiffFormat::readPageCopy(file.path, file.little_endian, file.page, image, error)) {
+        throw std::runtime_error(fileName(file.path) + ": " + error);
+    }
+    return image;
+}
+
+double FollowingSequenceSource::getTimestamp(std::size_t logical_index) const {
+    return TimeUtils::inferredTimestamp(logical_index, fps_manual_);
+}
+
+std::string FollowingSequenceSource::framePath(std::size_t logical_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_.at(logical_index).path;
+}
+
+cv::Size FollowingSequenceSource::frameSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_size_;
+}
+
+int FollowingSequenceSource::frameType() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frame_type_;
+}
+
+std::vector<SequenceValidationIssue> FollowingSequenceSource::skipped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return skipped_;
+}
+
+void FollowingSequenceSource::append(const std::vector<std::string>& completed) {
+    for (const auto& path : completed) {
+        if (!last_appended_.empty() && fileName(path) < last_appended_) {
+            reject(path, "completed after later files were already streamed (out of alphabetical order)");
+        } else {
+            held_.insert(path);
+        }
+    }
+    if (held_.empty()) {
+        return;
+    }
+    // FR-IS2 order: nothing may overtake a file that sorts earlier and is still being written.
+    const auto pending = watcher_.pending();
+    const std::string first_pending = pending.empty() ? std::string() : pending.front();
+    while (!held_.empty()) {
+        const std::string path = *held_.begin();
+        if (!first_pending.empty() && first_pending < fileName(path)) {
+            break;
+        }
+        held_.erase(held_.begin());
+        appendFile(path);
+    }
+}
+
+void FollowingSequenceSource::appendFile(const std::string& path) {
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) == 0 && !ec) {
+        reject(path, "file stayed empty (nothing was written to it)");
+        return;
+    }
+    TiffFileLayout layout;
+    std::string error;
+    if (!TiffFormat::parseFile(path, layout, error) || !acceptPage(layout, error)) {
+        reject(path, error);
+        return;
+    }
+    const TiffPageLayout& page = layout.pages.front();
+    last_appended_ = fileName(path);
+    last_growth_ = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frames_.empty()) {
+        frame_size_ = cv::Size(static_cast<int>(page.width), static_cast<int>(page.height));
+        frame_type_ = TiffFormat::matType(page);
+    } else if (static_cast<int>(page.width) != frame_size_.width ||
+               static_cast<int>(page.height) != frame_size_.height || TiffFormat::matType(page) != frame_type_) {
+        skipped_.push_back({fileName(path), "format does not match the rest of the sequence"});
+        return;
+    }
+    frames_.push_back({path, page, layout.little_endian});
+    appended_at_.push_back(last_growth_);
+    frame_count_.store(frames_.size(), std::memory_order_release);
+}
+
+void FollowingSequenceSource::reject(const std::string& path, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    skipped_.push_back({fileName(path), message});
+}
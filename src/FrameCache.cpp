@@ -0,0 +1,575 @@
+#include "FrameCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Frame Cache (Memory-Budget Based))
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Recorded requests after which a shard tries to hand them to the policy, and after which it waits to.
+constexpr std::size_t kAccessBatch = 64;
+constexpr std::size_t kMaxRecordedAccesses = 4096;
+
+std::uint64_t nanosecondsSince(Clock::time_point begin) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+}
+
+void raiseTo(std::atomic<std::size_t>& peak, std::size_t value) {
+    std::size_t current = peak.load();
+    while (current < value && !peak.compare_exchange_weak(current, value)) {
+    }
+}
+
+} // namespace
+
+const cv::Mat& FrameHandle::mat() const {
+    static const cv::Mat empty;
+    return frame_ ? *frame_ : empty;
+}
+
+std::size_t FrameHandle::bytes() const {
+    return frame_ ? frame_->total() * frame_->elemSize() : 0;
+}
+
+double FrameCacheStats::hitRate() const {
+    const std::size_t requests = hits + misses + compressed_hits + shared_loads;
+    return requests == 0 ? 0.0
+                         : static_cast<double>(hits + compressed_hits + shared_loads) / static_cast<double>(requests);
+}
+
+FrameCache::FrameCache(std::size_t memory_budget_bytes, std::size_t shards, std::unique_ptr<CachePolicy> policy,
+                       MemoryGovernor* governor)
+    : shards_(std::max<std::size_t>(1, shards)),
+      budget_(memory_budget_bytes),
+      policy_(policy ? std::move(policy) : std::make_unique<LruPolicy>()),
+      governor_(governor) {
+    if (governor_ != nullptr) {
+        shrinker_id_ = governor_->addShrinker([this](std::size_t bytes) { return shrink(bytes); });
+    }
+}
+
+FrameCache::~FrameCache() {
+    if (governor_ != nullptr) {
+        governor_->removeShrinker(shrinker_id_);
+        governor_->release(MemoryCategory::FrameCache, bytes_.load());
+        governor_->release(MemoryCategory::CompressedFrames, compressed_.bytes);
+    }
+}
+
+FrameHandle FrameCache::get(std::size_t frame_id, const std::function<cv::Mat()>& loader) {
+    Shard& shard = shardOf(frame_id);
+    std::promise<std::shared_ptr<const cv::Mat>> loaded;
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        const auto found = shard.entries.find(frame_id);
+        if (found != shard.entries.end()) {
+            Entry& entry = found->second;
+            accessed(shard, frame_id, entry.frame != nullptr);
+            if (entry.frame) {
+                ++hits_;
+                return FrameHandle(entry.frame);
+            }
+            const auto pending = entry.pending;
+            lock.unlock();
+            ++shared_loads_;
+            return FrameHandle(pending.get());
+        }
+        shard.entries[frame_id].pending = loaded.get_future().share();
+        accessed(shard, frame_id, false);
+    }
+
+    std::shared_ptr<const cv::Mat> frame;
+    try {
+        cv::Mat decoded;
+        if (promote(frame_id, decoded)) {
+            ++compressed_hits_;
+            frame = std::make_shared<const cv::Mat>(std::move(decoded));
+        } else {
+            ++misses_;
+            frame = std::make_shared<const cv::Mat>(loader());
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.erase(frame_id);
+        }
+        loaded.set_exception(std::current_exception());
+        throw;
+    }
+
+    const std::size_t bytes = frame->total() * frame->elemSize();
+    std::size_t unset = 0;
+    if (first_frame_bytes_.compare_exchange_strong(unset, bytes)) {
+        updateCapacity();
+    }
+    const bool keep = bytes <= budget_.load() && makeRoom(frame_id, bytes);
+    {
+        // clear() leaves loading entries alone, so ours is still there.
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Entry& entry = shard.entries.at(frame_id);
+        if (!keep) {
+            shard.entries.erase(frame_id);
+        } else {
+            entry.pending = {};
+            entry.frame = frame;
+            entry.bytes = bytes;
+            ++frames_;
+            std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+            drainAccesses();
+            entry.pinned = isPinned(frame_id);
+            if (entry.pinned) {
+                ++pinned_frames_;
+            } else {
+                policy_->inserted(frame_id);
+            }
+        }
+    }
+    loaded.set_value(frame);
+    raiseTo(peak_bytes_, bytes_.load());
+    if (governor_ != nullptr) {
+        governor_->enforce();
+    }
+    return FrameHandle(std::move(frame));
+}
+
+void FrameCache::pin(const std::string& set_name, std::span<const std::size_t> frame_ids) {
+    std::vector<std::size_t> changed;
+    {
+        std::lock_guard<std::mutex> lock(policy_mutex_);
+        std::vector<std::size_t>& set = pin_sets_[set_name];
+        for (const std::size_t frame_id : set) {
+            if (--pin_counts_[frame_id] == 0) {
+                pin_counts_.erase(frame_id);
+            }
+            changed.push_back(frame_id);
+        }
+        set.assign(frame_ids.begin(), frame_ids.end());
+        for (const std::size_t frame_id : set) {
+            ++pin_counts_[frame_id];
+            changed.push_back(frame_id);
+        }
+    }
+    for (const std::size_t frame_id : changed) {
+        refreshPin(frame_id);
+    }
+}
+
+void FrameCache::unpin(const std::string& set_name) {
+    std::vector<std::size_t> released;
+    {
+        std::lock_guard<std::mutex> lock(policy_mutex_);
+        const auto set = pin_sets_.find(set_name);
+        if (set == pin_sets_.end()) {
+            return;
+        }
+        released = std::move(set->second);
+        pin_sets_.erase(set);
+        for (const std::size_t frame_id : released) {
+            if (--pin_counts_[frame_id] == 0) {
+                pin_counts_.erase(frame_id);
+            }
+        }
+    }
+    for (const std::size_t frame_id : released) {
+        refreshPin(frame_id);
+    }
+    // Unpinned frames may have been kept over a budget that shrank meanwhile.
+    evictToBudget();
+}
+
+void FrameCache::clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto entry = shard.entries.begin(); entry != shard.entries.end();) {
+            if (!entry->second.frame) {
+                ++entry;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+                drainAccesses();
+                if (entry->second.pinned) {
+                    --pinned_frames_;
+                }
+                policy_->erased(entry->first);
+            }
+            bytes_ -= entry->second.bytes;
+            released(MemoryCategory::FrameCache, entry->second.bytes);
+            --frames_;
+            entry = shard.entries.erase(entry);
+        }
+    }
+    std::lock_guard<std::mutex> lock(compressed_.mutex);
+    released(MemoryCategory::CompressedFrames, compressed_.trim(0));
+}
+
+void FrameCache::setMemoryBudget(std::size_t bytes) {
+    budget_ = bytes;
+    updateCapacity();
+    evictToBudget();
+}
+
+std::size_t FrameCache::getMaxFrames() const {
+    const std::size_t frame_bytes = first_frame_bytes_.load();
+    return frame_bytes == 0 ? 0 : budget_.load() / frame_bytes;
+}
+
+void FrameCache::setCompressedBudget(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(compressed_.mutex);
+    compressed_.budget = bytes;
+    released(MemoryCategory::CompressedFrames, compressed_.trim(bytes));
+}
+
+std::size_t FrameCache::getCompressedBudgetBytes() const {
+    std::lock_guard<std::mutex> lock(compressed_.mutex);
+    return compressed_.budget;
+}
+
+const char* FrameCache::policyName() const {
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    return policy_->name();
+}
+
+void FrameCache::setTraceRecording(bool enabled) {
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    drainAccesses();
+    tracing_ = enabled;
+}
+
+std::vector<std::size_t> FrameCache::takeTrace() {
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    drainAccesses();
+    return std::exchange(trace_, {});
+}
+
+FrameCacheStats FrameCache::stats() const {
+    FrameCacheStats stats;
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    stats.shared_loads = shared_loads_.load();
+    stats.evictions = evictions_.load();
+    stats.rejected = rejected_.load();
+    stats.frames = frames_.load();
+    stats.pinned_frames = pinned_frames_.load();
+    stats.bytes = bytes_.load();
+    stats.peak_bytes = peak_bytes_.load();
+    stats.compressed_hits = compressed_hits_.load();
+    stats.encode_seconds = static_cast<double>(encode_nanoseconds_.load()) * 1e-9;
+    stats.decode_seconds = static_cast<double>(decode_nanoseconds_.load()) * 1e-9;
+    std::lock_guard<std::mutex> lock(compressed_.mutex);
+    stats.compressed_frames = compressed_.frames.size();
+    stats.compressed_bytes = compressed_.bytes;
+    stats.compressed_raw_bytes = compressed_.raw_bytes;
+    return stats;
+}
+
+void FrameCache::accessed(Shard& shard, std::size_t frame_id, bool resident) {
+    std::size_t recorded = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.access_mutex);
+        shard.accesses.push_back({access_sequence_.fetch_add(1, std::memory_order_relaxed), frame_id, resident});
+        recorded = shard.accesses.size();
+    }
+    if (recorded < kAccessBatch) {
+        return;
+    }
+    // Whoever holds the policy drains before deciding anything; only a shard far behind waits for it.
+    std::unique_lock<std::mutex> lock(policy_mutex_, std::defer_lock);
+    if (recorded >= kMaxRecordedAccesses) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+    drainAccesses();
+}
+
+void FrameCache::drainAccesses() {
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.access_mutex);
+        drained_.insert(drained_.end(), shard.accesses.begin(), shard.accesses.end());
+        shard.accesses.clear();
+    }
+    std::sort(drained_.begin(), drained_.end(),
+              [](const Access& left, const Access& right) { return left.sequence < right.sequence; });
+    for (const Access& access : drained_) {
+        policy_->accessed(access.frame_id, access.resident);
+        if (tracing_) {
+            trace_.push_back(access.frame_id);
+        }
+    }
+    drained_.clear();
+}
+
+void FrameCache::updateCapacity() {
+    if (first_frame_bytes_.load() == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    drainAccesses();
+    policy_->setCapacity(std::max<std::size_t>(1, getMaxFrames()));
+}
+
+bool FrameCache::makeRoom(std::size_t frame_id, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(evict_mutex_);
+    bool compared = false;
+    while (bytes_.load() + bytes > budget_.load()) {
+        std::size_t victim = 0;
+        {
+            std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+            drainAccesses();
+            const std::optional<std::size_t> next = policy_->victim();
+            if (!next) {
+                return false;  // everything left is pinned
+            }
+            // Admission is decided against the first victim only; the frames after it go regardless.
+            if (!compared && !isPinned(frame_id)) {
+                compared = true;
+                if (!policy_->admit(frame_id, *next)) {
+                    ++rejected_;
+                    return false;
+                }
+            }
+            victim = *next;
+            policy_->erased(victim);
+        }
+        if (const auto evicted = evict(victim)) {
+            ++evictions_;
+            demote(victim, *evicted);
+        }
+    }
+    bytes_ += bytes;
+    charged(MemoryCategory::FrameCache, bytes);
+    return true;
+}
+
+void FrameCache::evictToBudget() {
+    std::lock_guard<std::mutex> lock(evict_mutex_);
+    while (bytes_.load() > budget_.load()) {
+        std::size_t victim = 0;
+        {
+            std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+            drainAccesses();
+            const std::optional<std::size_t> next = policy_->victim();
+            if (!next) {
+                return;
+            }
+            victim = *next;
+            policy_->erased(victim);
+        }
+        if (const auto evicted = evict(victim)) {
+            ++evictions_;
+            demote(victim, *evicted);
+        }
+    }
+}
+
+std::shared_ptr<const cv::Mat> FrameCache::evict(std::size_t frame_id) {
+    Shard& shard = shardOf(frame_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = shard.entries.find(frame_id);
+    // Cleared, or pinned after the policy picked it.
+    if (found == shard.entries.end() || !found->second.frame || found->second.pinned) {
+        return nullptr;
+    }
+    std::shared_ptr<const cv::Mat> frame = std::move(found->second.frame);
+    bytes_ -= found->second.bytes;
+    released(MemoryCategory::FrameCache, found->second.bytes);
+    --frames_;
+    shard.entries.erase(found);
+    return frame;
+}
+
+void FrameCache::demote(std::size_t frame_id, const cv::Mat& frame) {
+    {
+        std::lock_guard<std::mutex> lock(compressed_.mutex);
+        if (compressed_.budget == 0 || !FrameCodec::supports(frame)) {
+            return;
+        }
+    }
+    // Encoding runs on the evicting thread, outside every lock but the eviction mutex.
+    const auto begin = Clock::now();
+    EncodedFrame encoded;
+    FrameCodec::encode(frame, encoded);
+    encode_nanoseconds_ += nanosecondsSince(begin);
+
+    std::lock_guard<std::mutex> lock(compressed_.mutex);
+    const std::size_t bytes = encoded.bytes.size();
+    if (bytes > compressed_.budget || compressed_.frames.count(frame_id) != 0) {
+        return;
+    }
+    released(MemoryCategory::CompressedFrames, compressed_.trim(compressed_.budget - bytes));
+    compressed_.recency.push_front(frame_id);
+    compressed_.bytes += bytes;
+    charged(MemoryCategory::CompressedFrames, bytes);
+    compressed_.raw_bytes += encoded.rawBytes();
+    compressed_.frames.emplace(frame_id, CompressedEntry{std::move(encoded), compressed_.recency.begin()});
+}
+
+bool FrameCache::promote(std::size_t frame_id, cv::Mat& frame) {
+    EncodedFrame encoded;
+    {
+        std::lock_guard<std::mutex> lock(compressed_.mutex);
+        const auto found = compressed_.frames.find(frame_id);
+        if (found == compressed_.frames.end()) {
+            return false;
+        }
+        encoded = std::move(found->second.encoded);
+        compressed_.recency.erase(found->second.position);
+        compressed_.bytes -= encoded.bytes.size();
+        compressed_.raw_bytes -= encoded.rawBytes();
+        compressed_.frames.erase(found);
+        released(MemoryCategory::CompressedFrames, encoded.bytes.size());
+    }
+    const auto begin = Clock::now();
+    const bool decoded = FrameCodec::decode(encoded, frame);
+    decode_nanoseconds_ += nanosecondsSince(begin);
+    return decoded;
+}
+
+std::size_t FrameCache::CompressedTier::trim(std::size_t limit) {
+    const std::size_t before = bytes;
+    while (bytes > limit && !recency.empty()) {
+        const auto found = frames.find(recency.back());
+        bytes -= found->second.encoded.bytes.size();
+        raw_bytes -= found->second.encoded.rawBytes();
+        frames.erase(found);
+        recency.pop_back();
+    }
+    return before - bytes;
+}
+
+void FrameCache::refreshPin(std::size_t frame_id) {
+    Shard& shard = shardOf(frame_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = shard.entries.find(frame_id);
+    if (found == shard.entries.end() || !found->second.frame) {
+        return;  // picked up by get() once loaded
+    }
+    Entry& entry = found->second;
+    std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+    drainAccesses();
+    const bool pinned = isPinned(frame_id);
+    if (pinned == entry.pinned) {
+        return;
+    }
+    if (pinned) {
+        policy_->pinned(frame_id);
+        ++pinned_frames_;
+    } else {
+        policy_->unpinned(frame_id);
+        --pinned_frames_;
+    }
+    entry.pinned = pinned;
+}
+
+std::size_t FrameCache::shrink(std::size_t bytes) {
+    std::size_t freed = 0;
+    {
+        std::lock_guard<std::mutex> lock(compressed_.mutex);
+        freed = compressed_.trim(compressed_.bytes > bytes ? compressed_.bytes - bytes : 0);
+        released(MemoryCategory::CompressedFrames, freed);
+    }
+    // Evicted frames are not demoted: the memory is wanted elsewhere.
+    std::lock_guard<std::mutex> lock(evict_mutex_);
+    while (freed < bytes) {
+        std::size_t victim = 0;
+        {
+            std::lock_guard<std::mutex> policy_lock(policy_mutex_);
+            drainAccesses();
+            const std::optional<std::size_t> next = policy_->victim();
+            if (!next) {
+                break;
+            }
+            victim = *next;
+            policy_->erased(victim);
+        }
+        if (const auto evicted = evict(victim)) {
+            ++evictions_;
+            freed += evicted->total() * evicted->elemSize();
+        }
+    }
+    return freed;
+}
+
+void FrameCache::charged(MemoryCategory category, std::size_t bytes) {
+    if (governor_ != nullptr) {
+        governor_->add(category, bytes);
+    }
+}
+
+void FrameCache::released(MemoryCategory category, std::size_t bytes) {
+    if (governor_ != nullptr) {
+        governor_->release(category, bytes);
+    }
+}
+
+namespace FrameCacheTrace {
+
+bool load(const std::filesystem::path& path, std::vector<std::size_t>& trace, std::string& error_message) {
+    std::ifstream file(path);
+    if (!file) {
+        error_message = "Cannot open file: " + path.string();
+        return false;
+    }
+    trace.clear();
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        const std::size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        const std::size_t last = line.find_last_not_of(" \t\r");
+        const std::string token = line.substr(first, last - first + 1);
+        if (token.find_first_not_of("0123456789") != std::string::npos || token.size() > 19) {
+            error_message = "Invalid frame id on line " + std::to_string(line_number) + " of " + path.string();
+            return false;
+        }
+        trace.push_back(static_cast<std::size_t>(std::stoull(token)));
+    }
+    return true;
+}
+
+bool save(const std::filesystem::path& path, std::span<const std::size_t> trace, std::string& error_message) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        error_message = "Cannot open file: " + path.string();
+        return false;
+    }
+    for (const std::size_t frame_id : trace) {
+        file << frame_id << '\n';
+    }
+    file.flush();
+    if (!file) {
+        error_message = "Cannot write file: " + path.string();
+        return false;
+    }
+    return true;
+}
+
+FrameCacheStats replay(std::span<const std::size_t> trace, std::size_t capacity_frames,
+                       std::unique_ptr<CachePolicy> policy, std::span<const std::size_t> pinned) {
+    // One byte per frame: only the counts matter, not the pixels.
+    FrameCache cache(capacity_frames, 1, std::move(policy), nullptr);
+    if (!pinned.empty()) {
+        cache.pin("replay", pinned);
+    }
+    const auto loader = []() { return cv::Mat(1, 1, CV_8UC1); };
+    for (const std::size_t frame_id : trace) {
+        cache.get(frame_id, loader);
+    }
+    return cache.stats();
+}
+
+} // namespace FrameCacheTrace
@@ -0,0 +1,308 @@
+#include "FrameCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAME_CODEC_SSE2 1
+#else
+#define FRAME_CODEC_SSE2 0
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (Cache Budget)
+
+namespace {
+
+constexpr std::size_t kLanes = 8;
+constexpr std::size_t kVectors = FrameCodec::kBlockSamples / kLanes;  // 16 vectors of 8 samples per block
+constexpr std::size_t kMaxWidth = 16;
+
+using Block = std::array<std::uint16_t, FrameCodec::kBlockSamples>;
+
+std::uint16_t laneMask(unsigned width) {
+    return static_cast<std::uint16_t>(width >= 16 ? 0xFFFFU : (1U << width) - 1U);
+}
+
+// Zigzag in the sample's own width; decoding in 16 bits gives the same low byte for 8-bit residuals.
+std::uint16_t zigzag(std::uint16_t residual, bool eight_bit) {
+    if (eight_bit) {
+        const auto value = static_cast<std::int8_t>(residual);
+        return static_cast<std::uint8_t>((static_cast<unsigned>(value) << 1) ^ static_cast<unsigned>(value >> 7));
+    }
+    const auto value = static_cast<std::int16_t>(residual);
+    return static_cast<std::uint16_t>((static_cast<unsigned>(value) << 1) ^ static_cast<unsigned>(value >> 15));
+}
+
+// Bytes of one exception: its position in the block and the bits above the packed width.
+constexpr std::size_t kExceptionBytes = 3;
+
+// Packed width that minimises the block size when values wider than it are stored as exceptions.
+unsigned chooseWidth(const Block& values, std::size_t& exceptions) {
+    std::array<std::size_t, kMaxWidth + 1> histogram{};
+    for (const std::uint16_t value : values) {
+        ++histogram[static_cast<std::size_t>(std::bit_width(value))];
+    }
+    unsigned best = kMaxWidth;
+    std::size_t best_bytes = kMaxWidth * kLanes * 2;
+    std::size_t wider = 0;
+    for (unsigned width = kMaxWidth; width-- > 0;) {
+        wider += histogram[width + 1];
+        const std::size_t bytes = width * kLanes * 2 + wider * kExceptionBytes;
+        if (wider <= 255 && bytes <= best_bytes) {
+            best = width;
+            best_bytes = bytes;
+            exceptions = wider;
+        }
+    }
+    if (best == kMaxWidth) {
+        exceptions = 0;
+    }
+    return best;
+}
+
+// Block layout: width, exception count, then the low `width` bits of every value and one (position, high bits)
+// record per exception. Sample i is lane i % 8 of vector i / 8; each lane packs its 16 values into `width`
+// consecutive 16-bit words, word j of every lane forming one 16-byte vector.
+void packBlock(const Block& values, std::vector<std::uint8_t>& out) {
+    std::size_t exceptions = 0;
+    const unsigned width = chooseWidth(values, exceptions);
+    out.push_back(static_cast<std::uint8_t>(width));
+    out.push_back(static_cast<std::uint8_t>(exceptions));
+    const std::uint16_t mask = laneMask(width);
+    std::array<std::uint16_t, kMaxWidth * kLanes> words{};
+    for (std::size_t k = 0; k < kVectors && width != 0; ++k) {
+        const std::size_t bit = k * width;
+        const std::size_t word = bit / 16;
+        const std::size_t shift = bit % 16;
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            const std::uint32_t value = values[k * kLanes + lane] & mask;
+            words[word * kLanes + lane] = static_cast<std::uint16_t>(words[word * kLanes + lane] | (value << shift));
+            if (shift + width > 16) {
+                words[(word + 1) * kLanes + lane] =
+                    static_cast<std::uint16_t>(words[(word + 1) * kLanes + lane] | (value >> (16 - shift)));
+            }
+        }
+    }
+    const std::size_t bytes = width * kLanes * sizeof(std::uint16_t);
+    const std::size_t offset = out.size();
+    out.resize(offset + bytes);
+    std::memcpy(out.data() + offset, words.data(), bytes);
+    for (std::size_t i = 0; i < values.size() && exceptions != 0; ++i) {
+        if ((values[i] & ~mask) != 0) {
+            const auto high = static_cast<std::uint16_t>(values[i] >> width);
+            out.push_back(static_cast<std::uint8_t>(i));
+            out.push_back(static_cast<std::uint8_t>(high & 0xFFU));
+            out.push_back(static_cast<std::uint8_t>(high >> 8));
+        }
+    }
+}
+
+void unpackScalar(const std::uint8_t* in, unsigned width, std::uint16_t* out) {
+    std::array<std::uint16_t, kMaxWidth * kLanes> words{};
+    std::memcpy(words.data(), in, width * kLanes * sizeof(std::uint16_t));
+    const std::uint16_t mask = laneMask(width);
+    for (std::size_t k = 0; k < kVectors; ++k) {
+        const std::size_t bit = k * width;
+        const std::size_t word = bit / 16;
+        const std::size_t shift = bit % 16;
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            std::uint32_t value = 0;
+            if (width != 0) {
+                value = static_cast<std::uint32_t>(words[word * kLanes + lane]) >> shift;
+                if (shift + width > 16) {
+                    value |= static_cast<std::uint32_t>(words[(word + 1) * kLanes + lane]) << (16 - shift);
+                }
+            }
+            out[k * kLanes + lane] = static_cast<std::uint16_t>(value & mask);
+        }
+    }
+}
+
+// Undoes the zigzag and adds the running sum starting from `carry`, in place. Returns the last sample.
+std::uint16_t reconstructScalar(std::uint16_t* values, std::uint16_t carry) {
+    for (std::size_t i = 0; i < FrameCodec::kBlockSamples; ++i) {
+        const std::uint16_t zigzagged = values[i];
+        carry = static_cast<std::uint16_t>(carry + ((zigzagged >> 1) ^ (0U - (zigzagged & 1U))));
+        values[i] = carry;
+    }
+    return carry;
+}
+
+#if FRAME_CODEC_SSE2
+void unpackSse2(const std::uint8_t* in, unsigned width, std::uint16_t* out) {
+    const auto* words = reinterpret_cast<const __m128i*>(in);
+    const __m128i mask = _mm_set1_epi16(static_cast<short>(laneMask(width)));
+    for (std::size_t k = 0; k < kVectors; ++k) {
+        __m128i value = _mm_setzero_si128();
+        if (width != 0) {
+            const std::size_t bit = k * width;
+            const std::size_t word = bit / 16;
+            const int shift = static_cast<int>(bit % 16);
+            value = _mm_srl_epi16(_mm_loadu_si128(words + word), _mm_cvtsi32_si128(shift));
+            if (shift + static_cast<int>(width) > 16) {
+                value = _mm_or_si128(value,
+                                     _mm_sll_epi16(_mm_loadu_si128(words + word + 1), _mm_cvtsi32_si128(16 - shift)));
+            }
+            value = _mm_and_si128(value, mask);
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + k * kLanes), value);
+    }
+}
+
+std::uint16_t reconstructSse2(std::uint16_t* values, std::uint16_t carry) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i running = _mm_set1_epi16(static_cast<short>(carry));
+    for (std::size_t k = 0; k < kVectors; ++k) {
+        auto* vector = reinterpret_cast<__m128i*>(values + k * kLanes);
+        const __m128i zigzagged = _mm_load_si128(vector);
+        __m128i residual =
+            _mm_xor_si128(_mm_srli_epi16(zigzagged, 1), _mm_sub_epi16(zero, _mm_and_si128(zigzagged, one)));
+        // In-register prefix sum over the 8 lanes, then add everything before this vector.
+        residual = _mm_add_epi16(residual, _mm_slli_si128(residual, 2));
+        residual = _mm_add_epi16(residual, _mm_slli_si128(residual, 4));
+        residual = _mm_add_epi16(residual, _mm_slli_si128(residual, 8));
+        const __m128i samples = _mm_add_epi16(residual, running);
+        _mm_store_si128(vector, samples);
+        const __m128i last = _mm_shufflehi_epi16(samples, 0xFF);
+        running = _mm_unpackhi_epi64(last, last);
+    }
+    return values[FrameCodec::kBlockSamples - 1];
+}
+#endif
+
+struct BlockDecoder {
+    void (*unpack)(const std::uint8_t*, unsigned, std::uint16_t*);
+    std::uint16_t (*reconstruct)(std::uint16_t*, std::uint16_t);
+};
+
+constexpr BlockDecoder kScalarDecoder{unpackScalar, reconstructScalar};
+#if FRAME_CODEC_SSE2
+constexpr BlockDecoder kSse2Decoder{unpackSse2, reconstructSse2};
+#endif
+
+bool supportedType(int type) {
+    return type == CV_8UC1 || type == CV_16UC1;
+}
+
+bool decodeWith(const EncodedFrame& encoded, cv::Mat& frame, const BlockDecoder& decoder) {
+    if (!supportedType(encoded.type) || encoded.rows <= 0 || encoded.cols <= 0) {
+        return false;
+    }
+    const bool eight_bit = encoded.type == CV_8UC1;
+    cv::Mat image(encoded.rows, encoded.cols, encoded.type);
+    const std::uint8_t* in = encoded.bytes.data();
+    const std::uint8_t* const end = in + encoded.bytes.size();
+    alignas(16) Block block{};
+    for (int y = 0; y < image.rows; ++y) {
+        std::uint16_t carry = 0;
+        if (y > 0) {
+            carry = eight_bit ? image.ptr<std::uint8_t>(y - 1)[0] : image.ptr<std::uint16_t>(y - 1)[0];
+        }
+        for (int x = 0; x < image.cols; x += static_cast<int>(FrameCodec::kBlockSamples)) {
+            if (end - in < 2 || in[0] > kMaxWidth) {
+                return false;
+            }
+            const unsigned width = in[0];
+            const std::size_t exceptions = in[1];
+            in += 2;
+            const std::size_t packed = width * kLanes * sizeof(std::uint16_t);
+            if (static_cast<std::size_t>(end - in) < packed + exceptions * kExceptionBytes) {
+                return false;
+            }
+            decoder.unpack(in, width, block.data());
+            in += packed;
+            for (std::size_t e = 0; e < exceptions; ++e, in += kExceptionBytes) {
+                if (in[0] >= FrameCodec::kBlockSamples) {
+                    return false;
+                }
+                const auto high = static_cast<std::uint32_t>(in[1] | (in[2] << 8));
+                block[in[0]] = static_cast<std::uint16_t>(block[in[0]] | (high << width));
+            }
+            carry = decoder.reconstruct(block.data(), carry);
+            const int count = std::min(static_cast<int>(FrameCodec::kBlockSamples), image.cols - x);
+            if (eight_bit) {
+                std::uint8_t* row = image.ptr<std::uint8_t>(y) + x;
+                for (int i = 0; i < count; ++i) {
+                    row[i] = static_cast<std::uint8_t>(block[static_cast<std::size_t>(i)]);
+                }
+            } else {
+                std::memcpy(image.ptr<std::uint16_t>(y) + x, block.data(), static_cast<std::size_t>(count) * 2);
+            }
+        }
+    }
+    if (in != end) {
+        return false;
+    }
+    frame = image;
+    return true;
+}
+
+} // namespace
+
+namespace FrameCodec {
+
+bool supports(const cv::Mat& frame) {
+    return !frame.empty() && frame.dims == 2 && supportedType(frame.type());
+}
+
+bool encode(const cv::Mat& frame, EncodedFrame& encoded) {
+    if (!supports(frame)) {
+        return false;
+    }
+    const bool eight_bit = frame.type() == CV_8UC1;
+    const auto cols = static_cast<std::size_t>(frame.cols);
+
+    std::vector<std::uint8_t> bytes;
+    // Smooth frames land around half their raw size; reserve for that rather than the worst case.
+    bytes.reserve(frame.total() * frame.elemSize() / 2);
+    std::vector<std::uint16_t> row(cols);
+    std::uint16_t above = 0;
+    Block block{};
+    for (int y = 0; y < frame.rows; ++y) {
+        if (eight_bit) {
+            std::copy_n(frame.ptr<std::uint8_t>(y), cols, row.begin());
+        } else {
+            std::copy_n(frame.ptr<std::uint16_t>(y), cols, row.begin());
+        }
+        std::uint16_t previous = above;
+        above = row[0];
+        for (std::size_t x = 0; x < cols; x += kBlockSamples) {
+            const std::size_t count = std::min(kBlockSamples, cols - x);
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::uint16_t current = row[x + i];
+                block[i] = zigzag(static_cast<std::uint16_t>(current - previous), eight_bit);
+                previous = current;
+            }
+            std::fill(block.begin() + static_cast<std::ptrdiff_t>(count), block.end(), std::uint16_t{0});
+            packBlock(block, bytes);
+        }
+    }
+
+    encoded.rows = frame.rows;
+    encoded.cols = frame.cols;
+    encoded.type = frame.type();
+    encoded.bytes = std::move(bytes);
+    return true;
+}
+
+bool decode(const EncodedFrame& encoded, cv::Mat& frame) {
+#if FRAME_CODEC_SSE2
+    return decodeWith(encoded, frame, kSse2Decoder);
+#else
+    return decodeWith(encoded, frame, kScalarDecoder);
+#endif
+}
+
+bool decodeScalar(const EncodedFrame& encoded, cv::Mat& frame) {
+    return decodeWith(encoded, frame, kScalarDecoder);
+}
+
+bool simdDecode() {
+    return FRAME_CODEC_SSE2 != 0;
+}
+
+} // namespace FrameCodec
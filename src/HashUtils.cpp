@@ -1,25 +1,75 @@
 #include "HashUtils.h"
 
+#include <algorithm>
 #include <array>
-#include <fstream>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <string>
-#include <vector>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HASH_UTILS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
 #ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-#include <bcrypt.h>
+// GCC and Clang compile the accelerated kernels for their instruction sets without raising the baseline of the
+// whole file; which kernel actually runs is decided from CPUID at run time. MSVC needs no annotation.
+#if defined(__GNUC__) || defined(__clang__)
+#define HASH_UTILS_TARGET(features) __attribute__((target(features)))
+#else
+#define HASH_UTILS_TARGET(features)
 #endif
 
 namespace HashUtils {
 namespace {
 
 constexpr std::size_t kSha256DigestBytes = 32;
+constexpr std::size_t kBlockBytes = 64;
+// Sequential reads this large keep the device busy and cost one system call per 4 MB.
+constexpr std::size_t kReadBytes = std::size_t{4} << 20;
+constexpr std::size_t kLanes = 8;
+constexpr std::size_t kLaneReadBytes = kReadBytes / kLanes * 2;
+
+using Digest = std::array<std::byte, kSha256DigestBytes>;
+using State = std::array<std::uint32_t, 8>;
+// Compresses `blocks` consecutive 64-byte blocks into the state.
+using CompressFunction = void (*)(State& state, const std::uint8_t* data, std::size_t blocks);
+
+alignas(64) constexpr std::array<std::uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
 
-std::string toLowerHex(const std::array<std::byte, kSha256DigestBytes>& digest) {
+constexpr State kInitialState = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+std::string toLowerHex(const Digest& digest) {
     static constexpr char kHex[] = "0123456789abcdef";
 
     std::string hex;
@@ -35,203 +85,557 @@ std::string toLowerHex(const std::array<std::byte, kSha256DigestBytes>& digest)
     return hex;
 }
 
-#ifdef _WIN32
+std::uint32_t loadBigEndian32(const std::uint8_t* bytes) {
+    return (static_cast<std::uint32_t>(bytes[0]) << 24U) | (static_cast<std::uint32_t>(bytes[1]) << 16U) |
+        (static_cast<std::uint32_t>(bytes[2]) << 8U) | static_cast<std::uint32_t>(bytes[3]);
+}
 
-void throwIfBcryptFailed(NTSTATUS status, const char* message) {
-    if (status == 0) {
-        return;
+// FIPS 180-4, section 6.2.
+void compressPortable(State& state, const std::uint8_t* data, std::size_t blocks) {
+    std::array<std::uint32_t, 64> w{};
+    for (; blocks > 0; --blocks, data += kBlockBytes) {
+        for (std::size_t t = 0; t < 16; ++t) {
+            w[t] = loadBigEndian32(data + 4 * t);
+        }
+        for (std::size_t t = 16; t < 64; ++t) {
+            const std::uint32_t s0 = std::rotr(w[t - 15], 7) ^ std::rotr(w[t - 15], 18) ^ (w[t - 15] >> 3U);
+            const std::uint32_t s1 = std::rotr(w[t - 2], 17) ^ std::rotr(w[t - 2], 19) ^ (w[t - 2] >> 10U);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (std::size_t t = 0; t < 64; ++t) {
+            const std::uint32_t t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                kRoundConstants[t] + w[t];
+            const std::uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
-    throw std::runtime_error(std::string(message) + " (NTSTATUS=" + std::to_string(status) + ")");
 }
 
-class AlgorithmProvider final {
-public:
-    AlgorithmProvider() {
-        const auto status = BCryptOpenAlgorithmProvider(&handle_, BCRYPT_SHA256_ALGORITHM, nullptr, 0);
-        throwIfBcryptFailed(status, "BCryptOpenAlgorithmProvider failed");
+#ifdef HASH_UTILS_X86
+
+// Four rounds with the SHA extensions. The message schedule lives in four registers of four words each; group G
+// consumes msg[G % 4] and, on the way, advances the schedule for the groups after it.
+template <int G>
+HASH_UTILS_TARGET("sha,sse4.1") inline void shaNiRounds(__m128i& state0, __m128i& state1, __m128i (&msg)[4]) {
+    constexpr int current = G % 4;
+    __m128i rounds = _mm_add_epi32(
+        msg[current], _mm_load_si128(reinterpret_cast<const __m128i*>(kRoundConstants.data() + 4 * G)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+    if constexpr (G >= 3 && G <= 14) {
+        constexpr int next = (G + 1) % 4;
+        const __m128i carried = _mm_alignr_epi8(msg[current], msg[(G + 3) % 4], 4);
+        msg[next] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[next], carried), msg[current]);
+    }
+    rounds = _mm_shuffle_epi32(rounds, 0x0E);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, rounds);
+    if constexpr (G >= 1 && G <= 12) {
+        msg[(G + 3) % 4] = _mm_sha256msg1_epu32(msg[(G + 3) % 4], msg[current]);
     }
+}
 
-    AlgorithmProvider(const AlgorithmProvider&) = delete;
-    AlgorithmProvider& operator=(const AlgorithmProvider&) = delete;
+template <int... G>
+HASH_UTILS_TARGET("sha,sse4.1")
+inline void shaNiBlock(__m128i& state0, __m128i& state1, __m128i (&msg)[4], std::integer_sequence<int, G...>) {
+    (shaNiRounds<G>(state0, state1, msg), ...);
+}
 
-    AlgorithmProvider(AlgorithmProvider&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
-    AlgorithmProvider& operator=(AlgorithmProvider&& other) noexcept {
-        if (this == &other) {
-            return *this;
+HASH_UTILS_TARGET("sha,sse4.1") void compressShaNi(State& state, const std::uint8_t* data, std::size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+    // sha256rnds2 keeps the working variables as ABEF / CDGH.
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data())), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data() + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; --blocks, data += kBlockBytes) {
+        const __m128i abef = state0;
+        const __m128i cdgh = state1;
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byte_swap);
         }
-        reset();
-        handle_ = other.handle_;
-        other.handle_ = nullptr;
-        return *this;
+        shaNiBlock(state0, state1, msg, std::make_integer_sequence<int, 16>{});
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
     }
 
-    ~AlgorithmProvider() { reset(); }
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data()), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data() + 4), state1);
+}
 
-    BCRYPT_ALG_HANDLE get() const { return handle_; }
+// 8x8 transpose of 32-bit words: out[j] holds word j of every row. Its own inverse.
+HASH_UTILS_TARGET("avx2") inline void transpose8x8(const __m256i (&in)[8], __m256i* out) {
+    const __m256i t0 = _mm256_unpacklo_epi32(in[0], in[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(in[0], in[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(in[2], in[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(in[2], in[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(in[4], in[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(in[4], in[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(in[6], in[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(in[6], in[7]);
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
 
-private:
-    void reset() {
-        if (handle_ != nullptr) {
-            BCryptCloseAlgorithmProvider(handle_, 0);
-            handle_ = nullptr;
-        }
-    }
+HASH_UTILS_TARGET("avx2") inline __m256i rotr8(__m256i x, int bits) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, bits), _mm256_slli_epi32(x, 32 - bits));
+}
 
-    BCRYPT_ALG_HANDLE handle_{nullptr};
-};
+HASH_UTILS_TARGET("avx2") inline __m256i xor3(__m256i a, __m256i b, __m256i c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+}
 
-std::array<std::byte, kSha256DigestBytes> sha256Digest(std::span<const std::byte> data) {
-    AlgorithmProvider algorithm;
-
-    DWORD object_length = 0;
-    ULONG bytes_written = 0;
-    auto status = BCryptGetProperty(
-        algorithm.get(),
-        BCRYPT_OBJECT_LENGTH,
-        reinterpret_cast<PUCHAR>(&object_length),
-        static_cast<ULONG>(sizeof(object_length)),
-        &bytes_written,
-        0);
-    throwIfBcryptFailed(status, "BCryptGetProperty(BCRYPT_OBJECT_LENGTH) failed");
-
-    DWORD hash_length = 0;
-    status = BCryptGetProperty(
-        algorithm.get(),
-        BCRYPT_HASH_LENGTH,
-        reinterpret_cast<PUCHAR>(&hash_length),
-        static_cast<ULONG>(sizeof(hash_length)),
-        &bytes_written,
-        0);
-    throwIfBcryptFailed(status, "BCryptGetProperty(BCRYPT_HASH_LENGTH) failed");
-    if (hash_length != kSha256DigestBytes) {
-        throw std::runtime_error("SHA-256 digest length mismatch: expected 32 bytes");
-    }
-
-    std::vector<unsigned char> hash_object(object_length);
-    BCRYPT_HASH_HANDLE hash_handle = nullptr;
-    status = BCryptCreateHash(
-        algorithm.get(),
-        &hash_handle,
-        reinterpret_cast<PUCHAR>(hash_object.data()),
-        static_cast<ULONG>(hash_object.size()),
-        nullptr,
-        0,
-        0);
-    throwIfBcryptFailed(status, "BCryptCreateHash failed");
-
-    const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
-    const auto total_size = data.size();
-    if (total_size > static_cast<std::size_t>(std::numeric_limits<ULONG>::max())) {
-        BCryptDestroyHash(hash_handle);
-        throw std::runtime_error("Input too large for BCryptHashData");
-    }
-
-    status = BCryptHashData(hash_handle, const_cast<PUCHAR>(bytes), static_cast<ULONG>(total_size), 0);
-    if (status != 0) {
-        BCryptDestroyHash(hash_handle);
-        throwIfBcryptFailed(status, "BCryptHashData failed");
-    }
-
-    std::array<std::byte, kSha256DigestBytes> digest{};
-    status = BCryptFinishHash(hash_handle, reinterpret_cast<PUCHAR>(digest.data()), kSha256DigestBytes, 0);
-    BCryptDestroyHash(hash_handle);
-    throwIfBcryptFailed(status, "BCryptFinishHash failed");
+// compressPortable() for eight independent streams, one per 32-bit lane. Every lane compresses `blocks` blocks.
+HASH_UTILS_TARGET("avx2")
+void compressAvx2x8(const std::array<State*, kLanes>& states, const std::array<const std::uint8_t*, kLanes>& data,
+                    std::size_t blocks) {
+    const __m256i byte_swap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15,
+                                              8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i rows[8];
+    __m256i s[8];
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        rows[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states[lane]->data()));
+    }
+    transpose8x8(rows, s);
+
+    for (std::size_t block = 0; block < blocks; ++block) {
+        __m256i w[16];
+        for (std::size_t half = 0; half < 2; ++half) {
+            for (std::size_t lane = 0; lane < kLanes; ++lane) {
+                rows[lane] = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data[lane] + block * kBlockBytes + 32 * half)),
+                    byte_swap);
+            }
+            transpose8x8(rows, w + 8 * half);
+        }
 
-    return digest;
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+        for (std::size_t t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                const __m256i w15 = w[(t - 15) & 15U];
+                const __m256i w2 = w[(t - 2) & 15U];
+                const __m256i s0 = xor3(rotr8(w15, 7), rotr8(w15, 18), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = xor3(rotr8(w2, 17), rotr8(w2, 19), _mm256_srli_epi32(w2, 10));
+                w[t & 15U] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15U], s0), _mm256_add_epi32(w[(t - 7) & 15U], s1));
+            }
+            const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i t1 = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_add_epi32(h, xor3(rotr8(e, 6), rotr8(e, 11), rotr8(e, 25))), ch),
+                _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(kRoundConstants[t])), w[t & 15U]));
+            const __m256i maj = _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(a, b), c), _mm256_and_si256(a, b));
+            const __m256i t2 = _mm256_add_epi32(xor3(rotr8(a, 2), rotr8(a, 13), rotr8(a, 22)), maj);
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+        s[0] = _mm256_add_epi32(s[0], a);
+        s[1] = _mm256_add_epi32(s[1], b);
+        s[2] = _mm256_add_epi32(s[2], c);
+        s[3] = _mm256_add_epi32(s[3], d);
+        s[4] = _mm256_add_epi32(s[4], e);
+        s[5] = _mm256_add_epi32(s[5], f);
+        s[6] = _mm256_add_epi32(s[6], g);
+        s[7] = _mm256_add_epi32(s[7], h);
+    }
+
+    transpose8x8(s, rows);
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(states[lane]->data()), rows[lane]);
+    }
 }
 
-std::array<std::byte, kSha256DigestBytes> sha256DigestFile(const std::filesystem::path& file_path) {
-    if (!std::filesystem::exists(file_path)) {
-        throw std::runtime_error("File does not exist: " + file_path.string());
+std::array<unsigned int, 4> cpuid(unsigned int leaf, unsigned int subleaf) {
+    std::array<unsigned int, 4> registers{};
+#ifdef _MSC_VER
+    int values[4] = {};
+    __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (std::size_t i = 0; i < 4; ++i) {
+        registers[i] = static_cast<unsigned int>(values[i]);
     }
-    if (!std::filesystem::is_regular_file(file_path)) {
-        throw std::runtime_error("Path is not a regular file: " + file_path.string());
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    return registers;
+}
+
+// Whether the OS saves the YMM registers on context switches (without that, AVX2 must not be used).
+bool osSavesYmmState() {
+    if ((cpuid(1, 0)[2] & (1U << 27U)) == 0) {  // OSXSAVE
+        return false;
     }
+#ifdef _MSC_VER
+    const auto xcr0 = _xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    const auto xcr0 = (static_cast<std::uint64_t>(edx) << 32U) | eax;
+#endif
+    return (xcr0 & 0x6U) == 0x6U;
+}
+
+#endif
+
+struct CpuFeatures {
+    bool sha_ni = false;
+    bool avx2 = false;
+};
 
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Failed to open file: " + file_path.string());
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#ifdef HASH_UTILS_X86
+    if (cpuid(0, 0)[0] < 7) {
+        return features;
     }
+    const auto leaf1 = cpuid(1, 0);
+    const auto leaf7 = cpuid(7, 0);
+    const bool sse41 = (leaf1[2] & (1U << 19U)) != 0;
+    features.sha_ni = sse41 && (leaf7[1] & (1U << 29U)) != 0;
+    features.avx2 = (leaf7[1] & (1U << 5U)) != 0 && osSavesYmmState();
+#endif
+    return features;
+}
 
-    AlgorithmProvider algorithm;
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
 
-    DWORD object_length = 0;
-    ULONG bytes_written = 0;
-    auto status = BCryptGetProperty(
-        algorithm.get(),
-        BCRYPT_OBJECT_LENGTH,
-        reinterpret_cast<PUCHAR>(&object_length),
-        static_cast<ULONG>(sizeof(object_length)),
-        &bytes_written,
-        0);
-    throwIfBcryptFailed(status, "BCryptGetProperty(BCRYPT_OBJECT_LENGTH) failed");
+std::atomic<Sha256Kernel>& selectedKernel() {
+    static std::atomic<Sha256Kernel> kernel{cpuFeatures().sha_ni ? Sha256Kernel::ShaNi
+                                                : cpuFeatures().avx2 ? Sha256Kernel::Avx2MultiBuffer
+                                                                     : Sha256Kernel::Portable};
+    return kernel;
+}
 
-    DWORD hash_length = 0;
-    status = BCryptGetProperty(
-        algorithm.get(),
-        BCRYPT_HASH_LENGTH,
-        reinterpret_cast<PUCHAR>(&hash_length),
-        static_cast<ULONG>(sizeof(hash_length)),
-        &bytes_written,
-        0);
-    throwIfBcryptFailed(status, "BCryptGetProperty(BCRYPT_HASH_LENGTH) failed");
-    if (hash_length != kSha256DigestBytes) {
-        throw std::runtime_error("SHA-256 digest length mismatch: expected 32 bytes");
+// Single-stream compression for a kernel (the multi-buffer kernel has no single-stream form).
+CompressFunction singleStreamCompress(Sha256Kernel kernel) {
+#ifdef HASH_UTILS_X86
+    if (kernel == Sha256Kernel::ShaNi) {
+        return compressShaNi;
     }
+#else
+    (void)kernel;
+#endif
+    return compressPortable;
+}
 
-    std::vector<unsigned char> hash_object(object_length);
-    BCRYPT_HASH_HANDLE hash_handle = nullptr;
-    status = BCryptCreateHash(
-        algorithm.get(),
-        &hash_handle,
-        reinterpret_cast<PUCHAR>(hash_object.data()),
-        static_cast<ULONG>(hash_object.size()),
-        nullptr,
-        0,
-        0);
-    throwIfBcryptFailed(status, "BCryptCreateHash failed");
+struct Sha256Context {
+    State state = kInitialState;
+    std::uint64_t length = 0;  // bytes hashed so far
+    std::array<std::uint8_t, kBlockBytes> tail{};
+    std::size_t tail_size = 0;
+};
 
-    std::vector<unsigned char> buffer(1 << 20);
-    while (file) {
-        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
-        const auto count = file.gcount();
-        if (count <= 0) {
-            continue;
+void update(Sha256Context& context, const std::uint8_t* data, std::size_t size, CompressFunction compress) {
+    context.length += size;
+    if (context.tail_size > 0) {
+        const std::size_t take = std::min(size, kBlockBytes - context.tail_size);
+        std::memcpy(context.tail.data() + context.tail_size, data, take);
+        context.tail_size += take;
+        data += take;
+        size -= take;
+        if (context.tail_size < kBlockBytes) {
+            return;
         }
-        if (count > static_cast<std::streamsize>(std::numeric_limits<ULONG>::max())) {
-            BCryptDestroyHash(hash_handle);
-            throw std::runtime_error("Read chunk too large for BCryptHashData");
+        compress(context.state, context.tail.data(), 1);
+        context.tail_size = 0;
+    }
+    const std::size_t blocks = size / kBlockBytes;
+    if (blocks > 0) {
+        compress(context.state, data, blocks);
+    }
+    context.tail_size = size - blocks * kBlockBytes;
+    if (context.tail_size > 0) {
+        std::memcpy(context.tail.data(), data + blocks * kBlockBytes, context.tail_size);
+    }
+}
+
+Digest finish(Sha256Context& context, CompressFunction compress) {
+    // 0x80, zeros, and the message length in bits as a 64-bit big-endian integer, in one or two blocks.
+    std::array<std::uint8_t, 2 * kBlockBytes> padding{};
+    std::memcpy(padding.data(), context.tail.data(), context.tail_size);
+    padding[context.tail_size] = 0x80;
+    const std::size_t blocks = context.tail_size < kBlockBytes - 8 ? 1 : 2;
+    const std::uint64_t bits = context.length * 8;
+    for (std::size_t i = 0; i < 8; ++i) {
+        padding[blocks * kBlockBytes - 1 - i] = static_cast<std::uint8_t>(bits >> (8 * i));
+    }
+    compress(context.state, padding.data(), blocks);
+
+    Digest digest{};
+    for (std::size_t i = 0; i < 8; ++i) {
+        for (std::size_t b = 0; b < 4; ++b) {
+            digest[4 * i + b] = static_cast<std::byte>(context.state[i] >> (24 - 8 * b));
         }
+    }
+    return digest;
+}
 
-        status = BCryptHashData(hash_handle, buffer.data(), static_cast<ULONG>(count), 0);
-        if (status != 0) {
-            BCryptDestroyHash(hash_handle);
-            throwIfBcryptFailed(status, "BCryptHashData failed");
+// Reads a file front to back in large chunks, telling the OS the access is sequential so it reads ahead.
+class FileReader final {
+public:
+    explicit FileReader(const std::filesystem::path& file_path) : path_(file_path.string()) {
+        if (!std::filesystem::exists(file_path)) {
+            throw std::runtime_error("File does not exist: " + path_);
+        }
+        if (!std::filesystem::is_regular_file(file_path)) {
+            throw std::runtime_error("Path is not a regular file: " + path_);
+        }
+#ifdef _WIN32
+        handle_ = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open file: " + path_);
+        }
+#else
+        fd_ = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file: " + path_);
         }
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
     }
 
-    std::array<std::byte, kSha256DigestBytes> digest{};
-    status = BCryptFinishHash(hash_handle, reinterpret_cast<PUCHAR>(digest.data()), kSha256DigestBytes, 0);
-    BCryptDestroyHash(hash_handle);
-    throwIfBcryptFailed(status, "BCryptFinishHash failed");
+    ~FileReader() {
+#ifdef _WIN32
+        CloseHandle(handle_);
+#else
+        ::close(fd_);
+#endif
+    }
 
-    return digest;
-}
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
 
+    // Fills up to `size` bytes; returns fewer only at the end of the file.
+    std::size_t read(std::uint8_t* buffer, std::size_t size) {
+        std::size_t filled = 0;
+        while (filled < size) {
+#ifdef _WIN32
+            DWORD count = 0;
+            const auto request = static_cast<DWORD>(std::min<std::size_t>(size - filled, kReadBytes));
+            if (!ReadFile(handle_, buffer + filled, request, &count, nullptr)) {
+                throw std::runtime_error("Failed to read file: " + path_);
+            }
 #else
+            const ssize_t count = ::read(fd_, buffer + filled, size - filled);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to read file: " + path_);
+            }
+#endif
+            if (count == 0) {
+                break;
+            }
+            filled += static_cast<std::size_t>(count);
+        }
+        return filled;
+    }
 
-std::array<std::byte, kSha256DigestBytes> sha256Digest(std::span<const std::byte>) {
-    throw std::runtime_error("HashUtils sha256Digest not implemented on this platform");
+private:
+    std::string path_;
+#ifdef _WIN32
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+Digest sha256Digest(std::span<const std::byte> data) {
+    const CompressFunction compress = singleStreamCompress(sha256Kernel());
+    Sha256Context context;
+    update(context, reinterpret_cast<const std::uint8_t*>(data.data()), data.size(), compress);
+    return finish(context, compress);
 }
 
-std::array<std::byte, kSha256DigestBytes> sha256DigestFile(const std::filesystem::path&) {
-    throw std::runtime_error("HashUtils sha256DigestFile not implemented on this platform");
+Digest sha256DigestFile(const std::filesystem::path& file_path) {
+    FileReader reader(file_path);
+    const CompressFunction compress = singleStreamCompress(sha256Kernel());
+    const auto buffer = std::make_unique_for_overwrite<std::uint8_t[]>(kReadBytes);
+    Sha256Context context;
+    for (;;) {
+        const std::size_t count = reader.read(buffer.get(), kReadBytes);
+        update(context, buffer.get(), count, compress);
+        if (count < kReadBytes) {
+            break;
+        }
+    }
+    return finish(context, compress);
+}
+
+#ifdef HASH_UTILS_X86
+
+struct Lane {
+    std::size_t file = 0;
+    std::unique_ptr<FileReader> reader;  // null when the lane is idle
+    Sha256Context context;
+    std::unique_ptr<std::uint8_t[]> buffer;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    bool at_eof = false;
+};
+
+// Hashes the files eight at a time. Each lane streams its own file through its own buffer; the lanes advance
+// together by as many whole blocks as every busy lane has buffered, and a lane whose file is done finishes its
+// last partial block on its own and moves on to the next file.
+std::vector<Digest> sha256DigestFilesMultiBuffer(std::span<const std::filesystem::path> file_paths) {
+    std::vector<Digest> digests(file_paths.size());
+    std::size_t next_file = 0;
+    std::array<Lane, kLanes> lanes;
+
+    const auto assign = [&](Lane& lane) {
+        lane.reader.reset();
+        if (next_file < file_paths.size()) {
+            lane.file = next_file++;
+            lane.reader = std::make_unique<FileReader>(file_paths[lane.file]);
+            lane.context = Sha256Context{};
+            lane.begin = 0;
+            lane.end = 0;
+            lane.at_eof = false;
+        }
+    };
+    // Until the lane holds a whole block: read more, or finish the file and take the next one.
+    const auto fill = [&](Lane& lane) {
+        while (lane.reader && lane.end - lane.begin < kBlockBytes) {
+            if (!lane.at_eof) {
+                const std::size_t kept = lane.end - lane.begin;
+                std::memmove(lane.buffer.get(), lane.buffer.get() + lane.begin, kept);
+                const std::size_t count = lane.reader->read(lane.buffer.get() + kept, kLaneReadBytes - kept);
+                lane.begin = 0;
+                lane.end = kept + count;
+                lane.at_eof = count < kLaneReadBytes - kept;
+                continue;
+            }
+            update(lane.context, lane.buffer.get() + lane.begin, lane.end - lane.begin, compressPortable);
+            digests[lane.file] = finish(lane.context, compressPortable);
+            assign(lane);
+        }
+    };
+
+    for (auto& lane : lanes) {
+        lane.buffer = std::make_unique_for_overwrite<std::uint8_t[]>(kLaneReadBytes);
+        assign(lane);
+    }
+    State idle_state{};
+    for (;;) {
+        std::size_t blocks = std::numeric_limits<std::size_t>::max();
+        std::size_t busy = 0;
+        const std::uint8_t* any_data = nullptr;
+        for (auto& lane : lanes) {
+            fill(lane);
+            if (lane.reader) {
+                ++busy;
+                blocks = std::min(blocks, (lane.end - lane.begin) / kBlockBytes);
+                any_data = lane.buffer.get() + lane.begin;
+            }
+        }
+        if (busy == 0) {
+            break;
+        }
+
+        // Idle lanes compress a copy of a busy lane's data into a scratch state that is thrown away.
+        std::array<State*, kLanes> states{};
+        std::array<const std::uint8_t*, kLanes> data{};
+        for (std::size_t i = 0; i < kLanes; ++i) {
+            states[i] = lanes[i].reader ? &lanes[i].context.state : &idle_state;
+            data[i] = lanes[i].reader ? lanes[i].buffer.get() + lanes[i].begin : any_data;
+        }
+        compressAvx2x8(states, data, blocks);
+        for (auto& lane : lanes) {
+            if (lane.reader) {
+                lane.begin += blocks * kBlockBytes;
+                lane.context.length += blocks * kBlockBytes;
+            }
+        }
+    }
+    return digests;
 }
 
 #endif
 
 } // namespace
 
+const char* sha256KernelName(Sha256Kernel kernel) {
+    switch (kernel) {
+        case Sha256Kernel::Portable:
+            return "portable";
+        case Sha256Kernel::ShaNi:
+            return "sha-ni";
+        case Sha256Kernel::Avx2MultiBuffer:
+            break;
+    }
+    return "avx2-multi-buffer";
+}
+
+bool sha256KernelSupported(Sha256Kernel kernel) {
+    switch (kernel) {
+        case Sha256Kernel::Portable:
+            return true;
+        case Sha256Kernel::ShaNi:
+            return cpuFeatures().sha_ni;
+        case Sha256Kernel::Avx2MultiBuffer:
+            break;
+    }
+    return cpuFeatures().avx2;
+}
+
+Sha256Kernel sha256Kernel() { return selectedKernel().load(std::memory_order_relaxed); }
+
+bool setSha256Kernel(Sha256Kernel kernel) {
+    if (!sha256KernelSupported(kernel)) {
+        return false;
+    }
+    selectedKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
 std::string sha256Hex(std::span<const std::byte> data) { return toLowerHex(sha256Digest(data)); }
 
 std::string sha256Hex(std::string_view text) {
@@ -241,5 +645,21 @@ std::string sha256Hex(std::string_view text) {
 
 std::string sha256HexFile(const std::filesystem::path& file_path) { return toLowerHex(sha256DigestFile(file_path)); }
 
-} // namespace HashUtils
+std::vector<std::string> sha256HexFiles(std::span<const std::filesystem::path> file_paths) {
+    std::vector<std::string> hashes;
+    hashes.reserve(file_paths.size());
+#ifdef HASH_UTILS_X86
+    if (sha256Kernel() == Sha256Kernel::Avx2MultiBuffer && file_paths.size() > 1) {
+        for (const auto& digest : sha256DigestFilesMultiBuffer(file_paths)) {
+            hashes.push_back(toLowerHex(digest));
+        }
+        return hashes;
+    }
+#endif
+    for (const auto& file_path : file_paths) {
+        hashes.push_back(sha256HexFile(file_path));
+    }
+    return hashes;
+}
 
+} // namespace HashUtils
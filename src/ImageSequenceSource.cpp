@@ -0,0 +1,459 @@
+#include "ImageSequenceSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+#include "ThreadPool.h"
+#include "TimeUtils.h"
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 1: Image Sequence Source)
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+namespace {
+
+constexpr const char* kIndexFileName = ".droplet_sequence.idx";
+constexpr std::string_view kIndexMagic = "DROPLET-IMAGE-SEQUENCE";
+constexpr std::uint32_t kIndexVersion = 1;
+
+bool hasTiffExtension(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".tif" || extension == ".tiff";
+}
+
+std::string fileName(const std::string& path) {
+    return std::filesystem::path(path).filename().string();
+}
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+bool acceptPage(const TiffFileLayout& layout, std::string& error_message) {
+    return TiffFormat::validatePage(layout, layout.pages.front(), error_message) &&
+        TiffFormat::canDecode(layout.pages.front(), error_message);
+}
+
+struct SampleResult {
+    std::size_t bytes_read = 0;
+    std::string error;
+};
+
+} // namespace
+
+ImageSequenceSource::ImageSequenceSource(const std::string& directory, double fps_manual, std::size_t scan_threads)
+    : directory_(directory), fps_manual_(fps_manual),
+      scan_threads_(scan_threads > 0 ? scan_threads : std::max<std::size_t>(4, std::thread::hardware_concurrency())) {}
+
+bool ImageSequenceSource::load(std::string& error_message) {
+    frames_.clear();
+    frame_size_ = cv::Size();
+    frame_type_ = -1;
+    zero_copy_frames_ = 0;
+    decoded_frames_ = 0;
+    libtiff_frames_ = 0;
+    batched_frames_ = 0;
+    headers_parsed_on_access_ = 0;
+    unindexed_headers_ = 0;
+    recent_mappings_.clear();
+    next_recent_mapping_ = 0;
+    report_ = SequenceValidationReport{};
+    index_write_error_.clear();
+
+    const auto begin = Clock::now();
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory_, ec);
+    if (ec) {
+        error_message = "Cannot open directory: " + directory_ + " (" + ec.message() + ")";
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    for (; it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            error_message = "Failed to scan directory: " + directory_ + " (" + ec.message() + ")";
+            return false;
+        }
+        std::error_code type_error;
+        if (!it->is_regular_file(type_error) || !hasTiffExtension(it->path())) {
+            continue;
+        }
+        if (paths.size() == kMaxFiles) {
+            error_message = "Too many TIFF files in directory (max 100,000)";
+            return false;
+        }
+        paths.push_back(it->path().string());
+    }
+    if (paths.empty()) {
+        error_message = "No TIFF files found in directory: " + directory_;
+        return false;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<FrameFile> frames(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        frames[i].path = std::move(paths[i]);
+    }
+    report_.total_files = frames.size();
+    report_.enumerate_seconds = secondsSince(begin);
+
+    const auto validate_begin = Clock::now();
+    const bool listing_indexed = reuseIndex(frames);
+    validateSample(frames);
+    report_.validate_seconds = secondsSince(validate_begin);
+    if (!report_.ok()) {
+        report_.time_to_ready_seconds = secondsSince(begin);
+        error_message = report_.issues.front().message;
+        return false;
+    }
+    if (!listing_indexed || report_.reused_headers < report_.sampled_files) {
+        writeIndex(frames);
+    }
+    report_.time_to_ready_seconds = secondsSince(begin);
+
+    const TiffPageLayout& first = *frames.front().page;
+    frame_size_ = cv::Size(static_cast<int>(first.width), static_cast<int>(first.height));
+    frame_type_ = TiffFormat::matType(first);
+    frames_ = std::move(frames);
+    return true;
+}
+
+cv::Mat ImageSequenceSource::getFrame(std::size_t logical_index) {
+    if (logical_index >= frames_.size()) {
+        throw std::out_of_range("ImageSequenceSource::getFrame index " + std::to_string(logical_index) + " out of range");
+    }
+    return readFrame(frames_[logical_index]);
+}
+
+double ImageSequenceSource::getTimestamp(std::size_t logical_index) const {
+    return TimeUtils::inferredTimestamp(logical_index, fps_manual_);
+}
+
+const std::string& ImageSequenceSource::framePath(std::size_t logical_index) const {
+    return frames_.at(logical_index).path;
+}
+
+void ImageSequenceSource::updateIndex() {
+    std::lock_guard<std::mutex> lock(pages_mutex_);
+    if (unindexed_headers_ == 0) {
+        return;
+    }
+    writeIndex(frames_);
+    unindexed_headers_ = 0;
+}
+
+std::filesystem::path ImageSequenceSource::indexPath(const std::string& directory) {
+    return std::filesystem::path(directory) / kIndexFileName;
+}
+
+bool ImageSequenceSource::reuseIndex(std::vector<FrameFile>& frames) {
+    auto reader = SidecarReader::open(indexPath(directory_), kIndexMagic, kIndexVersion);
+    std::uint64_t count = 0;
+    if (!reader || !reader->get(count) || count > reader->remaining()) {
+        return false;
+    }
+
+    std::vector<std::string> names(static_cast<std::size_t>(count));
+    std::unordered_map<std::string, FrameFile> indexed;
+    for (auto& name : names) {
+        std::uint8_t has_page = 0;
+        if (!reader->getString(name) || !reader->get(has_page)) {
+            return false;
+        }
+        if (has_page == 0) {
+            continue;
+        }
+        FrameFile entry;
+        FileStamp stamp;
+        std::uint8_t little_endian = 0;
+        TiffPageLayout page;
+        if (!reader->get(stamp.size) || !reader->get(stamp.mtime_ticks) || !reader->get(little_endian) ||
+            !TiffFormat::getPage(*reader, page)) {
+            return false;
+        }
+        entry.page = std::move(page);
+        entry.little_endian = little_endian != 0;
+        entry.stamp = stamp;
+        indexed.emplace(name, std::move(entry));
+    }
+    if (reader->remaining() != 0) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        FrameFile& frame = frames[i];
+        const auto entry = indexed.find(fileName(frame.path));
+        if (entry == indexed.end()) {
+            continue;
+        }
+        const bool sampled = i % kValidationStride == 0;
+        // Samples are checked against the file now; the rest on first access (layoutOf()), so load() does not
+        // have to stat every file.
+        if (sampled && FileStamp::of(frame.path) != entry->second.stamp) {
+            continue;
+        }
+        frame.page = std::move(entry->second.page);
+        frame.little_endian = entry->second.little_endian;
+        frame.stamp = entry->second.stamp;
+        frame.stamp_unchecked = !sampled;
+        report_.reused_headers += sampled ? 1 : 0;
+    }
+
+    if (names.size() != frames.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        if (names[i] != fileName(frames[i].path)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ImageSequenceSource::validateSample(std::vector<FrameFile>& frames) {
+    std::vector<std::size_t> sampled;
+    std::vector<std::size_t> unparsed;
+    for (std::size_t i = 0; i < frames.size(); i += kValidationStride) {
+        sampled.push_back(i);
+        if (!frames[i].page) {
+            unparsed.push_back(sampled.size() - 1);
+        }
+    }
+    report_.sampled_files = sampled.size();
+    report_.threads = std::min(scan_threads_, unparsed.size());
+
+    // Each task only touches its own FrameFile and result slot; the comparison below runs after all of them.
+    std::vector<SampleResult> results(sampled.size());
+    if (!unparsed.empty()) {
+        ThreadPool pool(report_.threads);
+        std::vector<std::future<void>> pending;
+        pending.reserve(unparsed.size());
+        for (const std::size_t s : unparsed) {
+            pending.push_back(pool.submit([&frame = frames[sampled[s]], &result = results[s]]() {
+                // Stamped before parsing: a file rewritten in between is simply re-read on the next open.
+                const auto stamp = FileStamp::of(frame.path);
+                TiffFileLayout layout;
+                if (!TiffFormat::parseFile(frame.path, layout, result.error, 1, &result.bytes_read) ||
+                    !acceptPage(layout, result.error)) {
+                    return;
+                }
+                frame.page = std::move(layout.pages.front());
+                frame.little_endian = layout.little_endian;
+                frame.stamp = stamp;
+            }));
+        }
+        for (auto& task : pending) {
+            task.get();
+        }
+    }
+
+    const FrameFile& reference = frames.front();
+    if (reference.page) {
+        report_.width = reference.page->width;
+        report_.height = reference.page->height;
+        report_.bits_per_sample = reference.page->bits_per_sample;
+    }
+    for (std::size_t s = 0; s < sampled.size(); ++s) {
+        const FrameFile& frame = frames[sampled[s]];
+        report_.header_bytes_read += results[s].bytes_read;
+        const std::string name = fileName(frame.path);
+        if (!frame.page) {
+            report_.issues.push_back({name, name + ": " + results[s].error});
+            continue;
+        }
+        if (!reference.page) {
+            continue;
+        }
+
+        const TiffPageLayout& page = *frame.page;
+        const TiffPageLayout& first = *reference.page;
+        if (page.width != first.width || page.height != first.height) {
+            report_.issues.push_back({name, "Dimension mismatch: " + name + " is " + std::to_string(page.width) + "x" +
+                std::to_string(page.height) + ", " + fileName(reference.path) + " is " +
+                std::to_string(first.width) + "x" + std::to_string(first.height)});
+        } else if (page.bits_per_sample != first.bits_per_sample) {
+            report_.issues.push_back({name, "Bit depth mismatch: " + name + " is " +
+                std::to_string(page.bits_per_sample) + "-bit, " + fileName(reference.path) + " is " +
+                std::to_string(first.bits_per_sample) + "-bit"});
+        }
+    }
+}
+
+void ImageSequenceSource::writeIndex(const std::vector<FrameFile>& frames) {
+    SidecarWriter writer(kIndexMagic, kIndexVersion);
+    writer.put(static_cast<std::uint64_t>(frames.size()));
+    for (const auto& frame : frames) {
+        writer.putString(fileName(frame.path));
+        const bool has_page = frame.page && frame.stamp;
+        writer.put(static_cast<std::uint8_t>(has_page ? 1 : 0));
+        if (has_page) {
+            writer.put(frame.stamp->size);
+            writer.put(frame.stamp->mtime_ticks);
+            writer.put(static_cast<std::uint8_t>(frame.little_endian ? 1 : 0));
+            TiffFormat::putPage(writer, *frame.page);
+        }
+    }
+    writer.commit(indexPath(directory_), index_write_error_);
+}
+
+ImageSequenceSource::FrameFile ImageSequenceSource::layoutOf(FrameFile& frame) {
+    // Pages are parsed at most once per file; concurrent readers work on their own copy of the (small) layout.
+    FrameFile parsed;
+    parsed.path = frame.path;
+    {
+        std::lock_guard<std::mutex> lock(pages_mutex_);
+        parsed.page = frame.page;
+        parsed.little_endian = frame.little_endian;
+        parsed.stamp = frame.stamp;
+        parsed.stamp_unchecked = frame.stamp_unchecked;
+    }
+    if (parsed.page && !parsed.stamp_unchecked) {
+        return parsed;
+    }
+    if (parsed.page && FileStamp::of(frame.path) == parsed.stamp) {
+        std::lock_guard<std::mutex> lock(pages_mutex_);
+        frame.stamp_unchecked = false;
+        parsed.stamp_unchecked = false;
+        return parsed;
+    }
+
+    // Stamped before parsing, like the load() samples.
+    const auto stamp = FileStamp::of(frame.path);
+    TiffFileLayout layout;
+    std::string error;
+    if (!TiffFormat::parseFile(frame.path, layout, error) || !acceptPage(layout, error)) {
+        throw std::runtime_error(fileName(frame.path) + ": " + error);
+    }
+    parsed.page = std::move(layout.pages.front());
+    parsed.little_endian = layout.little_endian;
+    parsed.stamp = stamp;
+    parsed.stamp_unchecked = false;
+    std::lock_guard<std::mutex> lock(pages_mutex_);
+    if (!frame.page || frame.stamp_unchecked) {
+        frame.page = parsed.page;
+        frame.little_endian = parsed.little_endian;
+        frame.stamp = stamp;
+        frame.stamp_unchecked = false;
+        frame.mapping.reset();  // maps the file as it was before it changed
+        ++unindexed_headers_;
+        headers_parsed_on_access_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return parsed;
+}
+
+void ImageSequenceSource::checkFormat(const FrameFile& frame) const {
+    const TiffPageLayout& page = *frame.page;
+    if (static_cast<int>(page.width) != frame_size_.width || static_cast<int>(page.height) != frame_size_.height ||
+        TiffFormat::matType(page) != frame_type_) {
+        throw std::runtime_error(fileName(frame.path) + ": format does not match the rest of the sequence");
+    }
+}
+
+std::shared_ptr<MappedFile> ImageSequenceSource::mappingOf(FrameFile& frame, const FrameFile& parsed) {
+    {
+        std::lock_guard<std::mutex> lock(pages_mutex_);
+        auto file = frame.mapping.lock();
+        // A file that grew or shrank since it was mapped is mapped again.
+        if (file && (!parsed.stamp || file->size() == parsed.stamp->size)) {
+            return file;
+        }
+    }
+    std::string error;
+    auto file = MappedFile::open(frame.path, error);
+    if (!file) {
+        throw std::runtime_error(error);
+    }
+    std::lock_guard<std::mutex> lock(pages_mutex_);
+    frame.mapping = file;
+    if (recent_mappings_.size() < kRecentMappings) {
+        recent_mappings_.push_back(file);
+    } else {
+        recent_mappings_[next_recent_mapping_] = file;
+        next_recent_mapping_ = (next_recent_mapping_ + 1) % kRecentMappings;
+    }
+    return file;
+}
+
+cv::Mat ImageSequenceSource::readFrame(FrameFile& frame) {
+    const FrameFile parsed = layoutOf(frame);
+    checkFormat(parsed);
+
+    const auto file = mappingOf(frame, parsed);
+    std::string error;
+    cv::Mat image;
+    TiffReadPath read_path = TiffReadPath::Decoded;
+    if (!TiffFormat::readPage(*file, frame.path, parsed.little_endian, *parsed.page, image, read_path, error)) {
+        throw std::runtime_error(fileName(frame.path) + ": " + error);
+    }
+    switch (read_path) {
+        case TiffReadPath::ZeroCopy:
+            zero_copy_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TiffReadPath::Decoded:
+            decoded_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TiffReadPath::Libtiff:
+            libtiff_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+    return image;
+}
+
+std::vector<cv::Mat> ImageSequenceSource::readFrames(std::span<const std::size_t> logical_indices,
+                                                     BatchFrameReader& reader) {
+    std::vector<cv::Mat> images(logical_indices.size());
+    std::vector<PreparedFrameRead> reads;
+    std::vector<std::size_t> targets;
+    for (std::size_t k = 0; k < logical_indices.size(); ++k) {
+        if (logical_indices[k] >= frames_.size()) {
+            throw std::out_of_range("ImageSequenceSource::readFrames index " + std::to_string(logical_indices[k]) +
+                                    " out of range");
+        }
+        FrameFile& frame = frames_[logical_indices[k]];
+        const FrameFile parsed = layoutOf(frame);
+        checkFormat(parsed);
+        const TiffPageLayout& page = *parsed.page;
+        const auto offset = TiffFormat::nativePixelOffset(page, parsed.little_endian, std::numeric_limits<std::uint64_t>::max());
+        if (!offset) {
+            images[k] = readFrame(frame);
+            continue;
+        }
+        reads.push_back(reader.prepareFrame(frame.path, *offset, static_cast<int>(page.height),
+                                            static_cast<int>(page.width), frame_type_, TiffFormat::rowBytes(page)));
+        targets.push_back(k);
+    }
+
+    std::vector<BatchReadRequest> requests;
+    requests.reserve(reads.size());
+    for (auto& read : reads) {
+        requests.push_back(std::move(read.request));
+    }
+    std::string error;
+    if (!reader.read(requests, error)) {
+        throw std::runtime_error(error);
+    }
+    for (std::size_t i = 0; i < reads.size(); ++i) {
+        images[targets[i]] = std::move(reads[i].frame);
+    }
+    batched_frames_.fetch_add(reads.size(), std::memory_order_relaxed);
+    return images;
+}
+
+TiffReadStats ImageSequenceSource::readStats() const {
+    TiffReadStats stats;
+    stats.zero_copy_frames = zero_copy_frames_.load(std::memory_order_relaxed);
+    stats.decoded_frames = decoded_frames_.load(std::memory_order_relaxed);
+    stats.libtiff_frames = libtiff_frames_.load(std::memory_order_relaxed);
+    stats.batched_frames = batched_frames_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,230 @@
+#include "IncrementalDetection.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (core droplet detection pipeline)
+
+namespace {
+
+// Samples of the tile whose absolute difference exceeds `threshold`, counted up to `enough`.
+template <typename T>
+int countChangedSamples(const cv::Mat& current, const cv::Mat& reference, const cv::Rect& tile, int step,
+                        int threshold, int enough) {
+    int changed = 0;
+    for (int y = tile.y; y < tile.y + tile.height; y += step) {
+        const T* current_row = current.ptr<T>(y);
+        const T* reference_row = reference.ptr<T>(y);
+        for (int x = tile.x; x < tile.x + tile.width; x += step) {
+            if (std::abs(static_cast<int>(current_row[x]) - static_cast<int>(reference_row[x])) > threshold &&
+                ++changed >= enough) {
+                return changed;
+            }
+        }
+    }
+    return changed;
+}
+
+cv::Rect grow(const cv::Rect& rect, int margin) {
+    return cv::Rect(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin);
+}
+
+} // namespace
+
+IncrementalDropletDetector::IncrementalDropletDetector(const IncrementalDetectionParams& params)
+    : params_(params), context_radius_(detectionContextRadius(params.detection)) {
+    if (params_.tile_size < 8) {
+        throw std::invalid_argument("IncrementalDetectionParams::tile_size must be at least 8");
+    }
+    if (params_.sample_step < 1 || params_.sample_step > params_.tile_size) {
+        throw std::invalid_argument("IncrementalDetectionParams::sample_step must be in [1, tile_size]");
+    }
+    if (params_.min_changed_samples < 1) {
+        throw std::invalid_argument("IncrementalDetectionParams::min_changed_samples must be at least 1");
+    }
+    if (params_.halo_px < 0) {
+        throw std::invalid_argument("IncrementalDetectionParams::halo_px must be non-negative");
+    }
+}
+
+double IncrementalDropletDetector::averageProcessedFraction() const {
+    return frames_ > 0 ? processed_fraction_sum_ / static_cast<double>(frames_) : 0.0;
+}
+
+std::vector<Detection> IncrementalDropletDetector::detect(const cv::Mat& frame) {
+    last_stats_ = IncrementalDetectionStats{};
+    if (frame.empty()) {
+        return {};
+    }
+
+    ++frames_;
+    const double frame_area = static_cast<double>(frame.total());
+    const bool supported = frame.channels() == 1 && (frame.depth() == CV_8U || frame.depth() == CV_16U);
+    bool full_frame = !supported || resync_requested_ || frame.size() != reference_.size() ||
+        frame.type() != reference_.type() ||
+        (params_.resync_interval_frames > 0 && frames_since_resync_ >= params_.resync_interval_frames);
+
+    std::vector<Detection> detections;
+    double processed_pixels = 0.0;
+    if (!full_frame) {
+        markChangedTiles(frame);
+        buildRegions(frame.size());
+
+        double region_pixels = 0.0;
+        for (const auto& region : regions_) {
+            region_pixels += static_cast<double>(region.area());
+        }
+        last_stats_.regions = regions_.size();
+
+        if (region_pixels > params_.max_changed_fraction * frame_area) {
+            full_frame = true;
+        } else {
+            for (const auto& region : regions_) {
+                std::size_t pixels_read = 0;
+                const bool complete = detectDropletsInRegion(frame, region, params_.detection, detections, &pixels_read);
+                processed_pixels += static_cast<double>(pixels_read);
+                if (!complete) {
+                    full_frame = true;
+                    break;
+                }
+            }
+        }
+
+        if (!full_frame) {
+            for (std::size_t index = 0; index < previous_.size(); ++index) {
+                if (carried_[index] != 0) {
+                    detections.push_back(previous_[index]);
+                    ++last_stats_.carried_detections;
+                }
+            }
+            for (const auto& region : regions_) {
+                cv::Mat target = reference_(region);
+                frame(region).copyTo(target);
+            }
+            previous_ = detections;
+            ++frames_since_resync_;
+        }
+    }
+
+    if (full_frame) {
+        detections = detectFullFrame(frame);
+        processed_pixels += frame_area;
+    }
+
+    last_stats_.full_frame = full_frame;
+    last_stats_.processed_pixel_fraction = processed_pixels / frame_area;
+    processed_fraction_sum_ += last_stats_.processed_pixel_fraction;
+    return detections;
+}
+
+std::vector<Detection> IncrementalDropletDetector::detectFullFrame(const cv::Mat& frame) {
+    resync_requested_ = false;
+    frames_since_resync_ = 0;
+    ++full_frames_;
+
+    auto detections = detectDroplets(frame, params_.detection);
+    if (frame.channels() == 1 && (frame.depth() == CV_8U || frame.depth() == CV_16U)) {
+        frame.copyTo(reference_);
+        previous_ = detections;
+    } else {
+        reference_.release();
+        previous_.clear();
+    }
+    return detections;
+}
+
+void IncrementalDropletDetector::markChangedTiles(const cv::Mat& frame) {
+    const int tile = params_.tile_size;
+    tiles_x_ = (frame.cols + tile - 1) / tile;
+    tiles_y_ = (frame.rows + tile - 1) / tile;
+    changed_.assign(static_cast<std::size_t>(tiles_x_) * static_cast<std::size_t>(tiles_y_), 0);
+    last_stats_.total_tiles = changed_.size();
+
+    const double scale = frame.depth() == CV_16U ? 257.0 : 1.0;
+    const int threshold = static_cast<int>(params_.change_threshold * scale);
+    const int enough = params_.min_changed_samples;
+    const cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+    for (int ty = 0; ty < tiles_y_; ++ty) {
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            const cv::Rect rect = cv::Rect(tx * tile, ty * tile, tile, tile) & frame_rect;
+            const int changed = frame.depth() == CV_8U
+                ? countChangedSamples<std::uint8_t>(frame, reference_, rect, params_.sample_step, threshold, enough)
+                : countChangedSamples<std::uint16_t>(frame, reference_, rect, params_.sample_step, threshold, enough);
+            if (changed >= enough) {
+                changed_[static_cast<std::size_t>(ty) * tiles_x_ + tx] = 1;
+                ++last_stats_.changed_tiles;
+            }
+        }
+    }
+}
+
+void IncrementalDropletDetector::buildRegions(const cv::Size& frame_size) {
+    const int tile = params_.tile_size;
+    const cv::Rect frame_rect(0, 0, frame_size.width, frame_size.height);
+    regions_.clear();
+
+    // 8-connected components of changed tiles, each becoming one region (bounding box plus halo).
+    std::vector<std::uint8_t> visited(changed_.size(), 0);
+    for (int start = 0; start < static_cast<int>(changed_.size()); ++start) {
+        if (changed_[start] == 0 || visited[start] != 0) {
+            continue;
+        }
+        int min_x = tiles_x_;
+        int min_y = tiles_y_;
+        int max_x = -1;
+        int max_y = -1;
+        component_stack_.assign(1, start);
+        visited[start] = 1;
+        while (!component_stack_.empty()) {
+            const int index = component_stack_.back();
+            component_stack_.pop_back();
+            const int tx = index % tiles_x_;
+            const int ty = index / tiles_x_;
+            min_x = std::min(min_x, tx);
+            min_y = std::min(min_y, ty);
+            max_x = std::max(max_x, tx);
+            max_y = std::max(max_y, ty);
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const int nx = tx + dx;
+                    const int ny = ty + dy;
+                    if (nx < 0 || ny < 0 || nx >= tiles_x_ || ny >= tiles_y_) {
+                        continue;
+                    }
+                    const int neighbour = ny * tiles_x_ + nx;
+                    if (changed_[neighbour] != 0 && visited[neighbour] == 0) {
+                        visited[neighbour] = 1;
+                        component_stack_.push_back(neighbour);
+                    }
+                }
+            }
+        }
+        const cv::Rect tiles_rect(min_x * tile, min_y * tile, (max_x - min_x + 1) * tile, (max_y - min_y + 1) * tile);
+        regions_.push_back(grow(tiles_rect, params_.halo_px) & frame_rect);
+    }
+
+    // Previous detections within reach of a region's filter footprint may change shape, so their boxes
+    // join the region and they are re-detected; the rest are carried over unchanged.
+    carried_.assign(previous_.size(), 1);
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        mergeOverlappingRegions(regions_);
+        for (std::size_t index = 0; index < previous_.size(); ++index) {
+            if (carried_[index] == 0) {
+                continue;
+            }
+            const cv::Rect& box = previous_[index].bounding_box;
+            for (auto& region : regions_) {
+                if ((grow(region, context_radius_) & box).area() > 0) {
+                    region |= box;
+                    region &= frame_rect;
+                    carried_[index] = 0;
+                    grew = true;
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,283 @@
+#include "LineScanAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LINE_SCAN_SSE2 1
+#else
+#define LINE_SCAN_SSE2 0
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (extreme high-speed modes)
+
+namespace {
+
+// Column means of a thin strip. The SSE2 path keeps one block of columns in registers while walking
+// down the rows (strips are only a few rows tall), widening to 32-bit lanes so any row count is exact.
+void columnMeans(const cv::Mat& strip, std::uint32_t* sums, float* profile) {
+    const int width = strip.cols;
+    const float inverse_rows = 1.0F / static_cast<float>(strip.rows);
+    int x = 0;
+#if LINE_SCAN_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(inverse_rows);
+    if (strip.depth() == CV_8U) {
+        for (; x + 16 <= width; x += 16) {
+            __m128i acc0 = zero;
+            __m128i acc1 = zero;
+            __m128i acc2 = zero;
+            __m128i acc3 = zero;
+            for (int y = 0; y < strip.rows; ++y) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(strip.ptr<std::uint8_t>(y) + x));
+                const __m128i lo = _mm_unpacklo_epi8(v, zero);
+                const __m128i hi = _mm_unpackhi_epi8(v, zero);
+                acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(lo, zero));
+                acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(lo, zero));
+                acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(hi, zero));
+                acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(hi, zero));
+            }
+            _mm_storeu_ps(profile + x, _mm_mul_ps(_mm_cvtepi32_ps(acc0), scale));
+            _mm_storeu_ps(profile + x + 4, _mm_mul_ps(_mm_cvtepi32_ps(acc1), scale));
+            _mm_storeu_ps(profile + x + 8, _mm_mul_ps(_mm_cvtepi32_ps(acc2), scale));
+            _mm_storeu_ps(profile + x + 12, _mm_mul_ps(_mm_cvtepi32_ps(acc3), scale));
+        }
+    } else {
+        for (; x + 8 <= width; x += 8) {
+            __m128i acc0 = zero;
+            __m128i acc1 = zero;
+            for (int y = 0; y < strip.rows; ++y) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(strip.ptr<std::uint16_t>(y) + x));
+                acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(v, zero));
+                acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(v, zero));
+            }
+            // Sums of up to 32767 16-bit rows stay below 2^31, so the signed conversion is exact enough.
+            _mm_storeu_ps(profile + x, _mm_mul_ps(_mm_cvtepi32_ps(acc0), scale));
+            _mm_storeu_ps(profile + x + 4, _mm_mul_ps(_mm_cvtepi32_ps(acc1), scale));
+        }
+    }
+#endif
+
+    // Scalar tail (and the whole strip on targets without SSE2).
+    if (x < width) {
+        std::fill(sums + x, sums + width, 0U);
+        for (int y = 0; y < strip.rows; ++y) {
+            if (strip.depth() == CV_8U) {
+                const std::uint8_t* row = strip.ptr<std::uint8_t>(y);
+                for (int column = x; column < width; ++column) {
+                    sums[column] += row[column];
+                }
+            } else {
+                const std::uint16_t* row = strip.ptr<std::uint16_t>(y);
+                for (int column = x; column < width; ++column) {
+                    sums[column] += row[column];
+                }
+            }
+        }
+        for (int column = x; column < width; ++column) {
+            profile[column] = static_cast<float>(sums[column]) * inverse_rows;
+        }
+    }
+}
+
+// Moves background towards the profile by `weight` on [begin, end) without classifying.
+void blendBackground(const float* profile, float* background, int begin, int end, float weight) {
+    for (int x = begin; x < end; ++x) {
+        background[x] += weight * (profile[x] - background[x]);
+    }
+}
+
+} // namespace
+
+LineScanAnalyzer::LineScanAnalyzer(const LineScanParams& params, PassageSink sink)
+    : params_(params), sink_(std::move(sink)) {
+    if (!(params_.relative_threshold > 0.0)) {
+        throw std::invalid_argument("LineScanParams.relative_threshold must be positive");
+    }
+    if (!(params_.occupancy_off >= 0.0 && params_.occupancy_off <= params_.occupancy_on && params_.occupancy_on <= 1.0)) {
+        throw std::invalid_argument("LineScanParams requires 0 <= occupancy_off <= occupancy_on <= 1");
+    }
+    if (!(params_.background_alpha >= 0.0 && params_.background_alpha <= 1.0)) {
+        throw std::invalid_argument("LineScanParams.background_alpha must be in [0, 1]");
+    }
+}
+
+void LineScanAnalyzer::reset() {
+    *this = LineScanAnalyzer(params_, std::move(sink_));
+}
+
+bool LineScanAnalyzer::push(const cv::Mat& strip, double timestamp_s) {
+    if (strip.empty() || strip.channels() != 1 || (strip.depth() != CV_8U && strip.depth() != CV_16U)) {
+        throw std::invalid_argument("LineScanAnalyzer expects a non-empty CV_8UC1 or CV_16UC1 strip");
+    }
+
+    if (width_ == 0) {
+        width_ = strip.cols;
+        type_ = strip.type();
+        probe_begin_ = std::clamp(params_.probe_begin, 0, width_);
+        probe_end_ = params_.probe_end > 0 ? std::clamp(params_.probe_end, probe_begin_, width_) : width_;
+        if (probe_end_ <= probe_begin_) {
+            throw std::invalid_argument("LineScanParams probe range is empty for this strip width");
+        }
+        row_sums_.assign(static_cast<std::size_t>(width_), 0);
+        profile_.assign(static_cast<std::size_t>(width_), 0.0F);
+        background_.assign(static_cast<std::size_t>(width_), 0.0F);
+        if (params_.kymograph_rows > 0) {
+            kymograph_.create(static_cast<int>(params_.kymograph_rows), width_, CV_32F);
+        }
+        first_s_ = timestamp_s;
+    } else if (strip.cols != width_ || strip.type() != type_) {
+        throw std::invalid_argument("LineScanAnalyzer strip width and type must not change within a stream");
+    }
+
+    columnMeans(strip, row_sums_.data(), profile_.data());
+
+    const std::size_t frame_index = frames_++;
+    last_s_ = timestamp_s;
+    appendKymographRow();
+
+    if (frames_ <= params_.warmup_frames) {
+        // Plain running mean while the background settles.
+        blendBackground(profile_.data(), background_.data(), 0, width_, 1.0F / static_cast<float>(frames_));
+        return false;
+    }
+
+    const float occupied_fraction = classifyAndUpdateBackground(static_cast<float>(params_.background_alpha));
+    last_occupancy_ = occupied_fraction;
+
+    if (!in_passage_) {
+        if (occupied_fraction >= params_.occupancy_on) {
+            in_passage_ = true;
+            current_ = LineScanPassage{};
+            current_.start_frame = frame_index;
+            current_.start_s = timestamp_s;
+            current_.peak_occupancy = occupied_fraction;
+        }
+        return false;
+    }
+
+    current_.peak_occupancy = std::max(current_.peak_occupancy, occupied_fraction);
+    if (occupied_fraction < params_.occupancy_off) {
+        closePassage(frame_index, timestamp_s);
+        return true;
+    }
+    return false;
+}
+
+void LineScanAnalyzer::finish() {
+    if (in_passage_) {
+        closePassage(frames_, last_s_);
+    }
+}
+
+float LineScanAnalyzer::classifyAndUpdateBackground(float weight) {
+    const float* profile = profile_.data();
+    float* background = background_.data();
+    blendBackground(profile, background, 0, probe_begin_, weight);
+    blendBackground(profile, background, probe_end_, width_, weight);
+
+    // Occupied probe columns are counted and left out of the background update, so a slow droplet is
+    // not absorbed into the background while it sits in the probe.
+    const float sign = params_.dark_droplets ? -1.0F : 1.0F;
+    const auto threshold = static_cast<float>(params_.relative_threshold);
+    std::uint32_t count = 0;
+    int x = probe_begin_;
+#if LINE_SCAN_SSE2
+    const __m128 sign_v = _mm_set1_ps(sign);
+    const __m128 threshold_v = _mm_set1_ps(threshold);
+    const __m128 weight_v = _mm_set1_ps(weight);
+    // Compare masks are all-ones (-1) per occupied lane, so subtracting them counts hits per lane.
+    __m128i lane_counts = _mm_setzero_si128();
+    for (; x + 4 <= probe_end_; x += 4) {
+        const __m128 p = _mm_loadu_ps(profile + x);
+        const __m128 b = _mm_loadu_ps(background + x);
+        const __m128 difference = _mm_sub_ps(p, b);
+        const __m128 occupied = _mm_cmpgt_ps(_mm_mul_ps(sign_v, difference), _mm_mul_ps(threshold_v, b));
+        lane_counts = _mm_sub_epi32(lane_counts, _mm_castps_si128(occupied));
+        const __m128 step = _mm_andnot_ps(occupied, _mm_mul_ps(weight_v, difference));
+        _mm_storeu_ps(background + x, _mm_add_ps(b, step));
+    }
+    alignas(16) std::uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), lane_counts);
+    count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; x < probe_end_; ++x) {
+        const float difference = profile[x] - background[x];
+        const bool occupied = sign * difference > threshold * background[x];
+        count += occupied ? 1U : 0U;
+        background[x] += occupied ? 0.0F : weight * difference;
+    }
+    return static_cast<float>(count) / static_cast<float>(probe_end_ - probe_begin_);
+}
+
+void LineScanAnalyzer::appendKymographRow() {
+    if (kymograph_.empty()) {
+        return;
+    }
+    std::memcpy(kymograph_.ptr<float>(static_cast<int>(kymograph_next_)), profile_.data(),
+                profile_.size() * sizeof(float));
+    kymograph_next_ = (kymograph_next_ + 1) % params_.kymograph_rows;
+    kymograph_filled_ = std::min(kymograph_filled_ + 1, params_.kymograph_rows);
+}
+
+cv::Mat LineScanAnalyzer::kymograph() const {
+    if (kymograph_.empty() || kymograph_filled_ == 0) {
+        return {};
+    }
+    cv::Mat ordered(static_cast<int>(kymograph_filled_), width_, CV_32F);
+    const std::size_t oldest = kymograph_filled_ < params_.kymograph_rows ? 0 : kymograph_next_;
+    for (std::size_t row = 0; row < kymograph_filled_; ++row) {
+        const auto source = static_cast<int>((oldest + row) % params_.kymograph_rows);
+        std::memcpy(ordered.ptr<float>(static_cast<int>(row)), kymograph_.ptr<float>(source),
+                    static_cast<std::size_t>(width_) * sizeof(float));
+    }
+    return ordered;
+}
+
+void LineScanAnalyzer::closePassage(std::size_t end_frame, double end_s) {
+    in_passage_ = false;
+    current_.end_frame = end_frame;
+    current_.end_s = end_s;
+    current_.duration_s = end_s - current_.start_s;
+    if (has_previous_) {
+        current_.gap_s = current_.start_s - previous_end_s_;
+        current_.period_s = current_.start_s - previous_start_s_;
+        gap_s_.add(current_.gap_s);
+        if (current_.period_s > 0.0) {
+            instantaneous_frequency_hz_.add(1.0 / current_.period_s);
+        }
+    } else {
+        current_.gap_s = std::numeric_limits<double>::quiet_NaN();
+        current_.period_s = std::numeric_limits<double>::quiet_NaN();
+        first_passage_start_s_ = current_.start_s;
+    }
+    duration_s_.add(current_.duration_s);
+
+    has_previous_ = true;
+    previous_start_s_ = current_.start_s;
+    previous_end_s_ = end_s;
+    last_passage_start_s_ = current_.start_s;
+    ++passages_;
+
+    if (sink_) {
+        sink_(current_);
+    }
+}
+
+LineScanSummary LineScanAnalyzer::summary() const {
+    LineScanSummary summary;
+    summary.frames = frames_;
+    summary.passages = passages_;
+    summary.elapsed_s = frames_ > 0 ? last_s_ - first_s_ : 0.0;
+    const double span = last_passage_start_s_ - first_passage_start_s_;
+    summary.frequency_hz = passages_ >= 2 && span > 0.0 ? static_cast<double>(passages_ - 1) / span : 0.0;
+    summary.instantaneous_frequency_hz = instantaneous_frequency_hz_;
+    summary.duration_s = duration_s_;
+    summary.gap_s = gap_s_;
+    return summary;
+}
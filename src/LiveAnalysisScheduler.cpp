@@ -0,0 +1,239 @@
+#include "LiveAnalysisScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    const double us = std::max(0.0, std::chrono::duration<double, std::micro>(latency).count());
+    // Bucket b >= 1 holds [2^((b-1)/4), 2^(b/4)) us; bucket 0 everything below 1 us.
+    const double position = us < 1.0 ? 0.0 : std::floor(4.0 * std::log2(us)) + 1.0;
+    const auto bucket = static_cast<std::size_t>(std::min(position, static_cast<double>(kBucketCount - 1)));
+    ++buckets_[bucket];
+    ++count_;
+    sum_us_ += us;
+    max_us_ = std::max(max_us_, us);
+}
+
+double LatencyHistogram::meanMs() const {
+    return count_ == 0 ? 0.0 : sum_us_ / static_cast<double>(count_) / 1000.0;
+}
+
+double LatencyHistogram::percentileMs(double percentile) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    const double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count_);
+    const auto wanted = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(rank)));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        seen += buckets_[bucket];
+        if (seen >= wanted) {
+            return std::min(bucketUpperMs(bucket), maxMs());
+        }
+    }
+    return maxMs();
+}
+
+double LatencyHistogram::bucketUpperMs(std::size_t bucket) {
+    if (bucket + 1 >= kBucketCount) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::exp2(static_cast<double>(bucket) / 4.0) / 1000.0;
+}
+
+std::string LatencyHistogram::summary() const {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(2);
+    out << "n=" << count_ << " mean=" << meanMs() << " p50=" << percentileMs(50.0) << " p95=" << percentileMs(95.0)
+        << " p99=" << percentileMs(99.0) << " max=" << maxMs() << " ms";
+    return out.str();
+}
+
+LiveAnalysisScheduler::LiveAnalysisScheduler(const LiveSchedulerParams& params) : params_(params) {}
+
+LiveAnalysisScheduler::~LiveAnalysisScheduler() {
+    stop();
+}
+
+bool LiveAnalysisScheduler::start(Grabber grabber, Analyzer analyzer, std::string& error_message) {
+    if (grab_thread_.joinable() || analysis_thread_.joinable()) {
+        error_message = "Live analysis is already running";
+        return false;
+    }
+    if (!grabber) {
+        error_message = "Live analysis needs a frame grabber";
+        return false;
+    }
+    grabber_ = std::move(grabber);
+    analyzer_ = std::move(analyzer);
+    // A run after stop() or join() starts from scratch, like the first one.
+    {
+        std::lock_guard<std::mutex> display_lock(display_mutex_);
+        std::lock_guard<std::mutex> analysis_lock(analysis_mutex_);
+        display_frame_ = StreamFrame{};
+        display_pending_ = false;
+        queue_.clear();
+        grabbing_done_ = false;
+        stop_requested_ = false;
+        stats_ = LiveSchedulerStats{};
+    }
+    if (analyzer_) {
+        analysis_thread_ = std::thread([this]() { analysisLoop(); });
+    }
+    grab_thread_ = std::thread([this]() { grabLoop(); });
+    return true;
+}
+
+void LiveAnalysisScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(analysis_mutex_);
+        stop_requested_ = true;
+    }
+    analysis_ready_.notify_all();
+    join();
+    // Including a frame the grab thread queued on its way out.
+    std::lock_guard<std::mutex> lock(analysis_mutex_);
+    stats_.analysis_skipped += queue_.size();
+    queue_.clear();
+}
+
+void LiveAnalysisScheduler::join() {
+    if (grab_thread_.joinable()) {
+        grab_thread_.join();
+    }
+    if (analysis_thread_.joinable()) {
+        analysis_thread_.join();
+    }
+}
+
+bool LiveAnalysisScheduler::takeDisplayFrame(StreamFrame& frame) {
+    std::lock_guard<std::mutex> lock(display_mutex_);
+    if (!display_pending_) {
+        return false;
+    }
+    frame = display_frame_;
+    display_pending_ = false;
+    ++stats_.frames_displayed;
+    stats_.display_latency.record(Clock::now() - frame.arrival);
+    return true;
+}
+
+LiveSchedulerStats LiveAnalysisScheduler::stats() const {
+    std::lock_guard<std::mutex> display_lock(display_mutex_);
+    std::lock_guard<std::mutex> analysis_lock(analysis_mutex_);
+    return stats_;
+}
+
+void LiveAnalysisScheduler::grabLoop() {
+    const std::size_t capacity =
+        params_.policy == LiveAnalysisPolicy::LatestWins ? 1 : std::max<std::size_t>(1, params_.max_queued_frames);
+    StreamFrame frame;
+    // Set by the first frame of the run: a camera that was already acquiring (or a restart) has not lost the frames
+    // before it.
+    std::optional<std::uint64_t> expected_index;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(analysis_mutex_);
+            if (stop_requested_) {
+                break;
+            }
+        }
+        // The previous frame's image is still shared with the display or the queue, so the camera will not reuse
+        // its buffer.
+        const GrabStatus status = grabber_(frame, params_.grab_timeout);
+        if (status == GrabStatus::Stopped) {
+            break;
+        }
+        if (status == GrabStatus::Timeout) {
+            std::lock_guard<std::mutex> lock(analysis_mutex_);
+            ++stats_.grab_timeouts;
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(display_mutex_);
+            if (display_pending_) {
+                ++stats_.display_superseded;
+            }
+            display_frame_ = frame;
+            display_pending_ = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(analysis_mutex_);
+            ++stats_.frames_grabbed;
+            if (expected_index && frame.frame_index > *expected_index) {
+                stats_.frames_lost += frame.frame_index - *expected_index;
+            }
+            expected_index = frame.frame_index + 1;
+            if (analyzer_) {
+                queue_.push_back(frame);
+                while (queue_.size() > capacity) {
+                    queue_.pop_front();
+                    ++stats_.analysis_skipped;
+                }
+            }
+        }
+        analysis_ready_.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(analysis_mutex_);
+        grabbing_done_ = true;
+    }
+    analysis_ready_.notify_all();
+}
+
+void LiveAnalysisScheduler::analysisLoop() {
+    const bool age_limited = params_.policy == LiveAnalysisPolicy::BoundedLag && params_.max_lag.count() > 0;
+    for (;;) {
+        StreamFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(analysis_mutex_);
+            analysis_ready_.wait(lock, [this]() { return stop_requested_ || grabbing_done_ || !queue_.empty(); });
+            if (stop_requested_ || queue_.empty()) {
+                return;
+            }
+            if (age_limited) {
+                const auto oldest_allowed = Clock::now() - params_.max_lag;
+                while (queue_.size() > 1 && queue_.front().arrival < oldest_allowed) {
+                    queue_.pop_front();
+                    ++stats_.analysis_skipped;
+                }
+            }
+            frame = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        std::string error;
+        try {
+            analyzer_(frame);
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "unknown error";
+        }
+
+        std::lock_guard<std::mutex> lock(analysis_mutex_);
+        if (error.empty()) {
+            ++stats_.frames_analyzed;
+            stats_.analysis_latency.record(Clock::now() - frame.arrival);
+        } else {
+            ++stats_.analysis_errors;
+            stats_.last_error = "Frame " + std::to_string(frame.frame_index) + ": " + error;
+        }
+    }
+}
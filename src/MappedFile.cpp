@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "OwnedMat.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+namespace {
+
+std::string describe(const std::filesystem::path& path, const char* what) {
+    return std::string(what) + ": " + path.string();
+}
+
+} // namespace
+
+cv::Mat MappedFile::matView(std::size_t offset, int rows, int cols, int type, std::size_t step) const {
+    const std::size_t bytes = rows > 0 ? static_cast<std::size_t>(rows - 1) * step + static_cast<std::size_t>(cols) * CV_ELEM_SIZE(type) : 0;
+    if (rows <= 0 || cols <= 0 || offset > size_ || bytes > size_ - offset) {
+        throw std::out_of_range("MappedFile::matView range lies outside the mapping");
+    }
+    return wrapOwnedMemory(shared_from_this(), data_ + offset, rows, cols, type, step);
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path, std::string& error_message) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_message = describe(path, "Cannot open file") + " (error " + std::to_string(GetLastError()) + ")";
+        return nullptr;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 ||
+        static_cast<unsigned long long>(file_size.QuadPart) > std::numeric_limits<std::size_t>::max()) {
+        CloseHandle(file);
+        error_message = describe(path, "File is empty or its size cannot be determined");
+        return nullptr;
+    }
+
+    // The view keeps the mapping (and the file) open; both handles can be closed right away.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        error_message = describe(path, "Cannot create file mapping") + " (error " + std::to_string(GetLastError()) + ")";
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        error_message = describe(path, "Cannot map file") + " (error " + std::to_string(GetLastError()) + ")";
+        return nullptr;
+    }
+
+    return std::shared_ptr<MappedFile>(
+        new MappedFile(static_cast<std::uint8_t*>(view), static_cast<std::size_t>(file_size.QuadPart)));
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& path, std::string& error_message) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_message = describe(path, "Cannot open file") + " (" + std::strerror(errno) + ")";
+        return nullptr;
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        error_message = describe(path, "File is empty or its size cannot be determined");
+        return nullptr;
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    // PROT_WRITE on a private mapping of a read-only descriptor is allowed and only affects this process.
+    void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        error_message = describe(path, "Cannot map file") + " (" + std::strerror(errno) + ")";
+        return nullptr;
+    }
+
+    return std::shared_ptr<MappedFile>(new MappedFile(static_cast<std::uint8_t*>(view), size));
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+    }
+}
+
+#endif
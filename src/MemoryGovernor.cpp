@@ -0,0 +1,216 @@
+#include "MemoryGovernor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.5 Memory Usage)
+
+namespace {
+
+// Set while this thread runs the shrinkers, so memory they release (or charge) cannot start another round.
+thread_local bool shrinking = false;
+
+void raiseTo(std::atomic<std::size_t>& peak, std::size_t value) {
+    std::size_t current = peak.load();
+    while (current < value && !peak.compare_exchange_weak(current, value)) {
+    }
+}
+
+std::string formatBytes(std::size_t bytes) {
+    constexpr double kMiB = 1024.0 * 1024.0;
+    const double mib = static_cast<double>(bytes) / kMiB;
+    char text[32];
+    if (mib >= 1024.0) {
+        std::snprintf(text, sizeof(text), "%.1f GB", mib / 1024.0);
+    } else {
+        std::snprintf(text, sizeof(text), "%.1f MB", mib);
+    }
+    return text;
+}
+
+} // namespace
+
+const char* memoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::FrameCache:
+            return "frame_cache";
+        case MemoryCategory::CompressedFrames:
+            return "compressed_frames";
+        case MemoryCategory::Background:
+            return "background";
+        case MemoryCategory::DetectorScratch:
+            return "detector_scratch";
+        case MemoryCategory::Results:
+            return "results";
+        case MemoryCategory::PooledBuffers:
+            return "pooled_buffers";
+        case MemoryCategory::Other:
+            break;
+    }
+    return "other";
+}
+
+std::string MemoryUsage::summary() const {
+    std::string text = formatBytes(bytes) + " (peak " + formatBytes(peak_bytes) + ")";
+    if (budget_bytes != 0) {
+        text += " of " + formatBytes(budget_bytes);
+    }
+    const char* separator = ": ";
+    for (const Category& category : categories) {
+        if (category.bytes != 0) {
+            text += separator;
+            text += category.name;
+            text += " " + formatBytes(category.bytes);
+            separator = ", ";
+        }
+    }
+    return text;
+}
+
+MemoryGovernor& MemoryGovernor::global() {
+    static MemoryGovernor governor(kOfflineBudgetBytes);
+    return governor;
+}
+
+MemoryGovernor::MemoryGovernor(std::size_t budget_bytes) : budget_(budget_bytes) {}
+
+void MemoryGovernor::setBudget(std::size_t bytes) {
+    budget_ = bytes;
+    enforce();
+}
+
+void MemoryGovernor::add(MemoryCategory category, std::size_t bytes) {
+    Account& account = accounts_[static_cast<std::size_t>(category)];
+    raiseTo(account.peak_bytes, account.bytes += bytes);
+    raiseTo(peak_bytes_, bytes_ += bytes);
+}
+
+void MemoryGovernor::release(MemoryCategory category, std::size_t bytes) {
+    accounts_[static_cast<std::size_t>(category)].bytes -= bytes;
+    bytes_ -= bytes;
+}
+
+std::size_t MemoryGovernor::enforce() {
+    const auto overBudget = [this]() {
+        const std::size_t budget = budget_.load();
+        const std::size_t bytes = bytes_.load();
+        return budget != 0 && bytes > budget ? bytes - budget : 0;
+    };
+    if (shrinking || overBudget() == 0) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(shrink_mutex_);
+    if (overBudget() == 0) {
+        return 0;  // another thread shrank while this one waited
+    }
+    ++shrink_requests_;
+    shrinking = true;
+    std::size_t freed = 0;
+    try {
+        for (const Registration& registration : shrinkers_) {
+            const std::size_t excess = overBudget();
+            if (excess == 0) {
+                break;
+            }
+            freed += registration.shrinker(excess);
+        }
+    } catch (...) {
+        shrinking = false;
+        throw;
+    }
+    shrinking = false;
+    shrunk_bytes_ += freed;
+    if (overBudget() != 0) {
+        ++overruns_;
+    }
+    return freed;
+}
+
+MemoryGovernor::ShrinkerId MemoryGovernor::addShrinker(Shrinker shrinker) {
+    std::lock_guard<std::mutex> lock(shrink_mutex_);
+    const ShrinkerId id = next_id_++;
+    shrinkers_.push_back(Registration{id, std::move(shrinker)});
+    return id;
+}
+
+void MemoryGovernor::removeShrinker(ShrinkerId id) {
+    std::lock_guard<std::mutex> lock(shrink_mutex_);
+    std::erase_if(shrinkers_, [id](const Registration& registration) { return registration.id == id; });
+}
+
+std::size_t MemoryGovernor::currentBytes(MemoryCategory category) const {
+    return accounts_[static_cast<std::size_t>(category)].bytes.load();
+}
+
+MemoryUsage MemoryGovernor::usage() const {
+    MemoryUsage usage;
+    for (std::size_t index = 0; index < kMemoryCategoryCount; ++index) {
+        usage.categories[index].name = memoryCategoryName(static_cast<MemoryCategory>(index));
+        usage.categories[index].bytes = accounts_[index].bytes.load();
+        usage.categories[index].peak_bytes = accounts_[index].peak_bytes.load();
+    }
+    usage.bytes = bytes_.load();
+    usage.peak_bytes = peak_bytes_.load();
+    usage.budget_bytes = budget_.load();
+    usage.shrink_requests = shrink_requests_.load();
+    usage.shrunk_bytes = shrunk_bytes_.load();
+    usage.overruns = overruns_.load();
+    return usage;
+}
+
+void MemoryGovernor::resetPeak() {
+    for (Account& account : accounts_) {
+        account.peak_bytes = account.bytes.load();
+    }
+    peak_bytes_ = bytes_.load();
+}
+
+MemoryCharge::MemoryCharge(MemoryCategory category, std::size_t bytes, MemoryGovernor& governor)
+    : governor_(&governor), category_(category) {
+    resize(bytes);
+}
+
+MemoryCharge::~MemoryCharge() {
+    governor_->release(category_, bytes_);
+}
+
+MemoryCharge::MemoryCharge(const MemoryCharge& other) : governor_(other.governor_), category_(other.category_) {
+    resize(other.bytes_);
+}
+
+MemoryCharge& MemoryCharge::operator=(const MemoryCharge& other) {
+    if (this != &other) {
+        reset();
+        governor_ = other.governor_;
+        category_ = other.category_;
+        resize(other.bytes_);
+    }
+    return *this;
+}
+
+MemoryCharge::MemoryCharge(MemoryCharge&& other) noexcept
+    : governor_(other.governor_), category_(other.category_), bytes_(std::exchange(other.bytes_, 0)) {}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+        governor_->release(category_, bytes_);
+        governor_ = other.governor_;
+        category_ = other.category_;
+        bytes_ = std::exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+void MemoryCharge::resize(std::size_t bytes) {
+    if (bytes < bytes_) {
+        governor_->release(category_, bytes_ - bytes);
+        bytes_ = bytes;
+        return;
+    }
+    if (bytes > bytes_) {
+        governor_->add(category_, bytes - bytes_);
+        bytes_ = bytes;
+        governor_->enforce();
+    }
+}
@@ -0,0 +1,215 @@
+#include "MultiPageTIFFSource.h"
+
+#include <stdexcept>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (Implementation 2: Multi-Page TIFF Source)
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+namespace {
+
+constexpr std::string_view kIndexMagic = "DROPLET-TIFF-PAGES";
+constexpr std::uint32_t kIndexVersion = 1;
+
+} // namespace
+
+MultiPageTIFFSource::MultiPageTIFFSource(const std::string& tiff_path, std::size_t max_pages)
+    : path_(tiff_path), max_pages_(max_pages) {}
+
+std::filesystem::path MultiPageTIFFSource::indexPath(const std::string& tiff_path) {
+    return std::filesystem::path(tiff_path + ".idx");
+}
+
+bool MultiPageTIFFSource::load(std::string& error_message) {
+    file_.reset();
+    pages_.clear();
+    frame_size_ = cv::Size();
+    frame_type_ = -1;
+    loaded_from_index_ = false;
+    index_write_error_.clear();
+
+    file_ = MappedFile::open(path_, error_message);
+    if (!file_) {
+        return false;
+    }
+
+    const auto stamp = FileStamp::of(path_);
+    if (stamp && readIndex(*stamp)) {
+        loaded_from_index_ = true;
+    } else {
+        pages_.clear();
+        if (!scan(error_message)) {
+            pages_.clear();
+            file_.reset();
+            return false;
+        }
+        // A scan cut short by the page limit has not seen the whole chain; indexing it would hand a truncated
+        // stack to a later open with a higher (or no) limit.
+        const bool complete = max_pages_ == 0 || pages_.size() <= max_pages_;
+        if (stamp && complete) {
+            writeIndex(*stamp);
+        }
+    }
+
+    if (max_pages_ > 0 && pages_.size() > max_pages_) {
+        error_message = "TIFF has more than " + std::to_string(max_pages_) + " pages (max " +
+            std::to_string(max_pages_) + ")";
+        pages_.clear();
+        file_.reset();
+        return false;
+    }
+
+    const TiffPageLayout& first = pages_.front();
+    frame_size_ = cv::Size(static_cast<int>(first.width), static_cast<int>(first.height));
+    frame_type_ = TiffFormat::matType(first);
+    return true;
+}
+
+cv::Mat MultiPageTIFFSource::getFrame(std::size_t page_index) {
+    if (page_index >= pages_.size()) {
+        throw std::out_of_range("MultiPageTIFFSource::getFrame page " + std::to_string(page_index) + " out of range");
+    }
+
+    cv::Mat image;
+    TiffReadPath read_path = TiffReadPath::Decoded;
+    std::string error;
+    if (!TiffFormat::readPage(*file_, path_, little_endian_, pages_[page_index], image, read_path, error)) {
+        throw std::runtime_error("Page " + std::to_string(page_index) + ": " + error);
+    }
+    switch (read_path) {
+        case TiffReadPath::ZeroCopy:
+            zero_copy_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TiffReadPath::Decoded:
+            decoded_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TiffReadPath::Libtiff:
+            libtiff_frames_.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+    return image;
+}
+
+std::vector<cv::Mat> MultiPageTIFFSource::readFrames(std::span<const std::size_t> page_indices,
+                                                     BatchFrameReader& reader) {
+    std::vector<cv::Mat> images(page_indices.size());
+    std::vector<PreparedFrameRead> reads;
+    std::vector<std::size_t> targets;
+    for (std::size_t k = 0; k < page_indices.size(); ++k) {
+        if (page_indices[k] >= pages_.size()) {
+            throw std::out_of_range("MultiPageTIFFSource::readFrames page " + std::to_string(page_indices[k]) +
+                                    " out of range");
+        }
+        const TiffPageLayout& page = pages_[page_indices[k]];
+        const auto offset = TiffFormat::nativePixelOffset(page, little_endian_, file_->size());
+        if (!offset) {
+            images[k] = getFrame(page_indices[k]);
+            continue;
+        }
+        reads.push_back(reader.prepareFrame(path_, *offset, static_cast<int>(page.height), static_cast<int>(page.width),
+                                            frame_type_, TiffFormat::rowBytes(page)));
+        targets.push_back(k);
+    }
+
+    std::vector<BatchReadRequest> requests;
+    requests.reserve(reads.size());
+    for (auto& read : reads) {
+        requests.push_back(std::move(read.request));
+    }
+    std::string error;
+    if (!reader.read(requests, error)) {
+        throw std::runtime_error(error);
+    }
+    for (std::size_t i = 0; i < reads.size(); ++i) {
+        images[targets[i]] = std::move(reads[i].frame);
+    }
+    batched_frames_.fetch_add(reads.size(), std::memory_order_relaxed);
+    return images;
+}
+
+TiffReadStats MultiPageTIFFSource::readStats() const {
+    TiffReadStats stats;
+    stats.zero_copy_frames = zero_copy_frames_.load(std::memory_order_relaxed);
+    stats.decoded_frames = decoded_frames_.load(std::memory_order_relaxed);
+    stats.libtiff_frames = libtiff_frames_.load(std::memory_order_relaxed);
+    stats.batched_frames = batched_frames_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool MultiPageTIFFSource::scan(std::string& error_message) {
+    TiffFileLayout layout;
+    // One page past the limit is enough to reject an oversized stack without walking its whole chain.
+    const std::size_t scan_limit = max_pages_ > 0 ? max_pages_ + 1 : 0;
+    if (!TiffFormat::parse(file_->bytes(), layout, error_message, scan_limit)) {
+        return false;
+    }
+
+    const TiffPageLayout& first = layout.pages.front();
+    for (std::size_t index = 0; index < layout.pages.size(); ++index) {
+        const TiffPageLayout& page = layout.pages[index];
+        if (!TiffFormat::validatePage(layout, page, error_message, true) || !TiffFormat::canDecode(page, error_message)) {
+            error_message = "Page " + std::to_string(index) + ": " + error_message;
+            return false;
+        }
+        if (page.width != first.width || page.height != first.height) {
+            error_message = "Page " + std::to_string(index) + " dimension mismatch: " + std::to_string(page.width) + "x" +
+                std::to_string(page.height) + ", page 0 is " + std::to_string(first.width) + "x" +
+                std::to_string(first.height);
+            return false;
+        }
+        if (page.bits_per_sample != first.bits_per_sample) {
+            error_message = "Page " + std::to_string(index) + " bit depth mismatch: " +
+                std::to_string(page.bits_per_sample) + "-bit, page 0 is " + std::to_string(first.bits_per_sample) + "-bit";
+            return false;
+        }
+    }
+
+    little_endian_ = layout.little_endian;
+    big_tiff_ = layout.big_tiff;
+    pages_ = std::move(layout.pages);
+    return true;
+}
+
+bool MultiPageTIFFSource::readIndex(const FileStamp& stamp) {
+    auto reader = SidecarReader::open(indexPath(path_), kIndexMagic, kIndexVersion);
+    if (!reader) {
+        return false;
+    }
+
+    FileStamp indexed;
+    std::uint8_t little_endian = 0;
+    std::uint8_t big_tiff = 0;
+    std::uint64_t page_count = 0;
+    if (!reader->get(indexed.size) || !reader->get(indexed.mtime_ticks) || !(indexed == stamp) ||
+        !reader->get(little_endian) || !reader->get(big_tiff) || !reader->get(page_count) || page_count == 0 ||
+        page_count > reader->remaining()) {
+        return false;
+    }
+
+    std::vector<TiffPageLayout> pages(static_cast<std::size_t>(page_count));
+    for (auto& page : pages) {
+        if (!TiffFormat::getPage(*reader, page)) {
+            return false;
+        }
+    }
+    if (reader->remaining() != 0) {
+        return false;
+    }
+
+    little_endian_ = little_endian != 0;
+    big_tiff_ = big_tiff != 0;
+    pages_ = std::move(pages);
+    return true;
+}
+
+void MultiPageTIFFSource::writeIndex(const FileStamp& stamp) {
+    SidecarWriter writer(kIndexMagic, kIndexVersion);
+    writer.put(stamp.size);
+    writer.put(stamp.mtime_ticks);
+    writer.put(static_cast<std::uint8_t>(little_endian_ ? 1 : 0));
+    writer.put(static_cast<std::uint8_t>(big_tiff_ ? 1 : 0));
+    writer.put(static_cast<std::uint64_t>(pages_.size()));
+    for (const auto& page : pages_) {
+        TiffFormat::putPage(writer, page);
+    }
+    writer.commit(indexPath(path_), index_write_error_);
+}
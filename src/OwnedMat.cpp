@@ -0,0 +1,60 @@
+#include "OwnedMat.h"
+
+#include <new>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+namespace {
+
+// Owns the UMatData of wrapped Mats. The UMatData carries a shared_ptr to the owner in its userdata, so the
+// memory lives exactly as long as the last Mat (or ROI, or copy) that refers to it.
+class OwnedMemoryAllocator final : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, std::size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage_flags) const override {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, access_flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        if (data == nullptr) {
+            return;
+        }
+        delete static_cast<std::shared_ptr<const void>*>(data->userdata);
+        data->userdata = nullptr;
+        delete data;
+    }
+};
+
+const cv::MatAllocator* ownedMemoryAllocator() {
+    // Never destroyed: frames may outlive static destruction order.
+    static const auto* allocator = new OwnedMemoryAllocator();
+    return allocator;
+}
+
+} // namespace
+
+cv::Mat wrapOwnedMemory(std::shared_ptr<const void> owner, std::uint8_t* data, int rows, int cols, int type,
+                        std::size_t step) {
+    auto holder = std::make_unique<std::shared_ptr<const void>>(std::move(owner));
+
+    auto* u = new cv::UMatData(ownedMemoryAllocator());
+    u->data = u->origdata = data;
+    u->size = rows > 0 ? static_cast<std::size_t>(rows - 1) * step + static_cast<std::size_t>(cols) * CV_ELEM_SIZE(type) : 0;
+    u->flags = cv::UMatData::USER_ALLOCATED;
+    u->userdata = holder.release();
+
+    cv::Mat image(rows, cols, type, u->data, step);
+    image.u = u;
+    image.addref();
+    return image;
+}
+
+std::shared_ptr<std::uint8_t> allocateAligned(std::size_t bytes, std::size_t alignment) {
+    const std::align_val_t align{alignment};
+    auto* data = static_cast<std::uint8_t*>(::operator new(bytes, align));
+    return std::shared_ptr<std::uint8_t>(data, [align](std::uint8_t* p) { ::operator delete(p, align); });
+}
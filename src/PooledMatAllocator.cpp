@@ -0,0 +1,289 @@
+#include "PooledMatAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/04_performance_benchmarks.md (4.3 Performance Targets, 4.5 Memory Usage)
+
+namespace {
+
+// The pool ScopedMatAllocator routed this thread's allocations to, if any.
+thread_local const PooledMatAllocator* current_pool = nullptr;
+
+std::size_t pageBytes() {
+#ifdef _WIN32
+    static const std::size_t bytes = []() {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<std::size_t>(info.dwPageSize);
+    }();
+#else
+    static const std::size_t bytes = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    return bytes;
+}
+
+std::size_t roundUp(std::size_t bytes, std::size_t multiple) {
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+// Page-aligned (with `huge`, 2 MB aligned and advised for transparent huge pages) anonymous memory, or null.
+void* mapPages(std::size_t bytes, bool huge) {
+#ifdef _WIN32
+    (void)huge;  // large pages need SeLockMemoryPrivilege, which analysis runs do not have
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    const std::size_t alignment = huge ? PooledMatAllocator::kHugePageBytes : 0;
+    const std::size_t span = bytes + alignment;
+    void* mapped = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    if (!huge) {
+        return mapped;
+    }
+    // Over-map by one huge page and unmap the slack on either side of the aligned range.
+    const auto base = reinterpret_cast<std::uintptr_t>(mapped);
+    const std::uintptr_t aligned = (base + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    if (aligned > base) {
+        munmap(mapped, aligned - base);
+    }
+    if (base + span > aligned + bytes) {
+        munmap(reinterpret_cast<void*>(aligned + bytes), base + span - (aligned + bytes));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void*>(aligned);
+#endif
+}
+
+void unmapPages(void* data, std::size_t bytes) {
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, bytes);
+#endif
+}
+
+// Installed once as OpenCV's default allocator by the first ScopedMatAllocator: hands each allocation to the
+// calling thread's current pool, or to the allocator that was the default before. Deallocation never comes here,
+// since every UMatData records the allocator that made it.
+class DispatchingAllocator final : public cv::MatAllocator {
+public:
+    explicit DispatchingAllocator(cv::MatAllocator* fallback) : fallback_(fallback) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, std::size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage_flags) const override {
+        const cv::MatAllocator* target = current_pool != nullptr ? current_pool : fallback_;
+        return target->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override {
+        return fallback_->allocate(data, access_flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* data) const override { fallback_->deallocate(data); }
+
+private:
+    cv::MatAllocator* fallback_;
+};
+
+void installDispatcher() {
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        // Never destroyed: Mats may be released during static destruction.
+        static auto* dispatcher = new DispatchingAllocator(cv::Mat::getDefaultAllocator());
+        cv::Mat::setDefaultAllocator(dispatcher);
+    });
+}
+
+} // namespace
+
+std::shared_ptr<PooledMatAllocator> PooledMatAllocator::create(const PooledMatAllocatorParams& params,
+                                                               MemoryGovernor* governor) {
+    return std::shared_ptr<PooledMatAllocator>(new PooledMatAllocator(params, governor),
+                                               [](PooledMatAllocator* pool) { pool->detach(); });
+}
+
+const std::shared_ptr<PooledMatAllocator>& PooledMatAllocator::forCurrentThread() {
+    thread_local const std::shared_ptr<PooledMatAllocator> pool = create();
+    return pool;
+}
+
+PooledMatAllocator::PooledMatAllocator(const PooledMatAllocatorParams& params, MemoryGovernor* governor)
+    : params_(params), governor_(governor) {
+    if (governor_ != nullptr) {
+        shrinker_id_ = governor_->addShrinker([this](std::size_t bytes) { return trim(bytes); });
+    }
+}
+
+PooledMatAllocator::~PooledMatAllocator() = default;
+
+cv::UMatData* PooledMatAllocator::allocate(int dims, const int* sizes, int type, void* data, std::size_t* step,
+                                           cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const {
+    std::size_t total = CV_ELEM_SIZE(type);
+    for (int dim = dims - 1; dim >= 0; --dim) {
+        total *= static_cast<std::size_t>(sizes[dim]);
+    }
+    if (data != nullptr || total < params_.min_pooled_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.unpooled;
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+    if (step != nullptr) {
+        std::size_t stride = CV_ELEM_SIZE(type);
+        for (int dim = dims - 1; dim >= 0; --dim) {
+            step[dim] = stride;
+            stride *= static_cast<std::size_t>(sizes[dim]);
+        }
+    }
+
+    const std::size_t bytes = sizeClass(total);
+    void* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto found = free_lists_.find(bytes);
+        if (found != free_lists_.end() && !found->second.empty()) {
+            buffer = found->second.back();
+            found->second.pop_back();
+            ++stats_.hits;
+            --stats_.buffers_retained;
+            stats_.bytes_retained -= bytes;
+            if (governor_ != nullptr) {
+                governor_->release(MemoryCategory::PooledBuffers, bytes);
+            }
+        } else {
+            ++stats_.misses;
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = mapPages(bytes, params_.huge_pages && bytes >= kHugePageBytes);
+        if (buffer == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bytes_in_use += bytes;
+    }
+    ++references_;
+
+    auto* u = new cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar*>(buffer);
+    u->size = total;
+    return u;
+}
+
+bool PooledMatAllocator::allocate(cv::UMatData* data, cv::AccessFlag /*access_flags*/,
+                                  cv::UMatUsageFlags /*usage_flags*/) const {
+    return data != nullptr;
+}
+
+void PooledMatAllocator::deallocate(cv::UMatData* data) const {
+    if (data == nullptr) {
+        return;
+    }
+    void* buffer = data->origdata;
+    const std::size_t bytes = sizeClass(data->size);
+    delete data;
+
+    bool retained = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bytes_in_use -= bytes;
+        if (!detached_ && stats_.bytes_retained + bytes <= params_.max_retained_bytes) {
+            free_lists_[bytes].push_back(buffer);
+            ++stats_.buffers_retained;
+            stats_.bytes_retained += bytes;
+            if (governor_ != nullptr) {
+                governor_->add(MemoryCategory::PooledBuffers, bytes);
+            }
+            retained = true;
+        } else {
+            ++stats_.released;
+        }
+    }
+    if (!retained) {
+        unmapPages(buffer, bytes);
+    }
+    unreference();
+}
+
+std::size_t PooledMatAllocator::sizeClass(std::size_t bytes) const {
+    const std::size_t granule = params_.huge_pages && bytes >= kHugePageBytes ? kHugePageBytes : pageBytes();
+    const std::size_t pages = roundUp(std::max<std::size_t>(bytes, 1), granule);
+    // Eight classes per power of two: a buffer is at most 12.5% larger than the request it serves.
+    return roundUp(pages, std::max(granule, std::bit_floor(pages) / 8));
+}
+
+std::size_t PooledMatAllocator::trim(std::size_t bytes) const {
+    std::vector<std::pair<void*, std::size_t>> unmapped;
+    std::size_t freed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [size, buffers] : free_lists_) {
+            while (!buffers.empty() && freed < bytes) {
+                unmapped.emplace_back(buffers.back(), size);
+                buffers.pop_back();
+                freed += size;
+            }
+        }
+        stats_.released += unmapped.size();
+        stats_.buffers_retained -= unmapped.size();
+        stats_.bytes_retained -= freed;
+        if (governor_ != nullptr) {
+            governor_->release(MemoryCategory::PooledBuffers, freed);
+        }
+    }
+    for (const auto& [buffer, size] : unmapped) {
+        unmapPages(buffer, size);
+    }
+    return freed;
+}
+
+PooledMatAllocatorStats PooledMatAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PooledMatAllocator::detach() {
+    // First, so the governor cannot be inside trim() once the pool goes.
+    if (governor_ != nullptr) {
+        governor_->removeShrinker(shrinker_id_);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        detached_ = true;
+    }
+    trim();
+    unreference();
+}
+
+void PooledMatAllocator::unreference() const {
+    if (references_.fetch_sub(1) == 1) {
+        delete this;
+    }
+}
+
+ScopedMatAllocator::ScopedMatAllocator(std::shared_ptr<PooledMatAllocator> pool)
+    : pool_(std::move(pool)), previous_(current_pool) {
+    installDispatcher();
+    current_pool = pool_.get();
+}
+
+ScopedMatAllocator::~ScopedMatAllocator() {
+    current_pool = previous_;
+}
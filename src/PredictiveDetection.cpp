@@ -0,0 +1,147 @@
+#include "PredictiveDetection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (high-speed acquisition modes)
+
+PredictiveDropletDetector::PredictiveDropletDetector(const PredictiveDetectionParams& params)
+    : params_(params), context_radius_(detectionContextRadius(params.detection)) {
+    if (params.window_margin_px < 0) {
+        throw std::invalid_argument("PredictiveDetectionParams::window_margin_px must be non-negative");
+    }
+}
+
+double PredictiveDropletDetector::averageProcessedFraction() const {
+    return frames_ > 0 ? processed_fraction_sum_ / static_cast<double>(frames_) : 0.0;
+}
+
+std::vector<Detection> PredictiveDropletDetector::detect(const cv::Mat& frame,
+                                                         const std::vector<TrackPrediction>& predictions) {
+    last_stats_ = PredictiveDetectionStats{};
+    if (frame.empty()) {
+        return {};
+    }
+    if (frame.size() != frame_size_) {
+        frame_size_ = frame.size();
+        resync_requested_ = true;
+    }
+
+    ++frames_;
+    const double frame_area = static_cast<double>(frame.total());
+    double processed_pixels = 0.0;
+
+    last_stats_.resync_scheduled = resync_requested_ ||
+        (params_.resync_interval_frames > 0 && frames_since_resync_ >= params_.resync_interval_frames);
+
+    std::vector<Detection> detections;
+    bool full_frame = last_stats_.resync_scheduled;
+    if (!full_frame) {
+        buildWindows(frame_size_, predictions);
+        last_stats_.windows = windows_.size();
+
+        double window_pixels = 0.0;
+        const cv::Rect frame_rect(0, 0, frame.cols, frame.rows);
+        for (const auto& core : windows_) {
+            const cv::Rect padded(core.x - context_radius_, core.y - context_radius_,
+                                  core.width + 2 * context_radius_, core.height + 2 * context_radius_);
+            window_pixels += static_cast<double>((padded & frame_rect).area());
+        }
+        if (window_pixels > params_.max_window_fraction * frame_area) {
+            full_frame = true;
+        } else if (!detectInWindows(frame, predictions, detections, processed_pixels)) {
+            last_stats_.gating_failed = true;
+            full_frame = true;
+        }
+    }
+
+    if (full_frame) {
+        detections = detectFullFrame(frame);
+        processed_pixels += frame_area;
+    } else {
+        ++frames_since_resync_;
+    }
+
+    last_stats_.full_frame = full_frame;
+    last_stats_.processed_pixel_fraction = processed_pixels / frame_area;
+    processed_fraction_sum_ += last_stats_.processed_pixel_fraction;
+    return detections;
+}
+
+std::vector<Detection> PredictiveDropletDetector::detectFullFrame(const cv::Mat& frame) {
+    resync_requested_ = false;
+    frames_since_resync_ = 0;
+    ++full_frames_;
+    return detectDroplets(frame, params_.detection);
+}
+
+void PredictiveDropletDetector::buildWindows(const cv::Size& frame_size, const std::vector<TrackPrediction>& predictions) {
+    const cv::Rect frame_rect(0, 0, frame_size.width, frame_size.height);
+    windows_.clear();
+    windows_.reserve(predictions.size() + 1);
+    for (const auto& prediction : predictions) {
+        const float half = prediction.search_radius + 0.5F * prediction.extent_px + static_cast<float>(params_.window_margin_px);
+        const cv::Rect window(static_cast<int>(std::floor(prediction.position.x - half)),
+                              static_cast<int>(std::floor(prediction.position.y - half)),
+                              static_cast<int>(std::ceil(2.0F * half)) + 1,
+                              static_cast<int>(std::ceil(2.0F * half)) + 1);
+        const cv::Rect clipped = window & frame_rect;
+        if (clipped.area() > 0) {
+            windows_.push_back(clipped);
+        }
+    }
+    const cv::Rect entry = params_.entry_zone & frame_rect;
+    if (entry.area() > 0) {
+        windows_.push_back(entry);
+    }
+    mergeOverlappingRegions(windows_);
+}
+
+bool PredictiveDropletDetector::detectInWindows(const cv::Mat& frame,
+                                                const std::vector<TrackPrediction>& predictions,
+                                                std::vector<Detection>& detections,
+                                                double& processed_pixels) {
+    for (const auto& core : windows_) {
+        std::size_t pixels_read = 0;
+        const bool complete = detectDropletsInRegion(frame, core, params_.detection, detections, &pixels_read);
+        processed_pixels += static_cast<double>(pixels_read);
+        if (!complete) {
+            return false;
+        }
+    }
+
+    // Every prediction that is well inside the frame must find a detection inside its gate; otherwise
+    // the droplet moved unexpectedly (or merged/split) and the windows cannot be trusted.
+    std::vector<cv::Point2f> centroids;
+    centroids.reserve(detections.size());
+    for (const auto& detection : detections) {
+        centroids.push_back(detection.centroid);
+    }
+    std::sort(centroids.begin(), centroids.end(), [](const cv::Point2f& left, const cv::Point2f& right) { return left.x < right.x; });
+
+    for (const auto& prediction : predictions) {
+        const float inset = prediction.extent_px;
+        const cv::Rect_<float> interior(inset, inset, static_cast<float>(frame.cols) - 2.0F * inset,
+                                        static_cast<float>(frame.rows) - 2.0F * inset);
+        if (!interior.contains(prediction.position)) {
+            continue;
+        }
+
+        const float radius = prediction.search_radius;
+        auto it = std::lower_bound(centroids.begin(), centroids.end(), prediction.position.x - radius,
+                                   [](const cv::Point2f& point, float x) { return point.x < x; });
+        bool found = false;
+        for (; it != centroids.end() && it->x <= prediction.position.x + radius; ++it) {
+            const cv::Point2f delta = *it - prediction.position;
+            if (delta.x * delta.x + delta.y * delta.y <= radius * radius) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,216 @@
+#include "PrefetchingSource.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+namespace {
+
+constexpr std::size_t kPageBytes = 4096;
+
+// Zero-copy frames are views of lazily mapped files: touching one byte per page here is what actually moves the
+// disk reads onto the I/O thread. For decoded frames this only re-reads memory that is already resident.
+void faultIn(const cv::Mat& frame) {
+    volatile std::uint8_t sink = 0;
+    const std::size_t row_bytes = static_cast<std::size_t>(frame.cols) * frame.elemSize();
+    for (int y = 0; y < frame.rows; ++y) {
+        const std::uint8_t* row = frame.ptr<std::uint8_t>(y);
+        for (std::size_t offset = 0; offset < row_bytes; offset += kPageBytes) {
+            sink = static_cast<std::uint8_t>(sink ^ row[offset]);
+        }
+    }
+}
+
+} // namespace
+
+PrefetchingSource::PrefetchingSource(std::shared_ptr<InputSource> source, const PrefetchParams& params)
+    : source_(std::move(source)), params_(params), pool_(std::max<std::size_t>(1, params.io_threads)) {
+    if (!source_) {
+        throw std::invalid_argument("PrefetchingSource requires a source");
+    }
+}
+
+PrefetchingSource::~PrefetchingSource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.clear();
+    }
+    slot_ready_.notify_all();
+}
+
+cv::Mat PrefetchingSource::getFrame(std::size_t logical_index) {
+    cv::Mat frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const bool prefetched = takeSlot(logical_index, frame, lock);
+        observe(logical_index);
+        schedule(logical_index);
+        if (prefetched) {
+            return frame;
+        }
+        ++stats_.misses;
+    }
+
+    frame = source_->getFrame(logical_index);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool first_frame = frame_bytes_ == 0;
+    frame_bytes_ = frame.total() * frame.elemSize();
+    if (first_frame) {
+        // Read-ahead cannot be budgeted before the first frame size is known.
+        schedule(logical_index);
+    }
+    return frame;
+}
+
+PrefetchStats PrefetchingSource::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool PrefetchingSource::takeSlot(std::size_t index, cv::Mat& frame, std::unique_lock<std::mutex>& lock) {
+    auto slot = slots_.find(index);
+    if (slot == slots_.end()) {
+        return false;
+    }
+    if (!slot->second.ready) {
+        const std::uint64_t generation = slot->second.generation;
+        slot_ready_.wait(lock, [&]() {
+            const auto current = slots_.find(index);
+            return current == slots_.end() || current->second.generation != generation || current->second.ready;
+        });
+        slot = slots_.find(index);
+        if (slot == slots_.end() || slot->second.generation != generation) {
+            // The read failed; the caller reads synchronously and sees the error itself.
+            return false;
+        }
+        ++stats_.late_hits;
+    } else {
+        ++stats_.hits;
+    }
+    frame = std::move(slot->second.frame);
+    slots_.erase(slot);
+    return true;
+}
+
+void PrefetchingSource::observe(std::size_t index) {
+    if (has_last_) {
+        const auto delta = static_cast<std::ptrdiff_t>(index) - static_cast<std::ptrdiff_t>(last_index_);
+        if (delta == 0) {
+            return;
+        }
+        if (delta == stride_) {
+            ++repeats_;
+        } else {
+            if (repeats_ >= params_.confirmations) {
+                ++stats_.pattern_changes;
+            }
+            stride_ = delta;
+            repeats_ = 1;
+        }
+    }
+    has_last_ = true;
+    last_index_ = index;
+}
+
+void PrefetchingSource::schedule(std::size_t index) {
+    std::vector<std::size_t> window;
+    const std::size_t total = source_->getTotalFrames();
+    if (repeats_ >= params_.confirmations && stride_ != 0 && frame_bytes_ > 0) {
+        auto next = static_cast<std::ptrdiff_t>(index);
+        for (std::size_t depth = 0; depth < params_.max_depth; ++depth) {
+            next += stride_;
+            if (next < 0 || static_cast<std::size_t>(next) >= total) {
+                break;
+            }
+            window.push_back(static_cast<std::size_t>(next));
+        }
+    }
+
+    bool dropped = false;
+    for (auto slot = slots_.begin(); slot != slots_.end();) {
+        if (std::find(window.begin(), window.end(), slot->first) == window.end()) {
+            ++stats_.cancelled;
+            if (slot->second.in_flight && !slot->second.ready) {
+                // Its buffer is still being filled; the bytes are released when read() returns.
+                abandoned_.emplace(slot->second.generation, slot->second.bytes);
+            }
+            slot = slots_.erase(slot);
+            dropped = true;
+        } else {
+            ++slot;
+        }
+    }
+    if (dropped) {
+        slot_ready_.notify_all();
+    }
+
+    std::size_t in_use = bytesInUse();
+    for (const std::size_t next : window) {
+        if (slots_.count(next) != 0) {
+            continue;
+        }
+        if (in_use + frame_bytes_ > params_.byte_budget) {
+            break;
+        }
+        Slot& slot = slots_[next];
+        slot.generation = ++generation_;
+        slot.bytes = frame_bytes_;
+        in_use += frame_bytes_;
+        ++stats_.issued;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, in_use);
+        pool_.submit([this, next, generation = slot.generation]() { read(next, generation); });
+    }
+}
+
+void PrefetchingSource::read(std::size_t index, std::uint64_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto slot = slots_.find(index);
+        if (slot == slots_.end() || slot->second.generation != generation) {
+            return;  // cancelled while queued
+        }
+        slot->second.in_flight = true;
+    }
+
+    cv::Mat frame;
+    bool ok = true;
+    try {
+        frame = source_->getFrame(index);
+        faultIn(frame);
+    } catch (const std::exception&) {
+        ok = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto slot = slots_.find(index);
+        if (slot == slots_.end() || slot->second.generation != generation) {
+            abandoned_.erase(generation);
+            return;  // cancelled while in flight
+        }
+        if (ok) {
+            slot->second.ready = true;
+            slot->second.bytes = frame.total() * frame.elemSize();
+            slot->second.frame = std::move(frame);
+            stats_.peak_bytes = std::max(stats_.peak_bytes, bytesInUse());
+        } else {
+            slots_.erase(slot);
+        }
+    }
+    slot_ready_.notify_all();
+}
+
+std::size_t PrefetchingSource::bytesInUse() const {
+    std::size_t bytes = 0;
+    for (const auto& [index, slot] : slots_) {
+        bytes += slot.bytes;
+    }
+    for (const auto& [generation, abandoned] : abandoned_) {
+        bytes += abandoned;
+    }
+    return bytes;
+}
@@ -0,0 +1,500 @@
+#include "RawRecording.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "OwnedMat.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+
+namespace {
+
+using namespace RawRecordingFormat;
+
+// Header field offsets.
+constexpr std::size_t kVersionAt = 8;
+constexpr std::size_t kWidthAt = 12;
+constexpr std::size_t kHeightAt = 16;
+constexpr std::size_t kTypeAt = 20;
+constexpr std::size_t kChunkFramesAt = 24;
+constexpr std::size_t kFrameBytesAt = 32;
+constexpr std::size_t kChunkBytesAt = 40;
+constexpr std::size_t kFpsAt = 48;
+constexpr std::size_t kFrameCountAt = 56;
+constexpr std::size_t kIndexOffsetAt = 64;
+
+std::size_t roundUp(std::size_t bytes, std::size_t multiple) {
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+void storeU64(std::uint8_t* at, std::uint64_t value) {
+    for (std::size_t i = 0; i < 8; ++i) {
+        at[i] = static_cast<std::uint8_t>((value >> (8 * i)) & 0xFFU);
+    }
+}
+
+void storeU32(std::uint8_t* at, std::uint32_t value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        at[i] = static_cast<std::uint8_t>((value >> (8 * i)) & 0xFFU);
+    }
+}
+
+std::uint64_t loadU64(const std::uint8_t* at) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        value |= static_cast<std::uint64_t>(at[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint32_t loadU32(const std::uint8_t* at) {
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(at[i]) << (8 * i);
+    }
+    return value;
+}
+
+struct HeaderFields {
+    cv::Size frame_size;
+    int type = -1;
+    std::size_t chunk_frames = 0;
+    std::size_t frame_bytes = 0;
+    std::size_t chunk_bytes = 0;
+    double fps = 0.0;
+    std::uint64_t frame_count = 0;
+    std::uint64_t index_offset = 0;
+};
+
+void encodeHeader(const HeaderFields& fields, std::uint8_t* header) {
+    std::memset(header, 0, kHeaderBytes);
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    storeU32(header + kVersionAt, kVersion);
+    storeU32(header + kWidthAt, static_cast<std::uint32_t>(fields.frame_size.width));
+    storeU32(header + kHeightAt, static_cast<std::uint32_t>(fields.frame_size.height));
+    storeU32(header + kTypeAt, static_cast<std::uint32_t>(fields.type));
+    storeU32(header + kChunkFramesAt, static_cast<std::uint32_t>(fields.chunk_frames));
+    storeU64(header + kFrameBytesAt, fields.frame_bytes);
+    storeU64(header + kChunkBytesAt, fields.chunk_bytes);
+    storeU64(header + kFpsAt, std::bit_cast<std::uint64_t>(fields.fps));
+    storeU64(header + kFrameCountAt, fields.frame_count);
+    storeU64(header + kIndexOffsetAt, fields.index_offset);
+}
+
+#ifdef _WIN32
+
+HANDLE openForRecording(const std::string& path, bool direct_io, bool& direct_used, std::string& error_message) {
+    direct_used = false;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    if (direct_io) {
+        file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, nullptr);
+        direct_used = file != INVALID_HANDLE_VALUE;
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        error_message = "Cannot create recording: " + path + " (error " + std::to_string(GetLastError()) + ")";
+    }
+    return file;
+}
+
+bool writeAt(HANDLE file, const std::uint8_t* data, std::size_t bytes, std::uint64_t offset,
+             std::string& error_message) {
+    while (bytes > 0) {
+        OVERLAPPED position{};
+        position.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFU);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(bytes, 1U << 30));
+        DWORD written = 0;
+        if (!WriteFile(file, data, chunk, &written, &position) || written == 0) {
+            error_message = "Failed to write recording (error " + std::to_string(GetLastError()) + ")";
+            return false;
+        }
+        data += written;
+        bytes -= written;
+        offset += written;
+    }
+    return true;
+}
+
+#else
+
+int openForRecording(const std::string& path, bool direct_io, bool& direct_used, std::string& error_message) {
+    direct_used = false;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct_io) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+        direct_used = fd >= 0;
+    }
+#else
+    (void)direct_io;
+#endif
+    if (fd < 0) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        error_message = "Cannot create recording: " + path + " (" + std::strerror(errno) + ")";
+    }
+    return fd;
+}
+
+bool writeAt(int fd, const std::uint8_t* data, std::size_t bytes, std::uint64_t offset, std::string& error_message) {
+    while (bytes > 0) {
+        const ssize_t written = ::pwrite(fd, data, bytes, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_message = std::string("Failed to write recording (") + std::strerror(errno) + ")";
+            return false;
+        }
+        data += written;
+        bytes -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
+RawRecorder::RawRecorder(const RawRecorderParams& params) : params_(params) {}
+
+RawRecorder::~RawRecorder() {
+    std::string ignored;
+    finish(ignored);
+}
+
+bool RawRecorder::open(const std::string& path, cv::Size frame_size, int type, double fps,
+                       std::string& error_message) {
+    if (isOpen()) {
+        error_message = "Recorder is already open: " + path_;
+        return false;
+    }
+    if (frame_size.width <= 0 || frame_size.height <= 0) {
+        error_message = "Recording needs a non-empty frame size";
+        return false;
+    }
+
+    path_ = path;
+    frame_size_ = frame_size;
+    type_ = type;
+    fps_ = fps;
+    frame_bytes_ = static_cast<std::size_t>(frame_size.width) * static_cast<std::size_t>(frame_size.height) *
+        CV_ELEM_SIZE(type);
+    chunk_frames_ = std::max<std::size_t>(1, params_.chunk_bytes / frame_bytes_);
+    chunk_bytes_ = roundUp(chunk_frames_ * frame_bytes_, kAlignment);
+
+    bool direct_used = false;
+#ifdef _WIN32
+    HANDLE file = openForRecording(path, params_.direct_io, direct_used, error_message);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file_ = file;
+#else
+    fd_ = openForRecording(path, params_.direct_io, direct_used, error_message);
+    if (fd_ < 0) {
+        return false;
+    }
+#endif
+
+    // Placeholder header (no frames, no index) until finish() completes the recording.
+    HeaderFields fields;
+    fields.frame_size = frame_size_;
+    fields.type = type_;
+    fields.chunk_frames = chunk_frames_;
+    fields.frame_bytes = frame_bytes_;
+    fields.chunk_bytes = chunk_bytes_;
+    fields.fps = fps_;
+    const std::shared_ptr<std::uint8_t> header = allocateAligned(kHeaderBytes, kAlignment);
+    encodeHeader(fields, header.get());
+#ifdef _WIN32
+    const bool written = writeAt(file, header.get(), kHeaderBytes, 0, error_message);
+#else
+    const bool written = writeAt(fd_, header.get(), kHeaderBytes, 0, error_message);
+#endif
+    if (!written) {
+#ifdef _WIN32
+        CloseHandle(file);
+        file_ = nullptr;
+#else
+        ::close(fd_);
+        fd_ = -1;
+#endif
+        return false;
+    }
+
+    chunks_.clear();
+    free_.clear();
+    queued_.clear();
+    for (std::size_t i = 0; i < std::max<std::size_t>(2, params_.buffers); ++i) {
+        chunks_.push_back(Chunk{allocateAligned(chunk_bytes_, kAlignment), 0, 0});
+        free_.push_back(i);
+    }
+    index_.clear();
+    filling_ = kNoChunk;
+    next_chunk_ = 0;
+    allocated_bytes_ = 0;
+    closing_ = false;
+    write_error_.clear();
+    failed_ = false;
+    stats_ = RawRecorderStats{};
+    stats_.direct_io = direct_used;
+    writer_ = std::thread([this]() { writeLoop(); });
+    return true;
+}
+
+bool RawRecorder::record(const StreamFrame& frame) {
+    const cv::Mat& image = frame.image;
+    if (!isOpen() || failed_.load(std::memory_order_relaxed) || image.size() != frame_size_ || image.type() != type_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.frames_dropped;
+        return false;
+    }
+    if (filling_ == kNoChunk) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            ++stats_.frames_dropped;
+            return false;
+        }
+        filling_ = free_.back();
+        free_.pop_back();
+    }
+
+    Chunk& chunk = chunks_[filling_];
+    std::uint8_t* target = chunk.data.get() + chunk.frames * frame_bytes_;
+    if (image.isContinuous()) {
+        std::memcpy(target, image.data, frame_bytes_);
+    } else {
+        const std::size_t row_bytes = frame_bytes_ / static_cast<std::size_t>(image.rows);
+        for (int y = 0; y < image.rows; ++y) {
+            std::memcpy(target + static_cast<std::size_t>(y) * row_bytes, image.ptr(y), row_bytes);
+        }
+    }
+    index_.push_back({frame.frame_index, frame.timestamp});
+    ++chunk.frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.frames_recorded;
+    }
+    if (chunk.frames == chunk_frames_) {
+        submitFilling();
+    }
+    return true;
+}
+
+bool RawRecorder::finish(std::string& error_message) {
+    if (!isOpen()) {
+        return true;
+    }
+    if (filling_ != kNoChunk) {
+        // The last chunk is written whole; zero the unused tail so the file does not carry stale frames.
+        Chunk& chunk = chunks_[filling_];
+        const std::size_t used = chunk.frames * frame_bytes_;
+        std::memset(chunk.data.get() + used, 0, chunk_bytes_ - used);
+        submitFilling();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    ready_.notify_all();
+    writer_.join();
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(file_));
+    file_ = nullptr;
+#else
+    ::close(fd_);
+    fd_ = -1;
+#endif
+    chunks_.clear();
+    if (!write_error_.empty()) {
+        error_message = write_error_ + ": " + path_;
+        return false;
+    }
+
+    // Drop the preallocated space past the last chunk, then append the index and complete the header through
+    // ordinary buffered I/O.
+    const std::uint64_t index_offset = kHeaderBytes + next_chunk_ * chunk_bytes_;
+    std::error_code ec;
+    std::filesystem::resize_file(path_, index_offset, ec);
+    if (ec) {
+        error_message = "Cannot truncate recording: " + path_ + " (" + ec.message() + ")";
+        return false;
+    }
+    std::vector<std::uint8_t> index(index_.size() * kIndexEntryBytes);
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        storeU64(index.data() + i * kIndexEntryBytes, index_[i].frame_index);
+        storeU64(index.data() + i * kIndexEntryBytes + 8, std::bit_cast<std::uint64_t>(index_[i].timestamp));
+    }
+    HeaderFields fields;
+    fields.frame_size = frame_size_;
+    fields.type = type_;
+    fields.chunk_frames = chunk_frames_;
+    fields.frame_bytes = frame_bytes_;
+    fields.chunk_bytes = chunk_bytes_;
+    fields.fps = fps_;
+    fields.frame_count = index_.size();
+    fields.index_offset = index_offset;
+    std::vector<std::uint8_t> header(kHeaderBytes);
+    encodeHeader(fields, header.data());
+
+    std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(static_cast<std::streamoff>(index_offset));
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    if (!out.flush()) {
+        error_message = "Failed to write recording index: " + path_;
+        return false;
+    }
+    return true;
+}
+
+RawRecorderStats RawRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void RawRecorder::submitFilling() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chunks_[filling_].number = next_chunk_++;
+        queued_.push_back(filling_);
+        stats_.peak_queued_chunks = std::max(stats_.peak_queued_chunks, queued_.size());
+    }
+    filling_ = kNoChunk;
+    ready_.notify_one();
+}
+
+void RawRecorder::writeLoop() {
+    for (;;) {
+        std::size_t slot = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return closing_ || !queued_.empty(); });
+            if (queued_.empty()) {
+                return;
+            }
+            slot = queued_.front();
+            queued_.pop_front();
+        }
+
+        const Chunk& chunk = chunks_[slot];
+        const std::uint64_t offset = kHeaderBytes + chunk.number * chunk_bytes_;
+        std::string error;
+        if (!failed_.load()) {
+#if defined(__linux__)
+            // Reserving space in large steps keeps the filesystem from allocating extents write by write.
+            if (params_.preallocate_bytes > 0 && offset + chunk_bytes_ > allocated_bytes_) {
+                const std::uint64_t reserve_end = offset + chunk_bytes_ + params_.preallocate_bytes;
+                if (::posix_fallocate(fd_, static_cast<off_t>(offset),
+                                      static_cast<off_t>(reserve_end - offset)) == 0) {
+                    allocated_bytes_ = reserve_end;
+                }
+            }
+#endif
+#ifdef _WIN32
+            writeAt(static_cast<HANDLE>(file_), chunk.data.get(), chunk_bytes_, offset, error);
+#else
+            writeAt(fd_, chunk.data.get(), chunk_bytes_, offset, error);
+#endif
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error.empty()) {
+            write_error_ = error;
+            failed_ = true;
+        } else if (!failed_.load()) {
+            ++stats_.chunks_written;
+            stats_.bytes_written += chunk_bytes_;
+        }
+        chunks_[slot].frames = 0;
+        free_.push_back(slot);
+    }
+}
+
+RawRecordingSource::RawRecordingSource(std::string path) : path_(std::move(path)) {}
+
+bool RawRecordingSource::load(std::string& error_message) {
+    file_ = MappedFile::open(path_, error_message);
+    if (!file_) {
+        return false;
+    }
+    const std::uint8_t* data = file_->data();
+    const std::size_t size = file_->size();
+    if (size < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        error_message = "Not a raw recording: " + path_;
+        return false;
+    }
+    if (loadU32(data + kVersionAt) != kVersion) {
+        error_message = "Unsupported raw recording version " + std::to_string(loadU32(data + kVersionAt)) + ": " +
+            path_;
+        return false;
+    }
+
+    frame_size_ = cv::Size(static_cast<int>(loadU32(data + kWidthAt)), static_cast<int>(loadU32(data + kHeightAt)));
+    type_ = static_cast<int>(loadU32(data + kTypeAt));
+    chunk_frames_ = loadU32(data + kChunkFramesAt);
+    frame_bytes_ = static_cast<std::size_t>(loadU64(data + kFrameBytesAt));
+    chunk_bytes_ = static_cast<std::size_t>(loadU64(data + kChunkBytesAt));
+    fps_ = std::bit_cast<double>(loadU64(data + kFpsAt));
+    const std::uint64_t frame_count = loadU64(data + kFrameCountAt);
+    const std::uint64_t index_offset = loadU64(data + kIndexOffsetAt);
+    if (index_offset == 0) {
+        error_message = "Raw recording was not finished: " + path_;
+        return false;
+    }
+
+    const bool geometry_ok = frame_size_.width > 0 && frame_size_.height > 0 && type_ >= 0 && chunk_frames_ > 0 &&
+        frame_bytes_ == static_cast<std::size_t>(frame_size_.width) * static_cast<std::size_t>(frame_size_.height) *
+                CV_ELEM_SIZE(type_) &&
+        chunk_bytes_ / chunk_frames_ >= frame_bytes_;
+    const std::uint64_t chunks = geometry_ok ? (frame_count + chunk_frames_ - 1) / chunk_frames_ : 0;
+    if (!geometry_ok || frame_count > size / kIndexEntryBytes || chunks > size / chunk_bytes_ ||
+        index_offset < kHeaderBytes + chunks * chunk_bytes_ || index_offset > size ||
+        size - index_offset < frame_count * kIndexEntryBytes) {
+        error_message = "Corrupt raw recording header: " + path_;
+        return false;
+    }
+
+    index_.resize(static_cast<std::size_t>(frame_count));
+    const std::uint8_t* entries = data + index_offset;
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        index_[i].frame_index = loadU64(entries + i * kIndexEntryBytes);
+        index_[i].timestamp = std::bit_cast<double>(loadU64(entries + i * kIndexEntryBytes + 8));
+    }
+    return true;
+}
+
+cv::Mat RawRecordingSource::getFrame(std::size_t logical_index) {
+    if (logical_index >= index_.size()) {
+        throw std::out_of_range("RawRecordingSource::getFrame index " + std::to_string(logical_index) +
+                                " out of range");
+    }
+    const std::size_t offset = kHeaderBytes + logical_index / chunk_frames_ * chunk_bytes_ +
+        logical_index % chunk_frames_ * frame_bytes_;
+    return file_->matView(offset, frame_size_.height, frame_size_.width, type_,
+                          frame_bytes_ / static_cast<std::size_t>(frame_size_.height));
+}
@@ -0,0 +1,119 @@
+#include "SidecarIndex.h"
+
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+// Spec: Docs/TECHSPEC_SPLIT/02_system_architecture.md (2.1 Input Source Abstraction)
+
+namespace {
+
+std::uint64_t fnv1a64(const std::uint8_t* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::optional<FileStamp> FileStamp::of(const std::filesystem::path& path) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return FileStamp{static_cast<std::uint64_t>(size), static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+}
+
+SidecarWriter::SidecarWriter(std::string_view magic, std::uint32_t version) {
+    putString(magic);
+    put(version);
+}
+
+void SidecarWriter::putString(std::string_view text) {
+    put(static_cast<std::uint32_t>(text.size()));
+    bytes_.insert(bytes_.end(), text.begin(), text.end());
+}
+
+bool SidecarWriter::commit(const std::filesystem::path& path, std::string& error_message) const {
+    std::vector<std::uint8_t> contents = bytes_;
+    const std::uint64_t checksum = fnv1a64(contents.data(), contents.size());
+    for (std::size_t i = 0; i < sizeof(checksum); ++i) {
+        contents.push_back(static_cast<std::uint8_t>((checksum >> (8 * i)) & 0xFFU));
+    }
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error_message = "Cannot create index file: " + temporary.string();
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+        if (!out.flush()) {
+            error_message = "Failed to write index file: " + temporary.string();
+            out.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary, ignored);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        error_message = "Cannot replace index file: " + path.string() + " (" + ec.message() + ")";
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        return false;
+    }
+    return true;
+}
+
+std::optional<SidecarReader> SidecarReader::open(const std::filesystem::path& path, std::string_view magic,
+                                                 std::uint32_t version) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    SidecarReader reader;
+    reader.bytes_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (reader.bytes_.size() < sizeof(std::uint64_t)) {
+        return std::nullopt;
+    }
+
+    reader.end_ = reader.bytes_.size() - sizeof(std::uint64_t);
+    std::uint64_t stored = 0;
+    for (std::size_t i = 0; i < sizeof(stored); ++i) {
+        stored |= static_cast<std::uint64_t>(reader.bytes_[reader.end_ + i]) << (8 * i);
+    }
+    if (stored != fnv1a64(reader.bytes_.data(), reader.end_)) {
+        return std::nullopt;
+    }
+
+    std::string stored_magic;
+    std::uint32_t stored_version = 0;
+    if (!reader.getString(stored_magic) || stored_magic != magic || !reader.get(stored_version) ||
+        stored_version != version) {
+        return std::nullopt;
+    }
+    return reader;
+}
+
+bool SidecarReader::getString(std::string& text) {
+    std::uint32_t length = 0;
+    if (!get(length) || length > remaining()) {
+        return false;
+    }
+    text.assign(reinterpret_cast<const char*>(bytes_.data() + position_), length);
+    position_ += length;
+    return true;
+}
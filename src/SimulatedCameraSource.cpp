@@ -0,0 +1,266 @@
+#include "SimulatedCameraSource.h"
+
+#include <algorithm>
+#include <utility>
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.5 Real-Time Camera Control)
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Longest sleep while waiting for a frame: short enough for the 8938 FPS line mode (112 us per frame).
+constexpr std::chrono::microseconds kPollInterval{50};
+
+int floorMod(int value, int modulus) {
+    const int remainder = value % modulus;
+    return remainder < 0 ? remainder + modulus : remainder;
+}
+
+// Droplets of `radius` on a hexagonal grid of `spacing`, shifted right by `shift`, over a flat background with
+// uniform noise. The first row of droplets is centred on the frame when it is shorter than one grid step, so a
+// line-scan frame cuts through every droplet.
+cv::Mat generateFrame(const SimulatedCameraParams& params, int shift, std::uint32_t seed) {
+    const bool sixteen_bit = CV_MAT_DEPTH(params.type) == CV_16U;
+    const double background = sixteen_bit ? 1800.0 : 40.0;
+    const double droplet = sixteen_bit ? 6000.0 : 150.0;
+    const int noise = sixteen_bit ? 40 : 8;
+    const int spacing = params.droplet_spacing_px;
+    const int first_row = std::min(params.height / 2, spacing / 2);
+    const double radius2 = static_cast<double>(params.droplet_radius_px) * params.droplet_radius_px;
+
+    cv::Mat frame(params.height, params.width, params.type);
+    std::uint32_t state = seed * 2654435761U + 1U;
+    for (int y = 0; y < params.height; ++y) {
+        const int row = (y - first_row + spacing / 2) / spacing;
+        const int dy = floorMod(y - first_row + spacing / 2, spacing) - spacing / 2;
+        const int stagger = (row % 2) * (spacing / 2);
+        for (int x = 0; x < params.width; ++x) {
+            const int dx = floorMod(x - shift - stagger, spacing) - spacing / 2;
+            state = state * 1664525U + 1013904223U;
+            double value = background + static_cast<int>(state >> 24) % (2 * noise + 1) - noise;
+            const double r2 = static_cast<double>(dx) * dx + static_cast<double>(dy) * dy;
+            if (r2 < radius2) {
+                value += droplet * (1.0 - 0.3 * r2 / radius2);
+            }
+            if (sixteen_bit) {
+                frame.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(std::clamp(value, 0.0, 65535.0));
+            } else {
+                frame.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(std::clamp(value, 0.0, 255.0));
+            }
+        }
+    }
+    return frame;
+}
+
+} // namespace
+
+SimulatedCameraParams SimulatedCameraParams::fullFrame() {
+    return SimulatedCameraParams{};
+}
+
+SimulatedCameraParams SimulatedCameraParams::highSpeedLine() {
+    SimulatedCameraParams params;
+    params.width = 2304;
+    params.height = 4;
+    params.type = CV_8UC1;
+    params.fps = 8938.0;
+    return params;
+}
+
+SimulatedCameraSource::SimulatedCameraSource(SimulatedCameraParams params) : params_(std::move(params)) {}
+
+SimulatedCameraSource::~SimulatedCameraSource() {
+    stop();
+}
+
+bool SimulatedCameraSource::start(std::string& error_message) {
+    if (camera_.joinable()) {
+        error_message = "Simulated camera was already started";
+        return false;
+    }
+    if (!(params_.fps > 0.0) || params_.ring_frames == 0) {
+        error_message = "Simulated camera needs a positive frame rate and at least one ring buffer";
+        return false;
+    }
+    if (!prepareFrames(error_message)) {
+        return false;
+    }
+
+    // Every acquisition starts from an empty ring at frame 0, including one after stop(); buffers and frames from
+    // the previous one stay with whoever still holds their Mats.
+    slots_ = std::vector<Slot>(params_.ring_frames);
+    // The ring, the camera's spare and one buffer on its way back: the return queue never fills up.
+    returned_ = std::vector<std::atomic<Buffer*>>(params_.ring_frames + 4);
+    returned_head_ = 0;
+    returned_tail_ = 0;
+    recycled_.clear();
+    buffers_.clear();
+    acquired_ = 0;
+    next_index_ = 0;
+    delivered_ = 0;
+    lost_ = 0;
+    lost_events_ = 0;
+    late_ = 0;
+    stop_requested_ = false;
+    acquiring_ = true;
+    camera_ = std::thread([this]() { acquire(); });
+    return true;
+}
+
+void SimulatedCameraSource::stop() {
+    stop_requested_ = true;
+    if (camera_.joinable()) {
+        camera_.join();
+    }
+    acquiring_ = false;
+}
+
+GrabStatus SimulatedCameraSource::grabNextFrame(StreamFrame& frame, std::chrono::microseconds timeout) {
+    const auto deadline = Clock::now() + timeout;
+    std::uint64_t acquired = acquired_.load(std::memory_order_acquire);
+    while (acquired <= next_index_) {
+        if (!acquiring_.load()) {
+            // The last frame may have been published just before acquisition ended.
+            acquired = acquired_.load(std::memory_order_acquire);
+            if (acquired <= next_index_) {
+                return GrabStatus::Stopped;
+            }
+            break;
+        }
+        const auto now = Clock::now();
+        if (now >= deadline) {
+            return GrabStatus::Timeout;
+        }
+        std::this_thread::sleep_for(std::min<Clock::duration>(kPollInterval, deadline - now));
+        acquired = acquired_.load(std::memory_order_acquire);
+    }
+
+    // Frames more than a ring behind are gone: start from the oldest one that can still be there.
+    const std::size_t ring = slots_.size();
+    const std::uint64_t oldest = acquired > ring ? acquired - ring : 0;
+    const std::uint64_t wanted = std::max(next_index_, oldest);
+    // The slot holds frame `wanted`, or a newer one if the camera has come round again in the meantime.
+    Buffer* buffer = slots_[wanted % ring].buffer.exchange(nullptr, std::memory_order_acq_rel);
+
+    GrabStatus status = GrabStatus::Ok;
+    const std::uint64_t index = buffer->frame.frame_index;
+    if (index > next_index_) {
+        lost_ += index - next_index_;
+        ++lost_events_;
+        status = GrabStatus::LostFrame;
+    }
+    next_index_ = index + 1;
+    std::swap(frame, buffer->frame);
+    ++delivered_;
+
+    const std::size_t tail = returned_tail_.load(std::memory_order_relaxed);
+    returned_[tail % returned_.size()].store(buffer, std::memory_order_relaxed);
+    returned_tail_.store(tail + 1, std::memory_order_release);
+    return status;
+}
+
+cv::Mat SimulatedCameraSource::getFrame(std::size_t /*logical_index*/) {
+    StreamFrame frame;
+    const GrabStatus status = grabNextFrame(frame, std::chrono::seconds(1));
+    return status == GrabStatus::Ok || status == GrabStatus::LostFrame ? frame.image : cv::Mat();
+}
+
+double SimulatedCameraSource::getTimestamp(std::size_t logical_index) const {
+    return static_cast<double>(logical_index) / params_.fps;
+}
+
+SimulatedCameraStats SimulatedCameraSource::stats() const {
+    SimulatedCameraStats stats;
+    stats.frames_acquired = acquired_.load();
+    stats.frames_delivered = delivered_.load();
+    stats.frames_lost = lost_.load();
+    stats.lost_frame_events = lost_events_.load();
+    stats.late_frames = late_.load();
+    return stats;
+}
+
+bool SimulatedCameraSource::prepareFrames(std::string& error_message) {
+    frames_.clear();
+    if (params_.replay) {
+        const std::size_t total = params_.replay->getTotalFrames();
+        const std::size_t count = params_.replay_frames == 0 ? total : std::min(total, params_.replay_frames);
+        if (count == 0) {
+            error_message = "Replay source has no frames";
+            return false;
+        }
+        for (std::size_t index = 0; index < count; ++index) {
+            cv::Mat frame = params_.replay->getFrame(index);
+            if (frame.empty() || (!frames_.empty() && (frame.size() != frames_.front().size() ||
+                                                       frame.type() != frames_.front().type()))) {
+                error_message = "Replay frame " + std::to_string(index) + " is empty or differs in size or type";
+                return false;
+            }
+            frames_.push_back(std::move(frame));
+        }
+        params_.width = frames_.front().cols;
+        params_.height = frames_.front().rows;
+        params_.type = frames_.front().type();
+        return true;
+    }
+
+    if (params_.width <= 0 || params_.height <= 0 || (params_.type != CV_8UC1 && params_.type != CV_16UC1) ||
+        params_.pattern_frames == 0 || params_.droplet_spacing_px <= 0) {
+        error_message = "Simulated camera needs a positive size, CV_8UC1 or CV_16UC1 and a droplet grid";
+        return false;
+    }
+    for (std::size_t index = 0; index < params_.pattern_frames; ++index) {
+        const int shift = static_cast<int>(index * static_cast<std::size_t>(params_.droplet_spacing_px) /
+                                           params_.pattern_frames);
+        frames_.push_back(generateFrame(params_, shift, static_cast<std::uint32_t>(index)));
+    }
+    return true;
+}
+
+void SimulatedCameraSource::acquire() {
+    const std::chrono::duration<double> interval(1.0 / params_.fps);
+    const auto start = Clock::now();
+    for (std::uint64_t index = 0; !stop_requested_.load() && (params_.frame_limit == 0 || index < params_.frame_limit);
+         ++index) {
+        const auto due = start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(index));
+        std::this_thread::sleep_until(due);
+
+        Buffer* buffer = spareBuffer();
+        StreamFrame& frame = buffer->frame;
+        // Write into the buffer the consumer gave back, unless a Mat outside the ring still refers to it.
+        if (frame.image.u == nullptr || frame.image.u->refcount != 1) {
+            frame.image = cv::Mat();
+        }
+        frames_[index % frames_.size()].copyTo(frame.image);
+        frame.frame_index = index;
+        frame.timestamp = static_cast<double>(index) * interval.count();
+        frame.arrival = Clock::now();
+        if (frame.arrival - due > interval) {
+            ++late_;
+        }
+
+        // The camera does not wait: a frame the consumer has not read yet is overwritten.
+        Buffer* overwritten = slots_[index % slots_.size()].buffer.exchange(buffer, std::memory_order_acq_rel);
+        if (overwritten != nullptr) {
+            recycled_.push_back(overwritten);
+        }
+        acquired_.store(index + 1, std::memory_order_release);
+    }
+    acquiring_ = false;
+}
+
+SimulatedCameraSource::Buffer* SimulatedCameraSource::spareBuffer() {
+    if (!recycled_.empty()) {
+        Buffer* buffer = recycled_.back();
+        recycled_.pop_back();
+        return buffer;
+    }
+    const std::size_t head = returned_head_.load(std::memory_order_relaxed);
+    if (head != returned_tail_.load(std::memory_order_acquire)) {
+        Buffer* buffer = returned_[head % returned_.size()].load(std::memory_order_relaxed);
+        returned_head_.store(head + 1, std::memory_order_release);
+        return buffer;
+    }
+    buffers_.push_back(std::make_unique<Buffer>());
+    return buffers_.back().get();
+}
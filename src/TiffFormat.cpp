@@ -0,0 +1,917 @@
+#include "TiffFormat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <system_error>
+#include <utility>
+
+#ifdef DROPLET_WITH_TIFF
+#include <tiffio.h>
+#endif
+
+// Spec: Docs/TECHSPEC_SPLIT/03_functional_requirements.md (3.2 TIFF Support Matrix)
+
+namespace {
+
+constexpr std::uint16_t kTagImageWidth = 256;
+constexpr std::uint16_t kTagImageLength = 257;
+constexpr std::uint16_t kTagBitsPerSample = 258;
+constexpr std::uint16_t kTagCompression = 259;
+constexpr std::uint16_t kTagPhotometric = 262;
+constexpr std::uint16_t kTagStripOffsets = 273;
+constexpr std::uint16_t kTagSamplesPerPixel = 277;
+constexpr std::uint16_t kTagRowsPerStrip = 278;
+constexpr std::uint16_t kTagStripByteCounts = 279;
+constexpr std::uint16_t kTagPlanarConfiguration = 284;
+constexpr std::uint16_t kTagTileWidth = 322;
+constexpr std::uint16_t kTagTileOffsets = 324;
+constexpr std::uint16_t kTagSampleFormat = 339;
+
+constexpr std::uint16_t kTypeShort = 3;
+constexpr std::uint16_t kTypeLong = 4;
+
+// Per strip in a sidecar index: one 64-bit offset and one 64-bit byte count.
+constexpr std::size_t kIndexBytesPerStrip = 16;
+
+// Header parsing reads the file in blocks of this size; one block covers typical single-page headers.
+constexpr std::size_t kHeaderBlockBytes = 4096;
+
+constexpr bool kHostLittleEndian = std::endian::native == std::endian::little;
+
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+    virtual std::uint64_t size() const = 0;
+    // Copies [offset, offset + length) into out; the range has already been checked against size().
+    virtual bool fetch(std::uint64_t offset, std::size_t length, std::uint8_t* out) const = 0;
+};
+
+class SpanSource final : public ByteSource {
+public:
+    explicit SpanSource(std::span<const std::uint8_t> bytes) : bytes_(bytes) {}
+    std::uint64_t size() const override { return bytes_.size(); }
+    bool fetch(std::uint64_t offset, std::size_t length, std::uint8_t* out) const override {
+        std::memcpy(out, bytes_.data() + offset, length);
+        return true;
+    }
+
+private:
+    std::span<const std::uint8_t> bytes_;
+};
+
+// Reads a file in aligned blocks on first use and keeps them, so parsing the directories touches only the
+// blocks that hold the header, the IFDs and the strip tables (usually just the first one).
+class FileBlockSource final : public ByteSource {
+public:
+    FileBlockSource(std::ifstream& in, std::uint64_t size, std::size_t block_bytes)
+        : in_(in), size_(size), block_bytes_(block_bytes) {}
+
+    std::uint64_t size() const override { return size_; }
+
+    bool fetch(std::uint64_t offset, std::size_t length, std::uint8_t* out) const override {
+        while (length > 0) {
+            const std::uint64_t block = offset / block_bytes_;
+            const std::vector<std::uint8_t>* data = load(block);
+            if (data == nullptr) {
+                return false;
+            }
+            const std::size_t within = static_cast<std::size_t>(offset - block * block_bytes_);
+            const std::size_t count = std::min(length, data->size() - within);
+            std::memcpy(out, data->data() + within, count);
+            out += count;
+            offset += count;
+            length -= count;
+        }
+        return true;
+    }
+
+    std::size_t bytesRead() const { return bytes_read_; }
+
+private:
+    const std::vector<std::uint8_t>* load(std::uint64_t block) const {
+        for (const auto& [index, data] : blocks_) {
+            if (index == block) {
+                return &data;
+            }
+        }
+        const std::uint64_t begin = block * block_bytes_;
+        const auto length = static_cast<std::size_t>(std::min<std::uint64_t>(block_bytes_, size_ - begin));
+        std::vector<std::uint8_t> data(length);
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(begin));
+        in_.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(length));
+        if (!in_) {
+            return nullptr;
+        }
+        bytes_read_ += length;
+        blocks_.emplace_back(block, std::move(data));
+        return &blocks_.back().second;
+    }
+
+    std::ifstream& in_;
+    std::uint64_t size_;
+    std::size_t block_bytes_;
+    // A handful of blocks per file at most; a list beats hashing here (and keeps references stable).
+    mutable std::list<std::pair<std::uint64_t, std::vector<std::uint8_t>>> blocks_;
+    mutable std::size_t bytes_read_ = 0;
+};
+
+class ByteReader {
+public:
+    ByteReader(const ByteSource& source, bool little_endian) : source_(source), little_endian_(little_endian) {}
+
+    bool contains(std::uint64_t offset, std::uint64_t length) const {
+        return offset <= source_.size() && length <= source_.size() - offset;
+    }
+
+    template <typename T>
+    bool read(std::uint64_t offset, T& value) const {
+        std::uint8_t bytes[sizeof(T)];
+        if (!contains(offset, sizeof(T)) || !source_.fetch(offset, sizeof(T), bytes)) {
+            return false;
+        }
+        value = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            const std::size_t shift = little_endian_ ? i : sizeof(T) - 1 - i;
+            value |= static_cast<T>(static_cast<T>(bytes[i]) << (8 * shift));
+        }
+        return true;
+    }
+
+private:
+    const ByteSource& source_;
+    bool little_endian_;
+};
+
+std::size_t fieldTypeSize(std::uint16_t type) {
+    switch (type) {
+        case 1:  // BYTE
+        case 2:  // ASCII
+        case 6:  // SBYTE
+        case 7:  // UNDEFINED
+            return 1;
+        case 3:  // SHORT
+        case 8:  // SSHORT
+            return 2;
+        case 4:   // LONG
+        case 9:   // SLONG
+        case 11:  // FLOAT
+        case 13:  // IFD
+            return 4;
+        case 16:  // LONG8
+        case 17:  // SLONG8
+        case 18:  // IFD8
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Reads an unsigned integer field (BYTE, SHORT, LONG, LONG8, IFD, IFD8) into 64-bit values.
+bool readUnsignedValues(const ByteReader& reader, bool big_tiff, std::uint16_t type, std::uint64_t count,
+                        std::uint64_t value_field, std::vector<std::uint64_t>& values) {
+    const std::size_t type_size = fieldTypeSize(type);
+    if (type_size == 0 || type == 2 || type == 6 || type == 8 || type == 9 || type == 11 || type == 17) {
+        return false;
+    }
+    const std::uint64_t inline_bytes = big_tiff ? 8 : 4;
+    if (count == 0 || !reader.contains(0, count) || !reader.contains(0, count * type_size)) {
+        return false;
+    }
+
+    std::uint64_t data_offset = value_field;
+    if (count * type_size > inline_bytes) {
+        if (big_tiff) {
+            if (!reader.read(value_field, data_offset)) {
+                return false;
+            }
+        } else {
+            std::uint32_t offset32 = 0;
+            if (!reader.read(value_field, offset32)) {
+                return false;
+            }
+            data_offset = offset32;
+        }
+    }
+    if (!reader.contains(data_offset, count * type_size)) {
+        return false;
+    }
+
+    values.resize(static_cast<std::size_t>(count));
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const std::uint64_t at = data_offset + i * type_size;
+        bool ok = true;
+        switch (type_size) {
+            case 1: {
+                std::uint8_t v = 0;
+                ok = reader.read(at, v);
+                values[i] = v;
+                break;
+            }
+            case 2: {
+                std::uint16_t v = 0;
+                ok = reader.read(at, v);
+                values[i] = v;
+                break;
+            }
+            case 4: {
+                std::uint32_t v = 0;
+                ok = reader.read(at, v);
+                values[i] = v;
+                break;
+            }
+            default:
+                ok = reader.read(at, values[i]);
+                break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseDirectory(const ByteReader& reader, bool big_tiff, std::uint64_t offset, TiffPageLayout& page,
+                    std::uint64_t& next_offset, std::string& error_message) {
+    std::uint64_t entry_count = 0;
+    std::uint64_t entries_begin = 0;
+    if (big_tiff) {
+        if (!reader.read(offset, entry_count)) {
+            error_message = "Truncated TIFF directory";
+            return false;
+        }
+        entries_begin = offset + 8;
+    } else {
+        std::uint16_t count16 = 0;
+        if (!reader.read(offset, count16)) {
+            error_message = "Truncated TIFF directory";
+            return false;
+        }
+        entry_count = count16;
+        entries_begin = offset + 2;
+    }
+
+    const std::uint64_t entry_size = big_tiff ? 20 : 12;
+    const std::uint64_t next_size = big_tiff ? 8 : 4;
+    if (!reader.contains(0, entry_count) || !reader.contains(entries_begin, entry_count * entry_size + next_size)) {
+        error_message = "Truncated TIFF directory";
+        return false;
+    }
+
+    std::vector<std::uint64_t> values;
+    for (std::uint64_t index = 0; index < entry_count; ++index) {
+        const std::uint64_t entry = entries_begin + index * entry_size;
+        std::uint16_t tag = 0;
+        std::uint16_t type = 0;
+        std::uint64_t count = 0;
+        reader.read(entry, tag);
+        reader.read(entry + 2, type);
+        if (big_tiff) {
+            reader.read(entry + 4, count);
+        } else {
+            std::uint32_t count32 = 0;
+            reader.read(entry + 4, count32);
+            count = count32;
+        }
+        const std::uint64_t value_field = entry + (big_tiff ? 12 : 8);
+
+        switch (tag) {
+            case kTagImageWidth:
+            case kTagImageLength:
+            case kTagBitsPerSample:
+            case kTagCompression:
+            case kTagPhotometric:
+            case kTagStripOffsets:
+            case kTagSamplesPerPixel:
+            case kTagRowsPerStrip:
+            case kTagStripByteCounts:
+            case kTagPlanarConfiguration:
+            case kTagSampleFormat:
+                break;
+            case kTagTileWidth:
+            case kTagTileOffsets:
+                page.tiled = true;
+                continue;
+            default:
+                continue;
+        }
+
+        if (!readUnsignedValues(reader, big_tiff, type, count, value_field, values)) {
+            error_message = "Invalid TIFF field (tag " + std::to_string(tag) + ")";
+            return false;
+        }
+        const std::uint64_t first = values.front();
+        switch (tag) {
+            case kTagImageWidth:
+                page.width = static_cast<std::uint32_t>(std::min<std::uint64_t>(first, std::numeric_limits<std::uint32_t>::max()));
+                break;
+            case kTagImageLength:
+                page.height = static_cast<std::uint32_t>(std::min<std::uint64_t>(first, std::numeric_limits<std::uint32_t>::max()));
+                break;
+            case kTagBitsPerSample:
+                page.bits_per_sample = static_cast<std::uint16_t>(first);
+                break;
+            case kTagCompression:
+                page.compression = static_cast<std::uint16_t>(first);
+                break;
+            case kTagPhotometric:
+                page.photometric = static_cast<std::uint16_t>(first);
+                break;
+            case kTagStripOffsets:
+                page.strip_offsets = values;
+                break;
+            case kTagSamplesPerPixel:
+                page.samples_per_pixel = static_cast<std::uint16_t>(first);
+                break;
+            case kTagRowsPerStrip:
+                page.rows_per_strip = static_cast<std::uint32_t>(std::min<std::uint64_t>(first, std::numeric_limits<std::uint32_t>::max()));
+                break;
+            case kTagStripByteCounts:
+                page.strip_byte_counts = values;
+                break;
+            case kTagPlanarConfiguration:
+                page.planar_configuration = static_cast<std::uint16_t>(first);
+                break;
+            case kTagSampleFormat:
+                page.sample_format = static_cast<std::uint16_t>(first);
+                break;
+            default:
+                break;
+        }
+    }
+
+    const std::uint64_t next_field = entries_begin + entry_count * entry_size;
+    if (big_tiff) {
+        reader.read(next_field, next_offset);
+    } else {
+        std::uint32_t next32 = 0;
+        reader.read(next_field, next32);
+        next_offset = next32;
+    }
+
+    if (page.width == 0 || page.height == 0) {
+        error_message = "TIFF page has no image dimensions";
+        return false;
+    }
+    if (page.tiled) {
+        return true;
+    }
+    if (page.rows_per_strip == 0 || page.rows_per_strip > page.height) {
+        page.rows_per_strip = page.height;
+    }
+    if (page.strip_offsets.empty()) {
+        error_message = "TIFF page has no StripOffsets";
+        return false;
+    }
+    if (page.strip_byte_counts.empty() && page.compression == 1 && page.strip_offsets.size() == 1) {
+        // Tolerated by libtiff for single-strip uncompressed images; the size follows from the dimensions.
+        page.strip_byte_counts.push_back(static_cast<std::uint64_t>(TiffFormat::rowBytes(page)) * page.height);
+    }
+    if (page.strip_byte_counts.size() != page.strip_offsets.size()) {
+        error_message = "TIFF StripOffsets and StripByteCounts disagree";
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+void appendValue(std::vector<std::uint8_t>& buffer, T value, bool big_endian) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        const std::size_t shift = big_endian ? sizeof(T) - 1 - i : i;
+        buffer.push_back(static_cast<std::uint8_t>((static_cast<std::uint64_t>(value) >> (8 * shift)) & 0xFFU));
+    }
+}
+
+// Writes one directory entry. Values that fit the entry's value field (4 bytes classic, 8 BigTIFF) are stored
+// inline and left-justified; `value` is otherwise the offset of the out-of-line array.
+void appendEntry(std::vector<std::uint8_t>& buffer, bool big_endian, bool big_tiff, std::uint16_t tag,
+                 std::uint16_t type, std::uint64_t count, std::uint64_t value) {
+    appendValue(buffer, tag, big_endian);
+    appendValue(buffer, type, big_endian);
+    if (big_tiff) {
+        appendValue(buffer, count, big_endian);
+    } else {
+        appendValue(buffer, static_cast<std::uint32_t>(count), big_endian);
+    }
+
+    const std::size_t field_bytes = big_tiff ? 8 : 4;
+    const std::size_t before = buffer.size();
+    if (count == 1 && type == kTypeShort) {
+        appendValue(buffer, static_cast<std::uint16_t>(value), big_endian);
+    } else if (count == 1 && type == kTypeLong) {
+        appendValue(buffer, static_cast<std::uint32_t>(value), big_endian);
+    } else if (big_tiff) {
+        appendValue(buffer, value, big_endian);
+    } else {
+        appendValue(buffer, static_cast<std::uint32_t>(value), big_endian);
+    }
+    buffer.resize(before + field_bytes, 0);
+}
+
+#ifdef DROPLET_WITH_TIFF
+bool decodeWithLibtiff(const std::string& path, const TiffPageLayout& page, cv::Mat& image, std::string& error_message) {
+    TIFF* tif = TIFFOpen(path.c_str(), "r");
+    if (tif == nullptr) {
+        error_message = "Cannot open file (corrupted or not a TIFF)";
+        return false;
+    }
+    // Jump straight to the page's directory instead of walking the chain with TIFFSetDirectory().
+    if (!TIFFSetSubDirectory(tif, static_cast<toff_t>(page.ifd_offset))) {
+        TIFFClose(tif);
+        error_message = "libtiff cannot read the page directory";
+        return false;
+    }
+
+    const std::size_t row_bytes = TiffFormat::rowBytes(page);
+    const tmsize_t strip_size = TIFFStripSize(tif);
+    const tstrip_t strips = TIFFNumberOfStrips(tif);
+    std::vector<std::uint8_t> buffer(static_cast<std::size_t>(std::max<tmsize_t>(strip_size, 0)));
+    image.create(static_cast<int>(page.height), static_cast<int>(page.width), TiffFormat::matType(page));
+
+    bool ok = true;
+    for (tstrip_t strip = 0; strip < strips; ++strip) {
+        const std::size_t first_row = static_cast<std::size_t>(strip) * page.rows_per_strip;
+        if (first_row >= page.height) {
+            break;
+        }
+        const std::size_t rows = std::min<std::size_t>(page.rows_per_strip, page.height - first_row);
+        const tmsize_t read = TIFFReadEncodedStrip(tif, strip, buffer.data(), strip_size);
+        if (read < 0 || static_cast<std::size_t>(read) < rows * row_bytes) {
+            error_message = "libtiff failed to decode strip " + std::to_string(strip);
+            ok = false;
+            break;
+        }
+        for (std::size_t row = 0; row < rows; ++row) {
+            std::memcpy(image.ptr(static_cast<int>(first_row + row)), buffer.data() + row * row_bytes, row_bytes);
+        }
+    }
+    TIFFClose(tif);
+    return ok;
+}
+#endif
+
+bool parseSource(const ByteSource& source, TiffFileLayout& layout, std::string& error_message, std::size_t max_pages) {
+    layout = TiffFileLayout{};
+    std::uint8_t mark[2] = {0, 0};
+    if (source.size() < 8 || !source.fetch(0, 2, mark)) {
+        error_message = "Cannot open file (corrupted or not a TIFF)";
+        return false;
+    }
+    if (mark[0] == 'I' && mark[1] == 'I') {
+        layout.little_endian = true;
+    } else if (mark[0] == 'M' && mark[1] == 'M') {
+        layout.little_endian = false;
+    } else {
+        error_message = "Cannot open file (corrupted or not a TIFF)";
+        return false;
+    }
+
+    const ByteReader reader(source, layout.little_endian);
+    std::uint16_t version = 0;
+    reader.read(2, version);
+    std::uint64_t offset = 0;
+    if (version == 42) {
+        std::uint32_t offset32 = 0;
+        reader.read(4, offset32);
+        offset = offset32;
+    } else if (version == 43) {
+        std::uint16_t offset_size = 0;
+        std::uint16_t reserved = 0;
+        reader.read(4, offset_size);
+        reader.read(6, reserved);
+        if (offset_size != 8 || reserved != 0 || !reader.read(8, offset)) {
+            error_message = "Cannot open file (corrupted or not a TIFF)";
+            return false;
+        }
+        layout.big_tiff = true;
+    } else {
+        error_message = "Cannot open file (corrupted or not a TIFF)";
+        return false;
+    }
+
+    std::vector<std::uint64_t> visited;
+    while (offset != 0 && (max_pages == 0 || layout.pages.size() < max_pages)) {
+        const auto it = std::lower_bound(visited.begin(), visited.end(), offset);
+        if (it != visited.end() && *it == offset) {
+            error_message = "TIFF directory chain loops back on itself";
+            return false;
+        }
+        visited.insert(it, offset);
+
+        TiffPageLayout page;
+        page.ifd_offset = offset;
+        std::uint64_t next_offset = 0;
+        if (!parseDirectory(reader, layout.big_tiff, offset, page, next_offset, error_message)) {
+            error_message += " (page " + std::to_string(layout.pages.size()) + ")";
+            return false;
+        }
+        layout.pages.push_back(std::move(page));
+        offset = next_offset;
+    }
+
+    if (layout.pages.empty()) {
+        error_message = "TIFF file contains no pages";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+namespace TiffFormat {
+
+bool parse(std::span<const std::uint8_t> file, TiffFileLayout& layout, std::string& error_message,
+           std::size_t max_pages) {
+    return parseSource(SpanSource(file), layout, error_message, max_pages);
+}
+
+bool parseFile(const std::filesystem::path& path, TiffFileLayout& layout, std::string& error_message,
+               std::size_t max_pages, std::size_t* bytes_read) {
+    if (bytes_read != nullptr) {
+        *bytes_read = 0;
+    }
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    if (ec || !in) {
+        layout = TiffFileLayout{};
+        error_message = "Cannot open file: " + path.string();
+        return false;
+    }
+    const FileBlockSource source(in, static_cast<std::uint64_t>(size), kHeaderBlockBytes);
+    const bool ok = parseSource(source, layout, error_message, max_pages);
+    if (bytes_read != nullptr) {
+        *bytes_read = source.bytesRead();
+    }
+    return ok;
+}
+
+bool validatePage(const TiffFileLayout& layout, const TiffPageLayout& page, std::string& error_message,
+                  bool allow_big_tiff) {
+    if (layout.big_tiff && !allow_big_tiff) {
+        error_message = "BigTIFF not supported in v1.0.0 (file >4 GB). Split into smaller files.";
+        return false;
+    }
+    if (page.tiled) {
+        error_message = "Tiled TIFF not supported (must be strip-based). Convert in ImageJ or FIJI.";
+        return false;
+    }
+    if (page.samples_per_pixel != 1 || page.photometric != 1) {
+        error_message = "Unsupported color space (must be grayscale). Convert to grayscale in ImageJ.";
+        return false;
+    }
+    if ((page.bits_per_sample != 8 && page.bits_per_sample != 16) || page.sample_format != 1) {
+        error_message = "Unsupported bit depth (must be 8-bit or 16-bit grayscale)";
+        return false;
+    }
+    if (page.width > kMaxDimension || page.height > kMaxDimension) {
+        error_message = "Image too large (max 8192×8192 px)";
+        return false;
+    }
+    return true;
+}
+
+bool canDecode(const TiffPageLayout& page, std::string& error_message) {
+#ifdef DROPLET_WITH_TIFF
+    (void)page;
+    (void)error_message;
+    return true;
+#else
+    if (page.compression != 1) {
+        error_message = "Unsupported compression (must be uncompressed). Use ImageJ: Image → Type → 8-bit, File → Save As → TIFF";
+        return false;
+    }
+    return true;
+#endif
+}
+
+int matType(const TiffPageLayout& page) {
+    return page.bits_per_sample == 8 ? CV_8UC1 : CV_16UC1;
+}
+
+std::size_t rowBytes(const TiffPageLayout& page) {
+    return static_cast<std::size_t>(page.width) * page.samples_per_pixel * ((page.bits_per_sample + 7U) / 8U);
+}
+
+std::optional<std::uint64_t> contiguousPixelOffset(const TiffPageLayout& page, std::uint64_t file_size) {
+    if (page.compression != 1 || page.tiled || page.samples_per_pixel != 1 || page.strip_offsets.empty() ||
+        page.rows_per_strip == 0) {
+        return std::nullopt;
+    }
+    const std::uint64_t row_bytes = rowBytes(page);
+    const std::uint64_t strips = (static_cast<std::uint64_t>(page.height) + page.rows_per_strip - 1) / page.rows_per_strip;
+    if (page.strip_offsets.size() < strips || page.strip_byte_counts.size() < strips) {
+        return std::nullopt;
+    }
+
+    const std::uint64_t base = page.strip_offsets.front();
+    const std::uint64_t strip_bytes = row_bytes * page.rows_per_strip;
+    for (std::uint64_t k = 0; k < strips; ++k) {
+        const std::uint64_t rows = std::min<std::uint64_t>(page.rows_per_strip, page.height - k * page.rows_per_strip);
+        if (page.strip_offsets[k] != base + k * strip_bytes || page.strip_byte_counts[k] < rows * row_bytes) {
+            return std::nullopt;
+        }
+    }
+    const std::uint64_t image_bytes = row_bytes * page.height;
+    if (base > file_size || image_bytes > file_size - base) {
+        return std::nullopt;
+    }
+    return base;
+}
+
+std::optional<std::uint64_t> nativePixelOffset(const TiffPageLayout& page, bool little_endian,
+                                               std::uint64_t file_size) {
+    const bool native_order = page.bits_per_sample == 8 || little_endian == kHostLittleEndian;
+    return native_order ? contiguousPixelOffset(page, file_size) : std::nullopt;
+}
+
+bool decodeUncompressed(std::span<const std::uint8_t> file, bool little_endian, const TiffPageLayout& page,
+                        cv::Mat& image, std::string& error_message) {
+    if (page.compression != 1 || page.tiled || page.samples_per_pixel != 1 ||
+        (page.bits_per_sample != 8 && page.bits_per_sample != 16) || page.rows_per_strip == 0) {
+        error_message = "TIFF page layout cannot be decoded without libtiff";
+        return false;
+    }
+
+    const std::size_t row_bytes = rowBytes(page);
+    const std::size_t strips = (static_cast<std::size_t>(page.height) + page.rows_per_strip - 1) / page.rows_per_strip;
+    if (page.strip_offsets.size() < strips) {
+        error_message = "TIFF page has fewer strips than its height requires";
+        return false;
+    }
+
+    image.create(static_cast<int>(page.height), static_cast<int>(page.width), matType(page));
+    for (std::size_t k = 0; k < strips; ++k) {
+        const std::size_t first_row = k * page.rows_per_strip;
+        const std::size_t rows = std::min<std::size_t>(page.rows_per_strip, page.height - first_row);
+        const std::uint64_t offset = page.strip_offsets[k];
+        const std::uint64_t bytes = static_cast<std::uint64_t>(rows) * row_bytes;
+        if (offset > file.size() || bytes > file.size() - offset) {
+            error_message = "TIFF strip " + std::to_string(k) + " extends past the end of the file";
+            return false;
+        }
+        for (std::size_t row = 0; row < rows; ++row) {
+            std::memcpy(image.ptr(static_cast<int>(first_row + row)), file.data() + offset + row * row_bytes, row_bytes);
+        }
+    }
+
+    if (page.bits_per_sample == 16 && little_endian != kHostLittleEndian) {
+        for (int y = 0; y < image.rows; ++y) {
+            auto* row = image.ptr<std::uint16_t>(y);
+            for (int x = 0; x < image.cols; ++x) {
+                row[x] = static_cast<std::uint16_t>((row[x] >> 8) | (row[x] << 8));
+            }
+        }
+    }
+    return true;
+}
+
+bool readPage(const MappedFile& file, const std::string& path, bool little_endian, const TiffPageLayout& page,
+              cv::Mat& image, TiffReadPath& read_path, std::string& error_message) {
+    if (page.compression == 1) {
+        const auto offset = nativePixelOffset(page, little_endian, file.size());
+        if (offset && *offset % (page.bits_per_sample / 8U) == 0) {
+            image = file.matView(static_cast<std::size_t>(*offset), static_cast<int>(page.height),
+                                 static_cast<int>(page.width), matType(page), rowBytes(page));
+            read_path = TiffReadPath::ZeroCopy;
+            return true;
+        }
+        read_path = TiffReadPath::Decoded;
+        return decodeUncompressed(file.bytes(), little_endian, page, image, error_message);
+    }
+
+#ifdef DROPLET_WITH_TIFF
+    read_path = TiffReadPath::Libtiff;
+    return decodeWithLibtiff(path, page, image, error_message);
+#else
+    (void)path;
+    error_message = "Compressed TIFF requires libtiff support";
+    return false;
+#endif
+}
+
+bool readPageCopy(const std::string& path, bool little_endian, const TiffPageLayout& page, cv::Mat& image,
+                  std::string& error_message) {
+    if (page.compression != 1) {
+#ifdef DROPLET_WITH_TIFF
+        return decodeWithLibtiff(path, page, image, error_message);
+#else
+        error_message = "Compressed TIFF requires libtiff support";
+        return false;
+#endif
+    }
+    if (page.rows_per_strip == 0) {
+        return decodeUncompressed({}, little_endian, page, image, error_message);
+    }
+
+    // Only the prefix of the file that holds the strips is read.
+    const std::uint64_t row_bytes = rowBytes(page);
+    std::uint64_t end = 0;
+    for (std::size_t k = 0; k < page.strip_offsets.size(); ++k) {
+        const std::uint64_t first_row = static_cast<std::uint64_t>(k) * page.rows_per_strip;
+        if (first_row >= page.height) {
+            break;
+        }
+        const std::uint64_t rows = std::min<std::uint64_t>(page.rows_per_strip, page.height - first_row);
+        end = std::max(end, page.strip_offsets[k] + rows * row_bytes);
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error_message = "Cannot open file";
+        return false;
+    }
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(end));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    // A file truncated since it was parsed comes back short, and decoding reports the strip that is missing.
+    bytes.resize(static_cast<std::size_t>(in.gcount()));
+    return decodeUncompressed(bytes, little_endian, page, image, error_message);
+}
+
+void putPage(SidecarWriter& writer, const TiffPageLayout& page) {
+    writer.put(page.ifd_offset);
+    writer.put(page.width);
+    writer.put(page.height);
+    writer.put(page.bits_per_sample);
+    writer.put(page.samples_per_pixel);
+    writer.put(page.compression);
+    writer.put(page.photometric);
+    writer.put(page.planar_configuration);
+    writer.put(page.sample_format);
+    writer.put(page.rows_per_strip);
+    writer.put(static_cast<std::uint64_t>(page.strip_offsets.size()));
+    for (const auto offset : page.strip_offsets) {
+        writer.put(offset);
+    }
+    for (const auto count : page.strip_byte_counts) {
+        writer.put(count);
+    }
+}
+
+bool getPage(SidecarReader& reader, TiffPageLayout& page) {
+    std::uint64_t strips = 0;
+    if (!reader.get(page.ifd_offset) || !reader.get(page.width) || !reader.get(page.height) ||
+        !reader.get(page.bits_per_sample) || !reader.get(page.samples_per_pixel) || !reader.get(page.compression) ||
+        !reader.get(page.photometric) || !reader.get(page.planar_configuration) || !reader.get(page.sample_format) ||
+        !reader.get(page.rows_per_strip) || !reader.get(strips) || strips == 0 ||
+        strips > reader.remaining() / kIndexBytesPerStrip) {
+        return false;
+    }
+    page.tiled = false;
+    page.strip_offsets.resize(static_cast<std::size_t>(strips));
+    page.strip_byte_counts.resize(static_cast<std::size_t>(strips));
+    for (auto& offset : page.strip_offsets) {
+        reader.get(offset);
+    }
+    for (auto& count : page.strip_byte_counts) {
+        reader.get(count);
+    }
+    return true;
+}
+
+bool writeGrayscale(const std::filesystem::path& path, const cv::Mat& image, std::string& error_message,
+                    const TiffWriteOptions& options) {
+    return writeGrayscalePages(path, std::span<const cv::Mat>(&image, 1), error_message, options);
+}
+
+bool writeGrayscalePages(const std::filesystem::path& path, std::span<const cv::Mat> pages, std::string& error_message,
+                         const TiffWriteOptions& options) {
+    if (pages.empty()) {
+        error_message = "No pages to write";
+        return false;
+    }
+    for (const auto& image : pages) {
+        if (image.empty() || (image.type() != CV_8UC1 && image.type() != CV_16UC1)) {
+            error_message = "Only non-empty CV_8UC1/CV_16UC1 images can be written as grayscale TIFF";
+            return false;
+        }
+    }
+
+    const bool big_endian = options.big_endian;
+    const bool big_tiff = options.big_tiff;
+    constexpr std::uint16_t kEntries = 10;
+    const std::uint64_t header_bytes = big_tiff ? 16 : 8;
+    const std::uint64_t ifd_bytes = big_tiff ? 8 + kEntries * 20 + 8 : 2 + kEntries * 12 + 4;
+    const std::uint64_t array_value_bytes = big_tiff ? 8 : 4;
+    const std::uint16_t array_type = big_tiff ? 16 : kTypeLong;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error_message = "Cannot create file: " + path.string();
+        return false;
+    }
+
+    // Each page is written as: directory, strip offset/count arrays, padding, pixel rows. The next page's
+    // directory follows the previous page's pixels, so every offset is known before its page is written.
+    std::vector<std::uint8_t> block;
+    block.push_back(big_endian ? 'M' : 'I');
+    block.push_back(big_endian ? 'M' : 'I');
+    appendValue(block, static_cast<std::uint16_t>(big_tiff ? 43 : 42), big_endian);
+    if (big_tiff) {
+        appendValue(block, static_cast<std::uint16_t>(8), big_endian);
+        appendValue(block, static_cast<std::uint16_t>(0), big_endian);
+        appendValue(block, header_bytes, big_endian);
+    } else {
+        appendValue(block, static_cast<std::uint32_t>(header_bytes), big_endian);
+    }
+
+    std::uint64_t position = header_bytes;
+    std::vector<std::uint8_t> swapped;
+    for (std::size_t index = 0; index < pages.size(); ++index) {
+        const cv::Mat& image = pages[index];
+        const auto width = static_cast<std::uint32_t>(image.cols);
+        const auto height = static_cast<std::uint32_t>(image.rows);
+        const std::uint16_t bits = image.depth() == CV_8U ? 8 : 16;
+        const std::size_t row_bytes = static_cast<std::size_t>(image.cols) * image.elemSize();
+        const std::uint32_t rows_per_strip =
+            options.rows_per_strip == 0 ? height : std::min(options.rows_per_strip, height);
+        const std::uint32_t strips = (height + rows_per_strip - 1) / rows_per_strip;
+
+        const std::uint64_t ifd_offset = position;
+        const std::uint64_t arrays_offset = ifd_offset + ifd_bytes;
+        const std::uint64_t arrays_bytes = strips > 1 ? 2 * array_value_bytes * strips : 0;
+        // Pixel data starts on a 16-byte boundary so zero-copy readers get aligned rows.
+        const std::uint64_t pixel_offset = (arrays_offset + arrays_bytes + 15U) & ~std::uint64_t{15};
+        const std::uint64_t page_end = pixel_offset + static_cast<std::uint64_t>(row_bytes) * height;
+        if (!big_tiff && page_end > std::numeric_limits<std::uint32_t>::max()) {
+            error_message = "Image data too large for a classic TIFF (use BigTIFF)";
+            return false;
+        }
+        const bool last = index + 1 == pages.size();
+        const std::uint64_t next_ifd = last ? 0 : (page_end + 15U) & ~std::uint64_t{15};
+
+        std::vector<std::uint64_t> offsets(strips);
+        std::vector<std::uint64_t> counts(strips);
+        for (std::uint32_t k = 0; k < strips; ++k) {
+            const std::uint32_t rows = std::min(rows_per_strip, height - k * rows_per_strip);
+            offsets[k] = pixel_offset + static_cast<std::uint64_t>(k) * rows_per_strip * row_bytes;
+            counts[k] = static_cast<std::uint64_t>(rows) * row_bytes;
+        }
+
+        if (big_tiff) {
+            appendValue(block, static_cast<std::uint64_t>(kEntries), big_endian);
+        } else {
+            appendValue(block, kEntries, big_endian);
+        }
+        appendEntry(block, big_endian, big_tiff, kTagImageWidth, kTypeLong, 1, width);
+        appendEntry(block, big_endian, big_tiff, kTagImageLength, kTypeLong, 1, height);
+        appendEntry(block, big_endian, big_tiff, kTagBitsPerSample, kTypeShort, 1, bits);
+        appendEntry(block, big_endian, big_tiff, kTagCompression, kTypeShort, 1, 1);
+        appendEntry(block, big_endian, big_tiff, kTagPhotometric, kTypeShort, 1, 1);
+        appendEntry(block, big_endian, big_tiff, kTagStripOffsets, array_type, strips,
+                    strips > 1 ? arrays_offset : offsets[0]);
+        appendEntry(block, big_endian, big_tiff, kTagSamplesPerPixel, kTypeShort, 1, 1);
+        appendEntry(block, big_endian, big_tiff, kTagRowsPerStrip, kTypeLong, 1, rows_per_strip);
+        appendEntry(block, big_endian, big_tiff, kTagStripByteCounts, array_type, strips,
+                    strips > 1 ? arrays_offset + array_value_bytes * strips : counts[0]);
+        appendEntry(block, big_endian, big_tiff, kTagPlanarConfiguration, kTypeShort, 1, 1);
+        if (big_tiff) {
+            appendValue(block, next_ifd, big_endian);
+        } else {
+            appendValue(block, static_cast<std::uint32_t>(next_ifd), big_endian);
+        }
+        if (strips > 1) {
+            for (const auto* values : {&offsets, &counts}) {
+                for (const auto value : *values) {
+                    if (big_tiff) {
+                        appendValue(block, value, big_endian);
+                    } else {
+                        appendValue(block, static_cast<std::uint32_t>(value), big_endian);
+                    }
+                }
+            }
+        }
+        block.resize(static_cast<std::size_t>(block.size() + (pixel_offset - arrays_offset - arrays_bytes)), 0);
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+        block.clear();
+
+        const bool swap = bits == 16 && big_endian == kHostLittleEndian;
+        swapped.resize(swap ? row_bytes : 0);
+        for (int y = 0; y < image.rows; ++y) {
+            const std::uint8_t* row = image.ptr(y);
+            if (swap) {
+                for (std::size_t i = 0; i + 1 < row_bytes; i += 2) {
+                    swapped[i] = row[i + 1];
+                    swapped[i + 1] = row[i];
+                }
+                row = swapped.data();
+            }
+            out.write(reinterpret_cast<const char*>(row), static_cast<std::streamsize>(row_bytes));
+        }
+        if (!last) {
+            block.resize(static_cast<std::size_t>(next_ifd - page_end), 0);
+        }
+        position = next_ifd;
+    }
+
+    if (!out) {
+        error_message = "Failed to write file: " + path.string();
+        return false;
+    }
+    return true;
+}
+
+} // namespace TiffFormat
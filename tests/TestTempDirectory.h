@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+// Fresh directory under the system temp directory, removed with its contents on destruction. A random suffix is
+// appended to `name`, so parallel test runs (ctest -j, several build trees) never share or delete each other's files.
+class TestTempDirectory {
+public:
+    explicit TestTempDirectory(const std::string& name) {
+        std::random_device random;
+        const auto base = std::filesystem::temp_directory_path();
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            char suffix[20];
+            std::snprintf(suffix, sizeof(suffix), "_%08x%08x", random(), random());
+            path_ = base / (name + suffix);
+            std::error_code ec;
+            // False when the directory already exists: another run picked the same suffix.
+            if (std::filesystem::create_directory(path_, ec)) {
+                return;
+            }
+        }
+        throw std::runtime_error("cannot create a temporary directory for " + name);
+    }
+    ~TestTempDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+    TestTempDirectory(const TestTempDirectory&) = delete;
+    TestTempDirectory& operator=(const TestTempDirectory&) = delete;
+
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
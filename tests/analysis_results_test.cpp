@@ -2,92 +2,126 @@
 
 #include <gtest/gtest.h>
 
-#if __has_include("DataModels.h")
 #include "DataModels.h"
-#endif
 
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace {
-#if __has_include("DataModels.h")
-using FrameDetectionsTestType = FrameDetections;
-using TrackTestType = Track;
-#else
-struct FrameDetectionsTestType {
-    int frame_index = 0;
-};
-
-struct TrackTestType {
-    int track_id = 0;
-};
-#endif
-
-template <typename Frame>
-static void set_frame_index(Frame& frame, int value) {
-    if constexpr (requires(Frame& f) { f.frame_index_logical = static_cast<std::size_t>(0); }) {
-        frame.frame_index_logical = static_cast<std::size_t>(value);
-    } else if constexpr (requires(Frame& f) { f.frame_index = 0; }) {
-        frame.frame_index = value;
-    }
-}
-
-template <typename Frame>
-static int get_frame_index(const Frame& frame) {
-    if constexpr (requires(const Frame& f) { static_cast<int>(f.frame_index_logical); }) {
-        return static_cast<int>(frame.frame_index_logical);
-    } else if constexpr (requires(const Frame& f) { f.frame_index; }) {
-        return frame.frame_index;
-    } else {
-        return 0;
-    }
-}
+using ScaleKey = ResultKey<double, "scale_um_per_px">;
 
-template <typename Track>
-static void set_track_id(Track& track, int value) {
-    if constexpr (requires(Track& t) { t.track_id = static_cast<std::size_t>(0); }) {
-        track.track_id = static_cast<std::size_t>(value);
-    } else if constexpr (requires(Track& t) { t.track_id = 0; }) {
-        track.track_id = value;
-    }
-}
+template <typename Key, typename Value>
+concept CanSetFromLvalue = requires(AnalysisResults& results, Value& value) { results.set<Key>(value); };
 
-template <typename Track>
-static int get_track_id(const Track& track) {
-    if constexpr (requires(const Track& t) { static_cast<int>(t.track_id); }) {
-        return static_cast<int>(track.track_id);
-    } else if constexpr (requires(const Track& t) { t.track_id; }) {
-        return track.track_id;
-    } else {
-        return 0;
-    }
-}
+static_assert(!CanSetFromLvalue<FrameDetectionsKey, std::vector<FrameDetections>>);
+static_assert(FrameDetectionsKey::name() == "frame_detections");
+static_assert(TracksKey::name() == "tracks");
 }  // namespace
 
 TEST(AnalysisResultsTests, StoresAndRetrievesTypedValuesByKey) {
     AnalysisResults results;
 
-    std::vector<FrameDetectionsTestType> frames(2);
-    set_frame_index(frames[0], 1);
-    set_frame_index(frames[1], 2);
+    std::vector<FrameDetections> frames(2);
+    frames[0].frame_index_logical = 1;
+    frames[1].frame_index_logical = 2;
 
-    std::vector<TrackTestType> tracks(1);
-    set_track_id(tracks[0], 42);
+    std::vector<Track> tracks(1);
+    tracks[0].track_id = 42;
 
-    results.set("frame_detections", frames);
-    results.set("tracks", tracks);
+    results.set<FrameDetectionsKey>(std::move(frames));
+    results.set<TracksKey>(std::move(tracks));
 
+    ASSERT_TRUE(results.has<FrameDetectionsKey>());
+    ASSERT_TRUE(results.has<TracksKey>());
     ASSERT_TRUE(results.has("frame_detections"));
-    ASSERT_TRUE(results.has("tracks"));
+    EXPECT_FALSE(results.has<ScaleKey>());
 
-    const auto& stored_frames =
-        results.get<std::vector<FrameDetectionsTestType>>("frame_detections");
-    const auto& stored_tracks = results.get<std::vector<TrackTestType>>("tracks");
+    const auto& stored_frames = results.get<FrameDetectionsKey>();
+    const auto& stored_tracks = results.get<TracksKey>();
 
     ASSERT_EQ(stored_frames.size(), 2u);
-    EXPECT_EQ(get_frame_index(stored_frames[0]), 1);
-    EXPECT_EQ(get_frame_index(stored_frames[1]), 2);
+    EXPECT_EQ(stored_frames[0].frame_index_logical, 1u);
+    EXPECT_EQ(stored_frames[1].frame_index_logical, 2u);
 
     ASSERT_EQ(stored_tracks.size(), 1u);
-    EXPECT_EQ(get_track_id(stored_tracks[0]), 42);
+    EXPECT_EQ(stored_tracks[0].track_id, 42u);
+
+    EXPECT_THROW((void)results.get<ScaleKey>(), std::out_of_range);
+}
+
+TEST(AnalysisResultsTests, SharedViewsOutliveResultsWithoutCopying) {
+    std::vector<FrameDetections> frames(3);
+    const auto* original_data = frames.data();
+
+    std::shared_ptr<const std::vector<FrameDetections>> view;
+    {
+        AnalysisResults results;
+        results.set<FrameDetectionsKey>(std::move(frames));
+
+        const AnalysisResults copy = results;
+        EXPECT_EQ(&copy.get<FrameDetectionsKey>(), &results.get<FrameDetectionsKey>());
+
+        view = results.share<FrameDetectionsKey>();
+    }
+
+    ASSERT_NE(view, nullptr);
+    EXPECT_EQ(view->size(), 3u);
+    EXPECT_EQ(view->data(), original_data);
+}
+
+TEST(AnalysisResultsTests, ReportsBytesPerEntry) {
+    AnalysisResults results;
+
+    std::vector<FrameDetections> frames(4);
+    for (auto& frame : frames) {
+        frame.detections.resize(10);
+        for (auto& detection : frame.detections) {
+            detection.contour.resize(100);
+        }
+    }
+    const auto expected_frame_bytes = approximateMemoryBytes(frames);
+
+    results.set<FrameDetectionsKey>(std::move(frames));
+    results.set<ScaleKey>(0.58);
+
+    const auto report = results.memoryReport();
+    ASSERT_EQ(report.size(), 2u);
+
+    std::size_t frame_bytes = 0;
+    for (const auto& entry : report) {
+        if (entry.name == "frame_detections") {
+            frame_bytes = entry.bytes;
+        }
+    }
+    EXPECT_EQ(frame_bytes, expected_frame_bytes);
+    EXPECT_GE(frame_bytes, 40u * 100u * sizeof(cv::Point));
+    EXPECT_EQ(results.totalBytes(), expected_frame_bytes + sizeof(double));
+
+    results.erase<FrameDetectionsKey>();
+    EXPECT_FALSE(results.has<FrameDetectionsKey>());
+    EXPECT_EQ(results.totalBytes(), sizeof(double));
+}
+
+TEST(AnalysisResultsTests, ChargesStoredValuesToTheMemoryGovernorUntilTheLastViewIsGone) {
+    MemoryGovernor& governor = MemoryGovernor::global();
+    const std::size_t before = governor.currentBytes(MemoryCategory::Results);
+
+    std::vector<FrameDetections> frames(2);
+    frames[0].detections.resize(50);
+    const auto bytes = approximateMemoryBytes(frames);
+
+    std::shared_ptr<const std::vector<FrameDetections>> view;
+    {
+        AnalysisResults results;
+        results.set<FrameDetectionsKey>(std::move(frames));
+        const AnalysisResults copy = results;
+        EXPECT_EQ(governor.currentBytes(MemoryCategory::Results), before + bytes);
+        view = copy.share<FrameDetectionsKey>();
+    }
+    EXPECT_EQ(governor.currentBytes(MemoryCategory::Results), before + bytes);
+
+    view.reset();
+    EXPECT_EQ(governor.currentBytes(MemoryCategory::Results), before);
 }
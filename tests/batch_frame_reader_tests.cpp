@@ -0,0 +1,186 @@
+#include "BatchFrameReader.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ImageSequenceSource.h"
+#include "MultiPageTIFFSource.h"
+#include "TestTempDirectory.h"
+
+namespace {
+std::uint8_t patternAt(std::uint64_t offset) {
+    return static_cast<std::uint8_t>((offset * 7 + offset / 251) & 0xFFU);
+}
+
+std::string writePattern(const std::filesystem::path& path, std::size_t size) {
+    std::vector<char> bytes(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        bytes[i] = static_cast<char>(patternAt(i));
+    }
+    std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return path.string();
+}
+
+cv::Mat makeFrame(int value) {
+    cv::Mat image(30, 50, CV_16UC1);
+    for (int y = 0; y < image.rows; ++y) {
+        for (int x = 0; x < image.cols; ++x) {
+            image.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(value * 1000 + y * 50 + x);
+        }
+    }
+    return image;
+}
+
+bool samePixels(const cv::Mat& left, const cv::Mat& right) {
+    if (left.size() != right.size() || left.type() != right.type()) {
+        return false;
+    }
+    for (int y = 0; y < left.rows; ++y) {
+        if (std::memcmp(left.ptr(y), right.ptr(y), static_cast<std::size_t>(left.cols) * left.elemSize()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<BatchReadParams> allBackends() {
+    std::vector<BatchReadParams> variants;
+    for (const bool io_uring : {true, false}) {
+        for (const bool direct : {false, true}) {
+            BatchReadParams params;
+            params.use_io_uring = io_uring;
+            params.direct_io = direct;
+            params.queue_depth = 4;
+            variants.push_back(params);
+        }
+    }
+    return variants;
+}
+} // namespace
+
+TEST(BatchFrameReader, ReadsEveryRangeOnEitherBackend) {
+    TestTempDirectory dir("droplet_batch_reader_ranges");
+    const std::string first = writePattern(dir.path() / "a.bin", 300000);
+    const std::string second = writePattern(dir.path() / "b.bin", 70001);
+
+    for (const auto& params : allBackends()) {
+        BatchFrameReader reader(params);
+        if (!params.use_io_uring) {
+            EXPECT_EQ(reader.backend(), BatchReadBackend::ThreadPool);
+        } else {
+            EXPECT_EQ(reader.backend() == BatchReadBackend::IoUring, reader.fallbackReason().empty());
+        }
+        // More requests than the queue depth, unaligned offsets, a read ending exactly at EOF.
+        std::vector<PreparedFrameRead> reads;
+        for (std::uint64_t i = 0; i < 10; ++i) {
+            reads.push_back(reader.prepareFrame(first, 1000 + i * 20011, 20, 100, CV_8UC1, 100));
+        }
+        reads.push_back(reader.prepareFrame(second, 70001 - 3000, 30, 100, CV_8UC1, 100));
+
+        std::vector<BatchReadRequest> requests;
+        for (const auto& read : reads) {
+            requests.push_back(read.request);
+            if (params.direct_io) {
+                EXPECT_EQ(read.request.offset % BatchFrameReader::kDirectIoAlignment, 0U);
+                EXPECT_EQ(reinterpret_cast<std::uintptr_t>(read.request.destination) %
+                              BatchFrameReader::kDirectIoAlignment, 0U);
+            }
+        }
+        std::string error;
+        ASSERT_TRUE(reader.read(requests, error)) << error << " (" << reader.fallbackReason() << ")";
+
+        for (std::size_t i = 0; i < reads.size(); ++i) {
+            const std::uint64_t base = i < 10 ? 1000 + i * 20011 : 70001 - 3000;
+            const cv::Mat& frame = reads[i].frame;
+            bool matches = true;
+            for (int y = 0; y < frame.rows; ++y) {
+                for (int x = 0; x < frame.cols; ++x) {
+                    matches = matches && frame.at<std::uint8_t>(y, x) == patternAt(base + y * 100 + x);
+                }
+            }
+            EXPECT_TRUE(matches) << "request " << i << ", io_uring " << params.use_io_uring << ", direct "
+                                 << params.direct_io;
+        }
+        EXPECT_EQ(reader.stats().requests, reads.size());
+        EXPECT_GT(reader.stats().system_calls, 0U);
+    }
+}
+
+TEST(BatchFrameReader, ReportsMissingFilesAndShortReads) {
+    TestTempDirectory dir("droplet_batch_reader_errors");
+    const std::string path = writePattern(dir.path() / "short.bin", 5000);
+    for (const auto& params : allBackends()) {
+        BatchFrameReader reader(params);
+        std::string error;
+
+        const PreparedFrameRead past_end = reader.prepareFrame(path, 4000, 20, 100, CV_8UC1, 100);
+        EXPECT_FALSE(reader.read(std::span(&past_end.request, 1), error));
+        EXPECT_NE(error.find("Unexpected end of file"), std::string::npos) << error;
+
+        BatchReadRequest missing = past_end.request;
+        missing.path = (dir.path() / "missing.bin").string();
+        EXPECT_FALSE(reader.read(std::span(&missing, 1), error));
+        EXPECT_NE(error.find("Cannot open file"), std::string::npos) << error;
+
+        // The reader stays usable after a failed batch.
+        const PreparedFrameRead fits = reader.prepareFrame(path, 100, 10, 100, CV_8UC1, 100);
+        EXPECT_TRUE(reader.read(std::span(&fits.request, 1), error)) << error;
+        EXPECT_EQ(fits.frame.at<std::uint8_t>(9, 99), patternAt(100 + 999));
+    }
+}
+
+TEST(BatchFrameReader, SourcesReadBatchesThatMatchGetFrame) {
+    TestTempDirectory dir("droplet_batch_reader_sources");
+    std::vector<cv::Mat> pages;
+    for (int i = 0; i < 12; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        TiffWriteOptions options;
+        options.big_endian = i == 4;  // byte-swapped: decoded through getFrame()
+        std::string error;
+        ASSERT_TRUE(TiffFormat::writeGrayscale(dir.path() / name, makeFrame(i), error, options)) << error;
+        pages.push_back(makeFrame(i));
+    }
+    std::filesystem::create_directories(dir.path() / "stacks");
+    const auto stack = dir.path() / "stacks" / "stack.tiff";
+    {
+        std::string error;
+        ASSERT_TRUE(TiffFormat::writeGrayscalePages(stack, std::span(pages).first(5), error)) << error;
+    }
+
+    for (const auto& params : allBackends()) {
+        BatchFrameReader reader(params);
+        ImageSequenceSource sequence(dir.path().string(), 10.0);
+        std::string error;
+        ASSERT_TRUE(sequence.load(error)) << error;
+        ASSERT_EQ(sequence.getTotalFrames(), 12U);
+        const std::vector<std::size_t> indices = {11, 0, 4, 5, 6, 7, 8, 9, 10};
+        const std::vector<cv::Mat> frames = sequence.readFrames(indices, reader);
+        ASSERT_EQ(frames.size(), indices.size());
+        for (std::size_t k = 0; k < indices.size(); ++k) {
+            EXPECT_TRUE(samePixels(frames[k], pages[indices[k]])) << "frame " << indices[k];
+        }
+        EXPECT_EQ(sequence.readStats().batched_frames, 8U);
+        EXPECT_EQ(sequence.readStats().decoded_frames, 1U);
+        const std::vector<std::size_t> out_of_range = {12};
+        EXPECT_THROW(sequence.readFrames(out_of_range, reader), std::out_of_range);
+
+        MultiPageTIFFSource multipage(stack.string());
+        ASSERT_TRUE(multipage.load(error)) << error;
+        const std::vector<std::size_t> page_indices = {4, 2, 0};
+        const std::vector<cv::Mat> stack_frames = multipage.readFrames(page_indices, reader);
+        for (std::size_t k = 0; k < page_indices.size(); ++k) {
+            EXPECT_TRUE(samePixels(stack_frames[k], pages[page_indices[k]])) << "page " << page_indices[k];
+        }
+        EXPECT_EQ(multipage.readStats().batched_frames, 3U);
+    }
+}
@@ -0,0 +1,129 @@
+#include "CompactContour.h"
+
+#include "DataModels.h"
+#include "DropletDetection.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/imgproc.hpp>
+
+namespace {
+cv::Mat makeSyntheticCircles() {
+    cv::Mat image(200, 200, CV_8U, cv::Scalar(200));
+    cv::circle(image, cv::Point(40, 40), 20, cv::Scalar(30), cv::FILLED);
+    cv::circle(image, cv::Point(120, 50), 25, cv::Scalar(30), cv::FILLED);
+    cv::circle(image, cv::Point(70, 140), 30, cv::Scalar(30), cv::FILLED);
+    return image;
+}
+
+DropletDetectionParams defaultParams() {
+    DropletDetectionParams params{};
+    params.gaussian_sigma = 0.0;
+    params.gaussian_kernel_size = 1;
+    params.adaptive_block_size = 15;
+    params.morph_open_kernel = 1;
+    params.morph_close_kernel = 1;
+    params.min_area_px2 = 600.0;
+    params.invert_threshold = true;
+    return params;
+}
+
+cv::Mat filledWithDrawContours(const std::vector<cv::Point>& contour, const cv::Size& size) {
+    cv::Mat mask = cv::Mat::zeros(size, CV_8U);
+    cv::drawContours(mask, std::vector<std::vector<cv::Point>>{contour}, 0, cv::Scalar(255), cv::FILLED);
+    return mask;
+}
+} // namespace
+
+TEST(CompactContour, RoundTripsChainCodedContour) {
+    const std::vector<cv::Point> contour = {
+        cv::Point(10, 10), cv::Point(40, 10), cv::Point(45, 15), cv::Point(45, 30),
+        cv::Point(40, 35), cv::Point(10, 35), cv::Point(10, 11),
+    };
+
+    CompactContourStore store;
+    const auto ref = store.encode(contour);
+
+    EXPECT_EQ(ref.encoding, CompactContourEncoding::ChainRuns);
+    EXPECT_EQ(ref.vertex_count, contour.size());
+    EXPECT_EQ(store.decode(ref), contour);
+    EXPECT_EQ(store.boundingRect(ref), cv::boundingRect(contour));
+}
+
+TEST(CompactContour, FallsBackToDeltasForArbitraryPolygons) {
+    const std::vector<cv::Point> contour = {cv::Point(5, 5), cv::Point(30, 12), cv::Point(12, 40), cv::Point(-3, 9)};
+
+    CompactContourStore store;
+    const auto first = store.encode({cv::Point(0, 0), cv::Point(1, 0)});
+    const auto ref = store.encode(contour);
+
+    EXPECT_EQ(ref.encoding, CompactContourEncoding::DeltaVarint);
+    EXPECT_EQ(ref.offset, first.byte_length);
+    EXPECT_EQ(store.decode(ref), contour);
+}
+
+TEST(CompactContour, RasterizerMatchesDrawContoursForDetectedDroplets) {
+    const cv::Mat image = makeSyntheticCircles();
+    const auto detections = detectDroplets(image, defaultParams());
+    ASSERT_EQ(detections.size(), 3U);
+
+    CompactContourStore store;
+    for (const auto& detection : detections) {
+        const auto ref = store.encode(detection.contour);
+        const cv::Mat expected = filledWithDrawContours(detection.contour, image.size());
+
+        cv::Mat actual = cv::Mat::zeros(image.size(), CV_8U);
+        rasterizeCompactContour(store, ref, actual);
+
+        cv::Mat difference;
+        cv::absdiff(expected, actual, difference);
+        EXPECT_EQ(cv::countNonZero(difference), 0);
+    }
+}
+
+TEST(CompactContour, RasterizerClipsToMaskBounds) {
+    const std::vector<cv::Point> contour = {cv::Point(-5, -5), cv::Point(4, -5), cv::Point(4, 4), cv::Point(-5, 4)};
+
+    CompactContourStore store;
+    const auto ref = store.encode(contour);
+
+    cv::Mat mask = cv::Mat::zeros(10, 10, CV_8U);
+    rasterizeCompactContour(store, ref, mask);
+
+    EXPECT_EQ(cv::countNonZero(mask), 25);
+    EXPECT_EQ(mask.at<std::uint8_t>(4, 4), 255);
+    EXPECT_EQ(mask.at<std::uint8_t>(5, 5), 0);
+}
+
+TEST(CompactContour, DetectIntoStoreShrinksPerDetectionMemory) {
+    const cv::Mat image = makeSyntheticCircles();
+
+    const auto plain = detectDroplets(image, defaultParams());
+    CompactContourStore store;
+    const auto compact = detectDroplets(image, defaultParams(), store);
+    ASSERT_EQ(plain.size(), compact.size());
+
+    std::size_t plain_bytes = 0;
+    std::size_t compact_bytes = store.sizeBytes();
+    for (std::size_t i = 0; i < plain.size(); ++i) {
+        EXPECT_TRUE(compact[i].contour.empty());
+        EXPECT_EQ(store.decode(compact[i].compact_contour), plain[i].contour);
+        EXPECT_FLOAT_EQ(compact[i].area_px2, plain[i].area_px2);
+        plain_bytes += approximateMemoryBytes(plain[i]);
+        compact_bytes += approximateMemoryBytes(compact[i]);
+    }
+
+    const auto count = static_cast<double>(plain.size());
+    RecordProperty("bytes_per_detection_vector_contour", static_cast<int>(plain_bytes / count));
+    RecordProperty("bytes_per_detection_compact_contour", static_cast<int>(compact_bytes / count));
+
+    std::size_t plain_contour_bytes = 0;
+    for (const auto& detection : plain) {
+        plain_contour_bytes += detection.contour.size() * sizeof(cv::Point);
+    }
+    EXPECT_LT(store.sizeBytes() * 4, plain_contour_bytes);
+    EXPECT_LT(compact_bytes, plain_bytes);
+}
@@ -0,0 +1,253 @@
+#include "DropletStatistics.h"
+#include "DropletTracking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+Detection makeDetection(float x, float y, float diameter) {
+    Detection detection{};
+    detection.centroid = cv::Point2f(x, y);
+    detection.diameter_eq_px = diameter;
+    detection.area_px2 = static_cast<float>(CV_PI * diameter * diameter / 4.0);
+    const int side = static_cast<int>(diameter);
+    detection.bounding_box = cv::Rect(static_cast<int>(x) - side / 2, static_cast<int>(y) - side / 2, side, side);
+    return detection;
+}
+} // namespace
+
+TEST(OnlineStatistics, MatchesTwoPassMeanAndVarianceAndMerges) {
+    cv::RNG rng(3);
+    std::vector<double> values;
+    OnlineStatistics all;
+    OnlineStatistics first_half;
+    OnlineStatistics second_half;
+    for (int i = 0; i < 1000; ++i) {
+        const double value = 1.0e6 + rng.uniform(-5.0, 5.0);
+        values.push_back(value);
+        all.add(value);
+        (i < 400 ? first_half : second_half).add(value);
+    }
+    all.add(std::numeric_limits<double>::quiet_NaN());
+
+    const double mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+    double sum_sq = 0.0;
+    for (const double value : values) {
+        sum_sq += (value - mean) * (value - mean);
+    }
+    const double variance = sum_sq / static_cast<double>(values.size() - 1);
+
+    EXPECT_EQ(all.count(), values.size());
+    EXPECT_NEAR(all.mean(), mean, 1e-6);
+    EXPECT_NEAR(all.variance(), variance, 1e-6);
+
+    first_half.merge(second_half);
+    EXPECT_EQ(first_half.count(), all.count());
+    EXPECT_NEAR(first_half.mean(), all.mean(), 1e-6);
+    EXPECT_NEAR(first_half.variance(), all.variance(), 1e-6);
+    EXPECT_DOUBLE_EQ(first_half.min(), all.min());
+    EXPECT_DOUBLE_EQ(first_half.max(), all.max());
+
+    EXPECT_TRUE(std::isnan(OnlineStatistics{}.mean()));
+}
+
+TEST(FixedHistogram, QuantileWithinOneBinAndCountsOutOfRange) {
+    FixedHistogram histogram(0.0, 100.0, 200);
+    for (int i = 0; i < 1000; ++i) {
+        histogram.add(static_cast<double>(i % 100) + 0.25);
+    }
+    histogram.add(-1.0);
+    histogram.add(250.0);
+
+    EXPECT_EQ(histogram.total(), 1002U);
+    EXPECT_EQ(histogram.underflow(), 1U);
+    EXPECT_EQ(histogram.overflow(), 1U);
+    EXPECT_NEAR(histogram.quantile(0.5), 50.0, histogram.binWidth() * 2.0);
+    EXPECT_THROW(FixedHistogram(1.0, 1.0, 10), std::invalid_argument);
+}
+
+TEST(SlidingWindowRate, EvictsEventsOlderThanWindow) {
+    SlidingWindowRate rate(1.0);
+    for (int frame = 0; frame <= 40; ++frame) {
+        // 10 events per 0.1 s step: 100 Hz.
+        rate.add(0.1 * frame, 10);
+    }
+    EXPECT_EQ(rate.eventsInWindow(), 100U);
+    EXPECT_NEAR(rate.rateHz(), 100.0, 1e-9);
+
+    rate.advance(10.0);
+    EXPECT_EQ(rate.eventsInWindow(), 0U);
+    EXPECT_DOUBLE_EQ(rate.rateHz(), 0.0);
+}
+
+TEST(SegmentCrossesLine, CountsTouchingStepOnce) {
+    MeasurementLine line{true, cv::Point2f(50.0F, 0.0F), cv::Point2f(50.0F, 100.0F)};
+    EXPECT_TRUE(segmentCrossesLine(cv::Point2f(40.0F, 50.0F), cv::Point2f(60.0F, 50.0F), line));
+    EXPECT_TRUE(segmentCrossesLine(cv::Point2f(40.0F, 50.0F), cv::Point2f(50.0F, 50.0F), line));
+    EXPECT_FALSE(segmentCrossesLine(cv::Point2f(50.0F, 50.0F), cv::Point2f(60.0F, 50.0F), line));
+    EXPECT_FALSE(segmentCrossesLine(cv::Point2f(40.0F, 150.0F), cv::Point2f(60.0F, 150.0F), line));
+
+    // Leaving the line only counts from a point on the segment to a point off its line.
+    EXPECT_TRUE(segmentLeavesLine(cv::Point2f(50.0F, 50.0F), cv::Point2f(60.0F, 50.0F), line));
+    EXPECT_TRUE(segmentLeavesLine(cv::Point2f(50.0F, 100.0F), cv::Point2f(40.0F, 100.0F), line));
+    EXPECT_FALSE(segmentLeavesLine(cv::Point2f(50.0F, 50.0F), cv::Point2f(50.0F, 60.0F), line));
+    EXPECT_FALSE(segmentLeavesLine(cv::Point2f(50.0F, 150.0F), cv::Point2f(60.0F, 150.0F), line));
+    EXPECT_FALSE(segmentLeavesLine(cv::Point2f(40.0F, 50.0F), cv::Point2f(60.0F, 50.0F), line));
+}
+
+TEST(DropletStatisticsEngine, CountsTracksThatStartOnTheLine) {
+    MeasurementLine line{true, cv::Point2f(50.0F, 0.0F), cv::Point2f(50.0F, 100.0F)};
+    DropletStatisticsEngine engine;
+    std::vector<Track> tracks;
+    StreamingTracker tracker(TrackingParams{}, line, [&tracks](Track&& track) { tracks.push_back(std::move(track)); });
+    tracker.setStatisticsEngine(&engine);
+    // First seen exactly on the line, then carried off it (and a second droplet that touches it later).
+    const float first_x[] = {50.0F, 58.0F, 66.0F, 74.0F};
+    const float second_x[] = {26.0F, 34.0F, 42.0F, 50.0F, 58.0F};
+    for (std::size_t i = 0; i < 5; ++i) {
+        FrameDetections frame{};
+        frame.frame_index_logical = i;
+        frame.timestamp_inferred_s = static_cast<double>(i) / 10.0;
+        if (i < std::size(first_x)) {
+            frame.detections.push_back(makeDetection(first_x[i], 20.0F, 10.0F));
+        }
+        frame.detections.push_back(makeDetection(second_x[i], 80.0F, 10.0F));
+        tracker.push(frame);
+    }
+    tracker.finalize();
+
+    ASSERT_EQ(tracks.size(), 2U);
+    for (const auto& track : tracks) {
+        EXPECT_TRUE(track.crossed_line);
+    }
+    EXPECT_EQ(tracks[0].line_crossing_frame, 1U);
+    EXPECT_EQ(tracks[1].line_crossing_frame, 3U);
+    EXPECT_EQ(engine.snapshot().total_crossings, 2U);
+}
+
+TEST(DropletStatisticsEngine, AveragesDiametersPerTrack) {
+    DropletStatisticsEngine engine;
+    Track long_track;
+    long_track.track_id = 1;
+    Track short_track;
+    short_track.track_id = 2;
+    engine.onTrackStarted(long_track, 9.0F);
+    engine.onLink(long_track, 10.0F, 0.0F, false);
+    engine.onLink(long_track, 11.0F, 0.0F, false);
+    engine.onTrackStarted(short_track, 20.0F);
+
+    // Active tracks count with their diameter so far: (10 + 20) / 2, not (9 + 10 + 11 + 20) / 4.
+    auto snapshot = engine.snapshot();
+    EXPECT_EQ(snapshot.diameter_um.count(), 2U);
+    EXPECT_NEAR(snapshot.diameter_um.mean(), 15.0, 1e-9);
+
+    engine.onTrackRetired(long_track);
+    engine.onTrackRetired(short_track);
+    snapshot = engine.snapshot();
+    EXPECT_EQ(snapshot.diameter_um.count(), 2U);
+    EXPECT_NEAR(snapshot.diameter_um.mean(), 15.0, 1e-9);
+    EXPECT_EQ(engine.diameterHistogram().total(), 2U);
+}
+
+TEST(DropletStatisticsEngine, TracksFrequencyAndDiameterWhileStreaming) {
+    // Three lanes; a droplet enters each lane every third frame (staggered by lane) and moves 10 px/frame,
+    // so exactly one droplet crosses the line per frame: 1 crossing / (1 / 20 Hz) = 20 Hz.
+    constexpr double kFps = 20.0;
+    constexpr std::size_t kFrames = 100;
+    MeasurementLine line{true, cv::Point2f(55.0F, 0.0F), cv::Point2f(55.0F, 200.0F)};
+
+    DropletStatisticsParams params;
+    params.um_per_px = 0.5;
+    DropletStatisticsEngine engine(params);
+
+    std::vector<Track> tracks;
+    StreamingTracker tracker(TrackingParams{}, line, [&tracks](Track&& track) { tracks.push_back(std::move(track)); });
+    tracker.setStatisticsEngine(&engine);
+
+    std::size_t next_id = 1;
+    for (std::size_t i = 0; i < kFrames; ++i) {
+        FrameDetections frame{};
+        frame.frame_index_logical = i;
+        frame.timestamp_inferred_s = static_cast<double>(i) / kFps;
+        for (int lane = 0; lane < 3; ++lane) {
+            for (std::size_t age = 0; age <= std::min<std::size_t>(i, 11); ++age) {
+                if ((i - age + static_cast<std::size_t>(lane)) % 3 != 0) {
+                    continue;
+                }
+                const float diameter = 18.0F + 2.0F * static_cast<float>(lane);
+                frame.detections.push_back(makeDetection(10.0F * static_cast<float>(age) + 2.0F, 40.0F + 60.0F * lane, diameter));
+                frame.detections.back().droplet_id = next_id++;
+            }
+        }
+        tracker.push(frame);
+
+        if (i == kFrames / 2) {
+            const auto live = engine.snapshot();
+            EXPECT_EQ(live.total_frames, i + 1);
+            EXPECT_NEAR(live.frequency_hz.mean(), 20.0, 1e-6);
+        }
+    }
+    tracker.finalize();
+
+    const auto summary = engine.snapshot();
+    std::size_t crossed = 0;
+    std::size_t detected = 0;
+    OnlineStatistics post_pass_diameter_um;
+    for (const auto& track : tracks) {
+        crossed += track.crossed_line ? 1 : 0;
+        detected += track.centroids.size();
+        const double lane_diameter_px = 18.0 + 2.0 * std::round((track.centroids.front().y - 40.0) / 60.0);
+        post_pass_diameter_um.add(lane_diameter_px * params.um_per_px);
+    }
+
+    EXPECT_EQ(summary.total_crossings, crossed);
+    EXPECT_EQ(summary.total_detected, detected);
+    EXPECT_EQ(summary.total_tracked, tracks.size());
+    EXPECT_NEAR(summary.frequency_hz.mean(), 20.0, 1e-6);
+    EXPECT_NEAR(summary.frequency_hz.stddev(), 0.0, 1e-6);
+    EXPECT_NEAR(summary.crossing_rate_hz, 20.0, 1e-6);
+    EXPECT_NEAR(summary.diameter_um.mean(), post_pass_diameter_um.mean(), 1e-9);
+    EXPECT_NEAR(summary.diameter_um.stddev(), post_pass_diameter_um.stddev(), 1e-9);
+    EXPECT_NEAR(summary.diameter_median_um, 10.0, 0.5);
+    EXPECT_NEAR(summary.diameter_um.min(), 9.0, 1e-6);
+    EXPECT_NEAR(summary.diameter_um.max(), 11.0, 1e-6);
+    EXPECT_NEAR(summary.velocity_um_per_s.mean(), 100.0, 1e-3);
+    EXPECT_NEAR(summary.duration_s, (kFrames - 1) / kFps, 1e-9);
+}
+
+TEST(DropletStatisticsEngine, CountsTheLastFrequencyIntervalAtEndOfStream) {
+    DropletStatisticsEngine engine;
+    Track track;
+    // One crossing per frame with crossings; the last interval (0.2 s -> 0.5 s) differs from the others.
+    const double crossing_times[] = {0.0, 0.1, 0.2, 0.5};
+    for (std::size_t i = 0; i <= 5; ++i) {
+        FrameDetections frame{};
+        frame.frame_index_logical = i;
+        frame.timestamp_inferred_s = static_cast<double>(i) / 10.0;
+        engine.onFrame(frame);
+        for (const double crossing : crossing_times) {
+            if (crossing == frame.timestamp_inferred_s) {
+                track.timestamps.push_back(crossing);
+                engine.onLink(track, 0.0F, 0.0F, true);
+            }
+        }
+    }
+
+    // Nothing follows the last crossing, so only the end-of-stream snapshot can account for its interval.
+    const auto summary = engine.snapshot();
+    EXPECT_EQ(summary.total_crossings, 4U);
+    ASSERT_EQ(summary.frequency_hz.count(), 3U);
+    EXPECT_NEAR(summary.frequency_hz.mean(), (10.0 + 10.0 + 1.0 / 0.3) / 3.0, 1e-9);
+    EXPECT_NEAR(summary.frequency_hz.min(), 1.0 / 0.3, 1e-9);
+    // Snapshots do not change the engine.
+    EXPECT_EQ(engine.snapshot().frequency_hz.count(), 3U);
+}
@@ -0,0 +1,258 @@
+#include "DropletTracking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+Detection makeDetection(float x, float y, float diameter = 20.0F) {
+    Detection detection{};
+    detection.centroid = cv::Point2f(x, y);
+    detection.diameter_eq_px = diameter;
+    detection.area_px2 = static_cast<float>(CV_PI * diameter * diameter / 4.0);
+    const int side = static_cast<int>(diameter);
+    detection.bounding_box = cv::Rect(static_cast<int>(x) - side / 2, static_cast<int>(y) - side / 2, side, side);
+    return detection;
+}
+
+FrameDetections makeFrame(std::size_t index, double fps, std::vector<Detection> detections) {
+    FrameDetections frame{};
+    frame.frame_index_logical = index;
+    frame.timestamp_inferred_s = static_cast<double>(index) / fps;
+    frame.detections = std::move(detections);
+    return frame;
+}
+
+void assignDropletIds(std::vector<FrameDetections>& frames) {
+    std::size_t next_id = 1;
+    for (auto& frame : frames) {
+        for (auto& detection : frame.detections) {
+            detection.droplet_id = next_id++;
+        }
+    }
+}
+} // namespace
+
+TEST(DropletTracking, LinksDropletsMovingAcrossFrames) {
+    std::vector<FrameDetections> frames;
+    for (std::size_t i = 0; i < 10; ++i) {
+        const float x = 10.0F + 8.0F * static_cast<float>(i);
+        frames.push_back(makeFrame(i, 10.0, {makeDetection(x, 40.0F), makeDetection(x, 120.0F)}));
+    }
+    assignDropletIds(frames);
+
+    const auto tracks = performTracking(frames, TrackingParams{}, MeasurementLine{});
+
+    ASSERT_EQ(tracks.size(), 2U);
+    for (const auto& track : tracks) {
+        ASSERT_EQ(track.centroids.size(), 10U);
+        ASSERT_EQ(track.velocities.size(), 9U);
+        EXPECT_NEAR(track.velocities.front(), 80.0F, 1e-3F);
+        EXPECT_FLOAT_EQ(track.centroids.back().y, track.centroids.front().y);
+        EXPECT_FALSE(track.crossed_line);
+    }
+    EXPECT_EQ(tracks[0].track_id, 1U);
+    EXPECT_EQ(tracks[0].droplet_ids[1], 3U);
+}
+
+TEST(DropletTracking, RecordsMeasurementLineCrossing) {
+    std::vector<FrameDetections> frames;
+    for (std::size_t i = 0; i < 8; ++i) {
+        frames.push_back(makeFrame(i, 10.0, {makeDetection(12.0F + 10.0F * static_cast<float>(i), 50.0F)}));
+    }
+
+    MeasurementLine line;
+    line.enabled = true;
+    line.start = cv::Point2f(55.0F, 0.0F);
+    line.end = cv::Point2f(55.0F, 100.0F);
+
+    const auto tracks = performTracking(frames, TrackingParams{}, line);
+
+    ASSERT_EQ(tracks.size(), 1U);
+    EXPECT_TRUE(tracks[0].crossed_line);
+    EXPECT_EQ(tracks[0].line_crossing_frame, 5U);
+}
+
+TEST(DropletTracking, GatesOnAreaAndDiameter) {
+    std::vector<FrameDetections> frames;
+    frames.push_back(makeFrame(0, 10.0, {makeDetection(50.0F, 50.0F, 20.0F)}));
+    frames.push_back(makeFrame(1, 10.0, {makeDetection(55.0F, 50.0F, 40.0F)}));
+
+    const auto tracks = performTracking(frames, TrackingParams{}, MeasurementLine{});
+
+    EXPECT_EQ(tracks.size(), 2U);
+}
+
+TEST(DropletTracking, CoastsThroughMissedFrames) {
+    std::vector<FrameDetections> frames;
+    frames.push_back(makeFrame(0, 10.0, {makeDetection(10.0F, 50.0F)}));
+    frames.push_back(makeFrame(1, 10.0, {makeDetection(20.0F, 50.0F)}));
+    frames.push_back(makeFrame(2, 10.0, {}));
+    frames.push_back(makeFrame(3, 10.0, {makeDetection(40.0F, 50.0F)}));
+
+    TrackingParams params;
+    params.max_missed_frames = 1;
+    const auto coasting = performTracking(frames, params, MeasurementLine{});
+    ASSERT_EQ(coasting.size(), 1U);
+    EXPECT_EQ(coasting[0].frame_indices.back(), 3U);
+    EXPECT_NEAR(coasting[0].velocities.back(), 100.0F, 1e-3F);
+
+    params.max_missed_frames = 0;
+    EXPECT_EQ(performTracking(frames, params, MeasurementLine{}).size(), 2U);
+}
+
+TEST(DropletTracking, KeepsIdentitiesInDenseDropletTrains) {
+    constexpr int kColumns = 20;
+    constexpr int kRows = 15;
+    constexpr std::size_t kFrames = 30;
+
+    std::vector<FrameDetections> frames;
+    for (std::size_t i = 0; i < kFrames; ++i) {
+        std::vector<Detection> detections;
+        for (int row = 0; row < kRows; ++row) {
+            for (int column = 0; column < kColumns; ++column) {
+                const float x = 20.0F + 30.0F * static_cast<float>(column) + 6.0F * static_cast<float>(i);
+                detections.push_back(makeDetection(x, 20.0F + 30.0F * static_cast<float>(row)));
+            }
+        }
+        frames.push_back(makeFrame(i, 100.0, std::move(detections)));
+    }
+    assignDropletIds(frames);
+
+    for (const auto assignment : {TrackingAssignment::GreedyNearest, TrackingAssignment::Optimal}) {
+        TrackingParams params;
+        params.assignment = assignment;
+        const auto tracks = performTracking(frames, params, MeasurementLine{});
+
+        ASSERT_EQ(tracks.size(), static_cast<std::size_t>(kColumns * kRows));
+        for (const auto& track : tracks) {
+            ASSERT_EQ(track.centroids.size(), kFrames);
+            EXPECT_NEAR(track.centroids.back().x - track.centroids.front().x, 6.0F * (kFrames - 1), 1e-3F);
+            EXPECT_FLOAT_EQ(track.centroids.back().y, track.centroids.front().y);
+        }
+    }
+}
+
+TEST(DropletTracking, OptimalAssignmentAvoidsGreedyIdentitySwap) {
+    // Greedy takes the single closest pair (10 -> 6) and leaves the droplet at 0 with the far detection.
+    std::vector<FrameDetections> frames = {
+        makeFrame(0, 10.0, {makeDetection(0.0F, 50.0F, 4.0F), makeDetection(10.0F, 50.0F, 4.0F)}),
+        makeFrame(1, 10.0, {makeDetection(6.0F, 50.0F, 4.0F), makeDetection(15.0F, 50.0F, 4.0F)}),
+    };
+    assignDropletIds(frames);
+
+    TrackingParams params;
+    params.search_radius_px = 20.0F;
+
+    const auto greedy = performTracking(frames, params, MeasurementLine{});
+    ASSERT_EQ(greedy.size(), 2U);
+    EXPECT_FLOAT_EQ(greedy[0].centroids.back().x, 15.0F);
+
+    params.assignment = TrackingAssignment::Optimal;
+    const auto optimal = performTracking(frames, params, MeasurementLine{});
+    ASSERT_EQ(optimal.size(), 2U);
+    EXPECT_FLOAT_EQ(optimal[0].centroids.back().x, 6.0F);
+    EXPECT_FLOAT_EQ(optimal[1].centroids.back().x, 15.0F);
+}
+
+TEST(DropletTracking, OptimalAssignmentMinimisesTotalLinkCost) {
+    // One crowded cluster per frame: every track competes for every detection. The optimal mode must never
+    // produce a larger summed squared link distance than greedy, and must link as many pairs.
+    cv::RNG rng(11);
+    for (int trial = 0; trial < 50; ++trial) {
+        std::vector<Detection> first;
+        std::vector<Detection> second;
+        for (int i = 0; i < 7; ++i) {
+            first.push_back(makeDetection(static_cast<float>(rng.uniform(0.0, 30.0)), static_cast<float>(rng.uniform(0.0, 30.0)), 4.0F));
+            second.push_back(makeDetection(static_cast<float>(rng.uniform(0.0, 30.0)), static_cast<float>(rng.uniform(0.0, 30.0)), 4.0F));
+        }
+        std::vector<FrameDetections> frames = {makeFrame(0, 10.0, first), makeFrame(1, 10.0, second)};
+        assignDropletIds(frames);
+
+        const auto totals = [&](TrackingAssignment assignment) {
+            TrackingParams params;
+            params.search_radius_px = 45.0F;
+            params.assignment = assignment;
+            double cost = 0.0;
+            std::size_t links = 0;
+            for (const auto& track : performTracking(frames, params, MeasurementLine{})) {
+                if (track.centroids.size() == 2) {
+                    const auto delta = track.centroids[1] - track.centroids[0];
+                    cost += static_cast<double>(delta.x) * delta.x + static_cast<double>(delta.y) * delta.y;
+                    ++links;
+                }
+            }
+            return std::pair<double, std::size_t>{cost, links};
+        };
+
+        const auto greedy = totals(TrackingAssignment::GreedyNearest);
+        const auto optimal = totals(TrackingAssignment::Optimal);
+        EXPECT_EQ(optimal.second, 7U);
+        EXPECT_EQ(greedy.second, 7U);
+        EXPECT_LE(optimal.first, greedy.first + 1e-3);
+    }
+}
+
+TEST(StreamingTracker, MatchesBatchTrackerAndRetiresTracksEarly) {
+    cv::RNG rng(7);
+    std::vector<FrameDetections> frames;
+    for (std::size_t i = 0; i < 200; ++i) {
+        std::vector<Detection> detections;
+        for (int lane = 0; lane < 6; ++lane) {
+            // Droplets enter every 5 frames per lane, move 9 px/frame and leave after 40 frames.
+            for (std::size_t born = (i >= 40 ? i - 39 : 0); born <= i; ++born) {
+                if (born % 5 != static_cast<std::size_t>(lane) % 5) {
+                    continue;
+                }
+                const float jitter = static_cast<float>(rng.uniform(-0.5, 0.5));
+                detections.push_back(makeDetection(9.0F * static_cast<float>(i - born) + jitter, 30.0F + 40.0F * lane));
+            }
+        }
+        frames.push_back(makeFrame(i, 50.0, std::move(detections)));
+    }
+    assignDropletIds(frames);
+
+    MeasurementLine line;
+    line.enabled = true;
+    line.start = cv::Point2f(150.0F, 0.0F);
+    line.end = cv::Point2f(150.0F, 400.0F);
+
+    const auto batch = performTracking(frames, TrackingParams{}, line);
+
+    std::vector<Track> streamed;
+    StreamingTracker tracker(TrackingParams{}, line, [&streamed](Track&& track) { streamed.push_back(std::move(track)); });
+    std::size_t max_active = 0;
+    for (const auto& frame : frames) {
+        tracker.push(frame);
+        max_active = std::max(max_active, tracker.activeTrackCount());
+    }
+    const auto retired_before_finalize = tracker.retiredTrackCount();
+    tracker.finalize();
+
+    EXPECT_GT(retired_before_finalize, batch.size() / 2);
+    EXPECT_LE(max_active, 6U * 9U);
+    EXPECT_EQ(tracker.activeTrackCount(), 0U);
+
+    std::sort(streamed.begin(), streamed.end(),
+              [](const Track& left, const Track& right) { return left.track_id < right.track_id; });
+    ASSERT_EQ(streamed.size(), batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(streamed[i].track_id, batch[i].track_id);
+        EXPECT_EQ(streamed[i].droplet_ids, batch[i].droplet_ids);
+        EXPECT_EQ(streamed[i].frame_indices, batch[i].frame_indices);
+        EXPECT_EQ(streamed[i].velocities, batch[i].velocities);
+        EXPECT_EQ(streamed[i].crossed_line, batch[i].crossed_line);
+        EXPECT_EQ(streamed[i].line_crossing_frame, batch[i].line_crossing_frame);
+    }
+}
+
+TEST(StreamingTracker, RejectsOutOfOrderFrames) {
+    StreamingTracker tracker(TrackingParams{}, MeasurementLine{}, [](Track&&) {});
+    tracker.push(makeFrame(3, 10.0, {makeDetection(10.0F, 10.0F)}));
+    EXPECT_THROW(tracker.push(makeFrame(2, 10.0, {})), std::invalid_argument);
+}
@@ -0,0 +1,228 @@
+#include "FollowingSequenceSource.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+void writeFrame(const std::filesystem::path& path, std::uint16_t value, int width = 16) {
+    std::string error;
+    ASSERT_TRUE(TiffFormat::writeGrayscale(path, cv::Mat(12, width, CV_16UC1, cv::Scalar(value)), error)) << error;
+}
+
+// Grabs until a frame arrives or `limit` passes.
+GrabStatus grabWithin(FollowingSequenceSource& source, StreamFrame& frame, std::chrono::milliseconds limit) {
+    const auto deadline = std::chrono::steady_clock::now() + limit;
+    GrabStatus status = GrabStatus::Timeout;
+    while (status == GrabStatus::Timeout && std::chrono::steady_clock::now() < deadline) {
+        status = source.grabNextFrame(frame, std::chrono::milliseconds(20));
+    }
+    return status;
+}
+} // namespace
+
+TEST(FollowingSequenceSource, StreamsFilesInOrderAsTheyAreWritten) {
+    TestTempDirectory dir("droplet_following_sequence_order");
+    writeFrame(dir.path() / "frame_0001.tif", 1);
+    writeFrame(dir.path() / "frame_0000.tif", 0);
+
+    SequenceFollowParams params;
+    params.watch.stable_for = std::chrono::milliseconds(100);
+    params.watch.poll_interval = std::chrono::milliseconds(20);
+    FollowingSequenceSource source(dir.path().string(), 10.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+    EXPECT_EQ(source.getType(), InputSource::Type::ImageSequence);
+
+    StreamFrame frame;
+    // Files present at start are complete once stable, and come out alphabetically.
+    for (std::uint16_t expected = 0; expected <= 1; ++expected) {
+        ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+        EXPECT_EQ(frame.frame_index, expected);
+        EXPECT_DOUBLE_EQ(frame.timestamp, expected / 10.0);
+        EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), expected);
+    }
+    EXPECT_EQ(source.grabNextFrame(frame, std::chrono::milliseconds(10)), GrabStatus::Timeout);
+
+    std::thread writer([&] {
+        for (std::uint16_t value = 2; value <= 4; ++value) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            writeFrame(dir.path() / ("frame_000" + std::to_string(value) + ".tif"), value);
+        }
+    });
+    for (std::uint16_t expected = 2; expected <= 4; ++expected) {
+        ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+        EXPECT_EQ(frame.frame_index, expected);
+        EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), expected);
+    }
+    writer.join();
+
+    EXPECT_EQ(source.getTotalFrames(), 5U);
+    EXPECT_EQ(source.frameSize(), cv::Size(16, 12));
+    EXPECT_EQ(source.frameType(), CV_16UC1);
+    EXPECT_EQ(std::filesystem::path(source.framePath(3)).filename(), "frame_0003.tif");
+    EXPECT_EQ(source.getFrame(2).at<std::uint16_t>(5, 5), 2);
+    EXPECT_THROW(source.getFrame(5), std::out_of_range);
+    EXPECT_TRUE(source.skipped().empty());
+
+    source.stop();
+    EXPECT_EQ(source.grabNextFrame(frame, std::chrono::milliseconds(10)), GrabStatus::Stopped);
+}
+
+TEST(FollowingSequenceSource, SkipsLateAndMismatchedFiles) {
+    TestTempDirectory dir("droplet_following_sequence_skips");
+    SequenceFollowParams params;
+    params.watch.use_inotify = false;
+    params.watch.stable_for = std::chrono::milliseconds(60);
+    params.watch.poll_interval = std::chrono::milliseconds(20);
+    FollowingSequenceSource source(dir.path().string(), 0.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+    EXPECT_FALSE(source.usingInotify());
+
+    StreamFrame frame;
+    writeFrame(dir.path() / "b.tif", 1);
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+
+    // "a" sorts before the frame already streamed; "c" has a different width; "d" is fine.
+    writeFrame(dir.path() / "a.tif", 0);
+    writeFrame(dir.path() / "c.tif", 2, 20);
+    writeFrame(dir.path() / "d.tif", 3);
+    std::ofstream(dir.path() / "notes.txt") << "ignored";
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(frame.frame_index, 1U);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), 3);
+    EXPECT_EQ(source.getTotalFrames(), 2U);
+
+    const auto skipped = source.skipped();
+    ASSERT_EQ(skipped.size(), 2U);
+    EXPECT_EQ(skipped[0].file, "a.tif");
+    EXPECT_NE(skipped[0].message.find("out of alphabetical order"), std::string::npos) << skipped[0].message;
+    EXPECT_EQ(skipped[1].file, "c.tif");
+    EXPECT_NE(skipped[1].message.find("format does not match"), std::string::npos) << skipped[1].message;
+}
+
+TEST(FollowingSequenceSource, HoldsBackFilesBehindOneStillBeingWritten) {
+    TestTempDirectory dir("droplet_following_sequence_hold_back");
+    SequenceFollowParams params;
+    params.watch.use_inotify = false;
+    params.watch.stable_for = std::chrono::milliseconds(300);
+    params.watch.poll_interval = std::chrono::milliseconds(20);
+    FollowingSequenceSource source(dir.path().string(), 0.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+
+    // "a" keeps growing, so "b" (stable) must wait for it instead of being streamed first.
+    const auto growing = dir.path() / "a.tif";
+    std::ofstream(growing, std::ios::binary) << "II";
+    StreamFrame frame;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    writeFrame(dir.path() / "b.tif", 2);
+    for (int i = 0; i < 8; ++i) {
+        std::ofstream(growing, std::ios::binary | std::ios::app) << "xxxx";
+        EXPECT_EQ(source.grabNextFrame(frame, std::chrono::milliseconds(60)), GrabStatus::Timeout);
+    }
+    writeFrame(growing, 1);
+
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), 1);
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), 2);
+    EXPECT_TRUE(source.skipped().empty());
+}
+
+TEST(FollowingSequenceSource, EndsAfterIdleTime) {
+    TestTempDirectory dir("droplet_following_sequence_idle");
+    writeFrame(dir.path() / "only.tif", 7);
+
+    SequenceFollowParams params;
+    params.watch.stable_for = std::chrono::milliseconds(50);
+    params.watch.poll_interval = std::chrono::milliseconds(10);
+    params.end_after_idle = std::chrono::milliseconds(300);
+    FollowingSequenceSource source(dir.path().string(), 0.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+
+    StreamFrame frame;
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Stopped);
+    EXPECT_EQ(source.getTotalFrames(), 1U);
+
+    FollowingSequenceSource missing((dir.path() / "missing").string(), 0.0);
+    EXPECT_FALSE(missing.start(error));
+}
+
+TEST(FollowingSequenceSource, SkipsFilesDeletedAfterTheyWereAppended) {
+    TestTempDirectory dir("droplet_following_sequence_deleted");
+    for (std::uint16_t value = 0; value < 3; ++value) {
+        writeFrame(dir.path() / ("frame_000" + std::to_string(value) + ".tif"), value);
+    }
+    SequenceFollowParams params;
+    params.watch.use_inotify = false;
+    params.watch.stable_for = std::chrono::milliseconds(50);
+    params.watch.poll_interval = std::chrono::milliseconds(10);
+    FollowingSequenceSource source(dir.path().string(), 0.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+
+    StreamFrame frame;
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    ASSERT_EQ(source.getTotalFrames(), 3U);
+    std::filesystem::remove(dir.path() / "frame_0001.tif");
+
+    // Like a camera that lost a frame: no exception, the next readable frame comes flagged.
+    GrabStatus status = GrabStatus::Timeout;
+    EXPECT_NO_THROW(status = source.grabNextFrame(frame, std::chrono::milliseconds(10)));
+    EXPECT_EQ(status, GrabStatus::LostFrame);
+    EXPECT_EQ(frame.frame_index, 2U);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), 2);
+    EXPECT_THROW(source.getFrame(1), std::runtime_error);
+
+    const auto skipped = source.skipped();
+    ASSERT_EQ(skipped.size(), 1U);
+    EXPECT_EQ(skipped[0].file, "frame_0001.tif");
+
+    // Frames are copies: truncating a file afterwards leaves a frame already handed out intact (a mapped view would
+    // fault), and reading it again fails cleanly.
+    std::filesystem::resize_file(dir.path() / "frame_0002.tif", 16);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(11, 15), 2);
+    EXPECT_THROW(source.getFrame(2), std::runtime_error);
+
+    source.stop();
+    EXPECT_EQ(source.grabNextFrame(frame, std::chrono::milliseconds(10)), GrabStatus::Stopped);
+}
+
+TEST(FollowingSequenceSource, SkipsFilesThatStayEmpty) {
+    TestTempDirectory dir("droplet_following_sequence_empty");
+    SequenceFollowParams params;
+    params.watch.use_inotify = false;
+    params.watch.stable_for = std::chrono::milliseconds(50);
+    params.watch.poll_interval = std::chrono::milliseconds(10);
+    params.watch.empty_timeout = std::chrono::milliseconds(300);
+    FollowingSequenceSource source(dir.path().string(), 0.0, params);
+    std::string error;
+    ASSERT_TRUE(source.start(error)) << error;
+
+    // A placeholder that is never written must not hold back the files that sort after it for good.
+    std::ofstream(dir.path() / "a.tif", std::ios::binary).close();
+    writeFrame(dir.path() / "b.tif", 2);
+    StreamFrame frame;
+    const auto begin = std::chrono::steady_clock::now();
+    ASSERT_EQ(grabWithin(source, frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(250));
+    EXPECT_EQ(frame.frame_index, 0U);
+    EXPECT_EQ(frame.image.at<std::uint16_t>(0, 0), 2);
+
+    const auto skipped = source.skipped();
+    ASSERT_EQ(skipped.size(), 1U);
+    EXPECT_EQ(skipped[0].file, "a.tif");
+    EXPECT_NE(skipped[0].message.find("stayed empty"), std::string::npos) << skipped[0].message;
+}
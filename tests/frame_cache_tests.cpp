@@ -0,0 +1,387 @@
+#include "CachingSource.h"
+#include "FrameCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+// 4x4 8-bit frame (16 bytes) filled with `value`.
+cv::Mat frameOf(std::size_t value) {
+    return cv::Mat(4, 4, CV_8UC1, cv::Scalar(static_cast<double>(value % 256)));
+}
+
+std::uint8_t valueOf(const cv::Mat& frame) {
+    return frame.at<std::uint8_t>(3, 3);
+}
+
+class CountingSource final : public InputSource {
+public:
+    explicit CountingSource(std::size_t total) : total_(total) {}
+
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return total_; }
+    cv::Mat getFrame(std::size_t logical_index) override {
+        reads.fetch_add(1);
+        return frameOf(logical_index);
+    }
+    double getTimestamp(std::size_t logical_index) const override { return static_cast<double>(logical_index); }
+
+    std::atomic<std::size_t> reads{0};
+
+private:
+    std::size_t total_;
+};
+} // namespace
+
+TEST(FrameCache, EvictsTheLeastRecentlyUsedFrameAcrossShards) {
+    FrameCache cache(3 * 16, 2);
+    std::size_t loads = 0;
+    const auto get = [&](std::size_t id) {
+        return valueOf(*cache.get(id, [&]() {
+            ++loads;
+            return frameOf(id);
+        }));
+    };
+
+    EXPECT_EQ(get(0), 0);
+    EXPECT_EQ(get(1), 1);
+    EXPECT_EQ(get(2), 2);
+    EXPECT_EQ(cache.getMaxFrames(), 3U);
+    EXPECT_EQ(get(0), 0);  // 1 is now the oldest, although 0 shares a shard with 2
+    EXPECT_EQ(get(3), 3);
+    EXPECT_EQ(loads, 4U);
+
+    EXPECT_EQ(get(0), 0);
+    EXPECT_EQ(get(2), 2);
+    EXPECT_EQ(get(3), 3);
+    EXPECT_EQ(loads, 4U);
+    EXPECT_EQ(get(1), 1);
+    EXPECT_EQ(loads, 5U);
+
+    FrameCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 4U);
+    EXPECT_EQ(stats.misses, 5U);
+    EXPECT_EQ(stats.evictions, 2U);
+    EXPECT_EQ(stats.frames, 3U);
+    EXPECT_EQ(stats.bytes, 48U);
+    EXPECT_EQ(stats.peak_bytes, 48U);
+
+    cache.setMemoryBudget(16);
+    EXPECT_EQ(cache.stats().frames, 1U);
+    EXPECT_EQ(get(1), 1);  // the most recent frame survived
+    EXPECT_EQ(loads, 5U);
+
+    cache.clear();
+    stats = cache.stats();
+    EXPECT_EQ(stats.frames, 0U);
+    EXPECT_EQ(stats.bytes, 0U);
+}
+
+TEST(FrameCache, HandlesShareThePixelsAndOutliveEviction) {
+    FrameCache cache(16);
+    const FrameHandle first = cache.get(7, []() { return frameOf(7); });
+    const FrameHandle again = cache.get(7, []() { return frameOf(0); });
+    EXPECT_EQ(first->data, again->data);
+    EXPECT_EQ(first.bytes(), 16U);
+
+    cache.get(8, []() { return frameOf(8); });
+    EXPECT_EQ(cache.stats().evictions, 1U);
+    EXPECT_EQ(valueOf(*first), 7);
+
+    // Frames larger than the budget are returned but not kept.
+    const FrameHandle large = cache.get(9, []() { return cv::Mat(8, 8, CV_8UC1, cv::Scalar(9)); });
+    EXPECT_EQ(large->rows, 8);
+    EXPECT_EQ(cache.stats().frames, 1U);
+    EXPECT_FALSE(FrameHandle());
+    EXPECT_TRUE(FrameHandle().mat().empty());
+}
+
+TEST(FrameCache, ConcurrentRequestsShareOneLoad) {
+    FrameCache cache;
+    std::atomic<std::size_t> loads{0};
+    std::vector<std::thread> threads;
+    std::vector<const std::uint8_t*> data(8);
+    for (std::size_t t = 0; t < data.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            data[t] = cache.get(5, [&]() {
+                loads.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                return frameOf(5);
+            })->data;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(loads.load(), 1U);
+    for (const std::uint8_t* pixels : data) {
+        EXPECT_EQ(pixels, data.front());
+    }
+    const FrameCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1U);
+    EXPECT_EQ(stats.hits + stats.shared_loads, 7U);
+}
+
+TEST(FrameCache, LoaderFailuresReachEveryWaiterAndAreNotCached) {
+    FrameCache cache;
+    std::atomic<std::size_t> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            try {
+                cache.get(1, []() -> cv::Mat {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    throw std::runtime_error("unreadable frame");
+                });
+            } catch (const std::runtime_error&) {
+                failures.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_GE(failures.load(), 1U);
+    EXPECT_EQ(cache.stats().frames, 0U);
+    EXPECT_EQ(valueOf(*cache.get(1, []() { return frameOf(1); })), 1);
+}
+
+TEST(FrameCache, StaysWithinBudgetUnderConcurrentAccess) {
+    FrameCache cache(10 * 16, 4);
+    cache.setTraceRecording(true);
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> wrong{0};
+    for (std::size_t t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < 2000; ++i) {
+                const std::size_t id = (i * (t + 3)) % 40;
+                if (valueOf(*cache.get(id, [id]() { return frameOf(id); })) != id) {
+                    wrong.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong.load(), 0U);
+    const FrameCacheStats stats = cache.stats();
+    EXPECT_LE(stats.bytes, 10U * 16U);
+    EXPECT_EQ(stats.bytes, stats.frames * 16U);
+    EXPECT_EQ(stats.hits + stats.misses + stats.shared_loads, 8U * 2000U);
+    // Hits recorded in the shards all reach the policy, none twice.
+    EXPECT_EQ(cache.takeTrace().size(), 8U * 2000U);
+}
+
+TEST(CachingSource, ServesRepeatedFramesFromTheCache) {
+    auto counting = std::make_shared<CountingSource>(20);
+    auto cache = std::make_shared<FrameCache>(5 * 16);
+    CachingSource source(counting, cache);
+    EXPECT_EQ(source.getTotalFrames(), 20U);
+    EXPECT_DOUBLE_EQ(source.getTimestamp(4), 4.0);
+
+    const cv::Mat first = source.getFrame(4);
+    EXPECT_EQ(source.getFrame(4).data, first.data);
+    EXPECT_EQ(valueOf(*source.getFrameHandle(4)), 4);
+    EXPECT_EQ(counting->reads.load(), 1U);
+    EXPECT_THROW(source.getFrame(20), std::out_of_range);
+
+    // A second source over the same cache uses its own key range.
+    CachingSource other(std::make_shared<CountingSource>(20), cache, 1000);
+    EXPECT_EQ(valueOf(other.getFrame(5)), 5);
+    EXPECT_EQ(cache->stats().frames, 2U);
+}
+
+namespace {
+// Playback through `length` new frames while the user keeps returning to `hot` frames (one every `period` steps).
+std::vector<std::size_t> playbackWithRevisits(std::size_t length, std::size_t hot, std::size_t period) {
+    std::vector<std::size_t> trace;
+    for (std::size_t i = 0; i < length; ++i) {
+        trace.push_back(i);
+        if (i % period == 0) {
+            trace.push_back(100000 + (i / period) % hot);
+        }
+    }
+    return trace;
+}
+} // namespace
+
+TEST(FrameCache, ScanResistantPoliciesKeepRevisitedFrames) {
+    const std::vector<std::size_t> trace = playbackWithRevisits(3000, 8, 3);
+    const FrameCacheStats lru = FrameCacheTrace::replay(trace, 16, makeCachePolicy(CachePolicyKind::Lru));
+    const FrameCacheStats two_queue = FrameCacheTrace::replay(trace, 16, makeCachePolicy(CachePolicyKind::TwoQueue));
+    const FrameCacheStats tiny_lfu = FrameCacheTrace::replay(trace, 16, makeCachePolicy(CachePolicyKind::TinyLfu));
+    EXPECT_EQ(lru.hits + lru.misses, trace.size());
+    EXPECT_LT(lru.hitRate(), 0.05);
+    EXPECT_GT(two_queue.hitRate(), 0.2);
+    EXPECT_GT(tiny_lfu.hitRate(), 0.2);
+    EXPECT_GT(tiny_lfu.rejected, 0U);
+}
+
+TEST(TwoQueuePolicy, PinningNeitherPromotesNorDemotes) {
+    TwoQueuePolicy policy;
+    policy.setCapacity(8);
+    policy.inserted(1);
+    policy.inserted(2);
+    policy.pinned(1);
+    EXPECT_EQ(policy.victim(), 2U);
+    policy.unpinned(1);
+    // Back in probation rather than promoted to the main queue, which would make 1 the victim here.
+    EXPECT_EQ(policy.victim(), 2U);
+
+    // A frame that earned the main queue returns to it instead of waiting in probation again.
+    policy.erased(2);
+    policy.inserted(2);
+    policy.inserted(3);
+    policy.inserted(4);
+    policy.pinned(2);
+    policy.unpinned(2);
+    EXPECT_EQ(policy.victim(), 1U);
+    policy.erased(1);
+    EXPECT_EQ(policy.victim(), 2U);
+}
+
+TEST(FrameCache, PinnedSetsSurviveScansUntilReleased) {
+    FrameCache cache(6 * 16, 2);
+    const std::vector<std::size_t> samples = {100, 110, 120};
+    cache.pin("auto-tune", samples);
+    cache.get(100, []() { return frameOf(100); });
+    for (std::size_t i = 0; i < 50; ++i) {
+        cache.get(i, [i]() { return frameOf(i); });
+    }
+    // 110 and 120 were pinned before they were loaded.
+    cache.get(110, []() { return frameOf(110); });
+    cache.get(120, []() { return frameOf(120); });
+    for (std::size_t i = 50; i < 100; ++i) {
+        cache.get(i, [i]() { return frameOf(i); });
+    }
+    FrameCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.pinned_frames, 3U);
+    EXPECT_EQ(stats.frames, 6U);
+    std::size_t reloads = 0;
+    for (const std::size_t id : samples) {
+        cache.get(id, [&]() {
+            ++reloads;
+            return frameOf(id);
+        });
+    }
+    EXPECT_EQ(reloads, 0U);
+
+    // Only pinned frames left: a frame that needs their room is not cached.
+    cache.setMemoryBudget(3 * 16);
+    EXPECT_EQ(cache.stats().frames, 3U);
+    cache.get(7, []() { return frameOf(7); });
+    EXPECT_EQ(cache.stats().frames, 3U);
+
+    cache.unpin("auto-tune");
+    stats = cache.stats();
+    EXPECT_EQ(stats.pinned_frames, 0U);
+    cache.get(8, []() { return frameOf(8); });
+    EXPECT_EQ(cache.stats().frames, 3U);
+    EXPECT_EQ(cache.stats().evictions, stats.evictions + 1);
+}
+
+TEST(FrameCacheTrace, RecordsSavesAndReplaysRequests) {
+    FrameCache cache(4 * 16);
+    cache.setTraceRecording(true);
+    for (const std::size_t id : {3, 1, 3, 2}) {
+        cache.get(id, [id]() { return frameOf(id); });
+    }
+    cache.setTraceRecording(false);
+    cache.get(9, []() { return frameOf(9); });
+    const std::vector<std::size_t> trace = cache.takeTrace();
+    EXPECT_EQ(trace, (std::vector<std::size_t>{3, 1, 3, 2}));
+    EXPECT_STREQ(cache.policyName(), "lru");
+
+    TestTempDirectory dir("droplet_frame_cache_trace");
+    const auto path = dir.path() / "trace.txt";
+    std::string error;
+    ASSERT_TRUE(FrameCacheTrace::save(path, trace, error)) << error;
+    std::vector<std::size_t> loaded;
+    ASSERT_TRUE(FrameCacheTrace::load(path, loaded, error)) << error;
+    EXPECT_EQ(loaded, trace);
+
+    const FrameCacheStats stats = FrameCacheTrace::replay(loaded, 2, makeCachePolicy(CachePolicyKind::Lru));
+    EXPECT_EQ(stats.hits, 1U);
+    EXPECT_EQ(stats.misses, 3U);
+
+    {
+        std::FILE* file = std::fopen(path.string().c_str(), "w");
+        ASSERT_NE(file, nullptr);
+        std::fputs("# comment\n5\nfive\n", file);
+        std::fclose(file);
+    }
+    EXPECT_FALSE(FrameCacheTrace::load(path, loaded, error));
+    EXPECT_NE(error.find("line 3"), std::string::npos);
+
+    EXPECT_EQ(parseCachePolicyKind("2q"), CachePolicyKind::TwoQueue);
+    EXPECT_FALSE(parseCachePolicyKind("fifo").has_value());
+}
+
+TEST(FrameCache, CompressedTierServesEvictedFramesWithoutReloading) {
+    const auto smooth = [](std::size_t id) {
+        cv::Mat frame(64, 64, CV_16UC1);
+        for (int y = 0; y < frame.rows; ++y) {
+            for (int x = 0; x < frame.cols; ++x) {
+                frame.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(1000 + id * 7 + x + y);
+            }
+        }
+        return frame;
+    };
+    const std::size_t frame_bytes = 64 * 64 * 2;
+    FrameCache cache(2 * frame_bytes, 2);
+    cache.setCompressedBudget(2 * frame_bytes);
+    std::size_t loads = 0;
+    for (std::size_t id = 0; id < 6; ++id) {
+        cache.get(id, [&]() {
+            ++loads;
+            return smooth(id);
+        });
+    }
+    FrameCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.frames, 2U);
+    EXPECT_EQ(stats.compressed_frames, 4U);
+    EXPECT_EQ(stats.effectiveFrames(), 6U);
+    EXPECT_LE(stats.compressed_bytes, 2 * frame_bytes);
+    EXPECT_EQ(stats.compressed_raw_bytes, 4 * frame_bytes);
+
+    const FrameHandle decoded = cache.get(1, [&]() {
+        ++loads;
+        return smooth(1);
+    });
+    EXPECT_EQ(loads, 6U);
+    const cv::Mat expected = smooth(1);
+    for (int y = 0; y < expected.rows; ++y) {
+        ASSERT_EQ(std::memcmp(decoded->ptr<std::uint8_t>(y), expected.ptr<std::uint8_t>(y), 128), 0);
+    }
+    stats = cache.stats();
+    EXPECT_EQ(stats.compressed_hits, 1U);
+    EXPECT_EQ(stats.frames, 2U);
+    EXPECT_EQ(stats.compressed_frames, 4U);  // 1 moved up, the frame it displaced moved down
+    EXPECT_GT(stats.decode_seconds, 0.0);
+    EXPECT_DOUBLE_EQ(stats.hitRate(), 1.0 / 7.0);
+
+    // Frames the codec does not handle are dropped as before: 12 only displaces the float frame.
+    cache.get(10, []() { return cv::Mat(16, 32, CV_32FC1); });
+    cache.get(11, [&]() { return smooth(11); });
+    const std::size_t compressed = cache.stats().compressed_frames;
+    cache.get(12, [&]() { return smooth(12); });
+    EXPECT_EQ(cache.stats().compressed_frames, compressed);
+
+    cache.setCompressedBudget(0);
+    stats = cache.stats();
+    EXPECT_EQ(stats.compressed_frames, 0U);
+    EXPECT_EQ(stats.compressed_bytes, 0U);
+}
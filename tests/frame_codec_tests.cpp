@@ -0,0 +1,107 @@
+#include "FrameCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>
+
+namespace {
+// Smooth background with noise and a few bright discs, like a droplet frame.
+cv::Mat syntheticFrame(int rows, int cols, int type, unsigned seed) {
+    std::mt19937 random(seed);
+    std::normal_distribution<double> noise(0.0, 3.0);
+    const double scale = type == CV_16UC1 ? 1.0 : 1.0 / 256.0;
+    cv::Mat frame(rows, cols, type);
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            double value = 2000.0 + 3.0 * x + 2.0 * y + noise(random);
+            const double dx = x % 97 - 48.0;
+            const double dy = y % 89 - 44.0;
+            if (dx * dx + dy * dy < 400.0) {
+                value += 20000.0;
+            }
+            value = std::clamp(value * scale, 0.0, type == CV_16UC1 ? 65535.0 : 255.0);
+            if (type == CV_16UC1) {
+                frame.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(value);
+            } else {
+                frame.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(value);
+            }
+        }
+    }
+    return frame;
+}
+
+bool identical(const cv::Mat& a, const cv::Mat& b) {
+    if (a.rows != b.rows || a.cols != b.cols || a.type() != b.type()) {
+        return false;
+    }
+    const std::size_t row_bytes = static_cast<std::size_t>(a.cols) * a.elemSize();
+    for (int y = 0; y < a.rows; ++y) {
+        if (std::memcmp(a.ptr<std::uint8_t>(y), b.ptr<std::uint8_t>(y), row_bytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST(FrameCodec, RoundTripsSmoothAndRandomFramesLosslessly) {
+    std::mt19937 random(3);
+    for (const int type : {CV_16UC1, CV_8UC1}) {
+        for (const int cols : {1, 127, 128, 300}) {
+            cv::Mat noise(37, cols, type);
+            for (int y = 0; y < noise.rows; ++y) {
+                for (int x = 0; x < noise.cols; ++x) {
+                    if (type == CV_16UC1) {
+                        noise.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(random());
+                    } else {
+                        noise.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(random());
+                    }
+                }
+            }
+            for (const cv::Mat& frame : {syntheticFrame(37, cols, type, 1), noise}) {
+                EncodedFrame encoded;
+                ASSERT_TRUE(FrameCodec::encode(frame, encoded));
+                EXPECT_EQ(encoded.rawBytes(), frame.total() * frame.elemSize());
+                cv::Mat simd;
+                cv::Mat scalar;
+                ASSERT_TRUE(FrameCodec::decode(encoded, simd));
+                ASSERT_TRUE(FrameCodec::decodeScalar(encoded, scalar));
+                EXPECT_TRUE(identical(frame, simd)) << "type " << type << " cols " << cols;
+                EXPECT_TRUE(identical(frame, scalar)) << "type " << type << " cols " << cols;
+            }
+        }
+    }
+}
+
+TEST(FrameCodec, CompressesSmoothSixteenBitFrames) {
+    const cv::Mat frame = syntheticFrame(256, 512, CV_16UC1, 2);
+    EncodedFrame encoded;
+    ASSERT_TRUE(FrameCodec::encode(frame, encoded));
+    EXPECT_LT(encoded.bytes.size() * 2, encoded.rawBytes());
+
+    const cv::Mat flat(64, 256, CV_16UC1, cv::Scalar(1234));
+    ASSERT_TRUE(FrameCodec::encode(flat, encoded));
+    EXPECT_LT(encoded.bytes.size(), 64U * 2U * 8U);  // two header bytes per block, the first row's step as an exception
+}
+
+TEST(FrameCodec, RejectsUnsupportedAndCorruptInput) {
+    EncodedFrame encoded;
+    EXPECT_FALSE(FrameCodec::encode(cv::Mat(4, 4, CV_32FC1), encoded));
+    EXPECT_FALSE(FrameCodec::encode(cv::Mat(), encoded));
+
+    ASSERT_TRUE(FrameCodec::encode(syntheticFrame(8, 200, CV_16UC1, 4), encoded));
+    cv::Mat frame;
+    EncodedFrame truncated = encoded;
+    truncated.bytes.pop_back();
+    EXPECT_FALSE(FrameCodec::decode(truncated, frame));
+    EncodedFrame bad_width = encoded;
+    bad_width.bytes[0] = 17;
+    EXPECT_FALSE(FrameCodec::decode(bad_width, frame));
+    EncodedFrame trailing = encoded;
+    trailing.bytes.push_back(0);
+    EXPECT_FALSE(FrameCodec::decodeScalar(trailing, frame));
+}
@@ -1,15 +1,20 @@
 #include <cstddef>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include "HashUtils.h"
+#include "TestTempDirectory.h"
 
 TEST(HashUtils, Sha256HexFileMatchesKnownHash) {
-    const auto temp_dir = std::filesystem::temp_directory_path();
-    const auto test_path = temp_dir / "droplet_hashutils_test_hello_world.txt";
+    TestTempDirectory dir("droplet_hashutils_hello_world");
+    const auto test_path = dir.path() / "hello_world.txt";
 
     {
         std::ofstream out(test_path, std::ios::binary | std::ios::trunc);
@@ -19,9 +24,6 @@ TEST(HashUtils, Sha256HexFileMatchesKnownHash) {
 
     const auto digest = HashUtils::sha256HexFile(test_path);
     EXPECT_EQ(digest, "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9");
-
-    std::error_code remove_error;
-    std::filesystem::remove(test_path, remove_error);
 }
 
 TEST(HashUtils, Sha256HexStringMatchesKnownHash) {
@@ -30,3 +32,94 @@ TEST(HashUtils, Sha256HexStringMatchesKnownHash) {
     EXPECT_EQ(digest, "015abd7f5cc57a2dd94b7590f04ad8084273905ee33ec5cebeae62276a97f862");
 }
 
+namespace {
+// Restores the default kernel when a test that switches kernels ends.
+class KernelGuard {
+public:
+    KernelGuard() : kernel_(HashUtils::sha256Kernel()) {}
+    ~KernelGuard() { HashUtils::setSha256Kernel(kernel_); }
+
+private:
+    HashUtils::Sha256Kernel kernel_;
+};
+
+constexpr HashUtils::Sha256Kernel kKernels[] = {
+    HashUtils::Sha256Kernel::Portable,
+    HashUtils::Sha256Kernel::ShaNi,
+    HashUtils::Sha256Kernel::Avx2MultiBuffer,
+};
+
+std::string patternBytes(std::size_t size, unsigned int seed) {
+    std::string bytes(size, '\0');
+    unsigned int value = seed;
+    for (auto& byte : bytes) {
+        value = value * 1103515245U + 12345U;
+        byte = static_cast<char>(value >> 24U);
+    }
+    return bytes;
+}
+} // namespace
+
+TEST(HashUtils, EveryKernelMatchesStandardVectors) {
+    KernelGuard guard;
+    EXPECT_TRUE(HashUtils::sha256KernelSupported(HashUtils::Sha256Kernel::Portable));
+    for (const auto kernel : kKernels) {
+        if (!HashUtils::setSha256Kernel(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(HashUtils::sha256KernelName(kernel));
+        EXPECT_EQ(HashUtils::sha256Hex(std::string_view()),
+                  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        EXPECT_EQ(HashUtils::sha256Hex("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        EXPECT_EQ(HashUtils::sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+        EXPECT_EQ(HashUtils::sha256Hex(std::string(1000000, 'a')),
+                  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+}
+
+TEST(HashUtils, KernelsAgreeAcrossPaddingBoundaries) {
+    KernelGuard guard;
+    for (std::size_t size = 0; size <= 300; ++size) {
+        const std::string bytes = patternBytes(size, static_cast<unsigned int>(size));
+        ASSERT_TRUE(HashUtils::setSha256Kernel(HashUtils::Sha256Kernel::Portable));
+        const std::string expected = HashUtils::sha256Hex(bytes);
+        for (const auto kernel : kKernels) {
+            if (HashUtils::setSha256Kernel(kernel)) {
+                ASSERT_EQ(HashUtils::sha256Hex(bytes), expected)
+                    << HashUtils::sha256KernelName(kernel) << ", " << size << " bytes";
+            }
+        }
+    }
+}
+
+TEST(HashUtils, Sha256HexFilesMatchesOneFileAtATime) {
+    KernelGuard guard;
+    TestTempDirectory temp("droplet_hashutils_files");
+    const std::filesystem::path& dir = temp.path();
+
+    // Sizes around block, padding and read-buffer boundaries; more files than lanes, so lanes are reused.
+    const std::size_t sizes[] = {0, 1, 55, 56, 63, 64, 65, 1000, (1U << 20U) - 1, (1U << 20U) + 17,
+                                 (4U << 20U) + 100, 3 * 4096, 77, 129};
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::string> expected;
+    for (std::size_t i = 0; i < std::size(sizes); ++i) {
+        const std::string bytes = patternBytes(sizes[i], static_cast<unsigned int>(i + 1));
+        paths.push_back(dir / ("file_" + std::to_string(i) + ".bin"));
+        std::ofstream(paths.back(), std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        expected.push_back(HashUtils::sha256Hex(bytes));
+    }
+
+    for (const auto kernel : kKernels) {
+        if (!HashUtils::setSha256Kernel(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(HashUtils::sha256KernelName(kernel));
+        EXPECT_EQ(HashUtils::sha256HexFiles(paths), expected);
+        EXPECT_EQ(HashUtils::sha256HexFile(paths[10]), expected[10]);
+    }
+
+    paths.push_back(dir / "missing.bin");
+    EXPECT_THROW(HashUtils::sha256HexFiles(paths), std::runtime_error);
+    EXPECT_THROW(HashUtils::sha256HexFile(dir), std::runtime_error);
+}
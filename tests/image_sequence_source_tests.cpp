@@ -0,0 +1,320 @@
+#include "ImageSequenceSource.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+cv::Mat makeFrame(int value, int type) {
+    cv::Mat image(24, 40, type);
+    for (int y = 0; y < image.rows; ++y) {
+        for (int x = 0; x < image.cols; ++x) {
+            if (type == CV_8UC1) {
+                image.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(value + x + y);
+            } else {
+                image.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(value * 100 + 300 * x + y);
+            }
+        }
+    }
+    return image;
+}
+
+void writeFrame(const std::filesystem::path& path, const cv::Mat& image, const TiffWriteOptions& options = {}) {
+    std::string error;
+    ASSERT_TRUE(TiffFormat::writeGrayscale(path, image, error, options)) << error;
+}
+} // namespace
+
+TEST(ImageSequenceSource, ScansTopLevelTiffsInAlphabeticalOrder) {
+    TestTempDirectory dir("droplet_image_sequence_scan");
+    writeFrame(dir.path() / "frame_10.tif", makeFrame(10, CV_16UC1));
+    writeFrame(dir.path() / "frame_2.tiff", makeFrame(2, CV_16UC1));
+    writeFrame(dir.path() / "data.TIF", makeFrame(1, CV_16UC1));
+    std::filesystem::create_directories(dir.path() / "nested");
+    writeFrame(dir.path() / "nested" / "a.tif", makeFrame(0, CV_16UC1));
+    std::ofstream(dir.path() / "notes.txt") << "not a frame";
+
+    ImageSequenceSource source(dir.path().string(), 20.0);
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_EQ(source.getType(), InputSource::Type::ImageSequence);
+    ASSERT_EQ(source.getTotalFrames(), 3U);
+    EXPECT_EQ(std::filesystem::path(source.framePath(0)).filename(), "data.TIF");
+    EXPECT_EQ(std::filesystem::path(source.framePath(1)).filename(), "frame_10.tif");
+    EXPECT_EQ(std::filesystem::path(source.framePath(2)).filename(), "frame_2.tiff");
+    EXPECT_EQ(source.frameSize(), cv::Size(40, 24));
+    EXPECT_EQ(source.frameType(), CV_16UC1);
+    EXPECT_DOUBLE_EQ(source.getTimestamp(3), 0.15);
+    EXPECT_THROW(source.getFrame(3), std::out_of_range);
+}
+
+TEST(ImageSequenceSource, ReturnsZeroCopyFramesThatOutliveTheSource) {
+    TestTempDirectory dir("droplet_image_sequence_zero_copy");
+    const cv::Mat expected = makeFrame(7, CV_16UC1);
+    writeFrame(dir.path() / "a.tif", expected);
+    writeFrame(dir.path() / "b.tif", makeFrame(8, CV_16UC1), TiffWriteOptions{5, false});
+
+    cv::Mat first;
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0);
+        std::string error;
+        ASSERT_TRUE(source.load(error)) << error;
+        first = source.getFrame(0);
+        const cv::Mat second = source.getFrame(1);
+        EXPECT_EQ(source.readStats().zero_copy_frames, 2U);
+        EXPECT_EQ(source.readStats().decoded_frames, 0U);
+        EXPECT_EQ(second.at<std::uint16_t>(23, 39), makeFrame(8, CV_16UC1).at<std::uint16_t>(23, 39));
+
+        // Writes land in private pages, which later reads of the same file share while it stays mapped...
+        first.at<std::uint16_t>(0, 0) = 1;
+        EXPECT_EQ(source.getFrame(0).at<std::uint16_t>(0, 0), 1);
+    }
+    {
+        // ...but never reach the file.
+        ImageSequenceSource source(dir.path().string(), 10.0);
+        std::string error;
+        ASSERT_TRUE(source.load(error)) << error;
+        EXPECT_EQ(source.getFrame(0).at<std::uint16_t>(0, 0), expected.at<std::uint16_t>(0, 0));
+    }
+
+    ASSERT_EQ(first.size(), expected.size());
+    EXPECT_EQ(first.at<std::uint16_t>(0, 0), 1);
+    for (int y = 0; y < expected.rows; ++y) {
+        for (int x = 1; x < expected.cols; ++x) {
+            ASSERT_EQ(first.at<std::uint16_t>(y, x), expected.at<std::uint16_t>(y, x));
+        }
+    }
+}
+
+TEST(ImageSequenceSource, DecodesBigEndianFrames) {
+    TestTempDirectory dir("droplet_image_sequence_big_endian");
+    const cv::Mat expected = makeFrame(3, CV_16UC1);
+    writeFrame(dir.path() / "a.tif", expected, TiffWriteOptions{7, true});
+
+    ImageSequenceSource source(dir.path().string(), 10.0);
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+    const cv::Mat frame = source.getFrame(0);
+    EXPECT_EQ(source.readStats().decoded_frames, 1U);
+    EXPECT_EQ(source.readStats().zero_copy_frames, 0U);
+    for (int y = 0; y < expected.rows; ++y) {
+        for (int x = 0; x < expected.cols; ++x) {
+            ASSERT_EQ(frame.at<std::uint16_t>(y, x), expected.at<std::uint16_t>(y, x));
+        }
+    }
+}
+
+TEST(ImageSequenceSource, RejectsEmptyDirectoriesAndInconsistentSequences) {
+    TestTempDirectory dir("droplet_image_sequence_invalid");
+    ImageSequenceSource empty(dir.path().string(), 10.0);
+    std::string error;
+    EXPECT_FALSE(empty.load(error));
+    EXPECT_NE(error.find("No TIFF files found"), std::string::npos);
+
+    // Only every 10th file is sampled: frame_05 is never checked, frame_10 is.
+    for (int i = 0; i < 12; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        writeFrame(dir.path() / name, makeFrame(i, i == 5 || i == 10 ? CV_8UC1 : CV_16UC1));
+    }
+    ImageSequenceSource mixed(dir.path().string(), 10.0);
+    EXPECT_FALSE(mixed.load(error));
+    EXPECT_NE(error.find("Bit depth mismatch"), std::string::npos);
+    EXPECT_NE(error.find("frame_10.tif"), std::string::npos);
+    EXPECT_EQ(mixed.getTotalFrames(), 0U);
+
+    writeFrame(dir.path() / "frame_10.tif", makeFrame(10, CV_16UC1));
+    ASSERT_TRUE(mixed.load(error)) << error;
+    EXPECT_EQ(mixed.getTotalFrames(), 12U);
+    EXPECT_THROW(mixed.getFrame(5), std::runtime_error);
+}
+
+TEST(ImageSequenceSource, ReportsEveryRejectedSampleWithoutReadingPixels) {
+    TestTempDirectory dir("droplet_image_sequence_report");
+    for (int i = 0; i < 35; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        writeFrame(dir.path() / name, makeFrame(i, i == 20 ? CV_8UC1 : CV_16UC1));
+    }
+    std::ofstream(dir.path() / "frame_10.tif", std::ios::binary | std::ios::trunc) << "corrupt";
+
+    for (const std::size_t threads : {1U, 4U}) {
+        ImageSequenceSource source(dir.path().string(), 10.0, threads);
+        std::string error;
+        EXPECT_FALSE(source.load(error));
+        const SequenceValidationReport& report = source.validationReport();
+        EXPECT_EQ(report.total_files, 35U);
+        EXPECT_EQ(report.sampled_files, 4U);
+        EXPECT_EQ(report.threads, threads);
+        EXPECT_EQ(report.width, 40U);
+        EXPECT_EQ(report.bits_per_sample, 16U);
+        ASSERT_EQ(report.issues.size(), 2U);
+        EXPECT_EQ(report.issues[0].file, "frame_10.tif");
+        EXPECT_EQ(report.issues[1].file, "frame_20.tif");
+        EXPECT_NE(report.issues[1].message.find("Bit depth mismatch"), std::string::npos);
+        EXPECT_EQ(error, report.issues[0].message);
+        EXPECT_GE(report.time_to_ready_seconds, report.validate_seconds);
+        // Headers only: one 4 KB block per valid file, less for the 7-byte corrupt one.
+        EXPECT_LE(report.header_bytes_read, 4U * 4096U);
+        EXPECT_EQ(source.getTotalFrames(), 0U);
+    }
+
+    writeFrame(dir.path() / "frame_10.tif", makeFrame(10, CV_16UC1));
+    writeFrame(dir.path() / "frame_20.tif", makeFrame(20, CV_16UC1));
+    ImageSequenceSource source(dir.path().string(), 10.0);
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_TRUE(source.validationReport().ok());
+    EXPECT_EQ(source.getTotalFrames(), 35U);
+    EXPECT_EQ(source.getFrame(30).at<std::uint16_t>(0, 0), 3000);
+}
+
+TEST(ImageSequenceSource, ReopensFromTheSidecarIndex) {
+    TestTempDirectory dir("droplet_image_sequence_index");
+    for (int i = 0; i < 25; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        writeFrame(dir.path() / name, makeFrame(i, CV_16UC1));
+    }
+
+    std::string error;
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        EXPECT_EQ(source.validationReport().reused_headers, 0U);
+        EXPECT_TRUE(source.indexWriteError().empty()) << source.indexWriteError();
+        EXPECT_TRUE(std::filesystem::exists(ImageSequenceSource::indexPath(dir.path().string())));
+    }
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        const SequenceValidationReport& report = source.validationReport();
+        EXPECT_EQ(report.sampled_files, 3U);
+        EXPECT_EQ(report.reused_headers, 3U);
+        EXPECT_EQ(report.header_bytes_read, 0U);
+        EXPECT_EQ(report.threads, 0U);
+        EXPECT_EQ(source.getTotalFrames(), 25U);
+        EXPECT_EQ(source.getFrame(20).at<std::uint16_t>(1, 2), 20 * 100 + 600 + 1);
+    }
+
+    // A changed file is re-read (and rejected); the unchanged samples still come from the index.
+    writeFrame(dir.path() / "frame_10.tif", makeFrame(10, CV_8UC1));
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        EXPECT_FALSE(source.load(error));
+        EXPECT_NE(error.find("Bit depth mismatch"), std::string::npos);
+        EXPECT_EQ(source.validationReport().reused_headers, 2U);
+    }
+
+    // A new file shifts the sample positions; the index is rebuilt and current again afterwards.
+    writeFrame(dir.path() / "frame_10.tif", makeFrame(10, CV_16UC1));
+    writeFrame(dir.path() / "frame_00a.tif", makeFrame(30, CV_16UC1));
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        EXPECT_EQ(source.getTotalFrames(), 26U);
+        EXPECT_EQ(source.validationReport().reused_headers, 1U);
+    }
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        EXPECT_EQ(source.validationReport().reused_headers, 3U);
+        EXPECT_EQ(source.getFrame(1).at<std::uint16_t>(0, 0), 3000);
+    }
+
+    // A damaged index is ignored.
+    {
+        std::fstream index(ImageSequenceSource::indexPath(dir.path().string()),
+                           std::ios::in | std::ios::out | std::ios::binary);
+        index.seekp(60);
+        index.put('\x7f');
+    }
+    ImageSequenceSource source(dir.path().string(), 10.0, 2);
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_EQ(source.validationReport().reused_headers, 0U);
+    EXPECT_EQ(source.getTotalFrames(), 26U);
+}
+
+TEST(ImageSequenceSource, IndexesHeadersParsedOnFirstAccess) {
+    TestTempDirectory dir("droplet_image_sequence_lazy_index");
+    for (int i = 0; i < 25; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        writeFrame(dir.path() / name, makeFrame(i, CV_16UC1));
+    }
+
+    std::string error;
+    {
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        // Frames 3 and 4 were not sampled, so their headers are parsed here...
+        EXPECT_EQ(source.getFrame(3).at<std::uint16_t>(0, 0), 300);
+        EXPECT_EQ(source.getFrame(4).at<std::uint16_t>(0, 0), 400);
+        EXPECT_EQ(source.headersParsedOnAccess(), 2U);
+        // A frame still mapped is served from the same mapping rather than a new one.
+        const cv::Mat held = source.getFrame(3);
+        EXPECT_EQ(source.getFrame(3).data, held.data);
+        EXPECT_EQ(source.readStats().zero_copy_frames, 4U);
+        source.updateIndex();
+        EXPECT_TRUE(source.indexWriteError().empty()) << source.indexWriteError();
+    }
+    {
+        // ...and come from the index after a reopen.
+        ImageSequenceSource source(dir.path().string(), 10.0, 2);
+        ASSERT_TRUE(source.load(error)) << error;
+        EXPECT_EQ(source.getFrame(3).at<std::uint16_t>(0, 0), 300);
+        EXPECT_EQ(source.getFrame(4).at<std::uint16_t>(0, 0), 400);
+        EXPECT_EQ(source.headersParsedOnAccess(), 0U);
+    }
+
+    // A file rewritten with a different strip layout is parsed again instead of trusting its indexed offsets.
+    writeFrame(dir.path() / "frame_04.tif", makeFrame(44, CV_16UC1), TiffWriteOptions{5U, false});
+    ImageSequenceSource source(dir.path().string(), 10.0, 2);
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_EQ(source.getFrame(4).at<std::uint16_t>(3, 2), 44 * 100 + 600 + 3);
+    EXPECT_EQ(source.getFrame(3).at<std::uint16_t>(0, 0), 300);
+    EXPECT_EQ(source.headersParsedOnAccess(), 1U);
+}
+
+TEST(ImageSequenceSource, ConcurrentReadsParseEachFileOnce) {
+    TestTempDirectory dir("droplet_image_sequence_concurrent");
+    for (int i = 0; i < 20; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%02d.tif", i);
+        writeFrame(dir.path() / name, makeFrame(i, CV_16UC1), TiffWriteOptions{i % 2 == 0 ? 0U : 7U, i % 3 == 0});
+    }
+    ImageSequenceSource source(dir.path().string(), 10.0);
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+
+    std::vector<std::thread> readers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&source, &mismatches, t]() {
+            for (int pass = 0; pass < 3; ++pass) {
+                for (int i = 0; i < 20; ++i) {
+                    const int index = (i + t * 5) % 20;
+                    if (source.getFrame(static_cast<std::size_t>(index)).at<std::uint16_t>(0, 1) != index * 100 + 300) {
+                        mismatches.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+    const TiffReadStats stats = source.readStats();
+    EXPECT_EQ(stats.zero_copy_frames + stats.decoded_frames, 4U * 3U * 20U);
+}
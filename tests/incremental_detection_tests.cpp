@@ -0,0 +1,137 @@
+#include "IncrementalDetection.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/imgproc.hpp>
+
+namespace {
+DropletDetectionParams detectionParams() {
+    DropletDetectionParams params{};
+    params.gaussian_sigma = 0.0;
+    params.gaussian_kernel_size = 1;
+    params.adaptive_block_size = 15;
+    params.adaptive_c = 2.0;
+    params.morph_open_kernel = 1;
+    params.morph_close_kernel = 1;
+    params.min_area_px2 = 100.0;
+    params.invert_threshold = true;
+    return params;
+}
+
+// Static scene (channel walls and stuck debris) with droplets moving along a channel in the middle.
+cv::Mat makeFrame(std::size_t index) {
+    cv::Mat image(384, 512, CV_8U, cv::Scalar(200));
+    cv::rectangle(image, cv::Rect(0, 0, 512, 24), cv::Scalar(60), cv::FILLED);
+    cv::rectangle(image, cv::Rect(0, 360, 512, 24), cv::Scalar(60), cv::FILLED);
+    cv::circle(image, cv::Point(80, 300), 12, cv::Scalar(40), cv::FILLED);
+    cv::circle(image, cv::Point(420, 70), 9, cv::Scalar(40), cv::FILLED);
+    for (int droplet = 0; droplet < 4; ++droplet) {
+        const int x = static_cast<int>((index * 7 + static_cast<std::size_t>(droplet) * 130) % 560) - 24;
+        cv::circle(image, cv::Point(x, 190), 10, cv::Scalar(30), cv::FILLED);
+    }
+    return image;
+}
+
+struct Summary {
+    cv::Point2f centroid;
+    float area = 0.0F;
+};
+
+std::vector<Summary> sorted(const std::vector<Detection>& detections) {
+    std::vector<Summary> out;
+    for (const auto& detection : detections) {
+        out.push_back(Summary{detection.centroid, detection.area_px2});
+    }
+    std::sort(out.begin(), out.end(), [](const Summary& left, const Summary& right) {
+        return left.centroid.x != right.centroid.x ? left.centroid.x < right.centroid.x : left.centroid.y < right.centroid.y;
+    });
+    return out;
+}
+} // namespace
+
+TEST(IncrementalDetection, MatchesFullDetectionOnMostlyStaticScene) {
+    IncrementalDetectionParams params;
+    params.detection = detectionParams();
+    IncrementalDropletDetector detector(params);
+
+    for (std::size_t i = 0; i < 120; ++i) {
+        const cv::Mat frame = makeFrame(i);
+        const auto incremental = sorted(detector.detect(frame));
+        const auto full = sorted(detectDroplets(frame, params.detection));
+
+        ASSERT_EQ(incremental.size(), full.size()) << "frame " << i;
+        for (std::size_t d = 0; d < full.size(); ++d) {
+            EXPECT_NEAR(incremental[d].centroid.x, full[d].centroid.x, 1e-3F) << "frame " << i;
+            EXPECT_NEAR(incremental[d].centroid.y, full[d].centroid.y, 1e-3F) << "frame " << i;
+            EXPECT_FLOAT_EQ(incremental[d].area, full[d].area) << "frame " << i;
+        }
+    }
+
+    EXPECT_EQ(detector.framesProcessed(), 120U);
+    EXPECT_LT(detector.fullFrameCount(), 12U);
+    EXPECT_LT(detector.averageProcessedFraction(), 0.6);
+}
+
+TEST(IncrementalDetection, CarriesOverDetectionsWhenNothingChanges) {
+    IncrementalDetectionParams params;
+    params.detection = detectionParams();
+    IncrementalDropletDetector detector(params);
+
+    const cv::Mat frame = makeFrame(3);
+    const auto first = detector.detect(frame);
+    EXPECT_TRUE(detector.lastStats().full_frame);
+
+    const auto second = detector.detect(frame.clone());
+    EXPECT_FALSE(detector.lastStats().full_frame);
+    EXPECT_EQ(detector.lastStats().changed_tiles, 0U);
+    EXPECT_EQ(detector.lastStats().carried_detections, first.size());
+    EXPECT_DOUBLE_EQ(detector.lastStats().processed_pixel_fraction, 0.0);
+    EXPECT_EQ(second.size(), first.size());
+
+    detector.requestResync();
+    detector.detect(frame);
+    EXPECT_TRUE(detector.lastStats().full_frame);
+}
+
+TEST(IncrementalDetection, RedetectsSmallFaintDropletsAppearingInStaticTiles) {
+    IncrementalDetectionParams params;
+    params.detection = detectionParams();
+    params.detection.min_area_px2 = 20.0;
+    params.resync_interval_frames = 0;  // only the tile test may trigger re-detection
+    params.max_changed_fraction = 1.0;
+    IncrementalDropletDetector detector(params);
+
+    // r = 4-5 px droplets only 40 grey levels darker than the background blink on and off in otherwise
+    // static tiles: far too little to move a tile's mean difference, but several samples change outright.
+    for (const int type : {CV_8U, CV_16U}) {
+        for (std::size_t i = 0; i < 24; ++i) {
+            cv::Mat image(256, 384, CV_8U, cv::Scalar(200));
+            for (int droplet = 0; droplet < 6; ++droplet) {
+                if ((i + static_cast<std::size_t>(droplet)) % 4 < 2) {
+                    const cv::Point center(37 + droplet * 61, 45 + (droplet % 3) * 77);
+                    cv::circle(image, center, 4 + droplet % 2, cv::Scalar(160), cv::FILLED);
+                }
+            }
+            cv::Mat frame = image;
+            if (type == CV_16U) {
+                image.convertTo(frame, CV_16U, 257.0);
+            }
+            const auto incremental = sorted(detector.detect(frame));
+            const auto full = sorted(detectDroplets(frame, params.detection));
+
+            ASSERT_EQ(incremental.size(), full.size()) << "type " << type << ", frame " << i;
+            for (std::size_t d = 0; d < full.size(); ++d) {
+                EXPECT_NEAR(incremental[d].centroid.x, full[d].centroid.x, 1e-3F) << "frame " << i;
+                EXPECT_NEAR(incremental[d].centroid.y, full[d].centroid.y, 1e-3F) << "frame " << i;
+            }
+            if (i > 0) {
+                EXPECT_FALSE(detector.lastStats().full_frame) << "type " << type << ", frame " << i;
+                EXPECT_GT(detector.lastStats().changed_tiles, 0U) << "type " << type << ", frame " << i;
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "LineScanAnalysis.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+constexpr double kFps = 8938.0;
+constexpr int kWidth = 2304;
+constexpr int kRows = 4;
+
+// Background ~200 (8-bit) with mild noise; a dark droplet covers columns [900, 1400) for `duration`
+// frames out of every `period` frames, starting at `phase`.
+template <typename T>
+cv::Mat makeStrip(std::size_t index, std::size_t period, std::size_t duration, std::size_t phase, cv::RNG& rng, double scale) {
+    const int type = sizeof(T) == 1 ? CV_8U : CV_16U;
+    cv::Mat strip(kRows, kWidth, type);
+    const bool droplet = index >= phase && (index - phase) % period < duration;
+    for (int y = 0; y < kRows; ++y) {
+        T* row = strip.ptr<T>(y);
+        for (int x = 0; x < kWidth; ++x) {
+            double value = 200.0 + rng.uniform(-4.0, 4.0);
+            if (droplet && x >= 900 && x < 1400) {
+                value = 70.0 + rng.uniform(-4.0, 4.0);
+            }
+            row[x] = static_cast<T>(value * scale);
+        }
+    }
+    return strip;
+}
+} // namespace
+
+TEST(LineScanAnalysis, DetectsPeriodicPassages8Bit) {
+    LineScanParams params;
+    params.probe_begin = 1000;
+    params.probe_end = 1200;
+    params.kymograph_rows = 64;
+
+    std::vector<LineScanPassage> passages;
+    LineScanAnalyzer analyzer(params, [&passages](const LineScanPassage& passage) { passages.push_back(passage); });
+
+    cv::RNG rng(5);
+    constexpr std::size_t kPeriod = 20;
+    constexpr std::size_t kDuration = 7;
+    for (std::size_t i = 0; i < 2000; ++i) {
+        analyzer.push(makeStrip<std::uint8_t>(i, kPeriod, kDuration, 40, rng, 1.0), static_cast<double>(i) / kFps);
+    }
+    analyzer.finish();
+
+    ASSERT_EQ(passages.size(), (2000 - 40) / kPeriod);
+    EXPECT_EQ(passages.front().start_frame, 40U);
+    for (const auto& passage : passages) {
+        EXPECT_EQ(passage.end_frame - passage.start_frame, kDuration);
+        EXPECT_FLOAT_EQ(passage.peak_occupancy, 1.0F);
+    }
+
+    const auto summary = analyzer.summary();
+    EXPECT_EQ(summary.passages, passages.size());
+    EXPECT_NEAR(summary.frequency_hz, kFps / kPeriod, 1e-6);
+    EXPECT_NEAR(summary.instantaneous_frequency_hz.mean(), kFps / kPeriod, 1e-6);
+    EXPECT_NEAR(summary.duration_s.mean(), kDuration / kFps, 1e-9);
+    EXPECT_NEAR(summary.gap_s.mean(), (kPeriod - kDuration) / kFps, 1e-9);
+
+    const cv::Mat kymograph = analyzer.kymograph();
+    ASSERT_EQ(kymograph.rows, 64);
+    ASSERT_EQ(kymograph.cols, kWidth);
+    // Newest row is the last frame pushed (frame 1999: (1999 - 40) % 20 = 19, no droplet).
+    EXPECT_NEAR(kymograph.at<float>(63, 1100), 200.0F, 6.0F);
+}
+
+TEST(LineScanAnalysis, Handles16BitAndBrightDroplets) {
+    LineScanParams params;
+    params.dark_droplets = false;
+    params.probe_begin = 900;
+    params.probe_end = 1400;
+    params.kymograph_rows = 0;
+    LineScanAnalyzer analyzer(params);
+
+    cv::RNG rng(9);
+    // Bright droplets: invert the synthetic strip around 270 in 16-bit scale (x200).
+    for (std::size_t i = 0; i < 600; ++i) {
+        cv::Mat strip = makeStrip<std::uint16_t>(i, 50, 10, 25, rng, 200.0);
+        for (int y = 0; y < strip.rows; ++y) {
+            auto* row = strip.ptr<std::uint16_t>(y);
+            for (int x = 0; x < strip.cols; ++x) {
+                row[x] = static_cast<std::uint16_t>(270 * 200 - row[x]);
+            }
+        }
+        analyzer.push(strip, static_cast<double>(i) / kFps);
+    }
+
+    const auto summary = analyzer.summary();
+    EXPECT_EQ(summary.passages, 12U);
+    EXPECT_NEAR(summary.frequency_hz, kFps / 50.0, 1e-6);
+    EXPECT_TRUE(analyzer.kymograph().empty());
+    EXPECT_THROW(analyzer.push(cv::Mat(4, 100, CV_16U, cv::Scalar(0)), 1.0), std::invalid_argument);
+}
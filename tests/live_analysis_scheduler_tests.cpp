@@ -0,0 +1,230 @@
+#include "LiveAnalysisScheduler.h"
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SimulatedCameraSource.h"
+
+namespace {
+SimulatedCameraParams smallCamera(double fps, std::uint64_t frame_limit) {
+    SimulatedCameraParams params;
+    params.width = 64;
+    params.height = 48;
+    params.fps = fps;
+    params.frame_limit = frame_limit;
+    params.droplet_radius_px = 6;
+    params.droplet_spacing_px = 24;
+    return params;
+}
+
+LiveAnalysisScheduler::Grabber grabberFor(SimulatedCameraSource& camera) {
+    return [&camera](StreamFrame& frame, std::chrono::microseconds timeout) {
+        return camera.grabNextFrame(frame, timeout);
+    };
+}
+
+// Analyzer that takes `delay` per frame and records the frame indices it saw.
+struct SlowAnalyzer {
+    std::chrono::milliseconds delay;
+    std::mutex mutex;
+    std::vector<std::uint64_t> seen;
+
+    LiveAnalysisScheduler::Analyzer callback() {
+        return [this](const StreamFrame& frame) {
+            std::this_thread::sleep_for(delay);
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.push_back(frame.frame_index);
+        };
+    }
+};
+
+bool strictlyIncreasing(const std::vector<std::uint64_t>& indices) {
+    for (std::size_t i = 1; i < indices.size(); ++i) {
+        if (indices[i] <= indices[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST(LatencyHistogram, ReportsPercentilesWithinOneBucket) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentileMs(50.0), 0.0);
+    for (int ms = 1; ms <= 100; ++ms) {
+        histogram.record(std::chrono::milliseconds(ms));
+    }
+    EXPECT_EQ(histogram.count(), 100U);
+    EXPECT_NEAR(histogram.meanMs(), 50.5, 1e-9);
+    EXPECT_DOUBLE_EQ(histogram.maxMs(), 100.0);
+    EXPECT_GE(histogram.percentileMs(50.0), 50.0);
+    EXPECT_LE(histogram.percentileMs(50.0), 50.0 * 1.19);
+    EXPECT_GE(histogram.percentileMs(95.0), 95.0);
+    EXPECT_DOUBLE_EQ(histogram.percentileMs(100.0), 100.0);
+
+    std::uint64_t total = 0;
+    for (std::size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+        total += histogram.bucketCount(bucket);
+    }
+    EXPECT_EQ(total, 100U);
+    EXPECT_NE(histogram.summary().find("n=100"), std::string::npos);
+}
+
+TEST(LiveAnalysisScheduler, SlowAnalysisSkipsFramesWithoutLosingAny) {
+    SimulatedCameraSource camera(smallCamera(400.0, 80));
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+
+    SlowAnalyzer analyzer{std::chrono::milliseconds(15), {}, {}};
+    LiveAnalysisScheduler scheduler;
+    ASSERT_TRUE(scheduler.start(grabberFor(camera), analyzer.callback(), error)) << error;
+    EXPECT_FALSE(scheduler.start(grabberFor(camera), {}, error));
+    scheduler.join();
+
+    const LiveSchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.frames_grabbed, 80U);
+    EXPECT_EQ(stats.frames_lost, 0U);
+    EXPECT_EQ(camera.stats().frames_lost, 0U);
+    EXPECT_GT(stats.analysis_skipped, 0U);
+    EXPECT_EQ(stats.frames_analyzed + stats.analysis_skipped, 80U);
+    EXPECT_EQ(stats.analysis_latency.count(), stats.frames_analyzed);
+    // Latest wins: the analysis ends on the newest frame, after skipping everything it could not get to.
+    ASSERT_EQ(analyzer.seen.size(), stats.frames_analyzed);
+    EXPECT_TRUE(strictlyIncreasing(analyzer.seen));
+    EXPECT_EQ(analyzer.seen.back(), 79U);
+}
+
+TEST(LiveAnalysisScheduler, BoundedLagDropsTheOldestQueuedFrames) {
+    LiveSchedulerParams params;
+    params.policy = LiveAnalysisPolicy::BoundedLag;
+    params.max_queued_frames = 5;
+
+    {
+        // Fast enough: every frame is analyzed.
+        SimulatedCameraSource camera(smallCamera(400.0, 40));
+        std::string error;
+        ASSERT_TRUE(camera.start(error)) << error;
+        SlowAnalyzer analyzer{std::chrono::milliseconds(0), {}, {}};
+        LiveAnalysisScheduler scheduler(params);
+        ASSERT_TRUE(scheduler.start(grabberFor(camera), analyzer.callback(), error)) << error;
+        scheduler.join();
+        EXPECT_EQ(scheduler.stats().frames_analyzed, 40U);
+        EXPECT_EQ(scheduler.stats().analysis_skipped, 0U);
+        EXPECT_EQ(analyzer.seen.size(), 40U);
+        EXPECT_TRUE(strictlyIncreasing(analyzer.seen));
+    }
+    {
+        // Too slow: the queue stays full, so the last five frames are all analyzed once acquisition ends.
+        SimulatedCameraSource camera(smallCamera(400.0, 80));
+        std::string error;
+        ASSERT_TRUE(camera.start(error)) << error;
+        SlowAnalyzer analyzer{std::chrono::milliseconds(15), {}, {}};
+        LiveAnalysisScheduler scheduler(params);
+        ASSERT_TRUE(scheduler.start(grabberFor(camera), analyzer.callback(), error)) << error;
+        scheduler.join();
+        const LiveSchedulerStats stats = scheduler.stats();
+        EXPECT_EQ(stats.frames_lost, 0U);
+        EXPECT_GT(stats.analysis_skipped, 0U);
+        EXPECT_EQ(stats.frames_analyzed + stats.analysis_skipped, 80U);
+        ASSERT_GE(analyzer.seen.size(), 5U);
+        EXPECT_TRUE(strictlyIncreasing(analyzer.seen));
+        const std::vector<std::uint64_t> tail(analyzer.seen.end() - 5, analyzer.seen.end());
+        EXPECT_EQ(tail, (std::vector<std::uint64_t>{75, 76, 77, 78, 79}));
+    }
+}
+
+TEST(LiveAnalysisScheduler, DisplayAlwaysGetsTheNewestFrame) {
+    SimulatedCameraSource camera(smallCamera(400.0, 60));
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    LiveAnalysisScheduler scheduler;
+    ASSERT_TRUE(scheduler.start(grabberFor(camera), {}, error)) << error;
+
+    // A repaint timer slower than the camera.
+    std::vector<std::uint64_t> shown;
+    StreamFrame frame;
+    for (int tick = 0; tick < 10; ++tick) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (scheduler.takeDisplayFrame(frame)) {
+            shown.push_back(frame.frame_index);
+        }
+    }
+    scheduler.join();
+    if (scheduler.takeDisplayFrame(frame)) {
+        shown.push_back(frame.frame_index);
+    }
+    EXPECT_FALSE(scheduler.takeDisplayFrame(frame));
+
+    ASSERT_FALSE(shown.empty());
+    EXPECT_TRUE(strictlyIncreasing(shown));
+    EXPECT_EQ(shown.back(), 59U);
+    const LiveSchedulerStats stats = scheduler.stats();
+    EXPECT_EQ(stats.frames_grabbed, 60U);
+    EXPECT_EQ(stats.frames_analyzed, 0U);
+    EXPECT_EQ(stats.frames_displayed + stats.display_superseded, 60U);
+    EXPECT_GT(stats.display_superseded, 0U);
+    EXPECT_EQ(stats.display_latency.count(), stats.frames_displayed);
+}
+
+TEST(LiveAnalysisScheduler, CountsAnalysisErrorsAndStopsOnRequest) {
+    SimulatedCameraSource camera(smallCamera(200.0, 0));
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    LiveSchedulerParams params;
+    params.policy = LiveAnalysisPolicy::BoundedLag;
+    LiveAnalysisScheduler scheduler(params);
+    ASSERT_TRUE(scheduler.start(
+        grabberFor(camera),
+        [](const StreamFrame& frame) {
+            if (frame.frame_index == 2) {
+                throw std::runtime_error("bad frame");
+            }
+        },
+        error))
+        << error;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    scheduler.stop();
+    const LiveSchedulerStats stats = scheduler.stats();
+    EXPECT_GT(stats.frames_grabbed, 3U);
+    EXPECT_EQ(stats.analysis_errors, 1U);
+    EXPECT_EQ(stats.last_error, "Frame 2: bad frame");
+    EXPECT_EQ(stats.frames_analyzed + stats.analysis_skipped + stats.analysis_errors, stats.frames_grabbed);
+    EXPECT_TRUE(camera.isAcquiring());
+}
+
+TEST(LiveAnalysisScheduler, RestartsAfterStop) {
+    SimulatedCameraSource camera(smallCamera(400.0, 0));
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    SlowAnalyzer analyzer{std::chrono::milliseconds(0), {}, {}};
+    LiveAnalysisScheduler scheduler;
+    ASSERT_TRUE(scheduler.start(grabberFor(camera), analyzer.callback(), error)) << error;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    scheduler.stop();
+    const LiveSchedulerStats first = scheduler.stats();
+    ASSERT_GT(first.frames_grabbed, 0U);
+    const std::uint64_t last_first_run = analyzer.seen.empty() ? 0 : analyzer.seen.back();
+
+    // The camera keeps acquiring while the scheduler is stopped; those frames were not the new run's to lose.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    analyzer.seen.clear();
+    ASSERT_TRUE(scheduler.start(grabberFor(camera), analyzer.callback(), error)) << error;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    camera.stop();
+    scheduler.join();
+
+    const LiveSchedulerStats second = scheduler.stats();
+    EXPECT_GT(second.frames_grabbed, 0U);
+    EXPECT_EQ(second.frames_lost, 0U);
+    EXPECT_EQ(second.frames_analyzed + second.analysis_skipped, second.frames_grabbed);
+    ASSERT_FALSE(analyzer.seen.empty());
+    EXPECT_GT(analyzer.seen.front(), last_first_run);
+    EXPECT_TRUE(strictlyIncreasing(analyzer.seen));
+}
@@ -0,0 +1,114 @@
+#include "FrameCache.h"
+#include "MemoryGovernor.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+// 4x4 8-bit frame (16 bytes).
+cv::Mat frameOf(std::size_t value) {
+    return cv::Mat(4, 4, CV_8UC1, cv::Scalar(static_cast<double>(value % 256)));
+}
+
+void load(FrameCache& cache, std::size_t first, std::size_t count) {
+    for (std::size_t id = first; id < first + count; ++id) {
+        cache.get(id, [id]() { return frameOf(id); });
+    }
+}
+} // namespace
+
+TEST(MemoryGovernor, TracksCurrentAndPeakBytesPerCategory) {
+    MemoryGovernor governor;
+    {
+        MemoryCharge background(MemoryCategory::Background, 300, governor);
+        MemoryCharge scratch(MemoryCategory::DetectorScratch, 100, governor);
+        scratch.resize(200);
+        EXPECT_EQ(governor.currentBytes(), 500U);
+        scratch.resize(50);
+
+        const MemoryCharge copy = background;
+        EXPECT_EQ(governor.currentBytes(MemoryCategory::Background), 600U);
+        EXPECT_EQ(governor.currentBytes(), 650U);
+
+        MemoryCharge moved = std::move(scratch);
+        EXPECT_EQ(scratch.bytes(), 0U);
+        EXPECT_EQ(moved.bytes(), 50U);
+        EXPECT_EQ(governor.currentBytes(MemoryCategory::DetectorScratch), 50U);
+    }
+
+    const MemoryUsage usage = governor.usage();
+    EXPECT_EQ(usage.bytes, 0U);
+    EXPECT_EQ(usage.peak_bytes, 650U);
+    EXPECT_EQ(usage[MemoryCategory::Background].peak_bytes, 600U);
+    EXPECT_EQ(usage[MemoryCategory::DetectorScratch].peak_bytes, 200U);
+    EXPECT_STREQ(usage[MemoryCategory::Results].name, "results");
+    EXPECT_EQ(usage.shrink_requests, 0U);
+
+    governor.resetPeak();
+    EXPECT_EQ(governor.peakBytes(), 0U);
+
+    const MemoryCharge results(MemoryCategory::Results, 3U * 1024U * 1024U, governor);
+    EXPECT_EQ(governor.usage().summary(), "3.0 MB (peak 3.0 MB): results 3.0 MB");
+}
+
+TEST(MemoryGovernor, ShrinksCachesToMakeRoomForOtherConsumers) {
+    MemoryGovernor governor(10 * 16);
+    FrameCache cache(100 * 16, 2, nullptr, &governor);
+    load(cache, 0, 8);
+    EXPECT_EQ(governor.currentBytes(MemoryCategory::FrameCache), 8U * 16U);
+
+    {
+        // 8 frames + 4 frames' worth of results is two frames over budget: the oldest two go.
+        const MemoryCharge results(MemoryCategory::Results, 4 * 16, governor);
+        EXPECT_EQ(cache.stats().frames, 6U);
+        EXPECT_EQ(governor.currentBytes(), 10U * 16U);
+        EXPECT_EQ(governor.usage().shrink_requests, 1U);
+
+        // The cache keeps loading, but only into what the other consumers leave (each new frame overshoots by
+        // itself until the next victim goes).
+        governor.resetPeak();
+        load(cache, 8, 4);
+        EXPECT_EQ(cache.stats().frames, 6U);
+        EXPECT_LE(governor.peakBytes(), 11U * 16U);
+    }
+
+    // Budget freed elsewhere is the cache's to use again.
+    load(cache, 12, 4);
+    EXPECT_EQ(cache.stats().frames, 10U);
+
+    // Pinned frames are not given back; the overrun is reported instead.
+    std::vector<std::size_t> pinned(10);
+    for (std::size_t index = 0; index < pinned.size(); ++index) {
+        pinned[index] = 6 + index;
+    }
+    cache.pin("background", pinned);
+    const MemoryCharge scratch(MemoryCategory::DetectorScratch, 16, governor);
+    EXPECT_EQ(cache.stats().frames, 10U);
+    EXPECT_EQ(governor.usage().overruns, 1U);
+}
+
+TEST(MemoryGovernor, DropsCompressedFramesBeforeDecodedOnes) {
+    MemoryGovernor governor;
+    std::size_t cached_bytes = 0;
+    {
+        FrameCache cache(2 * 16, 1, nullptr, &governor);
+        cache.setCompressedBudget(1024);
+        load(cache, 0, 4);
+        const FrameCacheStats stats = cache.stats();
+        ASSERT_EQ(stats.frames, 2U);
+        ASSERT_EQ(stats.compressed_frames, 2U);
+        EXPECT_EQ(governor.currentBytes(MemoryCategory::CompressedFrames), stats.compressed_bytes);
+        cached_bytes = 2 * 16 + stats.compressed_bytes;
+        EXPECT_EQ(governor.currentBytes(), cached_bytes);
+
+        governor.setBudget(2 * 16);
+        EXPECT_EQ(cache.stats().frames, 2U);
+        EXPECT_EQ(cache.stats().compressed_frames, 0U);
+        EXPECT_EQ(governor.usage().shrunk_bytes, stats.compressed_bytes);
+    }
+    // A destroyed cache no longer counts.
+    EXPECT_EQ(governor.currentBytes(), 0U);
+}
@@ -0,0 +1,190 @@
+#include "MultiPageTIFFSource.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+// A TIFF path in a fresh directory, so its sidecar index goes away with it.
+class TempFile {
+public:
+    explicit TempFile(const std::string& name) : dir_(name) {}
+    std::string path() const { return (dir_.path() / "stack.tif").string(); }
+
+private:
+    TestTempDirectory dir_;
+};
+
+std::vector<cv::Mat> makePages(std::size_t count, int rows = 16, int cols = 24, int type = CV_16UC1) {
+    std::vector<cv::Mat> pages;
+    for (std::size_t p = 0; p < count; ++p) {
+        cv::Mat page(rows, cols, type);
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < cols; ++x) {
+                if (type == CV_8UC1) {
+                    page.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(p * 7 + x + y);
+                } else {
+                    page.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(p * 1000 + x * 31 + y);
+                }
+            }
+        }
+        pages.push_back(page);
+    }
+    return pages;
+}
+
+void writePages(const std::string& path, const std::vector<cv::Mat>& pages, const TiffWriteOptions& options = {}) {
+    std::string error;
+    ASSERT_TRUE(TiffFormat::writeGrayscalePages(path, pages, error, options)) << error;
+}
+
+bool samePixels(const cv::Mat& left, const cv::Mat& right) {
+    if (left.size() != right.size() || left.type() != right.type()) {
+        return false;
+    }
+    for (int y = 0; y < left.rows; ++y) {
+        if (std::memcmp(left.ptr(y), right.ptr(y), static_cast<std::size_t>(left.cols) * left.elemSize()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST(MultiPageTIFFSource, LoadsPagesAndReusesTheSidecarIndex) {
+    TempFile file("droplet_multipage_basic.tif");
+    const auto pages = makePages(3);
+    writePages(file.path(), pages);
+
+    MultiPageTIFFSource source(file.path());
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_EQ(source.getType(), InputSource::Type::MultiPageTIFF);
+    ASSERT_EQ(source.getTotalFrames(), 3U);
+    EXPECT_FALSE(source.loadedFromIndex());
+    EXPECT_TRUE(source.indexWriteError().empty()) << source.indexWriteError();
+    EXPECT_TRUE(std::filesystem::exists(MultiPageTIFFSource::indexPath(file.path())));
+    for (std::size_t i = 0; i < pages.size(); ++i) {
+        EXPECT_TRUE(samePixels(source.getFrame(i), pages[i])) << "page " << i;
+        EXPECT_DOUBLE_EQ(source.getTimestamp(i), static_cast<double>(i));
+    }
+    EXPECT_EQ(source.readStats().zero_copy_frames, 3U);
+    EXPECT_THROW(source.getFrame(5), std::out_of_range);
+
+    MultiPageTIFFSource reopened(file.path());
+    ASSERT_TRUE(reopened.load(error)) << error;
+    EXPECT_TRUE(reopened.loadedFromIndex());
+    EXPECT_EQ(reopened.frameSize(), cv::Size(24, 16));
+    EXPECT_EQ(reopened.frameType(), CV_16UC1);
+    EXPECT_TRUE(samePixels(reopened.getFrame(2), pages[2]));
+
+    // Rewriting the stack invalidates the index (size and mtime no longer match).
+    const auto longer = makePages(4);
+    writePages(file.path(), longer);
+    MultiPageTIFFSource rewritten(file.path());
+    ASSERT_TRUE(rewritten.load(error)) << error;
+    EXPECT_FALSE(rewritten.loadedFromIndex());
+    EXPECT_EQ(rewritten.getTotalFrames(), 4U);
+    EXPECT_TRUE(samePixels(rewritten.getFrame(3), longer[3]));
+}
+
+TEST(MultiPageTIFFSource, CorruptIndexFallsBackToScanning) {
+    TempFile file("droplet_multipage_corrupt_index.tif");
+    const auto pages = makePages(2);
+    writePages(file.path(), pages);
+
+    std::string error;
+    {
+        MultiPageTIFFSource source(file.path());
+        ASSERT_TRUE(source.load(error)) << error;
+    }
+    {
+        std::fstream index(MultiPageTIFFSource::indexPath(file.path()), std::ios::in | std::ios::out | std::ios::binary);
+        index.seekp(40);
+        index.put('\x7f');
+    }
+    MultiPageTIFFSource source(file.path());
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_FALSE(source.loadedFromIndex());
+    EXPECT_TRUE(samePixels(source.getFrame(1), pages[1]));
+}
+
+TEST(MultiPageTIFFSource, RandomAccessIntoLargeBigTiffStacksFromSeveralThreads) {
+    TempFile file("droplet_multipage_bigtiff.tif");
+    TiffWriteOptions options;
+    options.big_tiff = true;
+    options.rows_per_strip = 5;
+    const auto pages = makePages(300, 12, 20);
+    writePages(file.path(), pages, options);
+
+    MultiPageTIFFSource source(file.path(), 0);
+    std::string error;
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_TRUE(source.isBigTiff());
+    ASSERT_EQ(source.getTotalFrames(), 300U);
+
+    std::vector<int> mismatches(4, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < 300; ++i) {
+                const std::size_t page = (i * 37 + static_cast<std::size_t>(t) * 101) % 300;
+                if (!samePixels(source.getFrame(page), pages[page])) {
+                    ++mismatches[static_cast<std::size_t>(t)];
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const int count : mismatches) {
+        EXPECT_EQ(count, 0);
+    }
+    EXPECT_EQ(source.readStats().zero_copy_frames, 1200U);
+
+    MultiPageTIFFSource reopened(file.path(), 0);
+    ASSERT_TRUE(reopened.load(error)) << error;
+    EXPECT_TRUE(reopened.loadedFromIndex());
+    EXPECT_TRUE(reopened.isBigTiff());
+    EXPECT_TRUE(samePixels(reopened.getFrame(299), pages[299]));
+}
+
+TEST(MultiPageTIFFSource, RejectsOversizedAndInconsistentStacks) {
+    TempFile file("droplet_multipage_invalid.tif");
+    writePages(file.path(), makePages(14));
+    MultiPageTIFFSource too_many(file.path());
+    std::string error;
+    EXPECT_FALSE(too_many.load(error));
+    EXPECT_NE(error.find("more than 10 pages"), std::string::npos);
+    EXPECT_EQ(too_many.getTotalFrames(), 0U);
+    // The limited scan stopped at page 11 of 14, so it must not be indexed as the whole stack.
+    EXPECT_FALSE(std::filesystem::exists(MultiPageTIFFSource::indexPath(file.path())));
+    MultiPageTIFFSource unlimited(file.path(), 0);
+    ASSERT_TRUE(unlimited.load(error)) << error;
+    EXPECT_FALSE(unlimited.loadedFromIndex());
+    EXPECT_EQ(unlimited.getTotalFrames(), 14U);
+
+    auto mixed_size = makePages(2);
+    mixed_size.push_back(makePages(1, 10, 24).front());
+    writePages(file.path(), mixed_size);
+    MultiPageTIFFSource sizes(file.path());
+    EXPECT_FALSE(sizes.load(error));
+    EXPECT_NE(error.find("Page 2 dimension mismatch"), std::string::npos);
+
+    auto mixed_depth = makePages(1);
+    mixed_depth.push_back(makePages(1, 16, 24, CV_8UC1).front());
+    writePages(file.path(), mixed_depth);
+    MultiPageTIFFSource depths(file.path());
+    EXPECT_FALSE(depths.load(error));
+    EXPECT_NE(error.find("bit depth mismatch"), std::string::npos);
+}
@@ -0,0 +1,118 @@
+#include "PooledMatAllocator.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+PooledMatAllocatorParams smallPoolParams() {
+    PooledMatAllocatorParams params;
+    params.min_pooled_bytes = 4096;
+    return params;
+}
+
+cv::Mat allocateFrom(PooledMatAllocator& pool, int rows, int cols, int type) {
+    cv::Mat image;
+    image.allocator = &pool;
+    image.create(rows, cols, type);
+    return image;
+}
+} // namespace
+
+TEST(PooledMatAllocator, ReusesPageAlignedBuffersOfTheSameSizeClass) {
+    MemoryGovernor governor;
+    const auto pool = PooledMatAllocator::create(smallPoolParams(), &governor);
+
+    const std::uint8_t* first_data = nullptr;
+    {
+        cv::Mat image = allocateFrom(*pool, 300, 300, CV_16UC1);
+        first_data = image.data;
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(image.data) % 4096, 0U);
+        image.at<std::uint16_t>(299, 299) = 7;
+    }
+    const std::size_t bytes = pool->sizeClass(300 * 300 * 2);
+    EXPECT_EQ(pool->stats().bytes_retained, bytes);
+    EXPECT_EQ(governor.currentBytes(MemoryCategory::PooledBuffers), bytes);
+
+    {
+        // A slightly different size in the same class gets the same buffer back.
+        const cv::Mat image = allocateFrom(*pool, 299, 301, CV_16UC1);
+        EXPECT_EQ(image.data, first_data);
+        EXPECT_EQ(pool->stats().bytes_in_use, bytes);
+        EXPECT_EQ(governor.currentBytes(MemoryCategory::PooledBuffers), 0U);
+    }
+
+    const PooledMatAllocatorStats stats = pool->stats();
+    EXPECT_EQ(stats.misses, 1U);
+    EXPECT_EQ(stats.hits, 1U);
+    EXPECT_EQ(stats.buffers_retained, 1U);
+    EXPECT_EQ(stats.bytes_in_use, 0U);
+}
+
+TEST(PooledMatAllocator, SizeClassesWasteAtMostAnEighth) {
+    const auto pool = PooledMatAllocator::create({}, nullptr);
+    for (const std::size_t bytes : {std::size_t{1}, std::size_t{5000}, std::size_t{1U << 20},
+                                    std::size_t{2304U * 2304U * 2U}, std::size_t{1800U * 1800U * 4U}}) {
+        const std::size_t size_class = pool->sizeClass(bytes);
+        EXPECT_GE(size_class, bytes);
+        EXPECT_EQ(size_class % 4096, 0U);
+        if (bytes >= 64U * 1024U) {
+            EXPECT_LE(size_class, bytes + bytes / 8);
+        }
+    }
+
+    PooledMatAllocatorParams huge;
+    huge.huge_pages = true;
+    const auto huge_pool = PooledMatAllocator::create(huge, nullptr);
+    EXPECT_EQ(huge_pool->sizeClass(2304U * 2304U * 2U) % PooledMatAllocator::kHugePageBytes, 0U);
+    const cv::Mat frame = allocateFrom(*huge_pool, 2304, 2304, CV_16UC1);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(frame.data) % PooledMatAllocator::kHugePageBytes, 0U);
+}
+
+TEST(PooledMatAllocator, ScopedGuardRoutesOnlyThisThreadsLargeAllocations) {
+    const auto pool = PooledMatAllocator::create(smallPoolParams(), nullptr);
+    {
+        const ScopedMatAllocator guard(pool);
+        const cv::Mat large(256, 256, CV_8UC1);
+        const cv::Mat small(8, 8, CV_8UC1);
+        std::thread other([]() { const cv::Mat elsewhere(256, 256, CV_8UC1); });
+        other.join();
+
+        const PooledMatAllocatorStats stats = pool->stats();
+        EXPECT_EQ(stats.misses, 1U);
+        EXPECT_EQ(stats.unpooled, 1U);
+        EXPECT_EQ(stats.bytes_in_use, pool->sizeClass(256 * 256));
+    }
+    const cv::Mat after(256, 256, CV_8UC1);
+    EXPECT_EQ(pool->stats().misses, 1U);
+}
+
+TEST(PooledMatAllocator, BuffersOutliveThePoolAndRetentionIsBounded) {
+    MemoryGovernor governor;
+    PooledMatAllocatorParams params = smallPoolParams();
+    auto pool = PooledMatAllocator::create(params, &governor);
+    const std::size_t bytes = pool->sizeClass(64 * 1024);
+    params.max_retained_bytes = bytes;
+    pool = PooledMatAllocator::create(params, &governor);
+
+    {
+        const cv::Mat first = allocateFrom(*pool, 256, 256, CV_8UC1);
+        const cv::Mat second = allocateFrom(*pool, 256, 256, CV_8UC1);
+    }
+    EXPECT_EQ(pool->stats().buffers_retained, 1U);
+    EXPECT_EQ(pool->stats().released, 1U);
+
+    // The governor takes retained buffers back when it needs the memory.
+    governor.setBudget(1);
+    EXPECT_EQ(pool->stats().bytes_retained, 0U);
+    EXPECT_EQ(governor.usage().shrunk_bytes, bytes);
+
+    cv::Mat survivor = allocateFrom(*pool, 256, 256, CV_8UC1);
+    pool.reset();
+    survivor.at<std::uint8_t>(255, 255) = 1;
+    EXPECT_EQ(survivor.at<std::uint8_t>(255, 255), 1);
+    survivor.release();
+    EXPECT_EQ(governor.currentBytes(), 0U);
+}
@@ -0,0 +1,125 @@
+#include "PredictiveDetection.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/imgproc.hpp>
+
+namespace {
+DropletDetectionParams detectionParams() {
+    DropletDetectionParams params{};
+    params.gaussian_sigma = 0.0;
+    params.gaussian_kernel_size = 1;
+    params.adaptive_block_size = 15;
+    params.adaptive_c = 2.0;
+    params.morph_open_kernel = 1;
+    params.morph_close_kernel = 1;
+    params.min_area_px2 = 100.0;
+    params.invert_threshold = true;
+    return params;
+}
+
+// Dark droplets (r = 8) enter at the left every 32 frames in two lanes and move 5 px/frame.
+cv::Mat makeFrame(std::size_t index) {
+    cv::Mat image(256, 1024, CV_8U, cv::Scalar(200));
+    for (int lane = 0; lane < 2; ++lane) {
+        for (std::size_t born = 0; born <= index; ++born) {
+            if ((born + static_cast<std::size_t>(lane) * 16) % 32 != 0) {
+                continue;
+            }
+            const int x = -8 + 5 * static_cast<int>(index - born);
+            if (x > image.cols + 8) {
+                continue;
+            }
+            cv::circle(image, cv::Point(x, 64 + 128 * lane), 8, cv::Scalar(30), cv::FILLED);
+        }
+    }
+    return image;
+}
+
+std::vector<cv::Point2f> sortedCentroids(const std::vector<Detection>& detections) {
+    std::vector<cv::Point2f> centroids;
+    for (const auto& detection : detections) {
+        centroids.push_back(detection.centroid);
+    }
+    std::sort(centroids.begin(), centroids.end(), [](const cv::Point2f& left, const cv::Point2f& right) {
+        return left.x != right.x ? left.x < right.x : left.y < right.y;
+    });
+    return centroids;
+}
+} // namespace
+
+TEST(PredictiveDetection, MatchesFullFrameDetectionWhileProcessingFewerPixels) {
+    PredictiveDetectionParams params;
+    params.detection = detectionParams();
+    params.entry_zone = cv::Rect(0, 0, 40, 256);
+    params.resync_interval_frames = 25;
+
+    TrackingParams tracking;
+    tracking.search_radius_px = 8.0;
+
+    PredictiveDropletDetector detector(params);
+    StreamingTracker tracker(tracking, MeasurementLine{}, [](Track&&) {});
+
+    for (std::size_t i = 0; i < 200; ++i) {
+        const cv::Mat frame = makeFrame(i);
+        const auto sparse = detector.detect(frame, tracker.predictions(i));
+        const auto full = detectDroplets(frame, params.detection);
+
+        const auto sparse_centroids = sortedCentroids(sparse);
+        const auto full_centroids = sortedCentroids(full);
+        ASSERT_EQ(sparse_centroids.size(), full_centroids.size()) << "frame " << i;
+        for (std::size_t d = 0; d < full_centroids.size(); ++d) {
+            EXPECT_NEAR(sparse_centroids[d].x, full_centroids[d].x, 1e-3F) << "frame " << i;
+            EXPECT_NEAR(sparse_centroids[d].y, full_centroids[d].y, 1e-3F) << "frame " << i;
+        }
+
+        FrameDetections frame_detections{};
+        frame_detections.frame_index_logical = i;
+        frame_detections.timestamp_inferred_s = static_cast<double>(i) / 100.0;
+        frame_detections.detections = sparse;
+        tracker.push(frame_detections);
+    }
+
+    EXPECT_EQ(detector.framesProcessed(), 200U);
+    EXPECT_GE(detector.fullFrameCount(), 8U);
+    EXPECT_LT(detector.averageProcessedFraction(), 0.5);
+}
+
+TEST(PredictiveDetection, FallsBackToFullFrameWhenGatingFails) {
+    PredictiveDetectionParams params;
+    params.detection = detectionParams();
+    params.resync_interval_frames = 0;
+    PredictiveDropletDetector detector(params);
+
+    cv::Mat frame(160, 640, CV_8U, cv::Scalar(200));
+    cv::circle(frame, cv::Point(300, 80), 8, cv::Scalar(30), cv::FILLED);
+    ASSERT_EQ(detector.detect(frame, {}).size(), 1U);
+    EXPECT_TRUE(detector.lastStats().full_frame);
+
+    // The droplet is predicted at x = 305 but jumped far away: the window is empty, so the detector must
+    // fall back to the full frame and still find it.
+    TrackPrediction prediction;
+    prediction.track_id = 1;
+    prediction.position = cv::Point2f(305.0F, 80.0F);
+    prediction.search_radius = 12.0F;
+    prediction.extent_px = 17.0F;
+
+    cv::Mat moved(160, 640, CV_8U, cv::Scalar(200));
+    cv::circle(moved, cv::Point(500, 80), 8, cv::Scalar(30), cv::FILLED);
+    const auto detections = detector.detect(moved, {prediction});
+    ASSERT_EQ(detections.size(), 1U);
+    EXPECT_NEAR(detections.front().centroid.x, 500.0F, 1.0F);
+    EXPECT_TRUE(detector.lastStats().gating_failed);
+    EXPECT_TRUE(detector.lastStats().full_frame);
+    EXPECT_GT(detector.lastStats().processed_pixel_fraction, 1.0);
+
+    // Tracked correctly this time: only the window is processed.
+    prediction.position = cv::Point2f(500.0F, 80.0F);
+    ASSERT_EQ(detector.detect(moved, {prediction}).size(), 1U);
+    EXPECT_FALSE(detector.lastStats().full_frame);
+    EXPECT_LT(detector.lastStats().processed_pixel_fraction, 0.1);
+}
@@ -0,0 +1,189 @@
+#include "PrefetchingSource.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+// 4x4 8-bit frames filled with their index; optionally slow, optionally failing at one index.
+class CountingSource final : public InputSource {
+public:
+    explicit CountingSource(std::size_t total, std::chrono::milliseconds delay = {}, std::size_t failing = SIZE_MAX)
+        : total_(total), delay_(delay), failing_(failing) {}
+
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return total_; }
+    cv::Mat getFrame(std::size_t logical_index) override {
+        reads.fetch_add(1);
+        if (delay_.count() > 0) {
+            std::this_thread::sleep_for(delay_);
+        }
+        if (logical_index == failing_) {
+            throw std::runtime_error("unreadable frame");
+        }
+        cv::Mat frame(4, 4, CV_8UC1);
+        for (int y = 0; y < frame.rows; ++y) {
+            for (int x = 0; x < frame.cols; ++x) {
+                frame.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(logical_index);
+            }
+        }
+        return frame;
+    }
+    double getTimestamp(std::size_t logical_index) const override { return static_cast<double>(logical_index); }
+
+    std::atomic<std::size_t> reads{0};
+
+private:
+    std::size_t total_;
+    std::chrono::milliseconds delay_;
+    std::size_t failing_;
+};
+
+// Reads of frames in [blocked_begin, blocked_end) wait until release().
+class GatedSource final : public InputSource {
+public:
+    GatedSource(std::size_t blocked_begin, std::size_t blocked_end)
+        : blocked_begin_(blocked_begin), blocked_end_(blocked_end) {}
+
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return 200; }
+    cv::Mat getFrame(std::size_t logical_index) override {
+        if (logical_index >= blocked_begin_ && logical_index < blocked_end_) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++waiting_;
+            changed_.notify_all();
+            changed_.wait(lock, [&]() { return released_; });
+        }
+        return cv::Mat(4, 4, CV_8UC1, cv::Scalar(static_cast<double>(logical_index)));
+    }
+    double getTimestamp(std::size_t logical_index) const override { return static_cast<double>(logical_index); }
+
+    bool waitForReads(std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(5), [&]() { return waiting_ >= count; });
+    }
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        changed_.notify_all();
+    }
+
+private:
+    std::size_t blocked_begin_;
+    std::size_t blocked_end_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::size_t waiting_ = 0;
+    bool released_ = false;
+};
+
+std::uint8_t valueOf(const cv::Mat& frame) {
+    return frame.at<std::uint8_t>(3, 3);
+}
+} // namespace
+
+TEST(PrefetchingSource, ReadsAheadOfSequentialAndStridedAccess) {
+    auto counting = std::make_shared<CountingSource>(200, std::chrono::milliseconds(1));
+    PrefetchingSource source(counting);
+    EXPECT_EQ(source.getTotalFrames(), 200U);
+    EXPECT_DOUBLE_EQ(source.getTimestamp(7), 7.0);
+
+    for (std::size_t i = 0; i < 40; ++i) {
+        ASSERT_EQ(valueOf(source.getFrame(i)), i);
+    }
+    PrefetchStats stats = source.stats();
+    EXPECT_EQ(stats.misses, 3U);
+    EXPECT_EQ(stats.hits + stats.late_hits, 37U);
+    EXPECT_EQ(stats.pattern_changes, 0U);
+
+    // Auto-tune style sampling: every 10th frame, backwards.
+    for (std::size_t i = 190; i >= 60; i -= 10) {
+        ASSERT_EQ(valueOf(source.getFrame(i)), i);
+    }
+    stats = source.stats();
+    EXPECT_EQ(stats.pattern_changes, 1U);
+    EXPECT_EQ(stats.misses, 6U);
+    EXPECT_EQ(stats.hits + stats.late_hits, 37U + 11U);
+}
+
+TEST(PrefetchingSource, RespectsTheByteBudget) {
+    auto counting = std::make_shared<CountingSource>(100);
+    PrefetchParams params;
+    params.byte_budget = 3 * 16;  // three 4x4 8-bit frames
+    params.max_depth = 10;
+    PrefetchingSource source(counting, params);
+    for (std::size_t i = 0; i < 30; ++i) {
+        ASSERT_EQ(valueOf(source.getFrame(i)), i);
+    }
+    const PrefetchStats stats = source.stats();
+    EXPECT_LE(stats.peak_bytes, 3U * 16U);
+    EXPECT_GT(stats.hits + stats.late_hits, 20U);
+}
+
+TEST(PrefetchingSource, CancelsReadAheadWhenThePatternChanges) {
+    auto counting = std::make_shared<CountingSource>(200, std::chrono::milliseconds(2));
+    PrefetchParams params;
+    params.io_threads = 1;
+    params.max_depth = 16;
+    PrefetchingSource source(counting, params);
+    for (std::size_t i = 0; i < 4; ++i) {
+        source.getFrame(i);
+    }
+    // Scrub back: everything queued ahead of frame 3 is dropped, most of it before it was read.
+    ASSERT_EQ(valueOf(source.getFrame(150)), 150U);
+    const PrefetchStats stats = source.stats();
+    EXPECT_EQ(stats.pattern_changes, 1U);
+    EXPECT_GE(stats.cancelled, 10U);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_LT(counting->reads.load(), 4U + 1U + 16U);
+    EXPECT_EQ(valueOf(source.getFrame(5)), 5U);
+    EXPECT_EQ(source.stats().misses, stats.misses + 1);
+}
+
+TEST(PrefetchingSource, CancelledReadsInFlightStayInTheBudgetUntilTheyReturn) {
+    auto gated = std::make_shared<GatedSource>(3, 100);
+    PrefetchParams params;
+    params.io_threads = 2;
+    params.byte_budget = 2 * 16;
+    PrefetchingSource source(gated, params);
+    for (std::size_t i = 0; i < 3; ++i) {
+        source.getFrame(i);
+    }
+    const bool started = gated->waitForReads(2);  // frames 3 and 4, both stuck in a read
+    EXPECT_TRUE(started);
+
+    // A new stride cancels them, but their buffers are still being written: nothing more fits the budget.
+    for (const std::size_t i : {100, 110, 120}) {
+        source.getFrame(i);
+    }
+    PrefetchStats stats = source.stats();
+    EXPECT_EQ(stats.cancelled, 2U);
+    EXPECT_EQ(stats.issued, 2U);
+    EXPECT_LE(stats.peak_bytes, 2U * 16U);
+
+    gated->release();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(valueOf(source.getFrame(130)), 130U);
+    stats = source.stats();
+    EXPECT_EQ(stats.issued, 4U);
+    EXPECT_LE(stats.peak_bytes, 2U * 16U);
+}
+
+TEST(PrefetchingSource, FailedPrefetchSurfacesOnTheConsumerAndShutdownDrains) {
+    auto counting = std::make_shared<CountingSource>(50, std::chrono::milliseconds(1), 6);
+    {
+        PrefetchingSource source(counting);
+        for (std::size_t i = 0; i < 6; ++i) {
+            source.getFrame(i);
+        }
+        EXPECT_THROW(source.getFrame(6), std::runtime_error);
+        EXPECT_EQ(valueOf(source.getFrame(7)), 7U);
+    }
+    EXPECT_THROW(PrefetchingSource(nullptr), std::invalid_argument);
+}
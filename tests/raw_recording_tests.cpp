@@ -0,0 +1,140 @@
+#include "RawRecording.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+// 40x30 16-bit frame whose pixels encode the camera frame index and their position.
+StreamFrame streamFrame(std::uint64_t frame_index) {
+    StreamFrame frame;
+    frame.image = cv::Mat(30, 40, CV_16UC1);
+    for (int y = 0; y < 30; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            frame.image.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(frame_index * 1000 + y * 40 + x);
+        }
+    }
+    frame.frame_index = frame_index;
+    frame.timestamp = static_cast<double>(frame_index) / 25.0;
+    return frame;
+}
+
+bool matchesFrame(const cv::Mat& image, std::uint64_t frame_index) {
+    for (int y = 0; y < 30; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            if (image.at<std::uint16_t>(y, x) != static_cast<std::uint16_t>(frame_index * 1000 + y * 40 + x)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST(RawRecording, RoundTripsChunkedFramesWithTheirIndex) {
+    TestTempDirectory dir("droplet_raw_recording_round_trip");
+    const std::string path = (dir.path() / "run.draw").string();
+
+    RawRecorderParams params;
+    params.chunk_bytes = 3 * 40 * 30 * 2;  // three frames per chunk
+    RawRecorder recorder(params);
+    std::string error;
+    ASSERT_TRUE(recorder.open(path, cv::Size(40, 30), CV_16UC1, 25.0, error)) << error;
+    EXPECT_FALSE(recorder.open(path, cv::Size(40, 30), CV_16UC1, 25.0, error));
+    // Frame 3 never reached the recorder; frames 0-2 and 4-10 did.
+    for (std::uint64_t index = 0; index <= 10; ++index) {
+        if (index != 3) {
+            ASSERT_TRUE(recorder.record(streamFrame(index)));
+        }
+    }
+    StreamFrame wrong_size;
+    wrong_size.image = cv::Mat(10, 10, CV_16UC1, cv::Scalar(0));
+    EXPECT_FALSE(recorder.record(wrong_size));
+    ASSERT_TRUE(recorder.finish(error)) << error;
+    EXPECT_FALSE(recorder.isOpen());
+
+    const RawRecorderStats stats = recorder.stats();
+    EXPECT_EQ(stats.frames_recorded, 10U);
+    EXPECT_EQ(stats.frames_dropped, 1U);
+    EXPECT_EQ(stats.chunks_written, 4U);
+    EXPECT_EQ(stats.bytes_written, 4U * 8192U);
+    // Header, four 4 KB-aligned chunks of three 2400-byte frames, and the 16-byte index entries.
+    EXPECT_EQ(std::filesystem::file_size(path), 4096U + 4U * 8192U + 10U * 16U);
+
+    RawRecordingSource source(path);
+    ASSERT_TRUE(source.load(error)) << error;
+    EXPECT_EQ(source.getType(), InputSource::Type::ImageSequence);
+    ASSERT_EQ(source.getTotalFrames(), 10U);
+    EXPECT_EQ(source.frameSize(), cv::Size(40, 30));
+    EXPECT_EQ(source.frameType(), CV_16UC1);
+    EXPECT_DOUBLE_EQ(source.fps(), 25.0);
+    for (std::size_t i = 0; i < 10; ++i) {
+        const std::uint64_t camera_index = i < 3 ? i : i + 1;
+        EXPECT_EQ(source.cameraFrameIndex(i), camera_index);
+        EXPECT_DOUBLE_EQ(source.getTimestamp(i), static_cast<double>(camera_index) / 25.0);
+        EXPECT_TRUE(matchesFrame(source.getFrame(i), camera_index)) << "frame " << i;
+    }
+    EXPECT_THROW(source.getFrame(10), std::out_of_range);
+}
+
+TEST(RawRecording, NeverBlocksTheRecordingThread) {
+    TestTempDirectory dir("droplet_raw_recording_drops");
+    const std::string path = (dir.path() / "burst.draw").string();
+
+    RawRecorderParams params;
+    params.chunk_bytes = 0;  // one frame per chunk
+    params.buffers = 2;
+    RawRecorder recorder(params);
+    std::string error;
+    ASSERT_TRUE(recorder.open(path, cv::Size(40, 30), CV_16UC1, 8938.0, error)) << error;
+    // A burst far faster than one write per frame: whatever the writer cannot take is dropped, not waited for.
+    std::uint64_t accepted = 0;
+    for (std::uint64_t index = 0; index < 2000; ++index) {
+        accepted += recorder.record(streamFrame(index)) ? 1 : 0;
+    }
+    ASSERT_TRUE(recorder.finish(error)) << error;
+    const RawRecorderStats stats = recorder.stats();
+    EXPECT_EQ(stats.frames_recorded, accepted);
+    EXPECT_EQ(stats.frames_recorded + stats.frames_dropped, 2000U);
+    EXPECT_LE(stats.peak_queued_chunks, 2U);
+
+    RawRecordingSource source(path);
+    ASSERT_TRUE(source.load(error)) << error;
+    ASSERT_EQ(source.getTotalFrames(), accepted);
+    for (std::size_t i = 0; i < source.getTotalFrames(); ++i) {
+        if (i > 0) {
+            ASSERT_GT(source.cameraFrameIndex(i), source.cameraFrameIndex(i - 1));
+        }
+        ASSERT_TRUE(matchesFrame(source.getFrame(i), source.cameraFrameIndex(i)));
+    }
+}
+
+TEST(RawRecording, RejectsUnfinishedAndForeignFiles) {
+    TestTempDirectory dir("droplet_raw_recording_invalid");
+    const std::string path = (dir.path() / "open.draw").string();
+    std::string error;
+    {
+        RawRecorder recorder;
+        ASSERT_TRUE(recorder.open(path, cv::Size(40, 30), CV_16UC1, 25.0, error)) << error;
+        ASSERT_TRUE(recorder.record(streamFrame(0)));
+
+        RawRecordingSource unfinished(path);
+        EXPECT_FALSE(unfinished.load(error));
+        EXPECT_NE(error.find("not finished"), std::string::npos) << error;
+    }
+    RawRecordingSource finished(path);
+    ASSERT_TRUE(finished.load(error)) << error;
+    EXPECT_EQ(finished.getTotalFrames(), 1U);
+
+    const std::string foreign = (dir.path() / "foreign.draw").string();
+    std::ofstream(foreign, std::ios::binary) << std::string(8192, 'x');
+    RawRecordingSource not_raw(foreign);
+    EXPECT_FALSE(not_raw.load(error));
+    EXPECT_NE(error.find("Not a raw recording"), std::string::npos) << error;
+}
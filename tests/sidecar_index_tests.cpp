@@ -0,0 +1,61 @@
+#include "SidecarIndex.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+TEST(SidecarIndex, RoundTripsValuesAndRejectsForeignOrCorruptFiles) {
+    TestTempDirectory dir("droplet_sidecar_index");
+    const auto path = dir.path() / "test.idx";
+
+    SidecarWriter writer("TEST-INDEX", 3);
+    writer.put(std::uint8_t{7});
+    writer.put(std::int64_t{-42});
+    writer.put(std::uint64_t{0x0102030405060708ULL});
+    writer.putString("frame_0001.tif");
+    std::string error;
+    ASSERT_TRUE(writer.commit(path, error)) << error;
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+
+    auto reader = SidecarReader::open(path, "TEST-INDEX", 3);
+    ASSERT_TRUE(reader.has_value());
+    std::uint8_t small = 0;
+    std::int64_t negative = 0;
+    std::uint64_t large = 0;
+    std::string text;
+    ASSERT_TRUE(reader->get(small));
+    ASSERT_TRUE(reader->get(negative));
+    ASSERT_TRUE(reader->get(large));
+    ASSERT_TRUE(reader->getString(text));
+    EXPECT_EQ(small, 7);
+    EXPECT_EQ(negative, -42);
+    EXPECT_EQ(large, 0x0102030405060708ULL);
+    EXPECT_EQ(text, "frame_0001.tif");
+    EXPECT_EQ(reader->remaining(), 0U);
+    EXPECT_FALSE(reader->get(small));
+
+    EXPECT_FALSE(SidecarReader::open(path, "TEST-INDEX", 4).has_value());
+    EXPECT_FALSE(SidecarReader::open(path, "OTHER", 3).has_value());
+
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(20);
+        file.put('\x55');
+    }
+    EXPECT_FALSE(SidecarReader::open(path, "TEST-INDEX", 3).has_value());
+
+    const auto stamp = FileStamp::of(path);
+    ASSERT_TRUE(stamp.has_value());
+    EXPECT_EQ(stamp->size, std::filesystem::file_size(path));
+    EXPECT_EQ(FileStamp::of(path), stamp);
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    EXPECT_FALSE(SidecarReader::open(path, "TEST-INDEX", 3).has_value());
+    EXPECT_FALSE(FileStamp::of(path).has_value());
+}
@@ -0,0 +1,202 @@
+#include "SimulatedCameraSource.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+// Frames filled with their index; `odd_size` makes one frame larger than the others.
+class IndexedSource final : public InputSource {
+public:
+    explicit IndexedSource(std::size_t total, std::size_t odd_size = SIZE_MAX) : total_(total), odd_size_(odd_size) {}
+
+    Type getType() const override { return Type::ImageSequence; }
+    std::size_t getTotalFrames() const override { return total_; }
+    cv::Mat getFrame(std::size_t logical_index) override {
+        const int size = logical_index == odd_size_ ? 8 : 4;
+        cv::Mat frame(size, size, CV_8UC1);
+        for (int y = 0; y < frame.rows; ++y) {
+            for (int x = 0; x < frame.cols; ++x) {
+                frame.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(logical_index);
+            }
+        }
+        return frame;
+    }
+    double getTimestamp(std::size_t logical_index) const override { return static_cast<double>(logical_index); }
+
+private:
+    std::size_t total_;
+    std::size_t odd_size_;
+};
+
+SimulatedCameraParams smallCamera(double fps, std::uint64_t frame_limit) {
+    SimulatedCameraParams params;
+    params.width = 64;
+    params.height = 48;
+    params.fps = fps;
+    params.frame_limit = frame_limit;
+    params.droplet_radius_px = 6;
+    params.droplet_spacing_px = 24;
+    return params;
+}
+} // namespace
+
+TEST(SimulatedCameraSource, DeliversEveryFrameInOrderThenStops) {
+    SimulatedCameraSource camera(smallCamera(500.0, 40));
+    EXPECT_EQ(camera.getType(), InputSource::Type::CameraStream);
+    EXPECT_EQ(camera.getTotalFrames(), 0U);
+
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    EXPECT_FALSE(camera.start(error));
+
+    const auto begin = std::chrono::steady_clock::now();
+    StreamFrame frame;
+    for (std::uint64_t index = 0; index < 40; ++index) {
+        ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+        EXPECT_EQ(frame.frame_index, index);
+        EXPECT_DOUBLE_EQ(frame.timestamp, static_cast<double>(index) / 500.0);
+        ASSERT_EQ(frame.image.size(), cv::Size(64, 48));
+        ASSERT_EQ(frame.image.type(), CV_16UC1);
+    }
+    // Paced at the camera's rate: frame 39 is exposed 78 ms after frame 0.
+    EXPECT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(70));
+    // Frame 39 shows pattern frame 7, shifted right by 7 * 24 / 16 = 10 px; the first droplet row is centred half a
+    // grid step down, and the background stays far below it.
+    EXPECT_GT(frame.image.at<std::uint16_t>(12, 22), 6000);
+    EXPECT_LT(frame.image.at<std::uint16_t>(0, 0), 2000);
+
+    EXPECT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Stopped);
+    EXPECT_FALSE(camera.isAcquiring());
+    const SimulatedCameraStats stats = camera.stats();
+    EXPECT_EQ(stats.frames_acquired, 40U);
+    EXPECT_EQ(stats.frames_delivered, 40U);
+    EXPECT_EQ(stats.frames_lost, 0U);
+}
+
+TEST(SimulatedCameraSource, ReportsLostFramesWhenTheConsumerFallsARingBehind) {
+    SimulatedCameraParams params = smallCamera(1000.0, 60);
+    params.ring_frames = 4;
+    SimulatedCameraSource camera(params);
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+
+    StreamFrame frame;
+    ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(frame.frame_index, 0U);
+
+    // Acquisition ends while nobody reads: only the last ring's worth of frames is left.
+    for (int wait = 0; wait < 500 && camera.isAcquiring(); ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(camera.isAcquiring());
+    ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::LostFrame);
+    EXPECT_EQ(frame.frame_index, 56U);
+    for (std::uint64_t index = 57; index < 60; ++index) {
+        ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+        EXPECT_EQ(frame.frame_index, index);
+    }
+    EXPECT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Stopped);
+
+    const SimulatedCameraStats stats = camera.stats();
+    EXPECT_EQ(stats.frames_delivered, 5U);
+    EXPECT_EQ(stats.frames_lost, 55U);
+    EXPECT_EQ(stats.lost_frame_events, 1U);
+}
+
+TEST(SimulatedCameraSource, TimesOutBetweenFrames) {
+    SimulatedCameraSource camera(smallCamera(10.0, 2));
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    StreamFrame frame;
+    ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(camera.grabNextFrame(frame, std::chrono::milliseconds(10)), GrabStatus::Timeout);
+    ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    EXPECT_EQ(frame.frame_index, 1U);
+    EXPECT_DOUBLE_EQ(camera.getTimestamp(1), 0.1);
+}
+
+TEST(SimulatedCameraSource, RestartsAfterStop) {
+    SimulatedCameraSource camera(smallCamera(500.0, 6));
+    std::string error;
+    StreamFrame frame;
+    for (int run = 0; run < 2; ++run) {
+        ASSERT_TRUE(camera.start(error)) << error;
+        // Only part of the first run is read; the rest must not leak into the second.
+        const std::uint64_t grabs = run == 0 ? 3 : 6;
+        for (std::uint64_t index = 0; index < grabs; ++index) {
+            ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok) << "run " << run;
+            EXPECT_EQ(frame.frame_index, index);
+        }
+        if (run == 1) {
+            EXPECT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Stopped);
+        }
+        camera.stop();
+        EXPECT_FALSE(camera.isAcquiring());
+    }
+    const SimulatedCameraStats stats = camera.stats();
+    EXPECT_EQ(stats.frames_acquired, 6U);
+    EXPECT_EQ(stats.frames_delivered, 6U);
+    EXPECT_EQ(stats.frames_lost, 0U);
+}
+
+TEST(SimulatedCameraSource, KeepsUpWithTheHighSpeedLineMode) {
+    SimulatedCameraParams params = SimulatedCameraParams::highSpeedLine();
+    params.frame_limit = 2000;
+    SimulatedCameraSource camera(params);
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    EXPECT_EQ(camera.frameSize(), cv::Size(2304, 4));
+
+    StreamFrame frame;
+    std::uint64_t grabbed = 0;
+    std::uint64_t expected = 0;
+    GrabStatus status;
+    while ((status = camera.grabNextFrame(frame, std::chrono::seconds(5))) != GrabStatus::Stopped) {
+        ASSERT_NE(status, GrabStatus::Timeout);
+        // Indices only ever move forward, and a jump is always reported.
+        ASSERT_GE(frame.frame_index, expected);
+        EXPECT_EQ(status == GrabStatus::LostFrame, frame.frame_index > expected);
+        expected = frame.frame_index + 1;
+        ++grabbed;
+    }
+    const SimulatedCameraStats stats = camera.stats();
+    EXPECT_EQ(stats.frames_delivered, grabbed);
+    EXPECT_EQ(stats.frames_delivered + stats.frames_lost, 2000U);
+}
+
+TEST(SimulatedCameraSource, ReplaysAnInputSourceWithoutDisturbingHeldFrames) {
+    SimulatedCameraParams params = smallCamera(200.0, 12);
+    params.replay = std::make_shared<IndexedSource>(5);
+    params.replay_frames = 3;
+    SimulatedCameraSource camera(params);
+    std::string error;
+    ASSERT_TRUE(camera.start(error)) << error;
+    EXPECT_EQ(camera.frameSize(), cv::Size(4, 4));
+    EXPECT_EQ(camera.params().type, CV_8UC1);
+
+    StreamFrame frame;
+    ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+    // A Mat kept from a grabbed frame shares its buffer, so the camera must not write into it again.
+    const cv::Mat held = frame.image;
+    for (std::uint64_t index = 1; index < 12; ++index) {
+        ASSERT_EQ(camera.grabNextFrame(frame, std::chrono::seconds(5)), GrabStatus::Ok);
+        EXPECT_EQ(frame.image.at<std::uint8_t>(3, 3), index % 3);
+    }
+    EXPECT_EQ(held.at<std::uint8_t>(3, 3), 0);
+
+    SimulatedCameraParams mismatched = params;
+    mismatched.replay = std::make_shared<IndexedSource>(5, 2);
+    SimulatedCameraSource broken(mismatched);
+    EXPECT_FALSE(broken.start(error));
+    EXPECT_NE(error.find("Replay frame 2"), std::string::npos);
+
+    SimulatedCameraParams no_ring = smallCamera(100.0, 1);
+    no_ring.ring_frames = 0;
+    SimulatedCameraSource unstarted(no_ring);
+    EXPECT_FALSE(unstarted.start(error));
+    EXPECT_EQ(unstarted.grabNextFrame(frame, std::chrono::milliseconds(1)), GrabStatus::Stopped);
+}
@@ -0,0 +1,40 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(ThreadPool, RunsEveryTaskAndReturnsResults) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.threadCount(), 3U);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 50; ++i) {
+        results.push_back(pool.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(results[static_cast<std::size_t>(i)].get(), i * i);
+    }
+
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+}
+
+TEST(ThreadPool, DestructorDrainsQueuedTasks) {
+    std::atomic<int> completed{0};
+    std::vector<std::future<void>> pending;
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 20; ++i) {
+            pending.push_back(pool.submit([&completed]() { completed.fetch_add(1); }));
+        }
+    }
+    EXPECT_EQ(completed.load(), 20);
+    for (auto& task : pending) {
+        EXPECT_EQ(task.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    }
+    EXPECT_GE(ThreadPool().threadCount(), 1U);
+}
@@ -0,0 +1,221 @@
+#include "TiffFormat.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "TestTempDirectory.h"
+
+namespace {
+cv::Mat makeRamp(int rows, int cols, int type) {
+    cv::Mat image(rows, cols, type);
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < cols; ++x) {
+            if (type == CV_8UC1) {
+                image.at<std::uint8_t>(y, x) = static_cast<std::uint8_t>(x + 3 * y);
+            } else {
+                image.at<std::uint16_t>(y, x) = static_cast<std::uint16_t>(1000 + 257 * x + 31 * y);
+            }
+        }
+    }
+    return image;
+}
+
+std::vector<std::uint8_t> writeAndRead(const cv::Mat& image, const TiffWriteOptions& options) {
+    TestTempDirectory dir("droplet_tiff_format_write");
+    const auto path = dir.path() / "image.tif";
+    std::string error;
+    EXPECT_TRUE(TiffFormat::writeGrayscale(path, image, error, options)) << error;
+    std::ifstream in(path, std::ios::binary);
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return bytes;
+}
+
+bool equal(const cv::Mat& left, const cv::Mat& right) {
+    if (left.size() != right.size() || left.type() != right.type()) {
+        return false;
+    }
+    for (int y = 0; y < left.rows; ++y) {
+        if (std::memcmp(left.ptr(y), right.ptr(y), static_cast<std::size_t>(left.cols) * left.elemSize()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void put16(std::vector<std::uint8_t>& bytes, std::size_t at, std::uint16_t value) {
+    bytes[at] = static_cast<std::uint8_t>(value);
+    bytes[at + 1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void put64(std::vector<std::uint8_t>& bytes, std::size_t at, std::uint64_t value) {
+    for (std::size_t i = 0; i < 8; ++i) {
+        bytes[at + i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+} // namespace
+
+TEST(TiffFormat, RoundTripsSingleStripLittleEndian) {
+    const cv::Mat image = makeRamp(37, 53, CV_16UC1);
+    const auto bytes = writeAndRead(image, {});
+
+    TiffFileLayout layout;
+    std::string error;
+    ASSERT_TRUE(TiffFormat::parse(bytes, layout, error)) << error;
+    ASSERT_EQ(layout.pages.size(), 1U);
+    EXPECT_TRUE(layout.little_endian);
+    EXPECT_FALSE(layout.big_tiff);
+
+    const TiffPageLayout& page = layout.pages.front();
+    EXPECT_EQ(page.width, 53U);
+    EXPECT_EQ(page.height, 37U);
+    EXPECT_EQ(page.bits_per_sample, 16);
+    EXPECT_EQ(page.rows_per_strip, 37U);
+    EXPECT_TRUE(TiffFormat::validatePage(layout, page, error)) << error;
+
+    const auto offset = TiffFormat::contiguousPixelOffset(page, bytes.size());
+    ASSERT_TRUE(offset.has_value());
+    EXPECT_EQ(*offset % 16, 0U);
+
+    cv::Mat decoded;
+    ASSERT_TRUE(TiffFormat::decodeUncompressed(bytes, layout.little_endian, page, decoded, error)) << error;
+    EXPECT_TRUE(equal(decoded, image));
+}
+
+TEST(TiffFormat, MultiStripAndBigEndianLayouts) {
+    const cv::Mat image = makeRamp(50, 21, CV_16UC1);
+    TiffWriteOptions options;
+    options.rows_per_strip = 8;
+    options.big_endian = true;
+    const auto bytes = writeAndRead(image, options);
+
+    TiffFileLayout layout;
+    std::string error;
+    ASSERT_TRUE(TiffFormat::parse(bytes, layout, error)) << error;
+    EXPECT_FALSE(layout.little_endian);
+    const TiffPageLayout& page = layout.pages.front();
+    EXPECT_EQ(page.strip_offsets.size(), 7U);
+    EXPECT_EQ(page.strip_byte_counts.back(), 2U * 21U * 2U);
+    // Strips are written back to back, so the page is still contiguous.
+    EXPECT_TRUE(TiffFormat::contiguousPixelOffset(page, bytes.size()).has_value());
+    EXPECT_FALSE(TiffFormat::contiguousPixelOffset(page, bytes.size() - 1).has_value());
+
+    cv::Mat decoded;
+    ASSERT_TRUE(TiffFormat::decodeUncompressed(bytes, layout.little_endian, page, decoded, error)) << error;
+    EXPECT_TRUE(equal(decoded, image));
+
+    TiffPageLayout gapped = page;
+    gapped.strip_offsets[3] += 2;
+    EXPECT_FALSE(TiffFormat::contiguousPixelOffset(gapped, bytes.size()).has_value());
+}
+
+TEST(TiffFormat, RejectsCorruptAndUnsupportedFiles) {
+    TiffFileLayout layout;
+    std::string error;
+    const std::vector<std::uint8_t> garbage = {'P', 'K', 3, 4, 0, 0, 0, 0, 0, 0};
+    EXPECT_FALSE(TiffFormat::parse(garbage, layout, error));
+
+    auto bytes = writeAndRead(makeRamp(16, 16, CV_8UC1), {});
+    std::vector<std::uint8_t> truncated(bytes.begin(), bytes.begin() + 40);
+    EXPECT_FALSE(TiffFormat::parse(truncated, layout, error));
+    EXPECT_NE(error.find("Truncated"), std::string::npos);
+
+    // Point the next-IFD field back at the first directory.
+    auto looping = bytes;
+    const std::size_t next_field = 8 + 2 + 10 * 12;
+    looping[next_field] = 8;
+    EXPECT_FALSE(TiffFormat::parse(looping, layout, error, 0));
+    EXPECT_NE(error.find("loops"), std::string::npos);
+
+    auto wide = writeAndRead(makeRamp(2, 9000, CV_8UC1), {});
+    ASSERT_TRUE(TiffFormat::parse(wide, layout, error)) << error;
+    EXPECT_FALSE(TiffFormat::validatePage(layout, layout.pages.front(), error));
+    EXPECT_NE(error.find("too large"), std::string::npos);
+
+    // Compression entry (fourth) set to LZW still parses; validation leaves the decision to the reader.
+    auto compressed = bytes;
+    put16(compressed, 8 + 2 + 3 * 12 + 8, 5);
+    ASSERT_TRUE(TiffFormat::parse(compressed, layout, error)) << error;
+    EXPECT_EQ(layout.pages.front().compression, 5);
+    EXPECT_TRUE(TiffFormat::validatePage(layout, layout.pages.front(), error));
+    cv::Mat decoded;
+    EXPECT_FALSE(TiffFormat::decodeUncompressed(compressed, true, layout.pages.front(), decoded, error));
+}
+
+TEST(TiffFormat, ParsesBigTiffHeaders) {
+    // Hand-built BigTIFF: 16-byte header, 5-entry directory, 4x2 8-bit pixels.
+    std::vector<std::uint8_t> bytes(16 + 8 + 5 * 20 + 8 + 8, 0);
+    bytes[0] = 'I';
+    bytes[1] = 'I';
+    put16(bytes, 2, 43);
+    put16(bytes, 4, 8);
+    put64(bytes, 8, 16);
+    put64(bytes, 16, 5);
+    const std::size_t pixels = 16 + 8 + 5 * 20 + 8;
+    const std::uint16_t tags[5] = {256, 257, 258, 273, 279};
+    const std::uint64_t values[5] = {4, 2, 8, pixels, 8};
+    for (std::size_t i = 0; i < 5; ++i) {
+        const std::size_t entry = 24 + i * 20;
+        put16(bytes, entry, tags[i]);
+        put16(bytes, entry + 2, i == 3 ? 16 : 3);
+        put64(bytes, entry + 4, 1);
+        put64(bytes, entry + 12, values[i]);
+    }
+
+    TiffFileLayout layout;
+    std::string error;
+    ASSERT_TRUE(TiffFormat::parse(bytes, layout, error, 0)) << error;
+    EXPECT_TRUE(layout.big_tiff);
+    ASSERT_EQ(layout.pages.size(), 1U);
+    EXPECT_EQ(layout.pages.front().width, 4U);
+    EXPECT_EQ(layout.pages.front().strip_offsets.front(), pixels);
+    EXPECT_EQ(TiffFormat::contiguousPixelOffset(layout.pages.front(), bytes.size()), pixels);
+    EXPECT_FALSE(TiffFormat::validatePage(layout, layout.pages.front(), error));
+    EXPECT_NE(error.find("BigTIFF"), std::string::npos);
+}
+
+TEST(TiffFormat, ParseFileReadsOnlyDirectoryBlocks) {
+    // Three 256x256 16-bit pages: the second and third directories sit behind 128 KB of pixels each.
+    TestTempDirectory dir("droplet_tiff_format_parse_file");
+    const auto path = dir.path() / "pages.tif";
+    const std::vector<cv::Mat> pages(3, makeRamp(256, 256, CV_16UC1));
+    std::string error;
+    ASSERT_TRUE(TiffFormat::writeGrayscalePages(path, pages, error)) << error;
+    const auto file_size = std::filesystem::file_size(path);
+
+    TiffFileLayout from_file;
+    std::size_t bytes_read = 0;
+    ASSERT_TRUE(TiffFormat::parseFile(path, from_file, error, 0, &bytes_read)) << error;
+    ASSERT_EQ(from_file.pages.size(), 3U);
+    EXPECT_GT(bytes_read, 0U);
+    EXPECT_LE(bytes_read, 3U * 2U * 4096U);
+    EXPECT_LT(bytes_read * 10, file_size);
+
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    TiffFileLayout from_memory;
+    ASSERT_TRUE(TiffFormat::parse(bytes, from_memory, error, 0)) << error;
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(from_file.pages[i].ifd_offset, from_memory.pages[i].ifd_offset);
+        EXPECT_EQ(from_file.pages[i].strip_offsets, from_memory.pages[i].strip_offsets);
+        EXPECT_EQ(from_file.pages[i].strip_byte_counts, from_memory.pages[i].strip_byte_counts);
+    }
+
+    ASSERT_TRUE(TiffFormat::parseFile(path, from_file, error, 1, &bytes_read)) << error;
+    EXPECT_EQ(from_file.pages.size(), 1U);
+    EXPECT_EQ(bytes_read, 4096U);
+
+    std::filesystem::resize_file(path, 6);
+    EXPECT_FALSE(TiffFormat::parseFile(path, from_file, error));
+    std::error_code remove_error;
+    std::filesystem::remove(path, remove_error);
+    EXPECT_FALSE(TiffFormat::parseFile(path, from_file, error));
+    EXPECT_NE(error.find("Cannot open file"), std::string::npos);
+}